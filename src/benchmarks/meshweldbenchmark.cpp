@@ -0,0 +1,90 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*
+ * Vertex welding time (Mesh::weld) as a function of the number of vertices.
+ * Each mesh is a grid whose quads have their own four vertices (unwelded
+ * seams) moved by less than the tolerance : about 3 vertices out of 4 are
+ * removed. The time per vertex should stay about constant.
+ *
+ * Usage : meshweld_benchmark [max vertices] [threads]
+ * Meshes of 1M, 4M, 16M... vertices up to max vertices (16M by default).
+ */
+
+#include "fileloaders/mesh.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace Loaders;
+
+namespace {
+
+const float tolerance = 1e-5f;
+
+Mesh* grid(std::size_t number_of_vertices)
+{
+    std::size_t n = 1;
+    while (4 * (n + 1) * (n + 1) <= number_of_vertices) {
+        ++n;
+    }
+    std::vector<float> vertices;
+    std::vector<unsigned int> triangles;
+    vertices.reserve(4 * n * n * 8);
+    triangles.reserve(6 * n * n);
+    const int corners[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+    unsigned int seed = 1;
+    for (std::size_t j = 0; j < n; ++j) {
+        for (std::size_t i = 0; i < n; ++i) {
+            unsigned int first = unsigned(vertices.size() / 8);
+            for (int c = 0; c < 4; ++c) {
+                float u = float(i + corners[c][0]) / n, v = float(j + corners[c][1]) / n;
+                seed = seed * 1664525u + 1013904223u;
+                float jitter = (float(seed >> 8) / float(1 << 24) - 0.5f) * 0.5f * tolerance;
+                float vertex[8] = { u + jitter, v, 0.f, 0.f, 0.f, 1.f, u, v };
+                vertices.insert(vertices.end(), vertex, vertex + 8);
+            }
+            unsigned int quad[6] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+            triangles.insert(triangles.end(), quad, quad + 6);
+        }
+    }
+    return new Mesh(vertices.data(), vertices.size() / 8, triangles.data(), triangles.size() / 3, true, true);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t max_vertices = (argc > 1) ? std::size_t(std::atof(argv[1])) : 16000000;
+    unsigned threads = (argc > 2) ? unsigned(std::atoi(argv[2])) : 0;
+
+    for (std::size_t vertices = 1000000; vertices <= max_vertices; vertices *= 4) {
+        Mesh* mesh = grid(vertices);
+        std::size_t before = mesh->nbVertices();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::size_t removed = mesh->weld(tolerance, tolerance, tolerance, threads);
+        double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << before << " vertices : " << removed << " removed, " << time << " s, " << time * 1e9 / before << " ns/vertex" << std::endl;
+        delete mesh;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,180 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*
+ * Material library loading time : MTL parsing alone, then ObjLoader on a
+ * small model which uses a few materials of a large library, without and
+ * with the binary cache.
+ *
+ * Usage : mtl_benchmark [materials] [runs]
+ * The library (20000 materials with 4 texture maps each, sharing 500
+ * textures by default) and the model (64 groups, one material each) are
+ * generated in mtl_benchmark/ (current directory).
+ */
+
+#include "fileloaders/objloader.h"
+#include "fileloaders/objfileparser.h"
+
+#include <QDir>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace Loaders;
+
+namespace {
+
+const std::string library_dir = "mtl_benchmark";
+const std::size_t default_number_of_materials = 20000;
+const std::size_t number_of_textures = 500;
+const std::size_t number_of_groups = 64;
+
+bool generate_library(const std::string& filename, std::size_t number_of_materials)
+{
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    std::fprintf(file, "# %zu materials\n", number_of_materials);
+    for (std::size_t m = 0; m < number_of_materials; ++m) {
+        float t = float(m) / number_of_materials;
+        std::size_t texture = m % number_of_textures;
+        std::fprintf(file, "\nnewmtl material%zu\n", m);
+        std::fprintf(file, "Ka 0.1 0.1 0.1\nKd %.4f %.4f %.4f\nKs 0.5 0.5 0.5\nTf 1 1 1\n", t, 1 - t, 0.5f);
+        std::fprintf(file, "Ns %.2f\nNi 1.45\nd 1\nillum 2\n", 10 + 50 * t);
+        std::fprintf(file, "map_Kd -s 2 2 1 textures/diffuse%zu.png\n", texture);
+        std::fprintf(file, "map_Ks textures/specular%zu.png\n", texture);
+        std::fprintf(file, "map_d textures/alpha%zu.png\n", texture);
+        std::fprintf(file, "bump -s 1 1 1 textures/normal%zu.png\n", texture);
+    }
+    return std::fclose(file) == 0;
+}
+
+// one quad per group, each group uses one material of the library
+bool generate_model(const std::string& filename, std::size_t number_of_materials)
+{
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    std::fprintf(file, "mtllib library.mtl\n");
+    for (std::size_t g = 0; g < number_of_groups; ++g) {
+        std::fprintf(file, "v %zu 0 0\nv %zu 0 0\nv %zu 1 0\nv %zu 1 0\n", g, g + 1, g + 1, g);
+    }
+    for (std::size_t g = 0; g < number_of_groups; ++g) {
+        std::size_t v = 4 * g + 1;
+        std::fprintf(file, "g part%zu\nusemtl material%zu\n", g, (g * 7919) % number_of_materials);
+        std::fprintf(file, "f %zu %zu %zu\nf %zu %zu %zu\n", v, v + 1, v + 2, v, v + 2, v + 3);
+    }
+    return std::fclose(file) == 0;
+}
+
+double seconds_since(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// load and getObjects, number of meshes with a material
+std::size_t load(const QString& filename, bool cache)
+{
+    Obj_mtl::ObjLoader loader;
+    loader.setCacheEnabled(cache);
+    QString reason;
+    if (!loader.load(filename, reason)) {
+        std::cerr << reason.toStdString() << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    std::vector<Mesh*> meshes;
+    std::vector<const Obj_mtl::ObjLoader::mtlMaterial*> materials;
+    loader.getObjects(meshes, materials);
+    std::size_t found = 0;
+    for (std::size_t m = 0; m < meshes.size(); ++m) {
+        found += (materials[m] != 0);
+        delete meshes[m];
+    }
+    return found;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t number_of_materials = (argc > 1) ? std::size_t(std::atoi(argv[1])) : default_number_of_materials;
+    int runs = (argc > 2) ? std::atoi(argv[2]) : 5;
+    if (number_of_materials < 1) {
+        number_of_materials = 1;
+    }
+    if (runs < 1) {
+        runs = 1;
+    }
+
+    std::string library = library_dir + "/library.mtl";
+    std::string model = library_dir + "/model.obj";
+    std::cout << "Generating " << library << " (" << number_of_materials << " materials)" << std::endl;
+    if (!QDir().mkpath(QString(library_dir.c_str())) || !generate_library(library, number_of_materials) || !generate_model(model, number_of_materials)) {
+        std::cerr << "can't write " << library_dir << std::endl;
+        return EXIT_FAILURE;
+    }
+    QString filename(model.c_str());
+
+    double best_parser = 0, best_loader = 0, best_cached = 0;
+    std::size_t parsed = 0, found = 0, found_cached = 0;
+    for (int run = 0; run < runs; ++run) {
+        std::size_t blocks = 0;
+        Obj_mtl::mtl_parser parser;
+        parser.material_block_callback([&](const Obj_mtl::mtl_material_block&) { ++blocks; });
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (!parser.parse(library)) {
+            std::cerr << "can't parse " << library << std::endl;
+            return EXIT_FAILURE;
+        }
+        double time = seconds_since(start);
+        parsed = blocks;
+        if (run == 0 || time < best_parser) {
+            best_parser = time;
+        }
+
+        start = std::chrono::steady_clock::now();
+        found = load(filename, false);
+        time = seconds_since(start);
+        if (run == 0 || time < best_loader) {
+            best_loader = time;
+        }
+    }
+
+    // first load writes the cache
+    load(filename, true);
+    for (int run = 0; run < runs; ++run) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        found_cached = load(filename, true);
+        double time = seconds_since(start);
+        if (run == 0 || time < best_cached) {
+            best_cached = time;
+        }
+    }
+
+    std::cout << "materials parsed      : " << parsed << std::endl;
+    std::cout << "mtl_parser            : " << best_parser * 1000 << " ms" << std::endl;
+    std::cout << "ObjLoader (no cache)  : " << best_loader * 1000 << " ms, " << found << "/" << number_of_groups << " materials found" << std::endl;
+    std::cout << "ObjLoader (cache)     : " << best_cached * 1000 << " ms, " << found_cached << "/" << number_of_groups << " materials found" << std::endl;
+    return (found == number_of_groups && found_cached == number_of_groups) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,193 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*
+ * Load time of ObjLoader on a large model : parse (ObjLoader::load) and
+ * mesh construction (ObjLoader::getObjects, vertex welding), then the load
+ * time from the binary cache (written next to the model), and the peak
+ * resident memory of the process (POSIX systems).
+ *
+ * Usage : objloader_benchmark [file.obj] [runs] [threads]
+ * Without a file, a smooth grid of 4 000 000 triangles with texture vertices
+ * and normals is generated in objloader_benchmark.obj (current directory).
+ */
+
+#include "fileloaders/objloader.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#ifdef __unix__
+#include <sys/resource.h>
+#endif
+
+using namespace Loaders;
+
+namespace {
+
+const std::size_t default_number_of_faces = 4000000;
+
+bool generate(const std::string& filename, std::size_t number_of_faces)
+{
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    std::size_t n = std::size_t(std::ceil(std::sqrt(number_of_faces / 2.0))) + 1;
+    for (std::size_t j = 0; j < n; ++j) {
+        for (std::size_t i = 0; i < n; ++i) {
+            std::fprintf(file, "v %.6f %.6f %.6f\n", float(i) / n, float(j) / n, std::sin(float(i + j) / n));
+        }
+    }
+    for (std::size_t j = 0; j < n; ++j) {
+        for (std::size_t i = 0; i < n; ++i) {
+            std::fprintf(file, "vt %.6f %.6f\n", float(i) / n, float(j) / n);
+        }
+    }
+    for (std::size_t j = 0; j < n; ++j) {
+        for (std::size_t i = 0; i < n; ++i) {
+            std::fprintf(file, "vn %.4f %.4f 1\n", std::cos(float(i) / n), std::sin(float(j) / n));
+        }
+    }
+    // smoothing group : the vertices shared by the faces are welded
+    std::fprintf(file, "g grid\ns 1\n");
+    std::size_t faces = 0;
+    for (std::size_t j = 0; j + 1 < n && faces < number_of_faces; ++j) {
+        for (std::size_t i = 0; i + 1 < n && faces < number_of_faces; ++i) {
+            std::size_t a = j * n + i + 1, b = a + 1, c = a + n, d = c + 1;
+            std::fprintf(file, "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", a, a, a, b, b, b, d, d, d);
+            if (++faces < number_of_faces) {
+                std::fprintf(file, "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", a, a, a, d, d, d, c, c, c);
+                ++faces;
+            }
+        }
+    }
+    return std::fclose(file) == 0;
+}
+
+void delete_meshes(std::vector<Mesh*>& meshes)
+{
+    for (std::size_t i = 0; i < meshes.size(); ++i) {
+        delete meshes[i];
+    }
+    meshes.clear();
+}
+
+// peak resident memory in MB, 0 if unknown
+double peak_memory()
+{
+#ifdef __unix__
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return usage.ru_maxrss / 1024.;
+    }
+#endif
+    return 0;
+}
+
+double seconds_since(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::string filename = (argc > 1) ? argv[1] : "objloader_benchmark.obj";
+    int runs = (argc > 2) ? std::atoi(argv[2]) : 3;
+    unsigned threads = (argc > 3) ? unsigned(std::atoi(argv[3])) : 1;
+    if (runs < 1) {
+        runs = 1;
+    }
+
+    if (argc <= 1 && !std::ifstream(filename.c_str())) {
+        std::cout << "Generating " << filename << " (" << default_number_of_faces << " faces)" << std::endl;
+        if (!generate(filename, default_number_of_faces)) {
+            std::cerr << "can't write " << filename << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    double best_load = 0, best_meshes = 0;
+    std::size_t vertices = 0, triangles = 0;
+    for (int run = 0; run < runs; ++run) {
+        Obj_mtl::ObjLoader loader;
+        loader.setThreadCount(threads);
+        loader.setCacheEnabled(false);
+        QString reason;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (!loader.load(QString(filename.c_str()), reason)) {
+            std::cerr << "can't load " << filename << std::endl;
+            return EXIT_FAILURE;
+        }
+        double load = seconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        std::vector<Mesh*> meshes;
+        loader.getObjects(meshes);
+        double build = seconds_since(start);
+
+        vertices = triangles = 0;
+        for (std::size_t i = 0; i < meshes.size(); ++i) {
+            vertices += meshes[i]->nbVertices();
+            triangles += meshes[i]->nbTriangles();
+        }
+        delete_meshes(meshes);
+        if (run == 0 || load < best_load) {
+            best_load = load;
+        }
+        if (run == 0 || build < best_meshes) {
+            best_meshes = build;
+        }
+    }
+
+    // binary cache : written by a first load if needed, then mapped
+    double best_cached = 0;
+    for (int run = -1; run < runs; ++run) {
+        Obj_mtl::ObjLoader loader;
+        loader.setThreadCount(threads);
+        QString reason;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<Mesh*> meshes;
+        if (!loader.load(QString(filename.c_str()), reason)) {
+            std::cerr << "can't load " << filename << std::endl;
+            return EXIT_FAILURE;
+        }
+        loader.getObjects(meshes);
+        double cached = seconds_since(start);
+        delete_meshes(meshes);
+        if (run == 0 || (run > 0 && cached < best_cached)) {
+            best_cached = cached;
+        }
+    }
+
+    std::cout << filename << " : " << vertices << " vertices, " << triangles << " triangles, best of " << runs << " runs" << std::endl;
+    std::cout << "load (parse)         : " << best_load << " s" << std::endl;
+    std::cout << "getObjects (welding) : " << best_meshes << " s" << std::endl;
+    std::cout << "total                : " << best_load + best_meshes << " s" << std::endl;
+    std::cout << "cached load          : " << best_cached << " s" << std::endl;
+    std::cout << "peak memory          : " << peak_memory() << " MB" << std::endl;
+    return EXIT_SUCCESS;
+}
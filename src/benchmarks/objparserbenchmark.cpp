@@ -0,0 +1,238 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*
+ * Compare obj_parser (std::function callbacks), obj_batch_parser (blocks of
+ * elements) and basic_obj_parser (static handler) on the same in-memory OBJ
+ * content.
+ *
+ * Usage : objparser_benchmark [file.obj] [runs]
+ * Without a file, a grid of 10 000 000 triangles with texture vertices and
+ * normals is generated in objparser_benchmark.obj (current directory).
+ */
+
+#include "fileloaders/objbasicparser.h"
+#include "fileloaders/objbatchparser.h"
+#include "fileloaders/mappedfile.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace Loaders;
+using namespace Loaders::Obj_mtl;
+
+namespace {
+
+const std::size_t default_number_of_faces = 10000000;
+
+bool generate(const std::string& filename, std::size_t number_of_faces)
+{
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    std::size_t n = std::size_t(std::ceil(std::sqrt(number_of_faces / 2.0))) + 1;
+    for (std::size_t j = 0; j < n; ++j) {
+        for (std::size_t i = 0; i < n; ++i) {
+            std::fprintf(file, "v %.6f %.6f %.6f\n", float(i) / n, float(j) / n, std::sin(float(i + j) / n));
+        }
+    }
+    for (std::size_t j = 0; j < n; ++j) {
+        for (std::size_t i = 0; i < n; ++i) {
+            std::fprintf(file, "vt %.6f %.6f\n", float(i) / n, float(j) / n);
+        }
+    }
+    for (std::size_t k = 0; k < n * n; ++k) {
+        std::fprintf(file, "vn 0 0 1\n");
+    }
+    std::size_t faces = 0;
+    for (std::size_t j = 0; j + 1 < n && faces < number_of_faces; ++j) {
+        for (std::size_t i = 0; i + 1 < n && faces < number_of_faces; ++i) {
+            std::size_t a = j * n + i + 1, b = a + 1, c = a + n, d = c + 1;
+            std::fprintf(file, "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", a, a, a, b, b, b, d, d, d);
+            if (++faces < number_of_faces) {
+                std::fprintf(file, "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", a, a, a, d, d, d, c, c, c);
+                ++faces;
+            }
+        }
+    }
+    return std::fclose(file) == 0;
+}
+
+// Same work for both parsers : sum everything so that nothing is optimized out.
+struct checksum_type {
+    checksum_type()
+        : coordinates(0)
+        , indices(0)
+    {
+    }
+    double coordinates;
+    unsigned long long indices;
+};
+
+class checksum_handler : public obj_handler {
+public:
+    explicit checksum_handler(checksum_type& checksum)
+        : checksum_(checksum)
+    {
+    }
+    void geometric_vertex(float_type x, float_type y, float_type z) { checksum_.coordinates += x + y + z; }
+    void texture_vertex(float_type u, float_type v) { checksum_.coordinates += u + v; }
+    void vertex_normal(float_type x, float_type y, float_type z) { checksum_.coordinates += x + y + z; }
+    void triangular_face_geometric_vertices(index_type v1, index_type v2, index_type v3) { checksum_.indices += v1 + v2 + v3; }
+    void triangular_face_geometric_vertices_texture_vertices(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3) { add(v1), add(v2), add(v3); }
+    void triangular_face_geometric_vertices_vertex_normals(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3) { add(v1), add(v2), add(v3); }
+    void triangular_face_geometric_vertices_texture_vertices_vertex_normals(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3) { add(v1), add(v2), add(v3); }
+
+private:
+    void add(const face_vertex_type& v) { checksum_.indices += v.v + v.vt + v.vn; }
+
+    checksum_type& checksum_;
+};
+
+bool parse_callbacks(const char* begin, const char* end, checksum_type& checksum)
+{
+    checksum_type* c = &checksum;
+    obj_parser parser(obj_parser::triangulate_faces);
+    parser.geometric_vertex_callback([c](float_type x, float_type y, float_type z) { c->coordinates += x + y + z; });
+    parser.texture_vertex_callback([c](float_type u, float_type v) { c->coordinates += u + v; });
+    parser.vertex_normal_callback([c](float_type x, float_type y, float_type z) { c->coordinates += x + y + z; });
+    parser.face_callbacks(
+        [c](index_type v1, index_type v2, index_type v3) { c->indices += v1 + v2 + v3; },
+        [c](const index_2_tuple_type& v1, const index_2_tuple_type& v2, const index_2_tuple_type& v3) {
+            c->indices += std::get<0>(v1) + std::get<1>(v1) + std::get<0>(v2) + std::get<1>(v2) + std::get<0>(v3) + std::get<1>(v3);
+        },
+        [c](const index_2_tuple_type& v1, const index_2_tuple_type& v2, const index_2_tuple_type& v3) {
+            c->indices += std::get<0>(v1) + std::get<1>(v1) + std::get<0>(v2) + std::get<1>(v2) + std::get<0>(v3) + std::get<1>(v3);
+        },
+        [c](const index_3_tuple_type& v1, const index_3_tuple_type& v2, const index_3_tuple_type& v3) {
+            c->indices += std::get<0>(v1) + std::get<1>(v1) + std::get<2>(v1) + std::get<0>(v2) + std::get<1>(v2) + std::get<2>(v2) + std::get<0>(v3) + std::get<1>(v3) + std::get<2>(v3);
+        },
+        obj_parser::quadrilateral_face_geometric_vertices_callback_type(),
+        obj_parser::quadrilateral_face_geometric_vertices_texture_vertices_callback_type(),
+        obj_parser::quadrilateral_face_geometric_vertices_vertex_normals_callback_type(),
+        obj_parser::quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals_callback_type());
+    return parser.parse(begin, end);
+}
+
+bool parse_blocks(const char* begin, const char* end, checksum_type& checksum)
+{
+    checksum_type* c = &checksum;
+    obj_batch_parser parser(obj_parser::triangulate_faces);
+    parser.geometric_vertices_callback([c](const float_type* xyz, std::size_t count) {
+        for (std::size_t i = 0; i < 3 * count; i += 3) {
+            c->coordinates += xyz[i] + xyz[i + 1] + xyz[i + 2];
+        }
+    });
+    parser.texture_vertices_callback([c](const float_type* uv, std::size_t count) {
+        for (std::size_t i = 0; i < 2 * count; i += 2) {
+            c->coordinates += uv[i] + uv[i + 1];
+        }
+    });
+    parser.vertex_normals_callback([c](const float_type* xyz, std::size_t count) {
+        for (std::size_t i = 0; i < 3 * count; i += 3) {
+            c->coordinates += xyz[i] + xyz[i + 1] + xyz[i + 2];
+        }
+    });
+    parser.faces_callback([c](const face_block& faces) {
+        std::size_t corners = 0;
+        for (std::size_t i = 0; i < faces.size; ++i) {
+            corners += faces.corners[i];
+        }
+        for (std::size_t i = 0; i < corners; ++i) {
+            c->indices += faces.v[i] + faces.vt[i] + faces.vn[i];
+        }
+    });
+    return parser.parse(begin, end);
+}
+
+bool parse_handler(const char* begin, const char* end, checksum_type& checksum)
+{
+    checksum_handler handler(checksum);
+    basic_obj_parser<checksum_handler> parser(handler, obj_parser::triangulate_faces);
+    return parser.parse(begin, end);
+}
+
+// Best time of runs parses, in seconds.
+template <typename Parse>
+double measure(const Parse& parse, const MappedFile& file, int runs, checksum_type& checksum)
+{
+    double best = 0;
+    for (int run = 0; run < runs; ++run) {
+        checksum = checksum_type();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (!parse(file.begin(), file.end(), checksum)) {
+            std::cerr << "parse error" << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (run == 0 || seconds < best) {
+            best = seconds;
+        }
+    }
+    return best;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::string filename = (argc > 1) ? argv[1] : "objparser_benchmark.obj";
+    int runs = (argc > 2) ? std::atoi(argv[2]) : 3;
+    if (runs < 1) {
+        runs = 1;
+    }
+
+    MappedFile file;
+    if (argc <= 1 && !file.open(filename)) {
+        std::cout << "Generating " << filename << " (" << default_number_of_faces << " faces)" << std::endl;
+        if (!generate(filename, default_number_of_faces)) {
+            std::cerr << "can't write " << filename << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (!file.isOpen() && !file.open(filename)) {
+        std::cerr << "can't map " << filename << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    checksum_type callbacks_checksum, blocks_checksum, handler_checksum;
+    double callbacks_time = measure(parse_callbacks, file, runs, callbacks_checksum);
+    double blocks_time = measure(parse_blocks, file, runs, blocks_checksum);
+    double handler_time = measure(parse_handler, file, runs, handler_checksum);
+
+    double megabytes = file.size() / (1024.0 * 1024.0);
+    std::cout << filename << " : " << megabytes << " MB, best of " << runs << " runs" << std::endl;
+    std::cout << "obj_parser (std::function)        : " << callbacks_time << " s, " << megabytes / callbacks_time << " MB/s" << std::endl;
+    std::cout << "obj_batch_parser (blocks)         : " << blocks_time << " s, " << megabytes / blocks_time << " MB/s" << std::endl;
+    std::cout << "basic_obj_parser (static handler) : " << handler_time << " s, " << megabytes / handler_time << " MB/s" << std::endl;
+    std::cout << "speedup (static handler) : " << callbacks_time / handler_time << std::endl;
+
+    if (callbacks_checksum.indices != handler_checksum.indices || callbacks_checksum.coordinates != handler_checksum.coordinates
+        || callbacks_checksum.indices != blocks_checksum.indices || callbacks_checksum.coordinates != blocks_checksum.coordinates) {
+        std::cerr << "results differ" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,307 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*
+ * Conformance of the obj_parser entry points : an edge case corpus (CRLF,
+ * no final newline, '\' at the end of a line, comments at the end of the
+ * file, empty file, blank lines...) is parsed by parse(std::istream&),
+ * parse(const char*, const char*) and the push mode (feed, finish), with
+ * and without the parse options. The calls of all the callbacks (values,
+ * float bits, line numbers and messages) must be the same, and so must be
+ * the result, except for a content that does not end with a newline : the
+ * stream parse returns false (std::getline did not fail), the other ones
+ * true. Only the line of an error is compared, not its message.
+ *
+ * Usage : objparser_conformance [file.obj ...]
+ * The files given are checked too, parse(const std::string&) being the
+ * mapped path. Returns EXIT_FAILURE on error.
+ */
+
+#include "fileloaders/objfileparser.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Loaders;
+using namespace Loaders::Obj_mtl;
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const std::string& message)
+{
+    if (!condition) {
+        std::cout << "FAILED : " << message << std::endl;
+        ++failures;
+    }
+}
+
+// the content of a case
+struct corpus_entry {
+    const char* name;
+    std::string content;
+};
+
+std::vector<corpus_entry> corpus()
+{
+    const std::string model = "# cube corner\n"
+                              "mtllib model.mtl\n"
+                              "o corner\n"
+                              "v 0 0 0\nv 1.5 0 0\nv 0 -2.25e-1 0\nv 0 0 1e3\nv 1 1 1\n"
+                              "vt 0 0\nvt 1 0 0\nvt .5 1\n"
+                              "vn 0 0 1\nvn 0 1 0\n"
+                              "\n"
+                              "g side\ns 1\nusemtl red\n"
+                              "f 1 2 3\nf 1/1 2/2 3/3\nf 1//1 2//1 -1//2\nf 1/1/1 2/2/1 3/3/2\n"
+                              "f 1 2 3 4\nf -5 -4 -3 -2 -1\nf 1/1/1 2/2/1 3/3/2 4/1/2 5/2/1\n"
+                              "g\ns off\n\t \n"
+                              "fo 1 2 4\n"
+                              "vp 0.5\ncstype bezier\n"
+                              "# last line\n";
+    std::vector<corpus_entry> entries;
+    entries.push_back(corpus_entry{ "empty file", "" });
+    entries.push_back(corpus_entry{ "newline only", "\n" });
+    entries.push_back(corpus_entry{ "blank lines", "\n \n\t\n\n" });
+    entries.push_back(corpus_entry{ "model", model });
+    std::string crlf;
+    for (std::size_t c = 0; c < model.size(); ++c) {
+        crlf += (model[c] == '\n') ? "\r\n" : std::string(1, model[c]);
+    }
+    entries.push_back(corpus_entry{ "model, CRLF", crlf });
+    entries.push_back(corpus_entry{ "model, no final newline", model + "f 1 2 5" });
+    entries.push_back(corpus_entry{ "model, CRLF, no final newline", crlf + "f 1 2 5\r" });
+    entries.push_back(corpus_entry{ "comment at the end, no final newline", model + "# end" });
+    entries.push_back(corpus_entry{ "comment at the end, CRLF", crlf + "# end\r\n" });
+    entries.push_back(corpus_entry{ "blank line at the end", model + "  \t" });
+    entries.push_back(corpus_entry{ "no newline at all", "v 1 2 3" });
+    entries.push_back(corpus_entry{ "comment only, no newline", "# comment" });
+    entries.push_back(corpus_entry{ "continuation of a face", "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 \\\n3\n" });
+    entries.push_back(corpus_entry{ "continuation of a vertex", "v 0 0 \\\n0\n" });
+    entries.push_back(corpus_entry{ "continuation at the end", "v 0 0 0 \\" });
+    entries.push_back(corpus_entry{ "continuation of a comment", "# a \\\nv 0 0 0\n" });
+    entries.push_back(corpus_entry{ "other white spaces", "v\t1\v2\f3\r\nvn 0  0\t\t1 \n" });
+    entries.push_back(corpus_entry{ "long numbers", "v 1.00000000000000000000001 -3.4028234e38 1.4e-45\nv 123456789012345678901234567890 0.1 16777217\n" });
+    entries.push_back(corpus_entry{ "smoothing groups", "s 0\ns 12\ns off\ns on\n" });
+    entries.push_back(corpus_entry{ "names", "g a\ng a b\n" });
+    entries.push_back(corpus_entry{ "missing coordinate", "v 1 2\n" });
+    entries.push_back(corpus_entry{ "missing normal coordinate", "vn 0 1\n" });
+    entries.push_back(corpus_entry{ "missing texture coordinate", "vt 0\n" });
+    entries.push_back(corpus_entry{ "missing face vertex", "v 0 0 0\nf 1 1\n" });
+    entries.push_back(corpus_entry{ "missing face texture vertex", "v 0 0 0\nvt 0 0\nf 1/1 1/1 1/\n" });
+    entries.push_back(corpus_entry{ "missing names", "o\nusemtl\nmtllib\ns\n" });
+    entries.push_back(corpus_entry{ "index out of bounds", "v 0 0 0\nf 1 1 2\n" });
+    entries.push_back(corpus_entry{ "relative index out of bounds", "v 0 0 0\nf 1 1 -2\n" });
+    entries.push_back(corpus_entry{ "mixed face formats", "v 0 0 0\nvt 0 0\nf 1/1 1 1\n" });
+    entries.push_back(corpus_entry{ "garbage after a face", "v 0 0 0\nf 1 1 1 x\n" });
+    return entries;
+}
+
+// the calls of the callbacks of a parser
+struct recorder {
+    std::vector<std::string> calls;
+
+    void add(const std::string& call) { calls.push_back(call); }
+
+    static std::string bits(float_type f)
+    {
+        unsigned int u;
+        std::memcpy(&u, &f, sizeof(u));
+        char buffer[16];
+        std::snprintf(buffer, sizeof(buffer), "%08x", u);
+        return buffer;
+    }
+    static std::string index(const index_2_tuple_type& v) { return std::to_string(std::get<0>(v)) + "/" + std::to_string(std::get<1>(v)); }
+    static std::string index(const index_3_tuple_type& v)
+    {
+        return std::to_string(std::get<0>(v)) + "/" + std::to_string(std::get<1>(v)) + "/" + std::to_string(std::get<2>(v));
+    }
+
+    void attach(obj_parser& parser)
+    {
+        typedef const index_2_tuple_type& i2;
+        typedef const index_3_tuple_type& i3;
+        using std::to_string;
+        parser.info_callback([this](std::size_t l, const std::string& m) { add("info " + to_string(l) + " " + m); });
+        parser.warning_callback([this](std::size_t l, const std::string& m) { add("warning " + to_string(l) + " " + m); });
+        parser.error_callback([this](std::size_t l, const std::string& m) { add("error " + to_string(l) + " " + m); });
+        parser.geometric_vertex_callback([this](float_type x, float_type y, float_type z) { add("v " + bits(x) + " " + bits(y) + " " + bits(z)); });
+        parser.texture_vertex_callback([this](float_type u, float_type v) { add("vt " + bits(u) + " " + bits(v)); });
+        parser.vertex_normal_callback([this](float_type x, float_type y, float_type z) { add("vn " + bits(x) + " " + bits(y) + " " + bits(z)); });
+        parser.face_callbacks(
+            [this](index_type a, index_type b, index_type c) { add("f3 " + to_string(a) + " " + to_string(b) + " " + to_string(c)); },
+            [this](i2 a, i2 b, i2 c) { add("f3 " + index(a) + " " + index(b) + " " + index(c)); },
+            [this](i2 a, i2 b, i2 c) { add("f3n " + index(a) + " " + index(b) + " " + index(c)); },
+            [this](i3 a, i3 b, i3 c) { add("f3 " + index(a) + " " + index(b) + " " + index(c)); },
+            [this](index_type a, index_type b, index_type c, index_type d) {
+                add("f4 " + to_string(a) + " " + to_string(b) + " " + to_string(c) + " " + to_string(d));
+            },
+            [this](i2 a, i2 b, i2 c, i2 d) { add("f4 " + index(a) + " " + index(b) + " " + index(c) + " " + index(d)); },
+            [this](i2 a, i2 b, i2 c, i2 d) { add("f4n " + index(a) + " " + index(b) + " " + index(c) + " " + index(d)); },
+            [this](i3 a, i3 b, i3 c, i3 d) { add("f4 " + index(a) + " " + index(b) + " " + index(c) + " " + index(d)); });
+        parser.polygonal_face_callbacks(
+            [this](index_type a, index_type b, index_type c) { add("fn " + to_string(a) + " " + to_string(b) + " " + to_string(c)); },
+            [this](index_type a) { add("fn+ " + to_string(a)); }, [this]() { add("fn end"); },
+            [this](i2 a, i2 b, i2 c) { add("fn " + index(a) + " " + index(b) + " " + index(c)); }, [this](i2 a) { add("fn+ " + index(a)); },
+            [this]() { add("fn end"); },
+            [this](i2 a, i2 b, i2 c) { add("fnn " + index(a) + " " + index(b) + " " + index(c)); }, [this](i2 a) { add("fnn+ " + index(a)); },
+            [this]() { add("fnn end"); },
+            [this](i3 a, i3 b, i3 c) { add("fn " + index(a) + " " + index(b) + " " + index(c)); }, [this](i3 a) { add("fn+ " + index(a)); },
+            [this]() { add("fn end"); });
+        parser.group_name_callback([this](const std::string& name) { add("g " + name); });
+        parser.smoothing_group_callback([this](size_type group) { add("s " + std::to_string(group)); });
+        parser.object_name_callback([this](const std::string& name) { add("o " + name); });
+        parser.material_library_callback([this](const std::string& name) { add("mtllib " + name); });
+        parser.material_name_callback([this](const std::string& name) { add("usemtl " + name); });
+        parser.comment_callback([this](const std::string& comment) { add("comment " + comment); });
+    }
+};
+
+// calls and result of a parse
+struct parse_result {
+    std::vector<std::string> calls;
+    bool result;
+};
+
+template <typename Parse>
+parse_result record(obj_parser::flags_type flags, Parse parse)
+{
+    recorder calls;
+    obj_parser parser(flags);
+    calls.attach(parser);
+    parse_result result;
+    result.result = parse(parser);
+    result.calls = calls.calls;
+    return result;
+}
+
+parse_result parse_stream(const std::string& content, obj_parser::flags_type flags)
+{
+    return record(flags, [&](obj_parser& parser) {
+        std::istringstream stream(content);
+        return parser.parse(stream);
+    });
+}
+
+parse_result parse_memory(const std::string& content, obj_parser::flags_type flags)
+{
+    return record(flags, [&](obj_parser& parser) {
+        // exact size copy, a read past the end is caught by the address
+        // sanitizer
+        std::vector<char> buffer(content.begin(), content.end());
+        return parser.parse(buffer.data(), buffer.data() + buffer.size());
+    });
+}
+
+parse_result parse_push(const std::string& content, obj_parser::flags_type flags, std::size_t block)
+{
+    return record(flags, [&](obj_parser& parser) {
+        bool result = true;
+        for (std::size_t b = 0; b < content.size() && result; b += block) {
+            result = parser.feed(content.data() + b, std::min(block, content.size() - b));
+        }
+        return parser.finish() && result;
+    });
+}
+
+// errors on the same line are the same call : the stream parse reads a
+// non-numeric face index as 0 and reports it as out of bounds, the other
+// ones as a parse error
+bool same_call(const std::string& expected, const std::string& call)
+{
+    if (expected.compare(0, 6, "error ") == 0 && call.compare(0, 6, "error ") == 0) {
+        return expected.substr(0, expected.find(' ', 6)) == call.substr(0, call.find(' ', 6));
+    }
+    return expected == call;
+}
+
+// first difference between two lists of calls
+std::string difference(const std::vector<std::string>& expected, const std::vector<std::string>& calls)
+{
+    std::size_t c = 0;
+    while (c < expected.size() && c < calls.size() && same_call(expected[c], calls[c])) {
+        ++c;
+    }
+    if (c == expected.size() && c == calls.size()) {
+        return "";
+    }
+    std::string first = (c < expected.size()) ? expected[c] : "(none)";
+    std::string second = (c < calls.size()) ? calls[c] : "(none)";
+    return ", call " + std::to_string(c) + " : \"" + first + "\" instead of \"" + second + "\"";
+}
+
+void compare(const std::string& name, const parse_result& stream, const parse_result& other, bool expected_result)
+{
+    std::string calls = difference(stream.calls, other.calls);
+    check(calls.empty(), name + " : calls" + calls);
+    check(other.result == expected_result, name + " : result");
+}
+
+void check_content(const std::string& name, const std::string& content)
+{
+    const obj_parser::flags_type options[] = { 0, obj_parser::parse_blank_lines_as_comment | obj_parser::triangulate_faces | obj_parser::translate_negative_indices };
+    for (int o = 0; o < 2; ++o) {
+        std::string label = name + (o ? " (options)" : "");
+        parse_result stream = parse_stream(content, options[o]);
+        // the stream parse fails on a last line without newline
+        bool expected = stream.result || (!content.empty() && content[content.size() - 1] != '\n' && stream.calls.size() && stream.calls.back().compare(0, 5, "info ") == 0);
+        compare(label + ", memory", stream, parse_memory(content, options[o]), expected);
+        compare(label + ", push by 1", stream, parse_push(content, options[o], 1), expected);
+        compare(label + ", push by 7", stream, parse_push(content, options[o], 7), expected);
+    }
+}
+
+void check_file(const std::string& filename)
+{
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if (!file) {
+        check(false, "can't read " + filename);
+        return;
+    }
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    check_content(filename, content);
+    parse_result stream = parse_stream(content, 0);
+    parse_result mapped = record(0, [&](obj_parser& parser) { return parser.parse(filename); });
+    bool expected = stream.result || (!content.empty() && content[content.size() - 1] != '\n' && stream.calls.size() && stream.calls.back().compare(0, 5, "info ") == 0);
+    compare(filename + ", mapped file", stream, mapped, expected);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<corpus_entry> entries = corpus();
+    for (std::size_t e = 0; e < entries.size(); ++e) {
+        check_content(entries[e].name, entries[e].content);
+    }
+    for (int a = 1; a < argc; ++a) {
+        check_file(argv[a]);
+    }
+    std::cout << entries.size() << " cases, " << argc - 1 << " files" << std::endl;
+    std::cout << (failures ? "FAILED" : "ok") << std::endl;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
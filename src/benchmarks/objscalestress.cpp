@@ -0,0 +1,356 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*
+ * Stress test of the 64 bits indices and of the split of large groups,
+ * without multi-GB files :
+ * - index boundary : faces parsed after 2^31 - 1 to 3 * 2^31 preceding
+ *   vertices (Obj_mtl::obj_parser::statistics of the preceding parts), with
+ *   absolute, relative and out of bounds indices, by the SIMD and the scalar
+ *   paths of the tokenizer ;
+ * - long indices : indices of 17 digits and more (leading zeros included),
+ *   longer than a SIMD window, parsed as strtoll ;
+ * - mesh split : a generated grid loaded with the smallest meshes
+ *   (ObjLoader::setMaxMeshSize(65536, 65536)), each mesh must fit 16 bits
+ *   indices and the meshes must give the triangles, area and normals of
+ *   the unsplit load.
+ *
+ * Usage : objscale_stress [grid size] [threads]
+ * The grid (default 600 x 600 vertices) is generated in
+ * objscale_stress.obj (current directory). Returns EXIT_FAILURE on error.
+ */
+
+#include "fileloaders/objbasicparser.h"
+#include "fileloaders/objloader.h"
+#include "fileloaders/objtokenizer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace Loaders;
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const std::string& message)
+{
+    if (!condition) {
+        std::cout << "FAILED : " << message << std::endl;
+        ++failures;
+    }
+}
+
+// triangles and errors of a parse
+struct face_recorder : Obj_mtl::obj_handler {
+    std::vector<Obj_mtl::index_type> v;
+    std::size_t errors;
+
+    face_recorder()
+        : errors(0)
+    {
+    }
+    void error(std::size_t, const std::string&) { ++errors; }
+    void triangular_face_geometric_vertices(Obj_mtl::index_type v1, Obj_mtl::index_type v2, Obj_mtl::index_type v3)
+    {
+        v.push_back(v1);
+        v.push_back(v2);
+        v.push_back(v3);
+    }
+    void triangular_face_geometric_vertices_vertex_normals(const Obj_mtl::face_vertex_type& v1, const Obj_mtl::face_vertex_type& v2, const Obj_mtl::face_vertex_type& v3)
+    {
+        v.push_back(v1.v);
+        v.push_back(v2.vn);
+        v.push_back(v3.v);
+    }
+};
+
+// face line parsed after "count" vertices and normals : indices given to
+// the handler, empty on error. Padding after the line lets the tokenizer
+// take its SIMD path.
+std::vector<Obj_mtl::index_type> parse_face(const std::string& line, std::size_t count, bool padding)
+{
+    std::string content = line + "\n";
+    if (padding) {
+        content += "# " + std::string(126, '-') + "\n";
+    }
+    face_recorder recorder;
+    Obj_mtl::basic_obj_parser<face_recorder> parser(recorder, Obj_mtl::obj_parser::translate_negative_indices);
+    Obj_mtl::obj_parser::statistics statistics;
+    statistics.number_of_geometric_vertices = count;
+    statistics.number_of_vertex_normals = count;
+    bool parsed = parser.parse(content.data(), content.data() + content.size(), statistics);
+    if (!parsed || recorder.errors != 0) {
+        return std::vector<Obj_mtl::index_type>();
+    }
+    return recorder.v;
+}
+
+void check_indices(std::size_t count)
+{
+    const Obj_mtl::index_type last = Obj_mtl::index_type(count);
+    const std::string n = std::to_string(count);
+    for (int padding = 0; padding < 2; ++padding) {
+        std::string path = std::string(padding ? " (SIMD)" : " (scalar)") + " after " + n + " vertices";
+        std::vector<Obj_mtl::index_type> face = parse_face("f " + n + " 1 -1", count, padding != 0);
+        check(face.size() == 3 && face[0] == last && face[1] == 1 && face[2] == last, "absolute and relative indices" + path);
+        face = parse_face("f -" + n + " " + std::to_string(count - 1) + " -2", count, padding != 0);
+        check(face.size() == 3 && face[0] == 1 && face[1] == last - 1 && face[2] == last - 1, "relative indices" + path);
+        face = parse_face("f 1//" + n + " 2//-1 -3//1", count, padding != 0);
+        check(face.size() == 3 && face[0] == 1 && face[1] == last && face[2] == last - 2, "vertex normals" + path);
+        check(parse_face("f 1 2 " + std::to_string(count + 1), count, padding != 0).empty(), "index past the end" + path);
+        check(parse_face("f 1 2 -" + std::to_string(count + 1), count, padding != 0).empty(), "relative index before the start" + path);
+    }
+}
+
+// index followed by other tokens on its line, with and without the padding
+// that lets the tokenizer take its SIMD path : same value and same length
+// as strtoll, failure on overflow
+void check_long_index(const std::string& index)
+{
+    errno = 0;
+    char* expected_end = 0;
+    long long expected = std::strtoll(index.c_str(), &expected_end, 10);
+    bool overflow = (errno == ERANGE);
+    for (int padding = 0; padding < 2; ++padding) {
+        std::string content = index + " 1 2";
+        const std::size_t line = content.size();
+        content += "\n";
+        if (padding) {
+            content += "# " + std::string(126, '-') + "\n";
+        }
+        const char* p = content.data();
+        Obj_mtl::index_type value = 0;
+        bool parsed = Obj_mtl::tokenizer::parse_index(p, content.data() + line, value, content.data() + content.size());
+        std::string path = std::string(padding ? " (SIMD)" : " (scalar)") + " : " + index;
+        if (overflow) {
+            check(!parsed, "long index overflow" + path);
+        } else {
+            check(parsed && value == expected && p - content.data() == expected_end - index.c_str(), "long index" + path);
+        }
+    }
+}
+
+void check_long_indices()
+{
+    const char* indices[] = { "064243924261538508", "1234567890123456", "12345678901234567", "00000000000000001",
+                              "-00000000000000000123", "+0000000000000000000000000000000042", "9223372036854775807",
+                              "-9223372036854775808", "9223372036854775808", "00000000000000000000009223372036854775808" };
+    for (std::size_t i = 0; i < sizeof(indices) / sizeof(indices[0]); ++i) {
+        check_long_index(indices[i]);
+    }
+    // 1 to 40 digits, leading zeros included
+    unsigned long long state = 12345;
+    for (int i = 0; i < 20000; ++i) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        std::size_t digits = 1 + (state >> 33) % 40;
+        std::size_t zeros = (state >> 20) % (digits + 1);
+        std::string index((state >> 60) & 1 ? "-" : "");
+        for (std::size_t d = 0; d < digits; ++d) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            index += char('0' + (d < zeros ? 0 : (state >> 33) % 10));
+        }
+        check_long_index(index);
+    }
+}
+
+bool generate(const std::string& filename, std::size_t n)
+{
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    for (std::size_t j = 0; j < n; ++j) {
+        for (std::size_t i = 0; i < n; ++i) {
+            float x = float(i) / (n - 1), y = float(j) / (n - 1);
+            std::fprintf(file, "v %.6f %.6f %.6f\n", x, y, 0.25f * std::sin(3.f * x) * std::cos(2.f * y));
+        }
+    }
+    // welded quadrilaterals with computed normals, then faces that are not
+    // welded (smoothing group 0)
+    std::fprintf(file, "g welded\ns 1\n");
+    for (std::size_t j = 0; j + 1 < n; ++j) {
+        for (std::size_t i = 0; i + 1 < n; ++i) {
+            std::size_t a = j * n + i + 1, b = a + 1, c = a + n, d = c + 1;
+            std::fprintf(file, "f %zu %zu %zu %zu\n", a, b, d, c);
+        }
+    }
+    std::fprintf(file, "g flat\ns off\n");
+    for (std::size_t j = 0; j + 1 < n; j += 2) {
+        for (std::size_t i = 0; i + 1 < n; ++i) {
+            std::size_t a = j * n + i + 1, b = a + 1, c = a + n;
+            std::fprintf(file, "f %zu %zu %zu\n", a, b, c);
+        }
+    }
+    return std::fclose(file) == 0;
+}
+
+// meshes of a loader and the name of their group
+struct named_meshes : MeshArraySink {
+    std::vector<Mesh*> meshes;
+    std::vector<std::string> names;
+
+    named_meshes()
+        : MeshArraySink(meshes)
+    {
+    }
+    ~named_meshes()
+    {
+        for (std::size_t m = 0; m < meshes.size(); ++m) {
+            delete meshes[m];
+        }
+    }
+    void beginMesh(const std::string& name, std::size_t nbVertices, std::size_t nbTriangles, float*& vertices, unsigned int*& triangles)
+    {
+        names.push_back(name);
+        MeshArraySink::beginMesh(name, nbVertices, nbTriangles, vertices, triangles);
+    }
+
+    std::size_t triangles() const
+    {
+        std::size_t triangles = 0;
+        for (std::size_t m = 0; m < meshes.size(); ++m) {
+            triangles += meshes[m]->nbTriangles();
+        }
+        return triangles;
+    }
+    double area() const
+    {
+        double area = 0.;
+        for (std::size_t m = 0; m < meshes.size(); ++m) {
+            const float* vertices = meshes[m]->vertexData();
+            const unsigned int* triangles = meshes[m]->triangleData();
+            for (std::size_t t = 0; t < 3 * meshes[m]->nbTriangles(); t += 3) {
+                glm::vec3 p[3];
+                for (int c = 0; c < 3; ++c) {
+                    const float* v = vertices + 8 * std::size_t(triangles[t + c]);
+                    p[c] = glm::vec3(v[0], v[1], v[2]);
+                }
+                area += 0.5 * glm::length(glm::cross(p[1] - p[0], p[2] - p[0]));
+            }
+        }
+        return area;
+    }
+};
+
+void load(const std::string& filename, std::size_t max_size, unsigned threads, named_meshes& result)
+{
+    Obj_mtl::ObjLoader loader;
+    loader.setCacheEnabled(false);
+    loader.setThreadCount(threads);
+    if (max_size) {
+        loader.setMaxMeshSize(max_size, max_size);
+    }
+    QString reason;
+    if (!loader.load(QString(filename.c_str()), reason)) {
+        std::cerr << "can't load " << filename << " : " << reason.toStdString() << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    std::vector<const Obj_mtl::ObjLoader::mtlMaterial*> materials;
+    loader.getObjects(result, materials);
+}
+
+void check_split(std::size_t n, unsigned threads)
+{
+    const std::string filename = "objscale_stress.obj";
+    if (!generate(filename, n)) {
+        std::cerr << "can't write " << filename << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    named_meshes whole, split;
+    load(filename, 0, threads, whole);
+    load(filename, 65536, threads, split);
+    std::remove(filename.c_str());
+
+    std::cout << n * n << " vertices grid : " << whole.meshes.size() << " meshes, " << split.meshes.size()
+              << " meshes of at most 65536 vertices and triangles" << std::endl;
+    check(whole.meshes.size() == 2, "one mesh per group without split");
+    check(split.meshes.size() > 2 * whole.meshes.size(), "large groups split");
+    check(split.triangles() == whole.triangles(), "triangles of the split meshes");
+    check(std::fabs(split.area() - whole.area()) <= 1e-6 * whole.area(), "area of the split meshes");
+
+    // computed normals of the welded group : the vertices duplicated in
+    // several meshes have the normal of all their triangles
+    typedef std::tuple<float, float, float> position;
+    std::map<position, glm::vec3> normals;
+    std::size_t welded_vertices = 0;
+    for (std::size_t m = 0; m < whole.meshes.size(); ++m) {
+        if (whole.names[m] == "welded") {
+            for (std::size_t i = 0; i < whole.meshes[m]->nbVertices(); ++i) {
+                const float* v = whole.meshes[m]->vertexData() + 8 * i;
+                normals[position(v[0], v[1], v[2])] = glm::normalize(glm::vec3(v[3], v[4], v[5]));
+            }
+            welded_vertices += whole.meshes[m]->nbVertices();
+        }
+    }
+    std::size_t split_vertices = 0;
+    float normal_error = 0.f;
+    for (std::size_t m = 0; m < split.meshes.size(); ++m) {
+        const Mesh& mesh = *split.meshes[m];
+        check(mesh.nbVertices() <= 65536 && mesh.nbTriangles() <= 65536, "mesh size");
+        bool local = true;
+        for (std::size_t t = 0; t < 3 * mesh.nbTriangles(); ++t) {
+            local = local && mesh.triangleData()[t] < mesh.nbVertices();
+        }
+        check(local, "16 bits local indices");
+        if (split.names[m] != "welded") {
+            continue;
+        }
+        split_vertices += mesh.nbVertices();
+        for (std::size_t i = 0; i < mesh.nbVertices(); ++i) {
+            const float* v = mesh.vertexData() + 8 * i;
+            glm::vec3 normal = glm::normalize(glm::vec3(v[3], v[4], v[5]));
+            normal_error = std::max(normal_error, glm::length(normal - normals[position(v[0], v[1], v[2])]));
+        }
+    }
+    std::cout << split_vertices - welded_vertices << " welded vertices duplicated, normals error " << normal_error << std::endl;
+    check(split_vertices > welded_vertices, "welded vertices duplicated between the meshes");
+    check(normal_error < 1e-4f, "normals of the duplicated vertices");
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t n = (argc > 1) ? std::size_t(std::atol(argv[1])) : 600;
+    unsigned threads = (argc > 2) ? unsigned(std::atoi(argv[2])) : 0;
+
+    const std::size_t boundaries[] = { (std::size_t(1) << 31) - 1, std::size_t(1) << 31, (std::size_t(1) << 31) + 1,
+                                       (std::size_t(1) << 32) - 1, std::size_t(1) << 32, (std::size_t(1) << 32) + 1,
+                                       3 * (std::size_t(1) << 31) };
+    for (std::size_t b = 0; b < sizeof(boundaries) / sizeof(boundaries[0]); ++b) {
+        check_indices(boundaries[b]);
+    }
+    check(parse_face("f 1 2 9223372036854775808", std::size_t(1) << 40, false).empty(), "index overflow");
+    check_long_indices();
+
+    check_split(n, threads);
+
+    std::cout << (failures ? "FAILED" : "ok") << std::endl;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,226 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*
+ * Throughput of SceneLoader on a scene of many small OBJ files sharing a few
+ * material libraries, compared with one ObjLoader per file (each file parses
+ * its own material libraries).
+ *
+ * Usage : objscene_benchmark [files] [threads] [runs]
+ * The scene (1000 files of 800 triangles, 4 material libraries of 16
+ * materials by default) is generated in objscene_benchmark/ (current
+ * directory). The binary cache is disabled.
+ */
+
+#include "fileloaders/objsceneloader.h"
+#include "fileloaders/parallel.h"
+
+#include <QDir>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace Loaders;
+
+namespace {
+
+const std::string scene_dir = "objscene_benchmark";
+const std::size_t default_number_of_files = 1000;
+const std::size_t number_of_libraries = 4;
+const std::size_t materials_per_library = 16;
+const std::size_t grid_size = 21;
+
+std::string library_name(std::size_t l)
+{
+    return "library" + std::to_string(l) + ".mtl";
+}
+
+bool generate_library(const std::string& filename, std::size_t l)
+{
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    for (std::size_t m = 0; m < materials_per_library; ++m) {
+        float t = float(m) / materials_per_library;
+        std::fprintf(file, "newmtl material%zu_%zu\n", l, m);
+        std::fprintf(file, "Ka 0.1 0.1 0.1\nKd %.3f %.3f %.3f\nKs 0.5 0.5 0.5\nNs %.1f\nd 1\nillum 2\n", t, 1 - t, 0.5f, 10 + 5 * t);
+        std::fprintf(file, "map_Kd texture%zu_%zu.png\n\n", l, m);
+    }
+    return std::fclose(file) == 0;
+}
+
+// two groups (two materials) of a grid with normals and texture vertices
+bool generate_model(const std::string& filename, std::size_t f)
+{
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    std::size_t l = f % number_of_libraries, l2 = (f + 1) % number_of_libraries;
+    std::fprintf(file, "mtllib %s\nmtllib %s\n", library_name(l).c_str(), library_name(l2).c_str());
+    const std::size_t n = grid_size;
+    for (std::size_t j = 0; j < n; ++j) {
+        for (std::size_t i = 0; i < n; ++i) {
+            std::fprintf(file, "v %.6f %.6f %.6f\n", float(i) / n + f, float(j) / n, std::sin(float(i + j + f) / n));
+            std::fprintf(file, "vt %.6f %.6f\n", float(i) / n, float(j) / n);
+            std::fprintf(file, "vn %.4f %.4f 1\n", std::cos(float(i) / n), std::sin(float(j) / n));
+        }
+    }
+    for (int g = 0; g < 2; ++g) {
+        std::fprintf(file, "g part%d\nusemtl material%zu_%zu\ns 1\n", g, g ? l2 : l, (f + g) % materials_per_library);
+        for (std::size_t j = g * (n - 1) / 2; j < (g + 1) * (n - 1) / 2; ++j) {
+            for (std::size_t i = 0; i + 1 < n; ++i) {
+                std::size_t a = j * n + i + 1, b = a + 1, c = a + n, d = c + 1;
+                std::fprintf(file, "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", a, a, a, b, b, b, d, d, d);
+                std::fprintf(file, "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", a, a, a, d, d, d, c, c, c);
+            }
+        }
+    }
+    return std::fclose(file) == 0;
+}
+
+bool generate(std::vector<QString>& filenames, std::size_t number_of_files)
+{
+    if (!QDir().mkpath(QString(scene_dir.c_str()))) {
+        return false;
+    }
+    for (std::size_t l = 0; l < number_of_libraries; ++l) {
+        if (!generate_library(scene_dir + "/" + library_name(l), l)) {
+            return false;
+        }
+    }
+    for (std::size_t f = 0; f < number_of_files; ++f) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "/model%04zu.obj", f);
+        std::string filename = scene_dir + name;
+        if (!generate_model(filename, f)) {
+            return false;
+        }
+        filenames.push_back(QString(filename.c_str()));
+    }
+    return true;
+}
+
+struct Statistics {
+    std::size_t loaded;
+    std::size_t triangles;
+    std::size_t materials;
+};
+
+// frees the meshes
+Statistics statistics(std::vector<Obj_mtl::SceneLoader::Model>& models)
+{
+    Statistics result = { 0, 0, 0 };
+    for (std::size_t f = 0; f < models.size(); ++f) {
+        if (models[f].loaded) {
+            result.loaded++;
+        }
+        for (std::size_t m = 0; m < models[f].meshes.size(); ++m) {
+            result.triangles += models[f].meshes[m]->nbTriangles();
+            if (models[f].materials[m]) {
+                result.materials++;
+            }
+            delete models[f].meshes[m];
+        }
+    }
+    return result;
+}
+
+double seconds_since(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t number_of_files = (argc > 1) ? std::size_t(std::atoi(argv[1])) : default_number_of_files;
+    unsigned threads = (argc > 2) ? unsigned(std::atoi(argv[2])) : 0;
+    int runs = (argc > 3) ? std::atoi(argv[3]) : 3;
+    if (runs < 1) {
+        runs = 1;
+    }
+
+    std::vector<QString> filenames;
+    std::cout << "Generating " << number_of_files << " files in " << scene_dir << std::endl;
+    if (!generate(filenames, number_of_files)) {
+        std::cerr << "can't write " << scene_dir << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // one ObjLoader per file, sequential
+    double best_single = 0;
+    Statistics single = { 0, 0, 0 };
+    for (int run = 0; run < runs; ++run) {
+        std::vector<Obj_mtl::SceneLoader::Model> models(filenames.size());
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (std::size_t f = 0; f < filenames.size(); ++f) {
+            Obj_mtl::ObjLoader loader;
+            loader.setThreadCount(1);
+            loader.setCacheEnabled(false);
+            models[f].loaded = loader.load(filenames[f], models[f].reason);
+            loader.getObjects(models[f].meshes, models[f].materials);
+        }
+        double time = seconds_since(start);
+        // the materials belong to the loaders : only counted
+        single = statistics(models);
+        if (run == 0 || time < best_single) {
+            best_single = time;
+        }
+    }
+
+    // SceneLoader : concurrent loads, shared material libraries
+    double best_scene = 0;
+    Statistics scene = { 0, 0, 0 };
+    std::size_t libraries = 0;
+    for (int run = 0; run < runs; ++run) {
+        Obj_mtl::SceneLoader loader;
+        loader.setThreadCount(threads);
+        loader.setCacheEnabled(false);
+        std::vector<Obj_mtl::SceneLoader::Model> models;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        loader.load(filenames, models);
+        double time = seconds_since(start);
+        scene = statistics(models);
+        libraries = loader.materialLibraries().size();
+        if (run == 0 || time < best_scene) {
+            best_scene = time;
+        }
+    }
+
+    if (scene.loaded != filenames.size()) {
+        std::cerr << "can't load " << filenames.size() - scene.loaded << " files" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (scene.loaded != single.loaded || scene.triangles != single.triangles || scene.materials != single.materials) {
+        std::cerr << "SceneLoader and ObjLoader results differ" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << filenames.size() << " files : " << scene.triangles << " triangles, " << scene.materials << " meshes with a material, "
+              << libraries << " material libraries, best of " << runs << " runs" << std::endl;
+    std::cout << "ObjLoader per file : " << best_single << " s, " << filenames.size() / best_single << " files/s" << std::endl;
+    std::cout << "SceneLoader (" << threadCount(threads) << " threads) : " << best_scene << " s, " << filenames.size() / best_scene << " files/s" << std::endl;
+    return EXIT_SUCCESS;
+}
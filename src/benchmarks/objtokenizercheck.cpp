@@ -0,0 +1,195 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*
+ * Check of tokenizer::parse_float against strtof ("C" locale) : same float
+ * bits and same number of characters, by the SIMD window path (a padded
+ * buffer after the number) and by the scalar path (number at the end of
+ * the buffer). Fixed cases cover exponents, more than 19 significant
+ * digits, subnormals, overflows and inf/nan spellings (refused, as by the
+ * classic locale stream extractor), then random numbers.
+ *
+ * Usage : objtokenizer_check [samples] [seed]
+ * Default : 1 000 000 random numbers. Returns EXIT_FAILURE on error.
+ */
+
+#include "fileloaders/objtokenizer.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+using namespace Loaders;
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const std::string& message)
+{
+    if (!condition) {
+        if (failures < 20) {
+            std::cout << "FAILED : " << message << std::endl;
+        }
+        ++failures;
+    }
+}
+
+// the number followed by the rest of its line, then by padding (SIMD path)
+// or by nothing (scalar path near the end of the buffer)
+bool parse(const std::string& number, bool padding, Obj_mtl::float_type& value, std::size_t& length)
+{
+    std::string content = number + " 1.0 2.0";
+    const std::size_t line = content.size();
+    if (padding) {
+        content += "\n# " + std::string(126, '-') + "\n";
+    }
+    // exact size copy, so that a read past the buffer is caught by the
+    // address sanitizer
+    char* buffer = new char[content.size()];
+    std::memcpy(buffer, content.data(), content.size());
+    const char* p = buffer;
+    bool parsed = Obj_mtl::tokenizer::parse_float(p, buffer + line, value, buffer + content.size());
+    length = std::size_t(p - buffer);
+    delete[] buffer;
+    return parsed;
+}
+
+// same bits and length as strtof, or refused when strtof overflows
+void check_number(const std::string& number)
+{
+    errno = 0;
+    char* expected_end = 0;
+    float expected = std::strtof(number.c_str(), &expected_end);
+    bool refused = std::isinf(expected) || std::isnan(expected);
+    for (int padding = 0; padding < 2; ++padding) {
+        Obj_mtl::float_type value = 0;
+        std::size_t length = 0;
+        bool parsed = parse(number, padding != 0, value, length);
+        std::string path = std::string(padding ? " (SIMD)" : " (scalar)") + " : " + number;
+        if (refused) {
+            check(!parsed, "refused" + path);
+        } else {
+            float f = float(value);
+            check(parsed && std::memcmp(&f, &expected, sizeof(f)) == 0 && length == std::size_t(expected_end - number.c_str()),
+                  "strtof" + path);
+        }
+    }
+}
+
+void check_refused(const std::string& number)
+{
+    for (int padding = 0; padding < 2; ++padding) {
+        Obj_mtl::float_type value = 0;
+        std::size_t length = 0;
+        check(!parse(number, padding != 0, value, length), std::string("refused") + (padding ? " (SIMD)" : " (scalar)") + " : " + number);
+    }
+}
+
+unsigned long long state;
+
+unsigned random(unsigned n)
+{
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return unsigned((state >> 33) % n);
+}
+
+std::string digits(unsigned n)
+{
+    std::string result;
+    for (unsigned d = 0; d < n; ++d) {
+        result += char('0' + random(10));
+    }
+    return result;
+}
+
+// [+-]digits[.digits][(e|E)[+-]digits] : short numbers for the window path,
+// up to 30 digits, exponents up to the float range and past it
+std::string random_number()
+{
+    std::string number;
+    unsigned sign = random(4);
+    number += (sign == 0) ? "-" : (sign == 1) ? "+" : "";
+    unsigned integer = random(4) ? random(8) : random(31);
+    unsigned fraction = random(4) ? random(10) : random(31);
+    if (integer + fraction == 0) {
+        integer = 1;
+    }
+    number += digits(integer);
+    if (fraction || random(2)) {
+        number += "." + digits(fraction);
+    }
+    if (random(3) == 0) {
+        number += random(2) ? "e" : "E";
+        int exponent = int(random(101)) - 60;
+        unsigned exponent_sign = random(3);
+        if (exponent < 0) {
+            number += "-";
+            exponent = -exponent;
+        } else if (exponent_sign == 0) {
+            number += "+";
+        }
+        number += std::to_string(exponent);
+    }
+    return number;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t samples = (argc > 1) ? std::size_t(std::atol(argv[1])) : 1000000;
+    state = (argc > 2) ? std::strtoull(argv[2], 0, 10) : 20121;
+
+    const char* numbers[] = {
+        "0", "-0", "+0", "0.0", "1", "-1.5", "5.", ".5", "-.25", "0.1", "0.2", "0.3", "3.14159265358979323846",
+        "1e0", "1E5", "1e+5", "2.5e-3", "-7.e2", ".5E-1", "1e22", "1e23", "1e-22", "1e-23", "123456.789e-10",
+        // the largest float, the rounding limit and past it
+        "3.4028234e38", "3.40282346638528859811704183484516925440e38", "3.4028235677973366e38", "3.4028236e38", "1e39", "-1e39", "1e100000",
+        // normal limit and subnormals
+        "1.17549435e-38", "1.1754942e-38", "1e-40", "1.4e-45", "1.401298464324817e-45", "7.006492321624085e-46",
+        "7.006492321624086e-46", "1e-46", "1e-50", "-1e-45", "1e-100000",
+        // more than 16 and 19 significant digits
+        "1234567890123456", "12345678901234567", "1234567890123456789", "12345678901234567890",
+        "1.00000000000000000000001", "0.000000000000000000000000000000000000000000001", "123456789012345678901234567890",
+        "0000000000000000000000000000001.5", "16777217", "16777216.5", "16777217.000000000000000000001",
+        "0.1000000000000000055511151231257827", "1.00000005960464477539062", "1.000000059604644775390625",
+        "1.000000059604644775390626",
+    };
+    for (std::size_t n = 0; n < sizeof(numbers) / sizeof(numbers[0]); ++n) {
+        check_number(numbers[n]);
+    }
+    // accepted by strtof, not by the stream extractor
+    const char* refused[] = { "inf", "-inf", "+INF", "Infinity", "infinity", "nan", "NaN", "-nan", "nan(123)", "e5", ".", "-", "1e", "1e+" };
+    for (std::size_t n = 0; n < sizeof(refused) / sizeof(refused[0]); ++n) {
+        check_refused(refused[n]);
+    }
+
+    for (std::size_t s = 0; s < samples; ++s) {
+        check_number(random_number());
+    }
+
+    std::cout << samples << " random numbers, " << failures << " failures" << std::endl;
+    std::cout << (failures ? "FAILED" : "ok") << std::endl;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
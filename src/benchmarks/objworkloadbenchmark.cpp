@@ -0,0 +1,508 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*
+ * Regression benchmark of the OBJ loaders on deterministic synthetic
+ * workloads : for each shape, timed parses of the mapped file by
+ * basic_obj_parser, then timed loads by ObjLoader (load and getObjects,
+ * without the binary cache). Results are written as JSON on the standard
+ * output : MB/s, faces/s, peak resident memory and the number of C++
+ * allocations of each pass.
+ *
+ * Usage : objworkload_benchmark [faces] [runs] [threads] [shapes]
+ * shapes is a comma separated list of :
+ *   v          triangles with geometric vertices only
+ *   vtvn       triangles with texture vertices and normals
+ *   quads      quadrilaterals with texture vertices and normals
+ *   groups     triangles in many groups, one material of a library each
+ *   smoothing  triangles without normals in many smoothing groups
+ *   negative   triangles with relative (negative) indices
+ * All of them by default, with 1 000 000 faces each and 3 runs. The files
+ * are generated in objworkload_benchmark/ (current directory) if missing.
+ */
+
+#include "fileloaders/objbasicparser.h"
+#include "fileloaders/objloader.h"
+#include "fileloaders/mappedfile.h"
+
+#include <QDir>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#ifdef __unix__
+#include <sys/resource.h>
+#endif
+
+using namespace Loaders;
+using namespace Loaders::Obj_mtl;
+
+namespace {
+
+std::atomic<unsigned long long> allocation_count(0);
+std::atomic<unsigned long long> allocated_bytes(0);
+
+void* counted_allocation(std::size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+}
+
+// every C++ allocation of the process is counted (Qt allocates with malloc)
+void* operator new(std::size_t size) { return counted_allocation(size); }
+void* operator new[](std::size_t size) { return counted_allocation(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try {
+        return counted_allocation(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    try {
+        return counted_allocation(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+namespace {
+
+const std::string workload_dir = "objworkload_benchmark";
+const std::string library_name = "workload.mtl";
+const std::size_t default_number_of_faces = 1000000;
+const std::size_t number_of_materials = 64;
+const std::size_t faces_per_group = 200;
+const std::size_t faces_per_smoothing_group = 100;
+
+const char* const all_shapes[] = { "v", "vtvn", "quads", "groups", "smoothing", "negative" };
+
+// side of the vertex grid holding number_of_faces faces
+std::size_t grid_side(std::size_t number_of_faces, bool quads)
+{
+    return std::size_t(std::ceil(std::sqrt(number_of_faces / (quads ? 1.0 : 2.0)))) + 1;
+}
+
+// Deterministic pseudo random height, the same on every platform.
+float height(std::size_t i, std::size_t j)
+{
+    unsigned int h = unsigned(i) * 73856093u ^ unsigned(j) * 19349663u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    return float(h & 0xffff) / 65536.f * 0.01f;
+}
+
+void write_grid(std::FILE* file, std::size_t n, bool textures, bool normals)
+{
+    for (std::size_t j = 0; j < n; ++j) {
+        for (std::size_t i = 0; i < n; ++i) {
+            std::fprintf(file, "v %.6f %.6f %.6f\n", float(i) / n, float(j) / n, std::sin(float(i + j) / n) + height(i, j));
+        }
+    }
+    if (textures) {
+        for (std::size_t j = 0; j < n; ++j) {
+            for (std::size_t i = 0; i < n; ++i) {
+                std::fprintf(file, "vt %.6f %.6f\n", float(i) / n, float(j) / n);
+            }
+        }
+    }
+    if (normals) {
+        for (std::size_t j = 0; j < n; ++j) {
+            for (std::size_t i = 0; i < n; ++i) {
+                std::fprintf(file, "vn %.4f %.4f 1\n", std::cos(float(i) / n), std::sin(float(j) / n));
+            }
+        }
+    }
+}
+
+void write_vertex(std::FILE* file, std::size_t v, bool textures, bool normals)
+{
+    if (textures && normals) {
+        std::fprintf(file, " %zu/%zu/%zu", v, v, v);
+    } else if (textures) {
+        std::fprintf(file, " %zu/%zu", v, v);
+    } else if (normals) {
+        std::fprintf(file, " %zu//%zu", v, v);
+    } else {
+        std::fprintf(file, " %zu", v);
+    }
+}
+
+bool generate_library(const std::string& filename)
+{
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    for (std::size_t m = 0; m < number_of_materials; ++m) {
+        float t = float(m) / number_of_materials;
+        std::fprintf(file, "newmtl material%zu\n", m);
+        std::fprintf(file, "Ka 0.1 0.1 0.1\nKd %.3f %.3f %.3f\nKs 0.5 0.5 0.5\nNs %.1f\nd 1\nillum 2\n", t, 1 - t, 0.5f, 10 + 5 * t);
+        std::fprintf(file, "map_Kd texture%zu.png\n\n", m % 8);
+    }
+    return std::fclose(file) == 0;
+}
+
+// Faces of a grid, 2 triangles or 1 quadrilateral per cell. Groups, materials
+// and smoothing groups change every faces_per_group and
+// faces_per_smoothing_group faces for the corresponding shapes.
+bool generate_grid(const std::string& filename, const std::string& shape, std::size_t number_of_faces)
+{
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool quads = shape == "quads";
+    bool textures = shape != "v";
+    bool normals = shape == "vtvn" || shape == "quads" || shape == "groups";
+    std::size_t n = grid_side(number_of_faces, quads);
+    if (shape == "groups") {
+        std::fprintf(file, "mtllib %s\n", library_name.c_str());
+    }
+    write_grid(file, n, textures, normals);
+    std::size_t faces = 0;
+    for (std::size_t j = 0; j + 1 < n && faces < number_of_faces; ++j) {
+        for (std::size_t i = 0; i + 1 < n && faces < number_of_faces; ++i) {
+            std::size_t a = j * n + i + 1, b = a + 1, c = a + n, d = c + 1;
+            std::size_t cell_faces = quads ? 1 : 2;
+            for (std::size_t k = 0; k < cell_faces && faces < number_of_faces; ++k, ++faces) {
+                if (shape == "groups" && faces % faces_per_group == 0) {
+                    std::size_t g = faces / faces_per_group;
+                    std::fprintf(file, "g group%zu\nusemtl material%zu\n", g, g % number_of_materials);
+                }
+                if (shape == "smoothing" && faces % faces_per_smoothing_group == 0) {
+                    std::size_t s = faces / faces_per_smoothing_group;
+                    if (s % 8 == 7) {
+                        std::fprintf(file, "s off\n");
+                    } else {
+                        std::fprintf(file, "s %zu\n", s + 1);
+                    }
+                }
+                std::fputc('f', file);
+                if (quads) {
+                    write_vertex(file, a, textures, normals);
+                    write_vertex(file, b, textures, normals);
+                    write_vertex(file, d, textures, normals);
+                    write_vertex(file, c, textures, normals);
+                } else {
+                    write_vertex(file, a, textures, normals);
+                    write_vertex(file, k == 0 ? b : d, textures, normals);
+                    write_vertex(file, k == 0 ? d : c, textures, normals);
+                }
+                std::fputc('\n', file);
+            }
+        }
+    }
+    return std::fclose(file) == 0;
+}
+
+// Each cell writes its 4 corners then its 2 triangles with relative indices,
+// as exporters that stream their geometry do.
+bool generate_negative(const std::string& filename, std::size_t number_of_faces)
+{
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    std::size_t n = grid_side(number_of_faces, false);
+    std::size_t faces = 0;
+    for (std::size_t j = 0; j + 1 < n && faces < number_of_faces; ++j) {
+        for (std::size_t i = 0; i + 1 < n && faces < number_of_faces; ++i) {
+            for (std::size_t k = 0; k < 4; ++k) {
+                std::size_t x = i + (k & 1), y = j + (k >> 1);
+                std::fprintf(file, "v %.6f %.6f %.6f\n", float(x) / n, float(y) / n, std::sin(float(x + y) / n) + height(x, y));
+                std::fprintf(file, "vt %.6f %.6f\n", float(x) / n, float(y) / n);
+            }
+            std::fprintf(file, "vn 0 0 1\n");
+            std::fprintf(file, "f -4/-4/-1 -3/-3/-1 -1/-1/-1\n");
+            if (++faces < number_of_faces) {
+                std::fprintf(file, "f -4/-4/-1 -1/-1/-1 -2/-2/-1\n");
+                ++faces;
+            }
+        }
+    }
+    return std::fclose(file) == 0;
+}
+
+bool generate(const std::string& filename, const std::string& shape, std::size_t number_of_faces)
+{
+    if (shape == "negative") {
+        return generate_negative(filename, number_of_faces);
+    }
+    return generate_grid(filename, shape, number_of_faces);
+}
+
+// Counts the faces so that nothing is optimized out.
+class counting_handler : public obj_handler {
+public:
+    counting_handler()
+        : faces(0)
+        , indices(0)
+    {
+    }
+    void triangular_face_geometric_vertices(index_type v1, index_type v2, index_type v3) { ++faces, indices += v1 + v2 + v3; }
+    void triangular_face_geometric_vertices_texture_vertices(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3) { ++faces, add(v1), add(v2), add(v3); }
+    void triangular_face_geometric_vertices_vertex_normals(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3) { ++faces, add(v1), add(v2), add(v3); }
+    void triangular_face_geometric_vertices_texture_vertices_vertex_normals(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3) { ++faces, add(v1), add(v2), add(v3); }
+    void quadrilateral_face_geometric_vertices(index_type v1, index_type v2, index_type v3, index_type v4) { ++faces, indices += v1 + v2 + v3 + v4; }
+    void quadrilateral_face_geometric_vertices_texture_vertices(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3, const face_vertex_type& v4) { ++faces, add(v1), add(v2), add(v3), add(v4); }
+    void quadrilateral_face_geometric_vertices_vertex_normals(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3, const face_vertex_type& v4) { ++faces, add(v1), add(v2), add(v3), add(v4); }
+    void quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3, const face_vertex_type& v4) { ++faces, add(v1), add(v2), add(v3), add(v4); }
+
+    std::size_t faces;
+    unsigned long long indices;
+
+private:
+    void add(const face_vertex_type& v) { indices += v.v + v.vt + v.vn; }
+};
+
+// Linux : resets the peak resident memory of the process, so that each pass
+// reports its own peak. Elsewhere the peak of the process is reported.
+void reset_peak_memory()
+{
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    if (clear_refs) {
+        clear_refs << "5";
+    }
+}
+
+// peak resident memory in MB, 0 if unknown
+double peak_memory()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::atof(line.c_str() + 6) / 1024.;
+        }
+    }
+#ifdef __unix__
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return usage.ru_maxrss / 1024.;
+    }
+#endif
+    return 0;
+}
+
+double seconds_since(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Times, allocations and memory of the runs of a pass.
+struct pass_result {
+    pass_result()
+        : best(0)
+        , total(0)
+        , runs(0)
+        , allocations(0)
+        , bytes(0)
+        , peak(0)
+    {
+    }
+    void add(double seconds, unsigned long long run_allocations, unsigned long long run_bytes)
+    {
+        if (runs == 0 || seconds < best) {
+            best = seconds;
+        }
+        total += seconds;
+        ++runs;
+        allocations = run_allocations;
+        bytes = run_bytes;
+    }
+    double best;
+    double total;
+    int runs;
+    unsigned long long allocations;
+    unsigned long long bytes;
+    double peak;
+};
+
+void print_pass(const char* name, const pass_result& pass, double megabytes, std::size_t faces, const char* extra)
+{
+    std::printf("      \"%s\": {\"best_seconds\": %.6f, \"mean_seconds\": %.6f, \"mb_per_second\": %.2f, \"faces_per_second\": %.0f, "
+                "\"allocations\": %llu, \"allocated_bytes\": %llu, \"peak_rss_mb\": %.1f%s}",
+        name, pass.best, pass.total / pass.runs, megabytes / pass.best, faces / pass.best,
+        pass.allocations, pass.bytes, pass.peak, extra);
+}
+
+void delete_meshes(std::vector<Mesh*>& meshes)
+{
+    for (std::size_t i = 0; i < meshes.size(); ++i) {
+        delete meshes[i];
+    }
+    meshes.clear();
+}
+
+bool known_shape(const std::string& shape)
+{
+    for (std::size_t s = 0; s < sizeof(all_shapes) / sizeof(all_shapes[0]); ++s) {
+        if (shape == all_shapes[s]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    long long requested_faces = (argc > 1) ? std::atoll(argv[1]) : (long long)default_number_of_faces;
+    std::size_t number_of_faces = requested_faces > 0 ? std::size_t(requested_faces) : default_number_of_faces;
+    int runs = (argc > 2) ? std::atoi(argv[2]) : 3;
+    unsigned threads = (argc > 3) ? unsigned(std::atoi(argv[3])) : 1;
+    if (runs < 1) {
+        runs = 1;
+    }
+
+    std::vector<std::string> shapes;
+    if (argc > 4) {
+        std::string list = argv[4];
+        for (std::size_t begin = 0; begin <= list.size();) {
+            std::size_t end = list.find(',', begin);
+            if (end == std::string::npos) {
+                end = list.size();
+            }
+            std::string shape = list.substr(begin, end - begin);
+            if (!known_shape(shape)) {
+                std::cerr << "unknown shape " << shape << std::endl;
+                return EXIT_FAILURE;
+            }
+            shapes.push_back(shape);
+            begin = end + 1;
+        }
+    } else {
+        shapes.assign(all_shapes, all_shapes + sizeof(all_shapes) / sizeof(all_shapes[0]));
+    }
+
+    std::string library = workload_dir + "/" + library_name;
+    if (!QDir().mkpath(QString(workload_dir.c_str())) || !generate_library(library)) {
+        std::cerr << "can't write " << library << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::printf("{\n  \"faces\": %zu,\n  \"runs\": %d,\n  \"threads\": %u,\n  \"workloads\": [\n", number_of_faces, runs, threads);
+    for (std::size_t s = 0; s < shapes.size(); ++s) {
+        const std::string& shape = shapes[s];
+        std::string filename = workload_dir + "/" + shape + "_" + std::to_string(number_of_faces) + ".obj";
+        if (!std::ifstream(filename.c_str())) {
+            std::cerr << "Generating " << filename << std::endl;
+            if (!generate(filename, shape, number_of_faces)) {
+                std::cerr << "can't write " << filename << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        MappedFile file;
+        if (!file.open(filename)) {
+            std::cerr << "can't map " << filename << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::size_t file_size = file.size();
+        double megabytes = file_size / (1024.0 * 1024.0);
+
+        pass_result parse;
+        std::size_t parsed_faces = 0;
+        reset_peak_memory();
+        for (int run = 0; run < runs; ++run) {
+            counting_handler handler;
+            basic_obj_parser<counting_handler> parser(handler);
+            unsigned long long allocations = allocation_count, bytes = allocated_bytes;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            if (!parser.parse(file.begin(), file.end())) {
+                std::cerr << "can't parse " << filename << std::endl;
+                return EXIT_FAILURE;
+            }
+            parse.add(seconds_since(start), allocation_count - allocations, allocated_bytes - bytes);
+            parsed_faces = handler.faces;
+        }
+        parse.peak = peak_memory();
+        file.close();
+
+        pass_result load;
+        double best_load = 0, best_meshes = 0;
+        std::size_t meshes_number = 0, vertices = 0, triangles = 0;
+        reset_peak_memory();
+        for (int run = 0; run < runs; ++run) {
+            unsigned long long allocations = allocation_count, bytes = allocated_bytes;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            Obj_mtl::ObjLoader loader;
+            loader.setThreadCount(threads);
+            loader.setCacheEnabled(false);
+            QString reason;
+            if (!loader.load(QString(filename.c_str()), reason)) {
+                std::cerr << "can't load " << filename << std::endl;
+                return EXIT_FAILURE;
+            }
+            double parsed = seconds_since(start);
+            std::vector<Mesh*> meshes;
+            loader.getObjects(meshes);
+            double seconds = seconds_since(start);
+
+            meshes_number = meshes.size();
+            vertices = triangles = 0;
+            for (std::size_t i = 0; i < meshes.size(); ++i) {
+                vertices += meshes[i]->nbVertices();
+                triangles += meshes[i]->nbTriangles();
+            }
+            delete_meshes(meshes);
+            if (run == 0 || parsed < best_load) {
+                best_load = parsed;
+            }
+            if (run == 0 || seconds - parsed < best_meshes) {
+                best_meshes = seconds - parsed;
+            }
+            load.add(seconds, allocation_count - allocations, allocated_bytes - bytes);
+        }
+        load.peak = peak_memory();
+
+        std::printf("    {\n      \"shape\": \"%s\",\n      \"file\": \"%s\",\n      \"bytes\": %zu,\n      \"faces\": %zu,\n",
+            shape.c_str(), filename.c_str(), file_size, parsed_faces);
+        print_pass("parse", parse, megabytes, parsed_faces, "");
+        std::printf(",\n");
+        std::string extra = ", \"load_seconds\": " + std::to_string(best_load) + ", \"get_objects_seconds\": " + std::to_string(best_meshes)
+            + ", \"meshes\": " + std::to_string(meshes_number) + ", \"vertices\": " + std::to_string(vertices)
+            + ", \"triangles\": " + std::to_string(triangles);
+        print_pass("load", load, megabytes, parsed_faces, extra.c_str());
+        std::printf("\n    }%s\n", s + 1 < shapes.size() ? "," : "");
+        std::fflush(stdout);
+    }
+    std::printf("  ]\n}\n");
+    return EXIT_SUCCESS;
+}
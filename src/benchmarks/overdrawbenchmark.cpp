@@ -0,0 +1,252 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*
+ * Overdraw of a mesh measured on the CPU : the mesh is rasterized from
+ * directions spread over the sphere around it (orthographic views, back
+ * faces culled, depth test), overdraw being the number of fragments that
+ * pass the depth test per covered pixel (1 at best), averaged over the
+ * views. Measured in the order of the mesh, after the vertex cache
+ * optimization (Mesh::optimizeVertexCache) and after the overdraw
+ * optimization (Mesh::optimizeOverdraw), with the ACMR of each order.
+ *
+ * Usage : overdraw_benchmark [file.obj] [threshold] [views] [resolution]
+ * All the meshes of the file are merged. Without a file, a dense model of
+ * 125 overlapping spheres in shuffled order is generated. Defaults :
+ * threshold 1.05, 32 views of 512 x 512 pixels.
+ */
+
+#include "fileloaders/objloader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace Loaders;
+
+namespace {
+
+const unsigned cache_size = 16;
+const std::size_t spheres_per_side = 5;
+const std::size_t sphere_rings = 40;
+const std::size_t sphere_segments = 50;
+
+// spheres of a jittered grid, each one welded, in shuffled order
+Mesh* spheres()
+{
+    const std::size_t count = spheres_per_side * spheres_per_side * spheres_per_side;
+    std::vector<std::size_t> order(count);
+    for (std::size_t s = 0; s < count; ++s) {
+        order[s] = s;
+    }
+    unsigned long long state = 0x9e3779b97f4a7c15ULL;
+    auto next = [&]() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return std::size_t(state >> 33);
+    };
+    for (std::size_t s = count; s > 1; --s) {
+        std::swap(order[s - 1], order[next() % s]);
+    }
+
+    std::vector<float> vertices;
+    std::vector<unsigned int> triangles;
+    const float pi = 3.14159265f;
+    for (std::size_t k = 0; k < count; ++k) {
+        std::size_t s = order[k];
+        float center[3] = { float(s % spheres_per_side), float(s / spheres_per_side % spheres_per_side), float(s / spheres_per_side / spheres_per_side) };
+        for (int c = 0; c < 3; ++c) {
+            center[c] += float(next() % 1000) / 2000.f - 0.25f;
+        }
+        float radius = 0.6f + float(next() % 1000) / 2500.f;
+        unsigned int first = (unsigned int)(vertices.size() / 8);
+        for (std::size_t r = 0; r <= sphere_rings; ++r) {
+            float theta = pi * r / sphere_rings;
+            for (std::size_t g = 0; g < sphere_segments; ++g) {
+                float phi = 2 * pi * g / sphere_segments;
+                float n[3] = { std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta) };
+                float v[] = { center[0] + radius * n[0], center[1] + radius * n[1], center[2] + radius * n[2], n[0], n[1], n[2],
+                    float(g) / sphere_segments, float(r) / sphere_rings };
+                vertices.insert(vertices.end(), v, v + 8);
+            }
+        }
+        for (std::size_t r = 0; r < sphere_rings; ++r) {
+            for (std::size_t g = 0; g < sphere_segments; ++g) {
+                unsigned int a = first + (unsigned int)(r * sphere_segments + g);
+                unsigned int b = first + (unsigned int)(r * sphere_segments + (g + 1) % sphere_segments);
+                unsigned int c = a + (unsigned int)sphere_segments, d = b + (unsigned int)sphere_segments;
+                // counterclockwise seen from outside
+                unsigned int t[] = { a, c, d, a, d, b };
+                triangles.insert(triangles.end(), t, t + 6);
+            }
+        }
+    }
+    return new Mesh(vertices.data(), vertices.size() / 8, triangles.data(), triangles.size() / 3, true, true);
+}
+
+// Fragments passing the depth test per covered pixel, averaged over views
+// directions of a Fibonacci sphere.
+double overdraw(const Mesh& mesh, std::size_t views, int resolution)
+{
+    const float* vertices = mesh.vertexData();
+    const unsigned int* triangles = mesh.triangleData();
+    const std::size_t nbVertices = mesh.nbVertices();
+    if (nbVertices == 0) {
+        return 0.;
+    }
+    glm::vec3 low(vertices[0], vertices[1], vertices[2]), high = low;
+    for (std::size_t i = 1; i < nbVertices; ++i) {
+        glm::vec3 p(vertices[8 * i], vertices[8 * i + 1], vertices[8 * i + 2]);
+        low = glm::min(low, p);
+        high = glm::max(high, p);
+    }
+    const glm::vec3 center = 0.5f * (low + high);
+    const float radius = std::max(0.5f * glm::length(high - low), 1e-20f);
+    const float scale = resolution / (2.f * radius);
+
+    std::vector<float> depth(std::size_t(resolution) * resolution);
+    std::vector<glm::vec3> projected(nbVertices);
+    double total = 0.;
+    for (std::size_t view = 0; view < views; ++view) {
+        // toward the camera, then the screen axes : right x up = toward
+        float z = 1.f - (2.f * view + 1.f) / views;
+        float ring = std::sqrt(std::max(0.f, 1.f - z * z));
+        float angle = 2.39996323f * view;
+        glm::vec3 toward(ring * std::cos(angle), ring * std::sin(angle), z);
+        glm::vec3 helper = std::fabs(toward.z) < 0.9f ? glm::vec3(0.f, 0.f, 1.f) : glm::vec3(1.f, 0.f, 0.f);
+        glm::vec3 right = glm::normalize(glm::cross(helper, toward));
+        glm::vec3 up = glm::cross(toward, right);
+        for (std::size_t i = 0; i < nbVertices; ++i) {
+            glm::vec3 p = glm::vec3(vertices[8 * i], vertices[8 * i + 1], vertices[8 * i + 2]) - center;
+            projected[i] = glm::vec3((glm::dot(p, right) + radius) * scale, (glm::dot(p, up) + radius) * scale, -glm::dot(p, toward));
+        }
+
+        std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::infinity());
+        std::size_t fragments = 0;
+        for (std::size_t t = 0; t < mesh.nbTriangles(); ++t) {
+            const glm::vec3& a = projected[triangles[3 * t]];
+            const glm::vec3& b = projected[triangles[3 * t + 1]];
+            const glm::vec3& c = projected[triangles[3 * t + 2]];
+            float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+            if (!(area > 0.f)) {
+                continue; // back face or degenerated
+            }
+            int x0 = std::max(0, int(std::floor(std::min(a.x, std::min(b.x, c.x)))));
+            int x1 = std::min(resolution - 1, int(std::ceil(std::max(a.x, std::max(b.x, c.x)))));
+            int y0 = std::max(0, int(std::floor(std::min(a.y, std::min(b.y, c.y)))));
+            int y1 = std::min(resolution - 1, int(std::ceil(std::max(a.y, std::max(b.y, c.y)))));
+            // pixel centers, shared edges drawn once (top left rule)
+            auto edge = [](const glm::vec3& p, const glm::vec3& q, float x, float y) {
+                return (q.x - p.x) * (y - p.y) - (q.y - p.y) * (x - p.x);
+            };
+            auto topLeft = [](const glm::vec3& p, const glm::vec3& q) {
+                return (q.y == p.y && q.x < p.x) || q.y < p.y;
+            };
+            bool ab = topLeft(a, b), bc = topLeft(b, c), ca = topLeft(c, a);
+            for (int y = y0; y <= y1; ++y) {
+                for (int x = x0; x <= x1; ++x) {
+                    float px = x + 0.5f, py = y + 0.5f;
+                    float wa = edge(b, c, px, py), wb = edge(c, a, px, py), wc = edge(a, b, px, py);
+                    if ((wa > 0.f || (wa == 0.f && bc)) && (wb > 0.f || (wb == 0.f && ca)) && (wc > 0.f || (wc == 0.f && ab))) {
+                        float d = (wa * a.z + wb * b.z + wc * c.z) / area;
+                        float& stored = depth[std::size_t(y) * resolution + x];
+                        if (d < stored) {
+                            stored = d;
+                            ++fragments;
+                        }
+                    }
+                }
+            }
+        }
+        std::size_t covered = 0;
+        for (std::size_t p = 0; p < depth.size(); ++p) {
+            covered += depth[p] != std::numeric_limits<float>::infinity();
+        }
+        total += covered ? double(fragments) / covered : 1.;
+    }
+    return total / views;
+}
+
+double seconds_since(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const char* order, const Mesh& mesh, std::size_t views, int resolution, double seconds)
+{
+    std::printf("%-14s : ACMR %.3f, overdraw %.3f", order, mesh.vertexCacheStatistics(cache_size).acmr, overdraw(mesh, views, resolution));
+    if (seconds >= 0) {
+        std::printf(" (%.3f s)", seconds);
+    }
+    std::printf("\n");
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    float threshold = (argc > 2) ? float(std::atof(argv[2])) : 1.05f;
+    std::size_t views = (argc > 3) ? std::size_t(std::atoi(argv[3])) : 32;
+    int resolution = (argc > 4) ? std::atoi(argv[4]) : 512;
+    if (views < 1) {
+        views = 1;
+    }
+    if (resolution < 16) {
+        resolution = 16;
+    }
+
+    Mesh* mesh = 0;
+    if (argc > 1) {
+        Obj_mtl::ObjLoader loader;
+        loader.setCacheEnabled(false);
+        QString reason;
+        if (!loader.load(QString(argv[1]), reason)) {
+            std::cerr << "can't load " << argv[1] << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::vector<Mesh*> meshes;
+        loader.getObjects(meshes);
+        mesh = new Mesh(std::vector<const Mesh*>(meshes.begin(), meshes.end()));
+        for (std::size_t m = 0; m < meshes.size(); ++m) {
+            delete meshes[m];
+        }
+    } else {
+        mesh = spheres();
+    }
+
+    std::cout << mesh->nbVertices() << " vertices, " << mesh->nbTriangles() << " triangles, " << views << " views of "
+              << resolution << " x " << resolution << ", threshold " << threshold << std::endl;
+    report("input order", *mesh, views, resolution, -1);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    mesh->optimizeVertexCache(cache_size);
+    report("vertex cache", *mesh, views, resolution, seconds_since(start));
+
+    start = std::chrono::steady_clock::now();
+    mesh->optimizeOverdraw(threshold, cache_size);
+    report("overdraw", *mesh, views, resolution, seconds_since(start));
+
+    delete mesh;
+    return EXIT_SUCCESS;
+}
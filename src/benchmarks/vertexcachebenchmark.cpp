@@ -0,0 +1,175 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*
+ * Post-transform vertex cache optimization (Mesh::optimizeVertexCache) :
+ * ACMR and ATVR before and after, for FIFO caches of a few sizes, and the
+ * optimization time. The optimized meshes are checked to draw the same
+ * triangles (same positions, same orientation).
+ *
+ * Usage : vertexcache_benchmark [file.obj] [cache size]
+ * Without a file, a grid of 2 000 000 triangles is used twice : in row
+ * order, then in a shuffled (deterministic) order. The default cache size
+ * is 16 vertices.
+ */
+
+#include "fileloaders/objloader.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace Loaders;
+
+namespace {
+
+const std::size_t default_number_of_faces = 2000000;
+const unsigned cache_sizes[] = { 8, 16, 32 };
+
+// grid of n x n vertices with texture coordinates and normals, its cells in
+// row order or shuffled
+Mesh* grid(std::size_t number_of_faces, bool shuffled)
+{
+    std::size_t n = std::size_t(std::ceil(std::sqrt(number_of_faces / 2.0))) + 1;
+    std::vector<float> vertices;
+    vertices.reserve(8 * n * n);
+    for (std::size_t j = 0; j < n; ++j) {
+        for (std::size_t i = 0; i < n; ++i) {
+            float v[] = { float(i) / n, float(j) / n, std::sin(float(i + j) / n), 0.f, 0.f, 1.f, float(i) / n, float(j) / n };
+            vertices.insert(vertices.end(), v, v + 8);
+        }
+    }
+    std::vector<std::size_t> cells((n - 1) * (n - 1));
+    for (std::size_t c = 0; c < cells.size(); ++c) {
+        cells[c] = c;
+    }
+    if (shuffled) {
+        unsigned long long state = 0x2545f4914f6cdd1dULL;
+        for (std::size_t c = cells.size(); c > 1; --c) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            std::swap(cells[c - 1], cells[(state >> 33) % c]);
+        }
+    }
+    std::vector<unsigned int> triangles;
+    triangles.reserve(6 * cells.size());
+    for (std::size_t c = 0; c < cells.size(); ++c) {
+        unsigned int a = (unsigned int)(cells[c] / (n - 1) * n + cells[c] % (n - 1)), b = a + 1, d = a + (unsigned int)n, e = d + 1;
+        unsigned int t[] = { a, b, e, a, e, d };
+        triangles.insert(triangles.end(), t, t + 6);
+    }
+    return new Mesh(vertices.data(), n * n, triangles.data(), triangles.size() / 3, true, true);
+}
+
+// triangles as sorted triples of positions, first corner the smallest
+// position (same orientation)
+typedef std::array<float, 9> triangle_key;
+
+std::vector<triangle_key> triangle_keys(const Mesh& mesh)
+{
+    std::vector<triangle_key> keys(mesh.nbTriangles());
+    const float* vertices = mesh.vertexData();
+    const unsigned int* triangles = mesh.triangleData();
+    for (std::size_t t = 0; t < keys.size(); ++t) {
+        std::array<std::array<float, 3>, 3> p;
+        for (int c = 0; c < 3; ++c) {
+            const float* v = vertices + 8 * triangles[3 * t + c];
+            p[c] = { { v[0], v[1], v[2] } };
+        }
+        int first = int(std::min_element(p.begin(), p.end()) - p.begin());
+        for (int c = 0; c < 3; ++c) {
+            for (int k = 0; k < 3; ++k) {
+                keys[t][3 * c + k] = p[(first + c) % 3][k];
+            }
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+double seconds_since(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool measure(const std::string& name, Mesh& mesh, unsigned cache_size)
+{
+    std::cout << name << " : " << mesh.nbVertices() << " vertices, " << mesh.nbTriangles() << " triangles" << std::endl;
+    std::vector<VertexCacheStatistics> before;
+    for (std::size_t c = 0; c < sizeof(cache_sizes) / sizeof(cache_sizes[0]); ++c) {
+        before.push_back(mesh.vertexCacheStatistics(cache_sizes[c]));
+    }
+    std::vector<triangle_key> keys = triangle_keys(mesh);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    mesh.optimizeVertexCache(cache_size);
+    double seconds = seconds_since(start);
+
+    for (std::size_t c = 0; c < before.size(); ++c) {
+        VertexCacheStatistics after = mesh.vertexCacheStatistics(cache_sizes[c]);
+        std::printf("  cache %2u : ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", cache_sizes[c], before[c].acmr, after.acmr, before[c].atvr, after.atvr);
+    }
+    std::cout << "  optimization (cache " << cache_size << ") : " << seconds << " s" << std::endl;
+    if (triangle_keys(mesh) != keys) {
+        std::cerr << name << " : triangles differ after optimization" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    unsigned cache_size = (argc > 2) ? unsigned(std::atoi(argv[2])) : 16;
+    if (cache_size < 3) {
+        cache_size = 3;
+    }
+
+    if (argc > 1) {
+        Obj_mtl::ObjLoader loader;
+        loader.setCacheEnabled(false);
+        QString reason;
+        if (!loader.load(QString(argv[1]), reason)) {
+            std::cerr << "can't load " << argv[1] << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::vector<Mesh*> meshes;
+        loader.getObjects(meshes);
+        bool ok = true;
+        for (std::size_t m = 0; m < meshes.size(); ++m) {
+            ok = measure("mesh " + std::to_string(m), *meshes[m], cache_size) && ok;
+            delete meshes[m];
+        }
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    bool ok = true;
+    for (int shuffled = 0; shuffled < 2; ++shuffled) {
+        Mesh* mesh = grid(default_number_of_faces, shuffled != 0);
+        ok = measure(shuffled ? "shuffled grid" : "grid", *mesh, cache_size) && ok;
+        delete mesh;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,417 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#include "compressedfile.h"
+
+#ifdef OBJ_LOADER_ZLIB
+#include <zlib.h>
+#endif
+#ifdef OBJ_LOADER_ZSTD
+#include <zstd.h>
+#endif
+
+namespace Loaders {
+
+CompressedFile::CompressedFile() : mFormat(Plain), mOpen(false), mProduced(0), mConsumed(0), mEnd(false), mStop(false)
+{
+    for (int i = 0; i < 2; ++i) {
+        mBlocks[i].size = 0;
+        mBlocks[i].full = false;
+    }
+}
+
+CompressedFile::CompressedFile(const std::string& filename) : mFormat(Plain), mOpen(false), mProduced(0), mConsumed(0), mEnd(false), mStop(false)
+{
+    for (int i = 0; i < 2; ++i) {
+        mBlocks[i].size = 0;
+        mBlocks[i].full = false;
+    }
+    open(filename);
+}
+
+CompressedFile::~CompressedFile()
+{
+    close();
+}
+
+static CompressedFile::Format magicFormat(std::FILE* file)
+{
+    unsigned char magic[4] = { 0, 0, 0, 0 };
+    std::size_t size = std::fread(magic, 1, 4, file);
+    if ((size >= 2) && (magic[0] == 0x1f) && (magic[1] == 0x8b)) {
+        return CompressedFile::Gzip;
+    }
+    if ((size == 4) && (magic[0] == 0x28) && (magic[1] == 0xb5) && (magic[2] == 0x2f) && (magic[3] == 0xfd)) {
+        return CompressedFile::Zstd;
+    }
+    return CompressedFile::Plain;
+}
+
+CompressedFile::Format CompressedFile::format(const std::string& filename)
+{
+    std::FILE* file = std::fopen(filename.c_str(), "rb");
+    if (!file) {
+        return Plain;
+    }
+    Format format = magicFormat(file);
+    std::fclose(file);
+    return format;
+}
+
+static bool fileExists(const std::string& filename)
+{
+    std::FILE* file = std::fopen(filename.c_str(), "rb");
+    if (file) {
+        std::fclose(file);
+    }
+    return file != 0;
+}
+
+std::string CompressedFile::resolve(const std::string& filename)
+{
+    if (fileExists(filename)) {
+        return filename;
+    }
+    static const char* extensions[] = { ".gz", ".zst" };
+    for (int i = 0; i < 2; ++i) {
+        std::string sibling = filename + extensions[i];
+        if (fileExists(sibling)) {
+            return sibling;
+        }
+    }
+    return filename;
+}
+
+bool CompressedFile::open(const std::string& filename)
+{
+    close();
+    mError.clear();
+    std::FILE* file = std::fopen(filename.c_str(), "rb");
+    if (!file) {
+        mError = "can't open file " + filename;
+        return false;
+    }
+    mFormat = magicFormat(file);
+#ifndef OBJ_LOADER_ZLIB
+    if (mFormat == Gzip) {
+        mError = "gzip compressed files are not supported (built without zlib) : " + filename;
+    }
+#endif
+#ifndef OBJ_LOADER_ZSTD
+    if (mFormat == Zstd) {
+        mError = "zstd compressed files are not supported (built without libzstd) : " + filename;
+    }
+#endif
+    if (!mError.empty() || std::fseek(file, 0, SEEK_SET) != 0) {
+        if (mError.empty()) {
+            mError = "can't read file " + filename;
+        }
+        std::fclose(file);
+        mFormat = Plain;
+        return false;
+    }
+    for (int i = 0; i < 2; ++i) {
+        mBlocks[i].data.resize(BlockSize);
+    }
+    mOpen = true;
+    mThread = std::thread(&CompressedFile::decompress, this, file);
+    return true;
+}
+
+void CompressedFile::close()
+{
+    if (mThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStop = true;
+        }
+        mCondition.notify_all();
+        mThread.join();
+    }
+    for (int i = 0; i < 2; ++i) {
+        mBlocks[i].size = 0;
+        mBlocks[i].full = false;
+    }
+    mProduced = 0;
+    mConsumed = 0;
+    mEnd = false;
+    mStop = false;
+    mFormat = Plain;
+    mOpen = false;
+}
+
+std::string CompressedFile::error() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mError;
+}
+
+bool CompressedFile::nextBlock(const char*& data, std::size_t& size)
+{
+    if (!mOpen) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (mConsumed != 0) {
+        // the previous block can be filled again
+        mBlocks[(mConsumed - 1) % 2].full = false;
+        mCondition.notify_all();
+    }
+    Block& block = mBlocks[mConsumed % 2];
+    while (!block.full && !mEnd) {
+        mCondition.wait(lock);
+    }
+    if (!block.full) {
+        return false;
+    }
+    ++mConsumed;
+    data = block.data.data();
+    size = block.size;
+    return true;
+}
+
+CompressedFile::Block* CompressedFile::freeBlock()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    Block& block = mBlocks[mProduced % 2];
+    while (block.full && !mStop) {
+        mCondition.wait(lock);
+    }
+    return mStop ? 0 : &block;
+}
+
+void CompressedFile::blockFilled(Block* block)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        block->full = true;
+        ++mProduced;
+    }
+    mCondition.notify_all();
+}
+
+void CompressedFile::setError(const std::string& error)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mError = error;
+}
+
+void CompressedFile::decompress(std::FILE* file)
+{
+    switch (mFormat) {
+    case Gzip:
+        readGzip(file);
+        break;
+    case Zstd:
+        readZstd(file);
+        break;
+    default:
+        readPlain(file);
+        break;
+    }
+    std::fclose(file);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mEnd = true;
+    }
+    mCondition.notify_all();
+}
+
+bool CompressedFile::readPlain(std::FILE* file)
+{
+    for (;;) {
+        Block* block = freeBlock();
+        if (!block) {
+            return true;
+        }
+        block->size = std::fread(block->data.data(), 1, BlockSize, file);
+        if (block->size == 0) {
+            if (std::ferror(file)) {
+                setError("read error");
+                return false;
+            }
+            return true;
+        }
+        blockFilled(block);
+    }
+}
+
+#ifdef OBJ_LOADER_ZLIB
+
+bool CompressedFile::readGzip(std::FILE* file)
+{
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+    // 16 : gzip header
+    if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+        setError("can't initialize zlib");
+        return false;
+    }
+    std::vector<unsigned char> input(BlockSize / 4);
+    Block* block = freeBlock();
+    std::size_t blockSize = 0;
+    bool member_end = false;
+    // false when the output was full : inflate may hold more data
+    bool flushed = true;
+    bool result = true;
+    while (block) {
+        if ((stream.avail_in == 0) && flushed) {
+            std::size_t size = std::fread(input.data(), 1, input.size(), file);
+            if (size == 0) {
+                if (std::ferror(file)) {
+                    setError("read error");
+                    result = false;
+                } else if (!member_end) {
+                    setError("unexpected end of gzip data");
+                    result = false;
+                }
+                break;
+            }
+            stream.next_in = input.data();
+            stream.avail_in = uInt(size);
+        }
+        if (member_end && (stream.avail_in != 0)) {
+            // concatenated gzip members
+            inflateReset(&stream);
+            member_end = false;
+        }
+        stream.next_out = reinterpret_cast<Bytef*>(block->data.data() + blockSize);
+        stream.avail_out = uInt(BlockSize - blockSize);
+        int status = inflate(&stream, Z_NO_FLUSH);
+        blockSize = BlockSize - stream.avail_out;
+        flushed = stream.avail_out != 0;
+        if (status == Z_STREAM_END) {
+            member_end = true;
+        } else if ((status != Z_OK) && (status != Z_BUF_ERROR)) {
+            setError(std::string("gzip error : ") + (stream.msg ? stream.msg : "invalid data"));
+            result = false;
+            break;
+        }
+        if (blockSize == BlockSize) {
+            block->size = blockSize;
+            blockFilled(block);
+            block = freeBlock();
+            blockSize = 0;
+        }
+    }
+    if (block && blockSize != 0) {
+        block->size = blockSize;
+        blockFilled(block);
+    }
+    inflateEnd(&stream);
+    return result;
+}
+
+#else
+
+bool CompressedFile::readGzip(std::FILE*)
+{
+    return false;
+}
+
+#endif
+
+#ifdef OBJ_LOADER_ZSTD
+
+bool CompressedFile::readZstd(std::FILE* file)
+{
+    ZSTD_DStream* stream = ZSTD_createDStream();
+    if (!stream) {
+        setError("can't initialize zstd");
+        return false;
+    }
+    ZSTD_initDStream(stream);
+    std::vector<char> input(ZSTD_DStreamInSize());
+    ZSTD_inBuffer in = { input.data(), 0, 0 };
+    Block* block = freeBlock();
+    std::size_t blockSize = 0;
+    // 0 once a frame is completely decoded
+    std::size_t status = 0;
+    // false when the output was full : the decoder may hold more data
+    bool flushed = true;
+    bool result = true;
+    while (block) {
+        if ((in.pos == in.size) && flushed) {
+            std::size_t size = std::fread(input.data(), 1, input.size(), file);
+            if (size == 0) {
+                if (std::ferror(file)) {
+                    setError("read error");
+                    result = false;
+                } else if (status != 0) {
+                    setError("unexpected end of zstd data");
+                    result = false;
+                }
+                break;
+            }
+            in.size = size;
+            in.pos = 0;
+        }
+        ZSTD_outBuffer out = { block->data.data(), BlockSize, blockSize };
+        status = ZSTD_decompressStream(stream, &out, &in);
+        if (ZSTD_isError(status)) {
+            setError(std::string("zstd error : ") + ZSTD_getErrorName(status));
+            result = false;
+            break;
+        }
+        blockSize = out.pos;
+        flushed = out.pos != out.size;
+        if (blockSize == BlockSize) {
+            block->size = blockSize;
+            blockFilled(block);
+            block = freeBlock();
+            blockSize = 0;
+        }
+    }
+    if (block && blockSize != 0) {
+        block->size = blockSize;
+        blockFilled(block);
+    }
+    ZSTD_freeDStream(stream);
+    return result;
+}
+
+#else
+
+bool CompressedFile::readZstd(std::FILE*)
+{
+    return false;
+}
+
+#endif
+
+CompressedStreamBuf::int_type CompressedStreamBuf::underflow()
+{
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+    const char* data;
+    std::size_t size;
+    if (!mFile.nextBlock(data, size)) {
+        return traits_type::eof();
+    }
+    char* begin = const_cast<char*>(data);
+    setg(begin, begin, begin + size);
+    return traits_type::to_int_type(*gptr());
+}
+
+} // namespace loaders
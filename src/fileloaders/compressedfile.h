@@ -0,0 +1,145 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef COMPRESSEDFILE_H
+#define COMPRESSEDFILE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+// =============================================================================
+namespace Loaders {
+// =============================================================================
+
+/**
+  * @ingroup Loaders
+  * Sequential reading of a file which may be gzip or zstd compressed, the
+  * format is detected from the first bytes of the file (other files are
+  * read as is).
+  * The file is decompressed by a separate thread into two blocks used
+  * alternately : the caller processes a block while the next one is
+  * decompressed.
+  * gzip needs zlib (OBJ_LOADER_ZLIB) and zstd needs libzstd (OBJ_LOADER_ZSTD),
+  * open() fails with an error message when the support is not built.
+  */
+class CompressedFile {
+public:
+    typedef enum {
+        Plain,
+        Gzip,
+        Zstd
+    } Format;
+
+    /// Size of the decompressed blocks.
+    static const std::size_t BlockSize = 1 << 20;
+
+    CompressedFile();
+    explicit CompressedFile(const std::string& filename);
+    ~CompressedFile();
+
+    /// Format of the file "filename", Plain when it can't be read.
+    static Format format(const std::string& filename);
+    static bool isCompressed(const std::string& filename) { return format(filename) != Plain; }
+    /// "filename" if it exists, its compressed sibling ("filename.gz" or
+    /// "filename.zst") otherwise. Returns "filename" when none exists.
+    static std::string resolve(const std::string& filename);
+
+    /// Open the file "filename" and start decompressing it, any previously
+    /// opened file is closed.
+    /// @return false if the file can't be opened or its format is not supported.
+    bool open(const std::string& filename);
+
+    /// Stop the decompression and close the file.
+    void close();
+
+    bool isOpen() const { return mOpen; }
+    Format format() const { return mFormat; }
+
+    /// Next decompressed block [data, data + size), valid until the next call.
+    /// @return false at the end of the file or when the decompression failed.
+    bool nextBlock(const char*& data, std::size_t& size);
+
+    /// Error message, empty when the file was opened and decompressed
+    /// correctly. The decompression thread may set it until #nextBlock()
+    /// returns false : the message is copied under the lock.
+    std::string error() const;
+
+private:
+    // non copyable
+    CompressedFile(const CompressedFile&);
+    CompressedFile& operator=(const CompressedFile&);
+
+    struct Block {
+        std::vector<char> data;
+        std::size_t size;
+        bool full;
+    };
+
+    void decompress(std::FILE* file);
+    bool readPlain(std::FILE* file);
+    bool readGzip(std::FILE* file);
+    bool readZstd(std::FILE* file);
+    // error of the decompression thread
+    void setError(const std::string& error);
+    // producer side : block to fill, 0 when the reading is stopped
+    Block* freeBlock();
+    void blockFilled(Block* block);
+
+    Format mFormat;
+    bool mOpen;
+    std::string mError;
+
+    std::thread mThread;
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    Block mBlocks[2];
+    std::size_t mProduced;
+    std::size_t mConsumed;
+    bool mEnd;
+    bool mStop;
+};
+
+/**
+  * @ingroup Loaders
+  * Stream buffer over the decompressed blocks of a CompressedFile, so that
+  * stream parsers can read compressed files :
+  *     CompressedFile file(filename);
+  *     CompressedStreamBuf buffer(file);
+  *     std::istream istream(&buffer);
+  */
+class CompressedStreamBuf : public std::streambuf {
+public:
+    explicit CompressedStreamBuf(CompressedFile& file) : mFile(file) {}
+
+protected:
+    int_type underflow();
+
+private:
+    CompressedFile& mFile;
+};
+
+} // END namespace loaders =====================================================
+
+#endif // COMPRESSEDFILE_H
@@ -0,0 +1,149 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Loaders {
+
+MappedFile::MappedFile() : mData(0), mSize(0), mOpen(false)
+#ifdef _WIN32
+  , mFileHandle(INVALID_HANDLE_VALUE), mMappingHandle(0)
+#endif
+{
+}
+
+MappedFile::MappedFile(const std::string& filename) : mData(0), mSize(0), mOpen(false)
+#ifdef _WIN32
+  , mFileHandle(INVALID_HANDLE_VALUE), mMappingHandle(0)
+#endif
+{
+    open(filename);
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+    mFileHandle = file;
+    mSize = std::size_t(size.QuadPart);
+    mOpen = true;
+    if (mSize == 0) {
+        // empty files can't be mapped
+        return true;
+    }
+    mMappingHandle = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+    if (mMappingHandle) {
+        mData = static_cast<const char*>(MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (!mData) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (mData) {
+        UnmapViewOfFile(mData);
+    }
+    if (mMappingHandle) {
+        CloseHandle(mMappingHandle);
+    }
+    if (mFileHandle != INVALID_HANDLE_VALUE) {
+        CloseHandle(mFileHandle);
+    }
+    mFileHandle = INVALID_HANDLE_VALUE;
+    mMappingHandle = 0;
+    mData = 0;
+    mSize = 0;
+    mOpen = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || !S_ISREG(status.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+    mSize = std::size_t(status.st_size);
+    if (mSize != 0) {
+        void* data = mmap(0, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            mSize = 0;
+            return false;
+        }
+        madvise(data, mSize, MADV_SEQUENTIAL);
+        mData = static_cast<const char*>(data);
+    }
+    // the mapping stays valid once the descriptor is closed
+    ::close(fd);
+    mOpen = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (mData) {
+        munmap(const_cast<char*>(mData), mSize);
+    }
+    mData = 0;
+    mSize = 0;
+    mOpen = false;
+}
+
+#endif
+
+} // namespace loaders
@@ -0,0 +1,73 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// =============================================================================
+namespace Loaders {
+// =============================================================================
+
+/**
+  * @ingroup Loaders
+  * Read-only memory mapping of a whole file.
+  * The content is accessible as a contiguous range of characters
+  * [begin(), end()) which is NOT null terminated.
+  * Only regular files can be mapped, open() fails on pipes and devices so
+  * that callers can fall back to stream reading.
+  */
+class MappedFile {
+public:
+    MappedFile();
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    /// Map the file "filename", any previously mapped file is released.
+    /// @return false if the file can't be opened or is not a regular file.
+    bool open(const std::string& filename);
+
+    /// Release the mapping.
+    void close();
+
+    bool isOpen() const { return mOpen; }
+
+    const char* begin() const { return mData; }
+    const char* end() const { return mData + mSize; }
+    std::size_t size() const { return mSize; }
+
+private:
+    // non copyable
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* mData;
+    std::size_t mSize;
+    bool mOpen;
+#ifdef _WIN32
+    void* mFileHandle;
+    void* mMappingHandle;
+#endif
+};
+
+} // END namespace loaders =====================================================
+
+#endif // MAPPEDFILE_H
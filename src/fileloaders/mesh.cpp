@@ -1,4 +1,4 @@
-/***************************************************************************
+﻿/***************************************************************************
  *   Copyright (C) 2012 by Mathias Paulin                                  *
  *   Mathias.Paulin@irit.fr                                                *
  *                                                                         *
@@ -18,16 +18,28 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 #include "mesh.h"
+#include "meshstreams.h"
 #include "utils.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <iostream>
+#include <utility>
 
 namespace Loaders {
 using namespace Utils;
+
 Mesh::Mesh (): mNbVertices(0), mNbTriangles(0), mHasTextureCoords (true), mHasNormal (true) {
 
 }
 
 Mesh::Mesh (const std::vector<float> &vertexBuffer, const std::vector<int> &triangleBuffer, const std::vector<int> &quadBuffer, bool hasNormal, bool hasTextureCoords) : mHasTextureCoords (hasTextureCoords), mHasNormal (hasNormal) {
+    // tailles connues : pas de reallocation
+    std::size_t stride = 3 + (hasNormal ? 3 : 0) + (hasTextureCoords ? 2 : 0);
+    mVertices.reserve(vertexBuffer.size() / stride);
+    mTriangles.reserve(triangleBuffer.size() / 3 + quadBuffer.size() / 2);
+
     // Construction de la liste des sommets et BBox
     mNbVertices = 0;
     std::vector<float>::const_iterator it = vertexBuffer.begin();
@@ -41,7 +53,10 @@ Mesh::Mesh (const std::vector<float> &vertexBuffer, const std::vector<int> &tria
             float ny = *it; ++it;
             float nz = *it; ++it;
                         v.normal = glm::vec3 (nx, ny, nz);
-                        glm::normalize(v.normal);
+                        // normale nulle laissee telle quelle
+                        float length = glm::length(v.normal);
+                        if (length > 0.f)
+                            v.normal /= length;
         }
         if (hasTextureCoords) {
             v.texcoord[0] = *it; ++it;
@@ -56,11 +71,11 @@ Mesh::Mesh (const std::vector<float> &vertexBuffer, const std::vector<int> &tria
     mNbTriangles = 0;
     while (fit != triangleBuffer.end()) {
         int index1 = *fit; ++fit;
-        assert (index1 < mNbVertices);
+        assert (std::size_t(index1) < mNbVertices);
         int index2 = *fit; ++fit;
-        assert (index2 < mNbVertices);
+        assert (std::size_t(index2) < mNbVertices);
         int index3 = *fit; ++fit;
-        assert (index3 < mNbVertices);
+        assert (std::size_t(index3) < mNbVertices);
         ++mNbTriangles;
         TriangleIndex f (index1, index2, index3);
         mTriangles.push_back (f);
@@ -70,13 +85,13 @@ Mesh::Mesh (const std::vector<float> &vertexBuffer, const std::vector<int> &tria
     std::vector<int>::const_iterator fiq = quadBuffer.begin();
     while (fiq != quadBuffer.end()) {
         int index1 = *fiq; ++fiq;
-        assert (index1 < mNbVertices);
+        assert (std::size_t(index1) < mNbVertices);
         int index2 = *fiq; ++fiq;
-        assert (index2 < mNbVertices);
+        assert (std::size_t(index2) < mNbVertices);
         int index3 = *fiq; ++fiq;
-        assert (index3 < mNbVertices);
+        assert (std::size_t(index3) < mNbVertices);
         int index4 = *fiq; ++fiq;
-        assert (index4 < mNbVertices);
+        assert (std::size_t(index4) < mNbVertices);
 
                 ++mNbTriangles;
                 TriangleIndex f1 (index1, index2, index3);
@@ -90,11 +105,49 @@ Mesh::Mesh (const std::vector<float> &vertexBuffer, const std::vector<int> &tria
 
     if (!hasNormal){
                 computeNormals();
-                hasNormal = true;
+                mHasNormal = true;
         }
 
 }
 
+Mesh::Mesh (const float* vertices, std::size_t nbVertices, const unsigned int* triangles, std::size_t nbTriangles, bool hasNormal, bool hasTextureCoords) : mHasTextureCoords (hasTextureCoords), mHasNormal (hasNormal) {
+    static_assert(sizeof(Vertex) == 8 * sizeof(float), "Vertex must be packed");
+    static_assert(sizeof(TriangleIndex) == 3 * sizeof(unsigned int), "TriangleIndex must be packed");
+    const Vertex* firstVertex = reinterpret_cast<const Vertex*>(vertices);
+    mVertices.assign(firstVertex, firstVertex + nbVertices);
+    mNbVertices = nbVertices;
+    const TriangleIndex* firstTriangle = reinterpret_cast<const TriangleIndex*>(triangles);
+    mTriangles.assign(firstTriangle, firstTriangle + nbTriangles);
+    mNbTriangles = nbTriangles;
+}
+
+Mesh::Mesh (std::size_t nbVertices, std::size_t nbTriangles) : mVertices(nbVertices), mNbVertices(nbVertices), mTriangles(nbTriangles, TriangleIndex(0, 0, 0)), mNbTriangles(nbTriangles), mHasTextureCoords (true), mHasNormal (true) {
+}
+
+Mesh::Mesh (const MeshStreams &streams, unsigned threadCount) : mVertices(streams.nbVertices()), mNbVertices(streams.nbVertices()), mNbTriangles(streams.nbTriangles()), mHasTextureCoords (streams.has(MeshStreams::TextureCoords)), mHasNormal (streams.has(MeshStreams::Normals)) {
+    const unsigned int* triangles = streams.triangleData();
+    const TriangleIndex* firstTriangle = reinterpret_cast<const TriangleIndex*>(triangles);
+    mTriangles.assign(firstTriangle, firstTriangle + mNbTriangles);
+    // composantes presentes, les autres restent nulles
+    int copied[MeshStreams::NbStreams], nbCopied = 0;
+    for (int s = 0; s < MeshStreams::NbStreams; ++s) {
+        if (streams.stream(MeshStreams::Stream(s))) {
+            copied[nbCopied++] = s;
+        }
+    }
+    float* vertices = vertexData();
+    parallelFor((mNbVertices + MeshStreams::ConversionChunk - 1) / MeshStreams::ConversionChunk, threadCount, [&](std::size_t c) {
+        std::size_t begin = c * MeshStreams::ConversionChunk, end = std::min(begin + MeshStreams::ConversionChunk, mNbVertices);
+        for (int k = 0; k < nbCopied; ++k) {
+            const float* source = streams.stream(MeshStreams::Stream(copied[k]));
+            float* destination = vertices + copied[k];
+            for (std::size_t i = begin; i < end; ++i) {
+                destination[MeshStreams::NbStreams * i] = source[i];
+            }
+        }
+    });
+}
+
 Mesh::Mesh(const Mesh &mesh)
 {
     mVertices = mesh.mVertices;
@@ -105,6 +158,24 @@ Mesh::Mesh(const Mesh &mesh)
     mHasNormal = mesh.mHasNormal;
 }
 
+Mesh::Mesh (const std::vector<const Mesh*> &parts, unsigned threadCount) : mNbVertices(0), mNbTriangles(0), mHasTextureCoords (true), mHasNormal (true) {
+    append(parts, threadCount);
+}
+
+Mesh::Mesh(Mesh &&mesh)
+    : mVertices(std::move(mesh.mVertices))
+    , mNbVertices(mesh.mNbVertices)
+    , mTriangles(std::move(mesh.mTriangles))
+    , mNbTriangles(mesh.mNbTriangles)
+    , mHasTextureCoords(mesh.mHasTextureCoords)
+    , mHasNormal(mesh.mHasNormal)
+{
+    mesh.mVertices.clear();
+    mesh.mTriangles.clear();
+    mesh.mNbVertices = 0;
+    mesh.mNbTriangles = 0;
+}
+
 Mesh::~Mesh() {
 
 }
@@ -117,27 +188,235 @@ void Mesh::printfInfo() const {
                   << std::endl;
 }
 
-void Mesh::computeNormals (void) {
-    for (TriangleIndexArray::iterator f_iter = mTriangles.begin() ; f_iter != mTriangles.end() ; ++f_iter) {
-        Vertex& v0 = mVertices[f_iter->indexes[0]];
-        Vertex& v1 = mVertices[f_iter->indexes[1]];
-        Vertex& v2 = mVertices[f_iter->indexes[2]];
-                glm::vec3 p0, p1, p2;
-        p0 = v0.position;
-        p1 = v1.position;
-        p2 = v2.position;
-
-                // compute normals
-                glm::vec3 f_normal;
-                f_normal = glm::cross((p1 - p0), (p2 - p0));
-                glm::normalize(f_normal);
-        v0.normal += f_normal;
-        v1.normal += f_normal;
-        v2.normal += f_normal;
+namespace {
+
+// sommets traites par tache des boucles paralleles
+const std::size_t WeldChunk = 1 << 16;
+
+std::size_t weldCellHash(long long x, long long y, long long z) {
+    unsigned long long h = (unsigned long long)x * 0x9e3779b97f4a7c15ULL;
+    h ^= (unsigned long long)y * 0xc2b2ae3d27d4eb4fULL;
+    h ^= (unsigned long long)z * 0x165667b19e3779f9ULL;
+    h ^= h >> 29;
+    return std::size_t(h);
+}
+
+}
+
+std::size_t Mesh::weld(float positionTolerance, float normalTolerance, float texcoordTolerance, unsigned threadCount) {
+    const std::size_t n = mVertices.size();
+    if (n < 2)
+        return 0;
+    const std::size_t chunks = (n + WeldChunk - 1) / WeldChunk;
+
+    // grille : cellules de 2.5 fois la tolerance, un sommet proche est dans la
+    // cellule ou dans la voisine du cote de la demi cellule du sommet (8
+    // cellules a parcourir). Taille limitee a 1e-9 de la boite englobante pour
+    // que les coordonnees des cellules tiennent sur 64 bits.
+    glm::vec3 low = mVertices[0].position, high = low;
+    for (std::size_t i = 1; i < n; ++i) {
+        low = glm::min(low, mVertices[i].position);
+        high = glm::max(high, mVertices[i].position);
     }
-    for (VertexArray::iterator v_iter = mVertices.begin() ; v_iter != mVertices.end() ; ++v_iter) {
-                glm::normalize(v_iter->normal);
+    glm::vec3 extent = high - low;
+    float cellSize = std::max(2.5f * positionTolerance, 1e-9f * std::max(extent.x, std::max(extent.y, extent.z)));
+    if (!(cellSize > 0.f))
+        cellSize = 1.f;
+    const float invCellSize = 1.f / cellSize;
+    auto cellOf = [&](const glm::vec3& p, long long* cell, long long* side) {
+        for (int k = 0; k < 3; ++k) {
+            float x = (p[k] - low[k]) * invCellSize;
+            cell[k] = (long long)std::floor(x);
+            side[k] = (x - cell[k] < 0.5f) ? -1 : 1;
+        }
+    };
+
+    // seaux de la table de hachage des cellules : tri par denombrement en
+    // parallele, puis sommets de chaque seau par indice croissant
+    std::size_t bucketsNumber = 1;
+    while (bucketsNumber < n)
+        bucketsNumber *= 2;
+    const std::size_t mask = bucketsNumber - 1;
+    std::vector<unsigned int> bucketOf(n);
+    std::vector<std::atomic<unsigned int> > cursors(bucketsNumber);
+    parallelFor(chunks, threadCount, [&](std::size_t c) {
+        long long cell[3], side[3];
+        for (std::size_t i = c * WeldChunk; i < std::min(n, (c + 1) * WeldChunk); ++i) {
+            cellOf(mVertices[i].position, cell, side);
+            bucketOf[i] = (unsigned int)(weldCellHash(cell[0], cell[1], cell[2]) & mask);
+            cursors[bucketOf[i]].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    std::vector<unsigned int> bucketStart(bucketsNumber + 1);
+    bucketStart[0] = 0;
+    for (std::size_t b = 0; b < bucketsNumber; ++b) {
+        bucketStart[b + 1] = bucketStart[b] + cursors[b].load(std::memory_order_relaxed);
+        cursors[b].store(bucketStart[b], std::memory_order_relaxed);
     }
+    std::vector<unsigned int> bucketVertices(n);
+    parallelFor(chunks, threadCount, [&](std::size_t c) {
+        for (std::size_t i = c * WeldChunk; i < std::min(n, (c + 1) * WeldChunk); ++i)
+            bucketVertices[cursors[bucketOf[i]].fetch_add(1, std::memory_order_relaxed)] = (unsigned int)i;
+    });
+    std::vector<std::atomic<unsigned int> >().swap(cursors);
+    std::vector<unsigned int>().swap(bucketOf);
+    const std::size_t bucketChunks = (bucketsNumber + WeldChunk - 1) / WeldChunk;
+    parallelFor(bucketChunks, threadCount, [&](std::size_t c) {
+        for (std::size_t b = c * WeldChunk; b < std::min(bucketsNumber, (c + 1) * WeldChunk); ++b)
+            std::sort(bucketVertices.begin() + bucketStart[b], bucketVertices.begin() + bucketStart[b + 1]);
+    });
+
+    const float position2 = positionTolerance * positionTolerance;
+    const float normal2 = normalTolerance * normalTolerance;
+    const float texcoord2 = texcoordTolerance * texcoordTolerance;
+    auto close = [&](const Vertex& a, const Vertex& b) {
+        glm::vec3 dp = a.position - b.position;
+        glm::vec3 dn = a.normal - b.normal;
+        glm::vec2 dt = a.texcoord - b.texcoord;
+        return glm::dot(dp, dp) <= position2 && glm::dot(dn, dn) <= normal2 && glm::dot(dt, dt) <= texcoord2;
+    };
+    // premier sommet j < i proche de i verifiant accept(j), i sinon
+    // (cellules voisines, seaux parcourus par indice croissant)
+    auto firstClose = [&](unsigned int i, const std::vector<unsigned int>* kept) {
+        const Vertex& v = mVertices[i];
+        long long cell[3], side[3];
+        cellOf(v.position, cell, side);
+        unsigned int first = i;
+        for (int dz = 0; dz < 2; ++dz)
+            for (int dy = 0; dy < 2; ++dy)
+                for (int dx = 0; dx < 2; ++dx) {
+                    std::size_t b = weldCellHash(cell[0] + dx * side[0], cell[1] + dy * side[1], cell[2] + dz * side[2]) & mask;
+                    for (unsigned int k = bucketStart[b]; k < bucketStart[b + 1]; ++k) {
+                        unsigned int j = bucketVertices[k];
+                        if (j >= first)
+                            break;
+                        if ((!kept || (*kept)[j] == j) && close(mVertices[j], v)) {
+                            first = j;
+                            break;
+                        }
+                    }
+                }
+        return first;
+    };
+
+    // Etape 1 (parallele) : premier sommet proche de chaque sommet
+    std::vector<unsigned int> representative(n);
+    parallelFor(chunks, threadCount, [&](std::size_t c) {
+        for (std::size_t i = c * WeldChunk; i < std::min(n, (c + 1) * WeldChunk); ++i)
+            representative[i] = firstClose((unsigned int)i, 0);
+    });
+    // Etape 2 : un sommet est fusionne avec le premier sommet conserve proche
+    // de lui, c'est le premier sommet proche sauf s'il a lui-meme ete fusionne
+    // (nouvelle recherche, rare)
+    std::vector<unsigned int> remap(n);
+    unsigned int keptNumber = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        unsigned int r = representative[i];
+        if (r != i && representative[r] != r)
+            representative[i] = r = firstClose((unsigned int)i, &representative);
+        remap[i] = (r == i) ? keptNumber++ : remap[r];
+    }
+    std::vector<unsigned int>().swap(bucketVertices);
+    std::vector<unsigned int>().swap(bucketStart);
+
+    VertexArray vertices(keptNumber);
+    parallelFor(chunks, threadCount, [&](std::size_t c) {
+        for (std::size_t i = c * WeldChunk; i < std::min(n, (c + 1) * WeldChunk); ++i) {
+            if (representative[i] == i)
+                vertices[remap[i]] = mVertices[i];
+        }
+    });
+    mVertices.swap(vertices);
+    mNbVertices = keptNumber;
+
+    // triangles renumerotes, sans les triangles degeneres : nombre de
+    // triangles conserves par tache, puis ecriture a leur position
+    const std::size_t t = mTriangles.size();
+    const std::size_t triangleChunks = (t + WeldChunk - 1) / WeldChunk;
+    std::vector<std::size_t> chunkStart(triangleChunks + 1, 0);
+    auto remapTriangle = [&](std::size_t f, TriangleIndex& triangle) {
+        for (int k = 0; k < 3; ++k)
+            triangle[k] = remap[mTriangles[f][k]];
+        return triangle[0] != triangle[1] && triangle[1] != triangle[2] && triangle[2] != triangle[0];
+    };
+    parallelFor(triangleChunks, threadCount, [&](std::size_t c) {
+        TriangleIndex triangle(0, 0, 0);
+        for (std::size_t f = c * WeldChunk; f < std::min(t, (c + 1) * WeldChunk); ++f) {
+            if (remapTriangle(f, triangle))
+                chunkStart[c + 1]++;
+        }
+    });
+    for (std::size_t c = 0; c < triangleChunks; ++c)
+        chunkStart[c + 1] += chunkStart[c];
+    TriangleIndexArray triangles(chunkStart[triangleChunks], TriangleIndex(0, 0, 0));
+    parallelFor(triangleChunks, threadCount, [&](std::size_t c) {
+        TriangleIndex triangle(0, 0, 0);
+        std::size_t kept = chunkStart[c];
+        for (std::size_t f = c * WeldChunk; f < std::min(t, (c + 1) * WeldChunk); ++f) {
+            if (remapTriangle(f, triangle))
+                triangles[kept++] = triangle;
+        }
+    });
+    mTriangles.swap(triangles);
+    mNbTriangles = mTriangles.size();
+
+    return n - keptNumber;
+}
+
+void Mesh::computeNormals (void) {
+    // calcul sur les positions seules, rangees par composante
+    MeshStreams streams(*this, MeshStreams::Positions);
+    streams.computeNormals();
+    const float* nx = streams.stream(MeshStreams::NX);
+    const float* ny = streams.stream(MeshStreams::NY);
+    const float* nz = streams.stream(MeshStreams::NZ);
+    for (std::size_t i = 0; i < mNbVertices; ++i) {
+        mVertices[i].normal = glm::vec3(nx[i], ny[i], nz[i]);
+    }
+}
+
+void Mesh::optimizeVertexCache(unsigned cacheSize) {
+    if (mNbTriangles == 0)
+        return;
+    // ordre des triangles, puis sommets dans leur ordre d'utilisation
+    Loaders::optimizeVertexCache(triangleData(), mNbTriangles, mNbVertices, cacheSize);
+    reorderVertices();
+}
+
+void Mesh::optimizeOverdraw(float threshold, unsigned cacheSize) {
+    if (mNbTriangles == 0)
+        return;
+    Loaders::optimizeOverdraw(triangleData(), mNbTriangles, vertexData(), 8, mNbVertices, threshold, cacheSize);
+    reorderVertices();
+}
+
+void Mesh::reorderVertices() {
+    std::vector<unsigned int> order;
+    optimizeVertexFetch(triangleData(), mNbTriangles, mNbVertices, order);
+    VertexArray vertices(mNbVertices);
+    for (std::size_t i = 0; i < mNbVertices; ++i)
+        vertices[i] = mVertices[order[i]];
+    mVertices.swap(vertices);
+}
+
+VertexCacheStatistics Mesh::vertexCacheStatistics(unsigned cacheSize) const {
+    return Loaders::vertexCacheStatistics(triangleData(), mNbTriangles, mNbVertices, cacheSize);
+}
+
+const float* Mesh::vertexData() const {
+    return mVertices.empty() ? 0 : &mVertices[0].position[0];
+}
+
+const unsigned int* Mesh::triangleData() const {
+    return mTriangles.empty() ? 0 : mTriangles[0].indexes;
+}
+
+float* Mesh::vertexData() {
+    return mVertices.empty() ? 0 : &mVertices[0].position[0];
+}
+
+unsigned int* Mesh::triangleData() {
+    return mTriangles.empty() ? 0 : mTriangles[0].indexes;
 }
 
 void Mesh::getData ( std::vector<float> &vertexBuffer, std::vector<int> &triangleBuffer, bool &parametrized ){
@@ -166,17 +445,60 @@ void Mesh::getData ( std::vector<float> &vertexBuffer, std::vector<int> &triangl
 }
 
 Mesh & Mesh::operator+=(const Mesh &m){
-    for (VertexArray::const_iterator v_iter = m.mVertices.begin() ; v_iter != m.mVertices.end() ; ++v_iter) {
-        mVertices.push_back(*v_iter);
-    }
-    for (TriangleIndexArray::const_iterator f_iter = m.mTriangles.begin() ; f_iter != m.mTriangles.end() ; ++f_iter) {
-        TriangleIndex f (f_iter->indexes[0]+mNbVertices,
-                         f_iter->indexes[1]+mNbVertices,
-                         f_iter->indexes[2]+mNbVertices);
-        mTriangles.push_back(f);
+    return append(std::vector<const Mesh*>(1, &m), 1);
+}
+
+Mesh & Mesh::append(const std::vector<const Mesh*> &parts, unsigned threadCount){
+    assert(mVertices.size() == mNbVertices && mTriangles.size() == mNbTriangles);
+    // premiers sommet et triangle de chaque partie (somme prefixe)
+    const std::size_t nbParts = parts.size();
+    std::vector<std::size_t> firstVertex(nbParts + 1), firstTriangle(nbParts + 1);
+    firstVertex[0] = mNbVertices;
+    firstTriangle[0] = mNbTriangles;
+    for (std::size_t p = 0; p < nbParts; ++p) {
+        firstVertex[p + 1] = firstVertex[p] + parts[p]->mNbVertices;
+        firstTriangle[p + 1] = firstTriangle[p] + parts[p]->mNbTriangles;
+        mHasNormal = mHasNormal && parts[p]->mHasNormal;
+        mHasTextureCoords = mHasTextureCoords && parts[p]->mHasTextureCoords;
     }
-    mNbVertices+=m.mNbVertices;
-    mNbTriangles+=m.mNbTriangles;
+    // indices des triangles sur 32 bits
+    assert(firstVertex[nbParts] - 1 <= 0xffffffffu || firstVertex[nbParts] == 0);
+
+    // une seule allocation
+    mVertices.resize(firstVertex[nbParts]);
+    mTriangles.resize(firstTriangle[nbParts], TriangleIndex(0, 0, 0));
+
+    // copie par blocs de WeldChunk elements, un bloc pouvant couvrir
+    // plusieurs parties
+    const std::size_t vertices = firstVertex[nbParts] - mNbVertices;
+    parallelFor((vertices + WeldChunk - 1) / WeldChunk, threadCount, [&](std::size_t c) {
+        std::size_t begin = mNbVertices + c * WeldChunk;
+        std::size_t end = std::min(begin + WeldChunk, firstVertex[nbParts]);
+        std::size_t p = std::upper_bound(firstVertex.begin(), firstVertex.end(), begin) - firstVertex.begin() - 1;
+        for (std::size_t v = begin; v < end; ++p) {
+            std::size_t last = std::min(end, firstVertex[p + 1]);
+            std::copy(parts[p]->mVertices.begin() + (v - firstVertex[p]), parts[p]->mVertices.begin() + (last - firstVertex[p]), mVertices.begin() + v);
+            v = last;
+        }
+    });
+    const std::size_t triangles = firstTriangle[nbParts] - mNbTriangles;
+    parallelFor((triangles + WeldChunk - 1) / WeldChunk, threadCount, [&](std::size_t c) {
+        std::size_t begin = mNbTriangles + c * WeldChunk;
+        std::size_t end = std::min(begin + WeldChunk, firstTriangle[nbParts]);
+        std::size_t p = std::upper_bound(firstTriangle.begin(), firstTriangle.end(), begin) - firstTriangle.begin() - 1;
+        for (std::size_t t = begin; t < end; ++p) {
+            std::size_t last = std::min(end, firstTriangle[p + 1]);
+            const unsigned int offset = (unsigned int)firstVertex[p];
+            TriangleIndexArray::const_iterator source = parts[p]->mTriangles.begin() + (t - firstTriangle[p]);
+            for (; t < last; ++t, ++source) {
+                for (int k = 0; k < 3; ++k) {
+                    mTriangles[t].indexes[k] = source->indexes[k] + offset;
+                }
+            }
+        }
+    });
+    mNbVertices = firstVertex[nbParts];
+    mNbTriangles = firstTriangle[nbParts];
     return *this;
 }
 
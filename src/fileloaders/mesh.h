@@ -23,11 +23,14 @@
 
 #include <vector>
 #include "glm/glm.hpp"
+#include "vertexcache.h"
 
 // =============================================================================
 namespace Loaders {
 // =============================================================================
 
+class MeshStreams;
+
 /**
   *  @ingroup Loaders
   *
@@ -54,9 +57,46 @@ public:
           bool hasNormals, bool hasTextureCoords
           );
 
+    /**
+      * Constructor from the internal representation, as given by
+      * #vertexData() and #triangleData() (e.g. from a cache file).
+      * "vertices" holds nbVertices vertices (x,y,z,nx,ny,nz,u,v) and
+      * "triangles" nbTriangles triples of vertex indices.
+      */
+    Mesh (const float* vertices, std::size_t nbVertices,
+          const unsigned int* triangles, std::size_t nbTriangles,
+          bool hasNormals, bool hasTextureCoords
+          );
+
+    /**
+      * Constructor of a mesh of nbVertices vertices and nbTriangles
+      * triangles, written later through #vertexData() and #triangleData()
+      * (e.g. by a loader writing the final mesh directly).
+      */
+    Mesh (std::size_t nbVertices, std::size_t nbTriangles);
+
+    /**
+      * Concatenation of parts in a single pass : vertex and triangle offsets
+      * of the parts are computed first, the buffers are allocated once, then
+      * the parts are copied (and their triangles rebased) by threadCount
+      * threads (0 : all cores). The mesh has normals (texture coordinates)
+      * if all the parts have some.
+      */
+    Mesh (const std::vector<const Mesh*> &parts, unsigned threadCount = 0);
+
+    /**
+      * Conversion to the interleaved layout of a mesh stored by attribute
+      * streams, by threadCount threads (0 : all cores). Missing normals and
+      * texture coordinates are zero.
+      */
+    explicit Mesh (const MeshStreams &streams, unsigned threadCount = 0);
+
     /// Copy contructor.
     Mesh(const Mesh &mesh);
 
+    /// Move constructor : takes the buffers of mesh, which is left empty.
+    Mesh(Mesh &&mesh);
+
     /// Destructor.
     virtual ~Mesh();
 
@@ -68,8 +108,58 @@ public:
     /// Concatenates 2 meshes.
     Mesh & operator+=(const Mesh &m);
 
-    int nbVertices () const { return mNbVertices;  }
-    int nbTriangles() const { return mNbTriangles; }
+    /// Concatenates parts at the end of the mesh, as the constructor from
+    /// parts does.
+    Mesh & append(const std::vector<const Mesh*> &parts, unsigned threadCount = 0);
+
+    std::size_t nbVertices () const { return mNbVertices;  }
+    std::size_t nbTriangles() const { return mNbTriangles; }
+
+    bool hasNormals() const { return mHasNormal; }
+    bool hasTextureCoords() const { return mHasTextureCoords; }
+
+    /// Vertices in raw format : #nbVertices() times (x,y,z,nx,ny,nz,u,v).
+    const float* vertexData() const;
+    float* vertexData();
+    /// Triangles in raw format : #nbTriangles() triples of vertex indices.
+    const unsigned int* triangleData() const;
+    unsigned int* triangleData();
+
+    /**
+      * Vertex welding : merges the vertices whose positions, normals and
+      * texture coordinates are closer than the given distances (0 : equal
+      * values), then removes the degenerated triangles. The three
+      * tolerances are absolute Euclidean distances : normals are expected
+      * to be unit vectors for normalTolerance to have the same meaning on
+      * every mesh. Vertices are found by a uniform hash grid of cells of
+      * size 2.5 * positionTolerance (at least 1e-9 of the bounding box), in
+      * the cell of the vertex and the neighbour cells on the side of its
+      * half cell (8 cells). They are kept in their order, each one being
+      * merged into the first kept vertex close to it (no drift along chains
+      * of close vertices).
+      * Linear time, the grid and the triangles are built by threadCount
+      * threads (0 : all cores).
+      * @return the number of removed vertices
+      */
+    std::size_t weld(float positionTolerance, float normalTolerance, float texcoordTolerance, unsigned threadCount = 0);
+
+    /**
+      * Reorders the triangles for a post-transform vertex cache of
+      * cacheSize vertices (see Loaders::optimizeVertexCache()), then the
+      * vertices in their order of first use by the triangles.
+      */
+    void optimizeVertexCache(unsigned cacheSize = 16);
+
+    /**
+      * Reorders the triangles to reduce overdraw (see
+      * Loaders::optimizeOverdraw()), after #optimizeVertexCache() with the
+      * same cacheSize, then the vertices in their order of first use.
+      */
+    void optimizeOverdraw(float threshold = 1.05f, unsigned cacheSize = 16);
+
+    /// ACMR and ATVR of the triangles for a FIFO vertex cache of cacheSize
+    /// vertices.
+    VertexCacheStatistics vertexCacheStatistics(unsigned cacheSize = 16) const;
 
     /// Prints basic information about the mesh on stderr.
     void printfInfo() const;
@@ -116,15 +206,18 @@ protected:
     typedef std::vector<TriangleIndex> TriangleIndexArray;
 
     VertexArray mVertices; ///< vector of #Vertex
-    int mNbVertices; ///< number of vertices
+    std::size_t mNbVertices; ///< number of vertices
 
     TriangleIndexArray mTriangles; ///< vector of #TriangleIndex
-    int mNbTriangles; ///< number of triangles
+    std::size_t mNbTriangles; ///< number of triangles
 
     bool mHasTextureCoords;
     bool mHasNormal;
 
-    /// Compute smothed normals at each vertex.
+    /// Vertices in their order of first use by the triangles.
+    void reorderVertices();
+
+    /// Compute smothed normals at each vertex (see MeshStreams::computeNormals()).
     void computeNormals (void);
 
 };
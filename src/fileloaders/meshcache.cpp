@@ -0,0 +1,224 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#include "meshcache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace Loaders {
+
+namespace {
+
+// arrays alignment in the cache files
+const std::size_t ArrayAlignment = 16;
+
+std::size_t padding(std::size_t offset)
+{
+    return (ArrayAlignment - offset % ArrayAlignment) % ArrayAlignment;
+}
+
+// size and modification time, false if the file doesn't exist
+bool fileStatus(const std::string& path, long long& size, long long& time)
+{
+#ifdef _WIN32
+    struct _stat64 status;
+    if (_stat64(path.c_str(), &status) != 0) {
+        return false;
+    }
+    time = (long long)status.st_mtime;
+#else
+    struct stat status;
+    if (stat(path.c_str(), &status) != 0) {
+        return false;
+    }
+#if defined(__linux__)
+    time = (long long)status.st_mtim.tv_sec * 1000000000LL + status.st_mtim.tv_nsec;
+#else
+    time = (long long)status.st_mtime;
+#endif
+#endif
+    size = (long long)status.st_size;
+    return true;
+}
+
+unsigned long long rotate(unsigned long long x, int bits)
+{
+    return (x << bits) | (x >> (64 - bits));
+}
+
+unsigned long long fileHash(const std::string& path)
+{
+    MappedFile file(path);
+    return CacheSource::hash(file.begin(), file.size());
+}
+
+}
+
+// -----------------------------------------------------------------------------
+
+CacheSource CacheSource::of(const std::string& path)
+{
+    CacheSource source;
+    source.mPath = path;
+    if (fileStatus(path, source.mSize, source.mTime)) {
+        source.mHash = fileHash(path);
+    }
+    else {
+        source.mSize = -1;
+    }
+    return source;
+}
+
+bool CacheSource::isCurrent() const
+{
+    long long size, time;
+    if (!fileStatus(mPath, size, time)) {
+        return mSize == -1;
+    }
+    if (size != mSize) {
+        return false;
+    }
+    return time == mTime || fileHash(mPath) == mHash;
+}
+
+unsigned long long CacheSource::hash(const char* data, std::size_t size)
+{
+    // 4 independent lanes of 64 bits words, then the remaining bytes
+    const unsigned long long prime1 = 0x9e3779b185ebca87ULL;
+    const unsigned long long prime2 = 0xc2b2ae3d27d4eb4fULL;
+    unsigned long long lanes[4] = { prime1 + prime2, prime2, 0, 0 - prime1 };
+    std::size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int l = 0; l < 4; ++l) {
+            unsigned long long word;
+            std::memcpy(&word, data + i + 8 * l, sizeof(word));
+            lanes[l] = rotate(lanes[l] + word * prime2, 31) * prime1;
+        }
+    }
+    unsigned long long h = (unsigned long long)size * prime1;
+    for (int l = 0; l < 4; ++l) {
+        h = rotate(h ^ (rotate(lanes[l] * prime2, 31) * prime1), 27) * prime1 + prime2;
+    }
+    for (; i < size; ++i) {
+        h = rotate(h ^ ((unsigned char)data[i] * prime1), 11) * prime2;
+    }
+    h ^= h >> 33;
+    h *= prime2;
+    h ^= h >> 29;
+    return h;
+}
+
+// -----------------------------------------------------------------------------
+
+CacheWriter::CacheWriter(const std::string& filename)
+    : mFilename(filename), mTemporary(filename + ".tmp"),
+      mFile(mTemporary.c_str(), std::ios::binary | std::ios::trunc), mCommitted(false)
+{
+}
+
+CacheWriter::~CacheWriter()
+{
+    if (!mCommitted) {
+        mFile.close();
+        std::remove(mTemporary.c_str());
+    }
+}
+
+void CacheWriter::write(const std::string& value)
+{
+    unsigned int length = (unsigned int)value.size();
+    write(length);
+    mFile.write(value.data(), value.size());
+}
+
+void CacheWriter::writeArray(const void* data, std::size_t size)
+{
+    static const char zeros[ArrayAlignment] = { 0 };
+    mFile.write(zeros, padding(std::size_t(mFile.tellp())));
+    mFile.write(static_cast<const char*>(data), size);
+}
+
+bool CacheWriter::commit()
+{
+    mFile.close();
+    if (mFile.fail()) {
+        return false;
+    }
+    // rename doesn't replace an existing file on Windows
+    std::remove(mFilename.c_str());
+    if (std::rename(mTemporary.c_str(), mFilename.c_str()) != 0) {
+        return false;
+    }
+    mCommitted = true;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+CacheReader::CacheReader(const std::string& filename) : mCurrent(0), mOk(false)
+{
+    if (mFile.open(filename)) {
+        mCurrent = mFile.begin();
+        mOk = true;
+    }
+}
+
+bool CacheReader::readBytes(void* data, std::size_t size)
+{
+    if (!mOk || std::size_t(mFile.end() - mCurrent) < size) {
+        mOk = false;
+        return false;
+    }
+    std::memcpy(data, mCurrent, size);
+    mCurrent += size;
+    return true;
+}
+
+bool CacheReader::read(std::string& value)
+{
+    unsigned int length;
+    if (!read(length) || std::size_t(mFile.end() - mCurrent) < length) {
+        mOk = false;
+        return false;
+    }
+    value.assign(mCurrent, length);
+    mCurrent += length;
+    return true;
+}
+
+const char* CacheReader::readArray(std::size_t size)
+{
+    if (!mOk) {
+        return 0;
+    }
+    std::size_t skip = padding(std::size_t(mCurrent - mFile.begin()));
+    std::size_t left = std::size_t(mFile.end() - mCurrent);
+    if (left < skip || left - skip < size) {
+        mOk = false;
+        return 0;
+    }
+    const char* array = mCurrent + skip;
+    mCurrent = array + size;
+    return array;
+}
+
+} // namespace loaders
@@ -0,0 +1,117 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include "mappedfile.h"
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+
+// =============================================================================
+namespace Loaders {
+// =============================================================================
+
+/**
+  * @ingroup Loaders
+  * Source file of a cache : path, size, modification time and content hash.
+  * A cache stays valid while its sources have the same size and either the
+  * same modification time or the same content (files copied or touched).
+  * Missing files are recorded with a size of -1, so that a cache is also
+  * invalidated when a missing file appears.
+  */
+class CacheSource {
+public:
+    CacheSource() : mSize(-1), mTime(0), mHash(0) {}
+
+    /// Key of the file "path" as it is now (the content is hashed).
+    static CacheSource of(const std::string& path);
+
+    /// Whether the file still has this key.
+    bool isCurrent() const;
+
+    /// 64 bits hash of the content [data, data + size).
+    static unsigned long long hash(const char* data, std::size_t size);
+
+    std::string mPath;
+    long long mSize;
+    long long mTime;
+    unsigned long long mHash;
+};
+
+/**
+  * @ingroup Loaders
+  * Binary cache file writer. Values are written in the byte order of the
+  * machine, arrays are aligned on 16 bytes so that they can be used in place
+  * once the cache is mapped. The cache is written in a temporary file which
+  * replaces "filename" on commit(), a reader never sees a partial cache.
+  */
+class CacheWriter {
+public:
+    explicit CacheWriter(const std::string& filename);
+    ~CacheWriter();
+
+    template <typename T>
+    void write(const T& value) { mFile.write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+    void write(const std::string& value);
+    void writeArray(const void* data, std::size_t size);
+
+    /// Replace the cache file by the written content.
+    /// @return false if the cache could not be written.
+    bool commit();
+
+private:
+    std::string mFilename;
+    std::string mTemporary;
+    std::ofstream mFile;
+    bool mCommitted;
+};
+
+/**
+  * @ingroup Loaders
+  * Binary cache file reader over a memory mapped cache. Every read is bounds
+  * checked : once a read fails, the following ones fail too and ok() is false.
+  */
+class CacheReader {
+public:
+    /// Map the cache "filename", ok() is false if it can't be mapped.
+    explicit CacheReader(const std::string& filename);
+
+    bool ok() const { return mOk; }
+
+    template <typename T>
+    bool read(T& value) { return readBytes(&value, sizeof(T)); }
+    bool read(std::string& value);
+    /// Array of "size" bytes, aligned as written by CacheWriter::writeArray().
+    /// @return a pointer in the mapping, valid as long as the reader, 0 on failure
+    const char* readArray(std::size_t size);
+
+private:
+    bool readBytes(void* data, std::size_t size);
+
+    MappedFile mFile;
+    const char* mCurrent;
+    bool mOk;
+};
+
+} // END namespace loaders =====================================================
+
+#endif // MESHCACHE_H
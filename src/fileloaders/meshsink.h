@@ -0,0 +1,78 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef MESHSINK_H
+#define MESHSINK_H
+
+#include "mesh.h"
+
+#include <string>
+#include <vector>
+
+// =============================================================================
+namespace Loaders {
+// =============================================================================
+
+/**
+  * @ingroup Loaders
+  * Destination of meshes written directly in their final storage, for
+  * instance mapped OpenGL buffers. The loader first gives the exact size of
+  * each mesh to beginMesh(), then writes its vertices (x,y,z,nx,ny,nz,u,v)
+  * and triangles once, possibly from several threads, and calls endMesh().
+  * beginMesh() and endMesh() are called by the thread of the loader.
+  */
+class MeshSink {
+public:
+    virtual ~MeshSink() {}
+
+    /// Storage of the next mesh : nbVertices x 8 floats and nbTriangles x 3
+    /// vertex indices, valid until endMesh().
+    virtual void beginMesh(const std::string& name, std::size_t nbVertices, std::size_t nbTriangles, float*& vertices, unsigned int*& triangles) = 0;
+
+    /// The storage of the mesh number "mesh" (in the order of beginMesh()
+    /// calls) is written.
+    virtual void endMesh(std::size_t mesh) = 0;
+};
+
+/**
+  * @ingroup Loaders
+  * #MeshSink in main memory : the meshes are written directly in new #Mesh
+  * objects, appended to a vector of meshes.
+  */
+class MeshArraySink : public MeshSink {
+public:
+    explicit MeshArraySink(std::vector<Mesh*>& meshes) : mMeshes(meshes) {}
+
+    void beginMesh(const std::string& /*name*/, std::size_t nbVertices, std::size_t nbTriangles, float*& vertices, unsigned int*& triangles)
+    {
+        Mesh* mesh = new Mesh(nbVertices, nbTriangles);
+        vertices = mesh->vertexData();
+        triangles = mesh->triangleData();
+        mMeshes.push_back(mesh);
+    }
+
+    void endMesh(std::size_t /*mesh*/) {}
+
+private:
+    std::vector<Mesh*>& mMeshes;
+};
+
+} // END namespace loaders =====================================================
+
+#endif // MESHSINK_H
@@ -0,0 +1,311 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#include "meshstreams.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+
+namespace Loaders {
+
+namespace {
+
+// streams of an attribute
+void attributeStreams(MeshStreams::Attribute attribute, int& first, int& last)
+{
+    switch (attribute) {
+    case MeshStreams::Normals:
+        first = MeshStreams::NX, last = MeshStreams::NZ;
+        break;
+    case MeshStreams::TextureCoords:
+        first = MeshStreams::U, last = MeshStreams::V;
+        break;
+    default:
+        first = MeshStreams::X, last = MeshStreams::Z;
+        break;
+    }
+}
+
+const MeshStreams::Attribute Attributes[] = { MeshStreams::Positions, MeshStreams::Normals, MeshStreams::TextureCoords };
+
+// triangles processed by task of the parallel loops
+const std::size_t NormalChunk = 1 << 14;
+
+// triangles of the vectorized loops
+const std::size_t NormalBatch = 16;
+
+// unit vector, zero vector left as is
+inline void normalizeVector(float& x, float& y, float& z)
+{
+    float length2 = x * x + y * y + z * z;
+    float scale = length2 > 0.f ? 1.f / std::sqrt(length2) : 0.f;
+    x *= scale, y *= scale, z *= scale;
+}
+
+// angle between the edges (ax,ay,az) and (bx,by,bz)
+inline float cornerAngle(float ax, float ay, float az, float bx, float by, float bz)
+{
+    float cx = ay * bz - az * by, cy = az * bx - ax * bz, cz = ax * by - ay * bx;
+    return std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), ax * bx + ay * by + az * bz);
+}
+
+}
+
+MeshStreams::MeshStreams()
+    : mNbVertices(0)
+    , mNbTriangles(0)
+    , mAttributes(Positions)
+{
+}
+
+MeshStreams::MeshStreams(std::size_t nbVertices, std::size_t nbTriangles, unsigned attributes)
+    : mNbVertices(nbVertices)
+    , mNbTriangles(nbTriangles)
+    , mAttributes(0)
+    , mTriangles(3 * nbTriangles, 0)
+{
+    setAttributes(attributes);
+}
+
+MeshStreams::MeshStreams(const Mesh& mesh, unsigned attributes, unsigned threadCount)
+    : mNbVertices(mesh.nbVertices())
+    , mNbTriangles(mesh.nbTriangles())
+    , mAttributes(0)
+{
+    if (!mesh.hasNormals()) {
+        attributes &= ~unsigned(Normals);
+    }
+    if (!mesh.hasTextureCoords()) {
+        attributes &= ~unsigned(TextureCoords);
+    }
+    setAttributes(attributes);
+
+    // streams of the copied attributes
+    int copied[NbStreams], nbCopied = 0;
+    for (int s = 0; s < NbStreams; ++s) {
+        if (!mStreams[s].empty()) {
+            copied[nbCopied++] = s;
+        }
+    }
+    const float* vertices = mesh.vertexData();
+    parallelFor((mNbVertices + ConversionChunk - 1) / ConversionChunk, threadCount, [&](std::size_t c) {
+        std::size_t begin = c * ConversionChunk, end = std::min(begin + ConversionChunk, mNbVertices);
+        for (int k = 0; k < nbCopied; ++k) {
+            float* destination = &mStreams[copied[k]][0];
+            const float* source = vertices + copied[k];
+            for (std::size_t i = begin; i < end; ++i) {
+                destination[i] = source[NbStreams * i];
+            }
+        }
+    });
+    const unsigned int* triangles = mesh.triangleData();
+    mTriangles.assign(triangles, triangles + 3 * mNbTriangles);
+}
+
+void MeshStreams::setAttributes(unsigned attributes)
+{
+    attributes = (attributes & AllAttributes) | Positions;
+    for (std::size_t a = 0; a < sizeof(Attributes) / sizeof(Attributes[0]); ++a) {
+        int first, last;
+        attributeStreams(Attributes[a], first, last);
+        for (int s = first; s <= last; ++s) {
+            if (attributes & Attributes[a]) {
+                mStreams[s].resize(mNbVertices, 0.f);
+            } else {
+                std::vector<float>().swap(mStreams[s]);
+            }
+        }
+    }
+    mAttributes = attributes;
+}
+
+void MeshStreams::computeNormals(NormalWeighting weighting, unsigned threadCount)
+{
+    setAttributes(mAttributes | Normals);
+    vertexNormals(stream(X), stream(Y), stream(Z), 1, triangleData(), mNbTriangles, mNbVertices,
+                  stream(NX), stream(NY), stream(NZ), 1, weighting, threadCount);
+}
+
+void MeshStreams::bounds(glm::vec3& min, glm::vec3& max) const
+{
+    min = max = glm::vec3(0.f, 0.f, 0.f);
+    if (mNbVertices == 0) {
+        return;
+    }
+    // one pass per stream : branch free loops the compiler vectorizes
+    for (int s = X; s <= Z; ++s) {
+        const float* p = stream(Stream(s));
+        float lo = p[0], hi = p[0];
+        for (std::size_t i = 1; i < mNbVertices; ++i) {
+            lo = p[i] < lo ? p[i] : lo;
+            hi = p[i] > hi ? p[i] : hi;
+        }
+        min[s] = lo;
+        max[s] = hi;
+    }
+}
+
+void triangleNormals(const float* x, const float* y, const float* z, std::size_t stride,
+                     const unsigned int* triangles, std::size_t nbTriangles,
+                     float* nx, float* ny, float* nz, std::size_t normalStride,
+                     bool normalize, unsigned threadCount)
+{
+    const std::size_t chunks = (nbTriangles + NormalChunk - 1) / NormalChunk;
+    parallelFor(chunks, threadCount, [&](std::size_t c) {
+        // edges of a batch of triangles, then cross products on contiguous
+        // arrays of fixed size
+        float e1x[NormalBatch], e1y[NormalBatch], e1z[NormalBatch];
+        float e2x[NormalBatch], e2y[NormalBatch], e2z[NormalBatch];
+        float fx[NormalBatch], fy[NormalBatch], fz[NormalBatch];
+        const std::size_t end = std::min(nbTriangles, (c + 1) * NormalChunk);
+        for (std::size_t first = c * NormalChunk; first < end; first += NormalBatch) {
+            const std::size_t count = std::min(NormalBatch, end - first);
+            for (std::size_t k = 0; k < count; ++k) {
+                std::size_t t = first + k;
+                std::size_t i0 = triangles ? triangles[3 * t] : 3 * t;
+                std::size_t i1 = triangles ? triangles[3 * t + 1] : 3 * t + 1;
+                std::size_t i2 = triangles ? triangles[3 * t + 2] : 3 * t + 2;
+                i0 *= stride, i1 *= stride, i2 *= stride;
+                e1x[k] = x[i1] - x[i0], e1y[k] = y[i1] - y[i0], e1z[k] = z[i1] - z[i0];
+                e2x[k] = x[i2] - x[i0], e2y[k] = y[i2] - y[i0], e2z[k] = z[i2] - z[i0];
+            }
+            for (std::size_t k = count; k < NormalBatch; ++k) {
+                e1x[k] = e1y[k] = e1z[k] = e2x[k] = e2y[k] = e2z[k] = 0.f;
+            }
+            for (std::size_t k = 0; k < NormalBatch; ++k) {
+                fx[k] = e1y[k] * e2z[k] - e1z[k] * e2y[k];
+                fy[k] = e1z[k] * e2x[k] - e1x[k] * e2z[k];
+                fz[k] = e1x[k] * e2y[k] - e1y[k] * e2x[k];
+            }
+            if (normalize) {
+                for (std::size_t k = 0; k < NormalBatch; ++k) {
+                    float length2 = fx[k] * fx[k] + fy[k] * fy[k] + fz[k] * fz[k];
+                    float scale = length2 > 0.f ? 1.f / std::sqrt(length2) : 0.f;
+                    fx[k] *= scale, fy[k] *= scale, fz[k] *= scale;
+                }
+            }
+            for (std::size_t k = 0; k < count; ++k) {
+                std::size_t n = (first + k) * normalStride;
+                nx[n] = fx[k], ny[n] = fy[k], nz[n] = fz[k];
+            }
+        }
+    });
+}
+
+void vertexNormals(const float* x, const float* y, const float* z, std::size_t stride,
+                   const unsigned int* triangles, std::size_t nbTriangles, std::size_t nbVertices,
+                   float* nx, float* ny, float* nz, std::size_t normalStride,
+                   MeshStreams::NormalWeighting weighting, unsigned threadCount)
+{
+    const std::size_t chunks = (nbTriangles + NormalChunk - 1) / NormalChunk;
+
+    // triangle normals : non normalized (area weights) or unit vectors to be
+    // weighted by the angles of the corners
+    std::vector<float> faceNormals[3];
+    for (int k = 0; k < 3; ++k) {
+        faceNormals[k].resize(nbTriangles);
+    }
+    float* fx = faceNormals[0].empty() ? 0 : &faceNormals[0][0];
+    float* fy = faceNormals[1].empty() ? 0 : &faceNormals[1][0];
+    float* fz = faceNormals[2].empty() ? 0 : &faceNormals[2][0];
+    triangleNormals(x, y, z, stride, triangles, nbTriangles, fx, fy, fz, 1, weighting == MeshStreams::AngleWeighting, threadCount);
+    std::vector<float> angles;
+    if (weighting == MeshStreams::AngleWeighting) {
+        angles.resize(3 * nbTriangles);
+        parallelFor(chunks, threadCount, [&](std::size_t c) {
+            for (std::size_t t = c * NormalChunk; t < std::min(nbTriangles, (c + 1) * NormalChunk); ++t) {
+                for (int k = 0; k < 3; ++k) {
+                    std::size_t i0 = triangles[3 * t + k] * stride, i1 = triangles[3 * t + (k + 1) % 3] * stride;
+                    std::size_t i2 = triangles[3 * t + (k + 2) % 3] * stride;
+                    angles[3 * t + k] = cornerAngle(x[i1] - x[i0], y[i1] - y[i0], z[i1] - z[i0], x[i2] - x[i0], y[i2] - y[i0], z[i2] - z[i0]);
+                }
+            }
+        });
+    }
+    auto weight = [&](std::size_t corner) {
+        return angles.empty() ? 1.f : angles[corner];
+    };
+
+    if (chunks <= 1 || Loaders::threadCount(threadCount) == 1) {
+        // single thread : direct accumulation in triangle order
+        for (std::size_t i = 0; i < nbVertices; ++i) {
+            nx[i * normalStride] = ny[i * normalStride] = nz[i * normalStride] = 0.f;
+        }
+        for (std::size_t corner = 0; corner < 3 * nbTriangles; ++corner) {
+            std::size_t v = triangles[corner] * normalStride;
+            std::size_t t = corner / 3;
+            float w = weight(corner);
+            nx[v] += w * fx[t];
+            ny[v] += w * fy[t];
+            nz[v] += w * fz[t];
+        }
+        for (std::size_t i = 0; i < nbVertices; ++i) {
+            normalizeVector(nx[i * normalStride], ny[i * normalStride], nz[i * normalStride]);
+        }
+        return;
+    }
+
+    // corners of each vertex : parallel counting sort, then corners of each
+    // vertex by increasing index (same summation order as the single thread
+    // accumulation)
+    assert(3 * nbTriangles <= 0xffffffffu);
+    const std::size_t corners = 3 * nbTriangles;
+    std::vector<std::atomic<unsigned int> > cursors(nbVertices);
+    parallelFor(chunks, threadCount, [&](std::size_t c) {
+        for (std::size_t corner = 3 * c * NormalChunk; corner < std::min(corners, 3 * (c + 1) * NormalChunk); ++corner)
+            cursors[triangles[corner]].fetch_add(1, std::memory_order_relaxed);
+    });
+    std::vector<unsigned int> vertexStart(nbVertices + 1);
+    vertexStart[0] = 0;
+    for (std::size_t v = 0; v < nbVertices; ++v) {
+        vertexStart[v + 1] = vertexStart[v] + cursors[v].load(std::memory_order_relaxed);
+        cursors[v].store(vertexStart[v], std::memory_order_relaxed);
+    }
+    std::vector<unsigned int> vertexCorners(corners);
+    parallelFor(chunks, threadCount, [&](std::size_t c) {
+        for (std::size_t corner = 3 * c * NormalChunk; corner < std::min(corners, 3 * (c + 1) * NormalChunk); ++corner)
+            vertexCorners[cursors[triangles[corner]].fetch_add(1, std::memory_order_relaxed)] = (unsigned int)corner;
+    });
+    std::vector<std::atomic<unsigned int> >().swap(cursors);
+
+    // each vertex gathers the normals of its triangles
+    const std::size_t vertexChunks = (nbVertices + MeshStreams::ConversionChunk - 1) / MeshStreams::ConversionChunk;
+    parallelFor(vertexChunks, threadCount, [&](std::size_t c) {
+        for (std::size_t v = c * MeshStreams::ConversionChunk; v < std::min(nbVertices, (c + 1) * MeshStreams::ConversionChunk); ++v) {
+            std::sort(vertexCorners.begin() + vertexStart[v], vertexCorners.begin() + vertexStart[v + 1]);
+            float sx = 0.f, sy = 0.f, sz = 0.f;
+            for (unsigned int k = vertexStart[v]; k < vertexStart[v + 1]; ++k) {
+                std::size_t corner = vertexCorners[k], t = corner / 3;
+                float w = weight(corner);
+                sx += w * fx[t];
+                sy += w * fy[t];
+                sz += w * fz[t];
+            }
+            normalizeVector(sx, sy, sz);
+            nx[v * normalStride] = sx;
+            ny[v * normalStride] = sy;
+            nz[v * normalStride] = sz;
+        }
+    });
+}
+
+} // namespace loaders
@@ -0,0 +1,157 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef MESHSTREAMS_H
+#define MESHSTREAMS_H
+
+#include "mesh.h"
+
+#include <cstddef>
+#include <vector>
+
+// =============================================================================
+namespace Loaders {
+// =============================================================================
+
+/**
+  * @ingroup Loaders
+  * Mesh as one array per vertex attribute component (structure of arrays),
+  * for the CPU side processing whose loops read a few components of many
+  * vertices (normals, bounds...). Only the attributes of #attributes() are
+  * stored. Conversions from and to the interleaved layout of #Mesh (the one
+  * of the GPU buffers) are done by MeshStreams(const Mesh&, unsigned,
+  * unsigned) and Mesh(const MeshStreams&).
+  */
+class MeshStreams {
+public:
+    /// Attributes, combined in the attribute mask.
+    enum Attribute {
+        Positions = 1,
+        Normals = 2,
+        TextureCoords = 4,
+        AllAttributes = Positions | Normals | TextureCoords
+    };
+
+    /// Streams of the components of each attribute, in the order of the
+    /// interleaved vertices of #Mesh : x,y,z, nx,ny,nz, u,v.
+    enum Stream {
+        X, Y, Z, NX, NY, NZ, U, V,
+        NbStreams
+    };
+
+    /// Vertices converted by task of the parallel loops of the conversions
+    /// from and to #Mesh.
+    static const std::size_t ConversionChunk = 1 << 16;
+
+    /// Empty mesh with positions only.
+    MeshStreams();
+
+    /// Mesh of nbVertices vertices (zero) and nbTriangles triangles (0,0,0)
+    /// with the given attributes.
+    MeshStreams(std::size_t nbVertices, std::size_t nbTriangles, unsigned attributes);
+
+    /**
+      * Conversion from the interleaved layout : copies the attributes of
+      * mesh that are in attributes (the positions always), by threadCount
+      * threads (0 : all cores).
+      */
+    explicit MeshStreams(const Mesh& mesh, unsigned attributes = AllAttributes, unsigned threadCount = 0);
+
+    std::size_t nbVertices() const { return mNbVertices; }
+    std::size_t nbTriangles() const { return mNbTriangles; }
+
+    /// Attribute mask.
+    unsigned attributes() const { return mAttributes; }
+    bool has(Attribute attribute) const { return (mAttributes & attribute) != 0; }
+
+    /// Adds (zero streams) or removes attributes, the positions are kept.
+    void setAttributes(unsigned attributes);
+
+    /// Components of an attribute, null when the attribute is missing.
+    const float* stream(Stream s) const { return mStreams[s].empty() ? 0 : &mStreams[s][0]; }
+    float* stream(Stream s) { return mStreams[s].empty() ? 0 : &mStreams[s][0]; }
+
+    /// Triangles : #nbTriangles() triples of vertex indices.
+    const unsigned int* triangleData() const { return mTriangles.empty() ? 0 : &mTriangles[0]; }
+    unsigned int* triangleData() { return mTriangles.empty() ? 0 : &mTriangles[0]; }
+
+    /// Weights of the triangle normals in the vertex normals.
+    enum NormalWeighting {
+        AreaWeighting,  ///< area of the triangle
+        AngleWeighting  ///< angle of the triangle at the vertex
+    };
+
+    /**
+      * Smooth normals : sum of the normals of the triangles of each vertex,
+      * weighted by their area or their angle at the vertex, then normalized
+      * (zero for the vertices of degenerated triangles only). Adds the
+      * normals to the attributes.
+      * Triangle normals are computed in batches, then each vertex gathers
+      * the normals of its triangles (found by a counting sort) in triangle
+      * order, by threadCount threads (0 : all cores) : no concurrent writes,
+      * and the result doesn't depend on the number of threads (see
+      * #vertexNormals()).
+      */
+    void computeNormals(NormalWeighting weighting = AreaWeighting, unsigned threadCount = 0);
+
+    /// Axis aligned bounding box of the positions, (0,0,0) when empty.
+    void bounds(glm::vec3& min, glm::vec3& max) const;
+
+private:
+    std::size_t mNbVertices;
+    std::size_t mNbTriangles;
+    unsigned mAttributes;
+    std::vector<float> mStreams[NbStreams];
+    std::vector<unsigned int> mTriangles;
+};
+
+/**
+  * @ingroup Loaders
+  * Normals of nbTriangles triangles, computed by batches of triangles that
+  * the compiler vectorizes, by threadCount threads (0 : all cores).
+  * The position of vertex i is (x[i * stride], y[i * stride], z[i * stride])
+  * and triangle t is made of the vertices triangles[3t], triangles[3t + 1]
+  * and triangles[3t + 2], or of the vertices 3t, 3t + 1 and 3t + 2 when
+  * triangles is null. Its normal, (p1 - p0) x (p2 - p0), is written in
+  * (nx[t * normalStride], ny[t * normalStride], nz[t * normalStride]),
+  * normalized when normalize is true (zero for degenerated triangles),
+  * of length twice the area of the triangle otherwise.
+  */
+void triangleNormals(const float* x, const float* y, const float* z, std::size_t stride,
+                     const unsigned int* triangles, std::size_t nbTriangles,
+                     float* nx, float* ny, float* nz, std::size_t normalStride,
+                     bool normalize, unsigned threadCount = 0);
+
+/**
+  * @ingroup Loaders
+  * Smooth normals of nbVertices vertices, those of
+  * MeshStreams::computeNormals() for any layout : positions and triangles
+  * as in #triangleNormals() (triangles not null), the normal of vertex i is
+  * written in (nx[i * normalStride], ny[i * normalStride],
+  * nz[i * normalStride]). Unit vectors, zero for the vertices of
+  * degenerated triangles only, which don't depend on the number of threads.
+  */
+void vertexNormals(const float* x, const float* y, const float* z, std::size_t stride,
+                   const unsigned int* triangles, std::size_t nbTriangles, std::size_t nbVertices,
+                   float* nx, float* ny, float* nz, std::size_t normalStride,
+                   MeshStreams::NormalWeighting weighting = MeshStreams::AreaWeighting, unsigned threadCount = 0);
+
+} // END namespace loaders =====================================================
+
+#endif // MESHSTREAMS_H
@@ -0,0 +1,709 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef OBJBASICPARSER_H
+#define OBJBASICPARSER_H
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include "objfileparser.h"
+#include "objtokenizer.h"
+#include "mappedfile.h"
+#include "compressedfile.h"
+
+// =============================================================================
+namespace Loaders {
+// =============================================================================
+
+// =============================================================================
+namespace Obj_mtl {
+// =============================================================================
+
+/** @ingroup OBJ-MTL
+  * Vertex of a face : geometric vertex, texture vertex and vertex normal
+  * indices. Indices that are not given by the face are 0.
+  */
+struct face_vertex_type {
+    index_type v;
+    index_type vt;
+    index_type vn;
+};
+
+/** @ingroup OBJ-MTL
+  * Largest number of vertices of a face, so that polygon sizes fit in the
+  * 16 bits counts of #face_block and #obj_face.
+  */
+const std::size_t max_face_vertices = 65535;
+
+/** @ingroup OBJ-MTL
+  * Default handler of #basic_obj_parser : every event is ignored.
+  * Handlers derive from it and hide the members of the events they are
+  * interested in, the other ones are empty inline calls that compile away.
+  * Events are the same as the callbacks of #obj_parser.
+  */
+struct obj_handler {
+    void info(std::size_t, const std::string&) {}
+    void warning(std::size_t, const std::string&) {}
+    void error(std::size_t, const std::string&) {}
+
+    void geometric_vertex(float_type, float_type, float_type) {}
+    void texture_vertex(float_type, float_type) {}
+    void vertex_normal(float_type, float_type, float_type) {}
+
+    void triangular_face_geometric_vertices(index_type, index_type, index_type) {}
+    void triangular_face_geometric_vertices_texture_vertices(const face_vertex_type&, const face_vertex_type&, const face_vertex_type&) {}
+    void triangular_face_geometric_vertices_vertex_normals(const face_vertex_type&, const face_vertex_type&, const face_vertex_type&) {}
+    void triangular_face_geometric_vertices_texture_vertices_vertex_normals(const face_vertex_type&, const face_vertex_type&, const face_vertex_type&) {}
+
+    void quadrilateral_face_geometric_vertices(index_type, index_type, index_type, index_type) {}
+    void quadrilateral_face_geometric_vertices_texture_vertices(const face_vertex_type&, const face_vertex_type&, const face_vertex_type&, const face_vertex_type&) {}
+    void quadrilateral_face_geometric_vertices_vertex_normals(const face_vertex_type&, const face_vertex_type&, const face_vertex_type&, const face_vertex_type&) {}
+    void quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals(const face_vertex_type&, const face_vertex_type&, const face_vertex_type&, const face_vertex_type&) {}
+
+    void polygonal_face_geometric_vertices_begin(index_type, index_type, index_type) {}
+    void polygonal_face_geometric_vertices_vertex(index_type) {}
+    void polygonal_face_geometric_vertices_end() {}
+    void polygonal_face_geometric_vertices_texture_vertices_begin(const face_vertex_type&, const face_vertex_type&, const face_vertex_type&) {}
+    void polygonal_face_geometric_vertices_texture_vertices_vertex(const face_vertex_type&) {}
+    void polygonal_face_geometric_vertices_texture_vertices_end() {}
+    void polygonal_face_geometric_vertices_vertex_normals_begin(const face_vertex_type&, const face_vertex_type&, const face_vertex_type&) {}
+    void polygonal_face_geometric_vertices_vertex_normals_vertex(const face_vertex_type&) {}
+    void polygonal_face_geometric_vertices_vertex_normals_end() {}
+    void polygonal_face_geometric_vertices_texture_vertices_vertex_normals_begin(const face_vertex_type&, const face_vertex_type&, const face_vertex_type&) {}
+    void polygonal_face_geometric_vertices_texture_vertices_vertex_normals_vertex(const face_vertex_type&) {}
+    void polygonal_face_geometric_vertices_texture_vertices_vertex_normals_end() {}
+
+    void group_name(const std::string&) {}
+    void smoothing_group(size_type) {}
+    void object_name(const std::string&) {}
+    void material_library(const std::string&) {}
+    void material_name(const std::string&) {}
+    void comment(const std::string&) {}
+};
+
+/** @ingroup OBJ-MTL
+  * OBJ parser with a static handler.
+  * Events are sent to the members of Handler (see #obj_handler) by direct
+  * calls that the compiler can inline, instead of the std::function
+  * callbacks of #obj_parser, which is itself implemented on top of this
+  * class. Grammar, flags, messages and results are those of
+  * #obj_parser::parse(const char*, const char*).
+  */
+template <typename Handler>
+class basic_obj_parser {
+public:
+    typedef obj_parser::flags_type flags_type;
+    typedef obj_parser::statistics statistics;
+
+    basic_obj_parser(Handler& handler, flags_type flags = 0);
+
+    /// Parse a file, mapped in memory when possible, read in memory otherwise.
+    /// gzip and zstd compressed files are parsed block by block while the
+    /// next block is decompressed.
+    bool parse(const std::string& filename);
+    /// Parse an in-memory OBJ content [begin, end).
+    bool parse(const char* begin, const char* end);
+    /// Parse a part of an OBJ content, statistics holds the totals of the
+    /// preceding parts and is updated.
+    bool parse(const char* begin, const char* end, statistics& statistics);
+
+    /// Push mode : parse the next size characters of an OBJ content. Lines
+    /// may be split between calls, an incomplete last line is kept until
+    /// the next call. Returns false once a parse error occurred.
+    bool feed(const char* data, std::size_t size);
+    /// End of a push mode parse : parse the last line and send the summary.
+    /// The parser can then be fed again with a new content.
+    bool finish();
+
+private:
+    typedef enum {
+        face_v,
+        face_v_vt,
+        face_v_vn,
+        face_v_vt_vn
+    } FaceFormat;
+
+    static FaceFormat face_format(const char* begin, const char* end);
+    static bool parse_face_vertex(const char*& p, const char* end, FaceFormat format, face_vertex_type& vertex, const char* readable_end);
+    static bool index_in_bounds(index_type index, std::size_t count);
+    static void translate_index(index_type& index, std::size_t count);
+    bool check_face_vertex(FaceFormat format, face_vertex_type& vertex, const statistics& statistics) const;
+    void triangular_face(FaceFormat format, const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3);
+    void quadrilateral_face(FaceFormat format, const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3, const face_vertex_type& v4);
+    void polygonal_face_begin(FaceFormat format, const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3);
+    void polygonal_face_vertex(FaceFormat format, const face_vertex_type& v);
+    void polygonal_face_end(FaceFormat format);
+    bool parse_lines(const char* begin, const char* end, statistics& statistics);
+
+    Handler& handler_;
+    flags_type flags_;
+
+    // push mode
+    std::string pending_;
+    statistics totals_;
+    bool failed_;
+};
+
+} // END namespace obj =========================================================
+
+template <typename Handler>
+inline Obj_mtl::basic_obj_parser<Handler>::basic_obj_parser(Handler& handler, flags_type flags)
+    : handler_(handler)
+    , flags_(flags)
+    , failed_(false)
+{
+}
+
+template <typename Handler>
+bool Obj_mtl::basic_obj_parser<Handler>::parse(const std::string& filename)
+{
+    if (CompressedFile::isCompressed(filename)) {
+        CompressedFile compressed;
+        if (!compressed.open(filename)) {
+            handler_.error(0, compressed.error());
+            return false;
+        }
+        const char* data;
+        std::size_t size;
+        bool result = true;
+        while (result && compressed.nextBlock(data, size)) {
+            result = feed(data, size);
+        }
+        if (result && !compressed.error().empty()) {
+            handler_.error(0, compressed.error());
+            // the last line is incomplete : finish() only resets the push mode
+            failed_ = true;
+        }
+        return finish() && result;
+    }
+    MappedFile file;
+    if (file.open(filename)) {
+        return parse(file.begin(), file.end());
+    }
+    std::ifstream ifstream(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!ifstream) {
+        return false;
+    }
+    std::string content((std::istreambuf_iterator<char>(ifstream)), std::istreambuf_iterator<char>());
+    return parse(content.data(), content.data() + content.size());
+}
+
+template <typename Handler>
+inline bool Obj_mtl::basic_obj_parser<Handler>::parse(const char* begin, const char* end)
+{
+    statistics totals;
+    return parse(begin, end, totals);
+}
+
+template <typename Handler>
+inline typename Obj_mtl::basic_obj_parser<Handler>::FaceFormat Obj_mtl::basic_obj_parser<Handler>::face_format(const char* begin, const char* end)
+{
+    const char* slash = static_cast<const char*>(std::memchr(begin, '/', end - begin));
+    if (!slash) {
+        return face_v;
+    }
+    if ((slash + 1 != end) && (slash[1] == '/')) {
+        return face_v_vn;
+    }
+    return std::memchr(slash + 1, '/', end - slash - 1) ? face_v_vt_vn : face_v_vt;
+}
+
+template <typename Handler>
+inline bool Obj_mtl::basic_obj_parser<Handler>::parse_face_vertex(const char*& p, const char* end, FaceFormat format, face_vertex_type& vertex, const char* readable_end)
+{
+    using namespace tokenizer;
+#ifdef OBJ_TOKENIZER_SIMD
+    // Unsigned fields of 1 to 16 digits delimited in one window, the other
+    // vertices (relative indices, long indices) go through parse_index.
+    if (readable_end - p >= simd_margin) {
+        window_type window = classify(p);
+        unsigned v = digits_at(window, 0), vt = 0, vn = 0;
+        unsigned vt_position = v + 1, vn_position = v + 1;
+        unsigned position = v;
+        bool valid = (v - 1 < 16);
+        if (format != face_v) {
+            valid &= ((window.slashes >> position) & 1) != 0;
+            ++position;
+            if (format != face_v_vn) {
+                vt = digits_at(window, position);
+                valid &= (vt - 1 < 16);
+                position += vt;
+            }
+            if (format != face_v_vt) {
+                valid &= ((window.slashes >> position) & 1) != 0;
+                vn_position = ++position;
+                vn = digits_at(window, position);
+                valid &= (vn - 1 < 16);
+                position += vn;
+            }
+        }
+        if (valid && position < unsigned(window_size) && std::ptrdiff_t(position) <= end - p) {
+            vertex.v = index_type(parse_digits(p, v));
+            vertex.vt = index_type(parse_digits(p + vt_position, vt));
+            vertex.vn = index_type(parse_digits(p + vn_position, vn));
+            p += position;
+            return true;
+        }
+    }
+#endif
+    vertex.vt = 0;
+    vertex.vn = 0;
+    if (!parse_index(p, end, vertex.v, readable_end)) {
+        return false;
+    }
+    if (format != face_v) {
+        if (p == end || *p != '/') {
+            return false;
+        }
+        ++p;
+        if (format != face_v_vn) {
+            if (!parse_index(p, end, vertex.vt, readable_end)) {
+                return false;
+            }
+        }
+        if (format != face_v_vt) {
+            if (p == end || *p != '/') {
+                return false;
+            }
+            ++p;
+            if (!parse_index(p, end, vertex.vn, readable_end)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/// Check index against [1, count] and [-count, -1].
+template <typename Handler>
+inline bool Obj_mtl::basic_obj_parser<Handler>::index_in_bounds(index_type index, std::size_t count)
+{
+    // magnitude of a negative index computed without overflow
+    return (index > 0) ? (std::size_t(index) <= count) : ((index < 0) && (std::size_t(0) - std::size_t(index) <= count));
+}
+
+template <typename Handler>
+inline void Obj_mtl::basic_obj_parser<Handler>::translate_index(index_type& index, std::size_t count)
+{
+    if (index < 0) {
+        index += index_type(count + 1);
+    }
+}
+
+template <typename Handler>
+inline bool Obj_mtl::basic_obj_parser<Handler>::check_face_vertex(FaceFormat format, face_vertex_type& vertex, const statistics& statistics) const
+{
+    bool has_vt = (format == face_v_vt) || (format == face_v_vt_vn);
+    bool has_vn = (format == face_v_vn) || (format == face_v_vt_vn);
+    if (!index_in_bounds(vertex.v, statistics.number_of_geometric_vertices)
+        || (has_vt && !index_in_bounds(vertex.vt, statistics.number_of_texture_vertices))
+        || (has_vn && !index_in_bounds(vertex.vn, statistics.number_of_vertex_normals))) {
+        return false;
+    }
+    if (flags_ & obj_parser::translate_negative_indices) {
+        translate_index(vertex.v, statistics.number_of_geometric_vertices);
+        if (has_vt) {
+            translate_index(vertex.vt, statistics.number_of_texture_vertices);
+        }
+        if (has_vn) {
+            translate_index(vertex.vn, statistics.number_of_vertex_normals);
+        }
+    }
+    return true;
+}
+
+template <typename Handler>
+inline void Obj_mtl::basic_obj_parser<Handler>::triangular_face(FaceFormat format, const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+{
+    switch (format) {
+    case face_v:
+        handler_.triangular_face_geometric_vertices(v1.v, v2.v, v3.v);
+        break;
+    case face_v_vt:
+        handler_.triangular_face_geometric_vertices_texture_vertices(v1, v2, v3);
+        break;
+    case face_v_vn:
+        handler_.triangular_face_geometric_vertices_vertex_normals(v1, v2, v3);
+        break;
+    case face_v_vt_vn:
+        handler_.triangular_face_geometric_vertices_texture_vertices_vertex_normals(v1, v2, v3);
+        break;
+    }
+}
+
+template <typename Handler>
+inline void Obj_mtl::basic_obj_parser<Handler>::quadrilateral_face(FaceFormat format, const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3, const face_vertex_type& v4)
+{
+    switch (format) {
+    case face_v:
+        handler_.quadrilateral_face_geometric_vertices(v1.v, v2.v, v3.v, v4.v);
+        break;
+    case face_v_vt:
+        handler_.quadrilateral_face_geometric_vertices_texture_vertices(v1, v2, v3, v4);
+        break;
+    case face_v_vn:
+        handler_.quadrilateral_face_geometric_vertices_vertex_normals(v1, v2, v3, v4);
+        break;
+    case face_v_vt_vn:
+        handler_.quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals(v1, v2, v3, v4);
+        break;
+    }
+}
+
+template <typename Handler>
+inline void Obj_mtl::basic_obj_parser<Handler>::polygonal_face_begin(FaceFormat format, const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+{
+    switch (format) {
+    case face_v:
+        handler_.polygonal_face_geometric_vertices_begin(v1.v, v2.v, v3.v);
+        break;
+    case face_v_vt:
+        handler_.polygonal_face_geometric_vertices_texture_vertices_begin(v1, v2, v3);
+        break;
+    case face_v_vn:
+        handler_.polygonal_face_geometric_vertices_vertex_normals_begin(v1, v2, v3);
+        break;
+    case face_v_vt_vn:
+        handler_.polygonal_face_geometric_vertices_texture_vertices_vertex_normals_begin(v1, v2, v3);
+        break;
+    }
+}
+
+template <typename Handler>
+inline void Obj_mtl::basic_obj_parser<Handler>::polygonal_face_vertex(FaceFormat format, const face_vertex_type& v)
+{
+    switch (format) {
+    case face_v:
+        handler_.polygonal_face_geometric_vertices_vertex(v.v);
+        break;
+    case face_v_vt:
+        handler_.polygonal_face_geometric_vertices_texture_vertices_vertex(v);
+        break;
+    case face_v_vn:
+        handler_.polygonal_face_geometric_vertices_vertex_normals_vertex(v);
+        break;
+    case face_v_vt_vn:
+        handler_.polygonal_face_geometric_vertices_texture_vertices_vertex_normals_vertex(v);
+        break;
+    }
+}
+
+template <typename Handler>
+inline void Obj_mtl::basic_obj_parser<Handler>::polygonal_face_end(FaceFormat format)
+{
+    switch (format) {
+    case face_v:
+        handler_.polygonal_face_geometric_vertices_end();
+        break;
+    case face_v_vt:
+        handler_.polygonal_face_geometric_vertices_texture_vertices_end();
+        break;
+    case face_v_vn:
+        handler_.polygonal_face_geometric_vertices_vertex_normals_end();
+        break;
+    case face_v_vt_vn:
+        handler_.polygonal_face_geometric_vertices_texture_vertices_vertex_normals_end();
+        break;
+    }
+}
+
+template <typename Handler>
+bool Obj_mtl::basic_obj_parser<Handler>::parse(const char* begin, const char* end, statistics& statistics)
+{
+    if (!parse_lines(begin, end, statistics)) {
+        return false;
+    }
+    handler_.info(statistics.line_number, obj_parser::info_message(statistics));
+    return true;
+}
+
+template <typename Handler>
+bool Obj_mtl::basic_obj_parser<Handler>::feed(const char* data, std::size_t size)
+{
+    if (failed_) {
+        return false;
+    }
+    const char* begin = data;
+    const char* end = data + size;
+    const char* first_eol = static_cast<const char*>(std::memchr(begin, '\n', size));
+    if (!first_eol) {
+        pending_.append(begin, end);
+        return true;
+    }
+    // end of the line split by the previous call
+    if (!pending_.empty()) {
+        pending_.append(begin, first_eol + 1);
+        failed_ = !parse_lines(pending_.data(), pending_.data() + pending_.size(), totals_);
+        pending_.clear();
+        if (failed_) {
+            return false;
+        }
+        begin = first_eol + 1;
+    }
+    // complete lines are parsed in place, the incomplete one is kept
+    const char* lines_end = end;
+    while (lines_end != begin && lines_end[-1] != '\n') {
+        --lines_end;
+    }
+    failed_ = !parse_lines(begin, lines_end, totals_);
+    if (failed_) {
+        return false;
+    }
+    pending_.assign(lines_end, end);
+    return true;
+}
+
+template <typename Handler>
+bool Obj_mtl::basic_obj_parser<Handler>::finish()
+{
+    bool result = !failed_;
+    if (result && !pending_.empty()) {
+        result = parse_lines(pending_.data(), pending_.data() + pending_.size(), totals_);
+    }
+    if (result) {
+        handler_.info(totals_.line_number, obj_parser::info_message(totals_));
+    }
+    pending_.clear();
+    totals_ = statistics();
+    failed_ = false;
+    return result;
+}
+
+template <typename Handler>
+bool Obj_mtl::basic_obj_parser<Handler>::parse_lines(const char* begin, const char* end, statistics& statistics)
+{
+    using namespace tokenizer;
+
+    std::size_t& line_number = statistics.line_number;
+
+    auto error = [&](const char* message) {
+        handler_.error(line_number, message);
+        return false;
+    };
+
+    const char* next_line = begin;
+    while (next_line != end) {
+        const char* line_begin = next_line;
+        const char* eol = line_end(line_begin, end);
+        next_line = (eol == end) ? end : eol + 1;
+        ++line_number;
+
+        const char* p = line_begin;
+        skip_space(p, eol);
+        if (p == eol) {
+            if (flags_ & obj_parser::parse_blank_lines_as_comment) {
+                handler_.comment(std::string(line_begin, eol));
+            }
+            continue;
+        }
+        if (*p == '#') {
+            handler_.comment(std::string(line_begin, eol));
+            continue;
+        }
+
+        const char* keyword = p;
+        p = token_end(p, eol);
+        const char* keyword_end = p;
+
+        // geometric vertex (v)
+        if (token_equals(keyword, keyword_end, "v")) {
+            float_type x, y, z;
+            if (!separator(p, eol) || !parse_float(p, eol, x, end) || !separator(p, eol) || !parse_float(p, eol, y, end) || !separator(p, eol) || !parse_float(p, eol, z, end) || !end_of_line(p, eol)) {
+                return error("parse error");
+            }
+            ++statistics.number_of_geometric_vertices;
+            handler_.geometric_vertex(x, y, z);
+        }
+
+        // texture vertex (vt)
+        else if (token_equals(keyword, keyword_end, "vt")) {
+            float_type u, v, w;
+            if (!separator(p, eol) || !parse_float(p, eol, u, end) || !separator(p, eol) || !parse_float(p, eol, v, end) || !next_token(p, eol)) {
+                return error("parse error");
+            }
+            // TODO : verify (u v w) texture coordinates management.
+            if (p != eol && (!parse_float(p, eol, w, end) || !end_of_line(p, eol))) {
+                return error("parse error");
+            }
+            ++statistics.number_of_texture_vertices;
+            handler_.texture_vertex(u, v);
+        }
+
+        // vertex normal (vn)
+        else if (token_equals(keyword, keyword_end, "vn")) {
+            float_type x, y, z;
+            if (!separator(p, eol) || !parse_float(p, eol, x, end) || !separator(p, eol) || !parse_float(p, eol, y, end) || !separator(p, eol) || !parse_float(p, eol, z, end) || !end_of_line(p, eol)) {
+                return error("parse error");
+            }
+            ++statistics.number_of_vertex_normals;
+            handler_.vertex_normal(x, y, z);
+        }
+
+        // face (f)
+        else if (token_equals(keyword, keyword_end, "f") || token_equals(keyword, keyword_end, "fo")) {
+            if (!separator(p, eol)) {
+                return error("parse error");
+            }
+            // the format of the first vertex gives the format of the face
+            FaceFormat format = face_format(p, token_end(p, eol));
+            face_vertex_type v1, v2, v3, v4;
+            if (!parse_face_vertex(p, eol, format, v1, end) || !separator(p, eol) || !parse_face_vertex(p, eol, format, v2, end) || !separator(p, eol) || !parse_face_vertex(p, eol, format, v3, end) || !next_token(p, eol)) {
+                return error("parse error");
+            }
+            if (!check_face_vertex(format, v1, statistics) || !check_face_vertex(format, v2, statistics) || !check_face_vertex(format, v3, statistics)) {
+                return error("index out of bounds");
+            }
+            if (p == eol) {
+                ++statistics.number_of_faces;
+                triangular_face(format, v1, v2, v3);
+                continue;
+            }
+            if (!parse_face_vertex(p, eol, format, v4, end) || !next_token(p, eol)) {
+                return error("parse error");
+            }
+            if (!check_face_vertex(format, v4, statistics)) {
+                return error("index out of bounds");
+            }
+            if (p == eol) {
+                ++statistics.number_of_faces;
+                if (flags_ & obj_parser::triangulate_faces) {
+                    triangular_face(format, v1, v2, v3);
+                    triangular_face(format, v1, v3, v4);
+                }
+                else {
+                    quadrilateral_face(format, v1, v2, v3, v4);
+                }
+                continue;
+            }
+            // polygon : triangulated as a fan, or streamed vertex by vertex
+            if (flags_ & obj_parser::triangulate_faces) {
+                triangular_face(format, v1, v2, v3);
+                triangular_face(format, v1, v3, v4);
+            }
+            else {
+                polygonal_face_begin(format, v1, v2, v3);
+                polygonal_face_vertex(format, v4);
+            }
+            face_vertex_type v_previous = v4;
+            std::size_t face_size = 4;
+            while (p != eol) {
+                face_vertex_type v;
+                if (!parse_face_vertex(p, eol, format, v, end) || !next_token(p, eol)) {
+                    return error("parse error");
+                }
+                if (++face_size > max_face_vertices) {
+                    return error("too many face vertices");
+                }
+                if (!check_face_vertex(format, v, statistics)) {
+                    return error("index out of bounds");
+                }
+                if (flags_ & obj_parser::triangulate_faces) {
+                    triangular_face(format, v1, v_previous, v);
+                }
+                else {
+                    polygonal_face_vertex(format, v);
+                }
+                v_previous = v;
+            }
+            ++statistics.number_of_faces;
+            if (!(flags_ & obj_parser::triangulate_faces)) {
+                polygonal_face_end(format);
+            }
+        }
+
+        // group name (g)
+        else if (token_equals(keyword, keyword_end, "g")) {
+            skip_space(p, eol);
+            if (p == eol) {
+                ++statistics.number_of_group_names;
+                handler_.group_name("default");
+            }
+            else {
+                const char* group_name = p;
+                p = token_end(p, eol);
+                const char* group_name_end = p;
+                if (!end_of_line(p, eol)) {
+                    return error("parse error");
+                }
+                ++statistics.number_of_group_names;
+                handler_.group_name(std::string(group_name, group_name_end));
+            }
+        }
+
+        // smoothing group (s)
+        else if (token_equals(keyword, keyword_end, "s")) {
+            if (!separator(p, eol)) {
+                return error("parse error");
+            }
+            const char* group_number_string = p;
+            p = token_end(p, eol);
+            const char* group_number_string_end = p;
+            if (!end_of_line(p, eol)) {
+                return error("parse error");
+            }
+            size_type group_number = 0;
+            if (!token_equals(group_number_string, group_number_string_end, "off")) {
+                if (!parse_size(group_number_string, group_number_string_end, group_number) || group_number_string != group_number_string_end) {
+                    return error("parse error");
+                }
+            }
+            ++statistics.number_of_smoothing_groups;
+            handler_.smoothing_group(group_number);
+        }
+
+        // object name (o), material library (mtllib), material name (usemtl)
+        else if (token_equals(keyword, keyword_end, "o") || token_equals(keyword, keyword_end, "mtllib") || token_equals(keyword, keyword_end, "usemtl")) {
+            if (!separator(p, eol)) {
+                return error("parse error");
+            }
+            const char* name = p;
+            p = token_end(p, eol);
+            const char* name_end = p;
+            if (!end_of_line(p, eol)) {
+                return error("parse error");
+            }
+            if (*keyword == 'o') {
+                ++statistics.number_of_object_names;
+                handler_.object_name(std::string(name, name_end));
+            }
+            else if (*keyword == 'm') {
+                ++statistics.number_of_material_libraries;
+                handler_.material_library(std::string(name, name_end));
+            }
+            else {
+                ++statistics.number_of_material_names;
+                handler_.material_name(std::string(name, name_end));
+            }
+        }
+
+        // unknown keyword
+        else {
+            handler_.warning(line_number, "ignoring line " + std::string(line_begin, eol));
+        }
+    }
+
+    return true;
+}
+
+} // END namespace loaders =====================================================
+
+#endif // OBJBASICPARSER_H
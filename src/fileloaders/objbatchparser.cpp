@@ -0,0 +1,384 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#include "objbatchparser.h"
+#include "objbasicparser.h"
+#include <vector>
+
+namespace Loaders {
+
+class Obj_mtl::obj_batch_parser::block_handler : public obj_handler {
+public:
+    explicit block_handler(const obj_batch_parser& parser)
+        : parser_(parser)
+        , polygon_(false)
+    {
+        geometric_vertices_.reserve(3 * block_size);
+        texture_vertices_.reserve(2 * block_size);
+        vertex_normals_.reserve(3 * block_size);
+        corners_.reserve(block_size);
+        attributes_.reserve(block_size);
+        v_.reserve(4 * block_size);
+        vt_.reserve(4 * block_size);
+        vn_.reserve(4 * block_size);
+    }
+
+    void info(std::size_t line_number, const std::string& message)
+    {
+        flush();
+        if (parser_.info_callback_) {
+            parser_.info_callback_(line_number, message);
+        }
+    }
+    void warning(std::size_t line_number, const std::string& message)
+    {
+        if (parser_.warning_callback_) {
+            parser_.warning_callback_(line_number, message);
+        }
+    }
+    void error(std::size_t line_number, const std::string& message)
+    {
+        // what precedes the error has been parsed, as with obj_parser : an
+        // unfinished polygon is dropped
+        if (polygon_) {
+            drop_polygon();
+        }
+        flush();
+        if (parser_.error_callback_) {
+            parser_.error_callback_(line_number, message);
+        }
+    }
+
+    void geometric_vertex(float_type x, float_type y, float_type z)
+    {
+        geometric_vertices_.push_back(x);
+        geometric_vertices_.push_back(y);
+        geometric_vertices_.push_back(z);
+        if (geometric_vertices_.size() == 3 * block_size) {
+            flush_geometric_vertices();
+        }
+    }
+    void texture_vertex(float_type u, float_type v)
+    {
+        texture_vertices_.push_back(u);
+        texture_vertices_.push_back(v);
+        if (texture_vertices_.size() == 2 * block_size) {
+            flush_texture_vertices();
+        }
+    }
+    void vertex_normal(float_type x, float_type y, float_type z)
+    {
+        vertex_normals_.push_back(x);
+        vertex_normals_.push_back(y);
+        vertex_normals_.push_back(z);
+        if (vertex_normals_.size() == 3 * block_size) {
+            flush_vertex_normals();
+        }
+    }
+
+    void triangular_face_geometric_vertices(index_type v1, index_type v2, index_type v3)
+    {
+        face_vertex_type c1 = { v1, 0, 0 }, c2 = { v2, 0, 0 }, c3 = { v3, 0, 0 };
+        face(0, c1, c2, c3);
+    }
+    void triangular_face_geometric_vertices_texture_vertices(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        face(obj_face::has_texture_vertices, v1, v2, v3);
+    }
+    void triangular_face_geometric_vertices_vertex_normals(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        face(obj_face::has_vertex_normals, v1, v2, v3);
+    }
+    void triangular_face_geometric_vertices_texture_vertices_vertex_normals(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        face(obj_face::has_texture_vertices | obj_face::has_vertex_normals, v1, v2, v3);
+    }
+
+    void quadrilateral_face_geometric_vertices(index_type v1, index_type v2, index_type v3, index_type v4)
+    {
+        face_vertex_type c1 = { v1, 0, 0 }, c2 = { v2, 0, 0 }, c3 = { v3, 0, 0 }, c4 = { v4, 0, 0 };
+        face(0, c1, c2, c3, &c4);
+    }
+    void quadrilateral_face_geometric_vertices_texture_vertices(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3, const face_vertex_type& v4)
+    {
+        face(obj_face::has_texture_vertices, v1, v2, v3, &v4);
+    }
+    void quadrilateral_face_geometric_vertices_vertex_normals(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3, const face_vertex_type& v4)
+    {
+        face(obj_face::has_vertex_normals, v1, v2, v3, &v4);
+    }
+    void quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3, const face_vertex_type& v4)
+    {
+        face(obj_face::has_texture_vertices | obj_face::has_vertex_normals, v1, v2, v3, &v4);
+    }
+
+    void polygonal_face_geometric_vertices_begin(index_type v1, index_type v2, index_type v3)
+    {
+        face_vertex_type c1 = { v1, 0, 0 }, c2 = { v2, 0, 0 }, c3 = { v3, 0, 0 };
+        polygon_begin(0, c1, c2, c3);
+    }
+    void polygonal_face_geometric_vertices_vertex(index_type v)
+    {
+        face_vertex_type c = { v, 0, 0 };
+        polygon_vertex(c);
+    }
+    void polygonal_face_geometric_vertices_end()
+    {
+        polygon_end();
+    }
+    void polygonal_face_geometric_vertices_texture_vertices_begin(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        polygon_begin(obj_face::has_texture_vertices, v1, v2, v3);
+    }
+    void polygonal_face_geometric_vertices_texture_vertices_vertex(const face_vertex_type& v)
+    {
+        polygon_vertex(v);
+    }
+    void polygonal_face_geometric_vertices_texture_vertices_end()
+    {
+        polygon_end();
+    }
+    void polygonal_face_geometric_vertices_vertex_normals_begin(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        polygon_begin(obj_face::has_vertex_normals, v1, v2, v3);
+    }
+    void polygonal_face_geometric_vertices_vertex_normals_vertex(const face_vertex_type& v)
+    {
+        polygon_vertex(v);
+    }
+    void polygonal_face_geometric_vertices_vertex_normals_end()
+    {
+        polygon_end();
+    }
+    void polygonal_face_geometric_vertices_texture_vertices_vertex_normals_begin(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        polygon_begin(obj_face::has_texture_vertices | obj_face::has_vertex_normals, v1, v2, v3);
+    }
+    void polygonal_face_geometric_vertices_texture_vertices_vertex_normals_vertex(const face_vertex_type& v)
+    {
+        polygon_vertex(v);
+    }
+    void polygonal_face_geometric_vertices_texture_vertices_vertex_normals_end()
+    {
+        polygon_end();
+    }
+
+    void group_name(const std::string& name)
+    {
+        flush();
+        if (parser_.group_name_callback_) {
+            parser_.group_name_callback_(name);
+        }
+    }
+    void smoothing_group(size_type group_number)
+    {
+        flush();
+        if (parser_.smoothing_group_callback_) {
+            parser_.smoothing_group_callback_(group_number);
+        }
+    }
+    void object_name(const std::string& name)
+    {
+        flush();
+        if (parser_.object_name_callback_) {
+            parser_.object_name_callback_(name);
+        }
+    }
+    void material_library(const std::string& name)
+    {
+        flush();
+        if (parser_.material_library_callback_) {
+            parser_.material_library_callback_(name);
+        }
+    }
+    void material_name(const std::string& name)
+    {
+        flush();
+        if (parser_.material_name_callback_) {
+            parser_.material_name_callback_(name);
+        }
+    }
+    void comment(const std::string& comment)
+    {
+        if (parser_.comment_callback_) {
+            parser_.comment_callback_(comment);
+        }
+    }
+
+private:
+    void face(unsigned char attributes, const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3, const face_vertex_type* v4 = 0)
+    {
+        corners_.push_back(v4 ? 4 : 3);
+        attributes_.push_back(attributes);
+        corner(v1), corner(v2), corner(v3);
+        if (v4) {
+            corner(*v4);
+        }
+        if (corners_.size() == block_size) {
+            flush();
+        }
+    }
+    // a polygon is never split between two blocks : the block is only sent
+    // at its end, once full or holding more than 4 * block_size corners
+    void polygon_begin(unsigned char attributes, const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        polygon_ = true;
+        corners_.push_back(3);
+        attributes_.push_back(attributes);
+        corner(v1), corner(v2), corner(v3);
+    }
+    void polygon_vertex(const face_vertex_type& vertex)
+    {
+        ++corners_.back();
+        corner(vertex);
+    }
+    void polygon_end()
+    {
+        polygon_ = false;
+        if (corners_.size() == block_size || v_.size() >= 4 * block_size) {
+            flush();
+        }
+    }
+    void drop_polygon()
+    {
+        std::size_t size = v_.size() - corners_.back();
+        v_.resize(size);
+        vt_.resize(size);
+        vn_.resize(size);
+        corners_.pop_back();
+        attributes_.pop_back();
+        polygon_ = false;
+    }
+    void corner(const face_vertex_type& vertex)
+    {
+        v_.push_back(vertex.v);
+        vt_.push_back(vertex.vt);
+        vn_.push_back(vertex.vn);
+    }
+
+    void flush_geometric_vertices()
+    {
+        if (!geometric_vertices_.empty() && parser_.geometric_vertices_callback_) {
+            parser_.geometric_vertices_callback_(&geometric_vertices_[0], geometric_vertices_.size() / 3);
+        }
+        geometric_vertices_.clear();
+    }
+    void flush_texture_vertices()
+    {
+        if (!texture_vertices_.empty() && parser_.texture_vertices_callback_) {
+            parser_.texture_vertices_callback_(&texture_vertices_[0], texture_vertices_.size() / 2);
+        }
+        texture_vertices_.clear();
+    }
+    void flush_vertex_normals()
+    {
+        if (!vertex_normals_.empty() && parser_.vertex_normals_callback_) {
+            parser_.vertex_normals_callback_(&vertex_normals_[0], vertex_normals_.size() / 3);
+        }
+        vertex_normals_.clear();
+    }
+    // vertices first : a face block only refers to vertices already sent
+    void flush()
+    {
+        flush_geometric_vertices();
+        flush_texture_vertices();
+        flush_vertex_normals();
+        if (!corners_.empty() && parser_.faces_callback_) {
+            face_block block;
+            block.size = corners_.size();
+            block.corners = &corners_[0];
+            block.attributes = &attributes_[0];
+            block.v = &v_[0];
+            block.vt = &vt_[0];
+            block.vn = &vn_[0];
+            parser_.faces_callback_(block);
+        }
+        corners_.clear();
+        attributes_.clear();
+        v_.clear();
+        vt_.clear();
+        vn_.clear();
+    }
+
+    const obj_batch_parser& parser_;
+    std::vector<float_type> geometric_vertices_;
+    std::vector<float_type> texture_vertices_;
+    std::vector<float_type> vertex_normals_;
+    std::vector<unsigned short> corners_;
+    std::vector<unsigned char> attributes_;
+    std::vector<index_type> v_;
+    std::vector<index_type> vt_;
+    std::vector<index_type> vn_;
+    bool polygon_;
+};
+
+class Obj_mtl::obj_batch_parser::push_parser {
+public:
+    explicit push_parser(const obj_batch_parser& parser)
+        : handler(parser)
+        , parser(handler, parser.flags_)
+    {
+    }
+
+    block_handler handler;
+    basic_obj_parser<block_handler> parser;
+};
+
+Obj_mtl::obj_batch_parser::obj_batch_parser(flags_type flags)
+    : flags_(flags)
+{
+}
+
+Obj_mtl::obj_batch_parser::~obj_batch_parser()
+{
+}
+
+bool Obj_mtl::obj_batch_parser::parse(const std::string& filename)
+{
+    block_handler handler(*this);
+    basic_obj_parser<block_handler> parser(handler, flags_);
+    return parser.parse(filename);
+}
+
+bool Obj_mtl::obj_batch_parser::parse(const char* begin, const char* end)
+{
+    block_handler handler(*this);
+    basic_obj_parser<block_handler> parser(handler, flags_);
+    return parser.parse(begin, end);
+}
+
+bool Obj_mtl::obj_batch_parser::feed(const char* data, std::size_t size)
+{
+    if (!push_parser_) {
+        push_parser_.reset(new push_parser(*this));
+    }
+    return push_parser_->parser.feed(data, size);
+}
+
+bool Obj_mtl::obj_batch_parser::finish()
+{
+    if (!push_parser_) {
+        push_parser_.reset(new push_parser(*this));
+    }
+    bool result = push_parser_->parser.finish();
+    push_parser_.reset();
+    return result;
+}
+
+} // namespace loaders
@@ -0,0 +1,210 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef OBJBATCHPARSER_H
+#define OBJBATCHPARSER_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include "objfileparser.h"
+#include "objparallelparser.h"
+
+// =============================================================================
+namespace Loaders {
+// =============================================================================
+
+// =============================================================================
+namespace Obj_mtl {
+// =============================================================================
+
+/** @ingroup OBJ-MTL
+  * Block of faces sent by #obj_batch_parser, one array per face attribute.
+  * Face i has corners[i] (3 or more) vertices, stored after those of face
+  * i - 1 : the indices of its vertex c are v[first + c], vt[first + c] and
+  * vn[first + c], first being the sum of the preceding corners (0 when the
+  * face has no such index, see attributes[i], a combination of
+  * obj_face::Attributes).
+  */
+struct face_block {
+    std::size_t size;
+    const unsigned short* corners;
+    const unsigned char* attributes;
+    const index_type* v;
+    const index_type* vt;
+    const index_type* vn;
+};
+
+/** @ingroup OBJ-MTL
+  * OBJ parser sending vertices and faces by blocks of at most #block_size
+  * elements instead of one callback per element. Vertex blocks are packed
+  * arrays (x y z, or u v for texture vertices) that can be appended with a
+  * single copy.
+  * Order is kept : pending blocks are sent before any other event (group,
+  * material...), and vertex blocks before the face blocks that follow them
+  * in the file.
+  * Polygons are sent as such, or as triangles with triangulate_faces.
+  */
+class obj_batch_parser {
+public:
+    enum { block_size = 4096 };
+
+    typedef obj_parser::info_callback_type info_callback_type;
+    typedef obj_parser::warning_callback_type warning_callback_type;
+    typedef obj_parser::error_callback_type error_callback_type;
+
+    /// (array of 3 * count coordinates, count)
+    typedef std::function<void(const float_type*, std::size_t)> geometric_vertices_callback_type;
+    /// (array of 2 * count coordinates, count)
+    typedef std::function<void(const float_type*, std::size_t)> texture_vertices_callback_type;
+    /// (array of 3 * count coordinates, count)
+    typedef std::function<void(const float_type*, std::size_t)> vertex_normals_callback_type;
+    typedef std::function<void(const face_block&)> faces_callback_type;
+
+    typedef obj_parser::group_name_callback_type group_name_callback_type;
+    typedef obj_parser::smoothing_group_callback_type smoothing_group_callback_type;
+    typedef obj_parser::object_name_callback_type object_name_callback_type;
+    typedef obj_parser::material_library_callback_type material_library_callback_type;
+    typedef obj_parser::material_name_callback_type material_name_callback_type;
+    typedef obj_parser::comment_callback_type comment_callback_type;
+
+    typedef obj_parser::flags_type flags_type;
+
+    obj_batch_parser(flags_type flags = 0);
+    ~obj_batch_parser();
+    void info_callback(const info_callback_type& info_callback);
+    void warning_callback(const warning_callback_type& warning_callback);
+    void error_callback(const error_callback_type& error_callback);
+    void geometric_vertices_callback(const geometric_vertices_callback_type& geometric_vertices_callback);
+    void texture_vertices_callback(const texture_vertices_callback_type& texture_vertices_callback);
+    void vertex_normals_callback(const vertex_normals_callback_type& vertex_normals_callback);
+    void faces_callback(const faces_callback_type& faces_callback);
+    void group_name_callback(const group_name_callback_type& group_name_callback);
+    void smoothing_group_callback(const smoothing_group_callback_type& smoothing_group_callback);
+    void object_name_callback(const object_name_callback_type& object_name_callback);
+    void material_library_callback(const material_library_callback_type& material_library_callback);
+    void material_name_callback(const material_name_callback_type& material_name_callback);
+    void comment_callback(const comment_callback_type& comment_callback);
+
+    /// Parse a file, mapped in memory when possible, read in memory otherwise.
+    bool parse(const std::string& filename);
+    /// Parse an in-memory OBJ content [begin, end).
+    bool parse(const char* begin, const char* end);
+    /// Push mode : parse the next size characters of an OBJ content. Lines
+    /// may be split between calls, blocks are kept until they are full or
+    /// until the next event. Returns false once a parse error occurred.
+    bool feed(const char* data, std::size_t size);
+    /// End of a push mode parse : parse the last line, send the pending
+    /// blocks and the summary.
+    bool finish();
+
+private:
+    // fills the blocks and sends them to the callbacks
+    class block_handler;
+    // handler and parser kept between the calls of a push mode parse
+    class push_parser;
+
+    flags_type flags_;
+    info_callback_type info_callback_;
+    warning_callback_type warning_callback_;
+    error_callback_type error_callback_;
+    geometric_vertices_callback_type geometric_vertices_callback_;
+    texture_vertices_callback_type texture_vertices_callback_;
+    vertex_normals_callback_type vertex_normals_callback_;
+    faces_callback_type faces_callback_;
+    group_name_callback_type group_name_callback_;
+    smoothing_group_callback_type smoothing_group_callback_;
+    object_name_callback_type object_name_callback_;
+    material_library_callback_type material_library_callback_;
+    material_name_callback_type material_name_callback_;
+    comment_callback_type comment_callback_;
+    std::unique_ptr<push_parser> push_parser_;
+};
+
+} // END namespace obj =========================================================
+
+inline void Obj_mtl::obj_batch_parser::info_callback(const info_callback_type& info_callback)
+{
+    info_callback_ = info_callback;
+}
+
+inline void Obj_mtl::obj_batch_parser::warning_callback(const warning_callback_type& warning_callback)
+{
+    warning_callback_ = warning_callback;
+}
+
+inline void Obj_mtl::obj_batch_parser::error_callback(const error_callback_type& error_callback)
+{
+    error_callback_ = error_callback;
+}
+
+inline void Obj_mtl::obj_batch_parser::geometric_vertices_callback(const geometric_vertices_callback_type& geometric_vertices_callback)
+{
+    geometric_vertices_callback_ = geometric_vertices_callback;
+}
+
+inline void Obj_mtl::obj_batch_parser::texture_vertices_callback(const texture_vertices_callback_type& texture_vertices_callback)
+{
+    texture_vertices_callback_ = texture_vertices_callback;
+}
+
+inline void Obj_mtl::obj_batch_parser::vertex_normals_callback(const vertex_normals_callback_type& vertex_normals_callback)
+{
+    vertex_normals_callback_ = vertex_normals_callback;
+}
+
+inline void Obj_mtl::obj_batch_parser::faces_callback(const faces_callback_type& faces_callback)
+{
+    faces_callback_ = faces_callback;
+}
+
+inline void Obj_mtl::obj_batch_parser::group_name_callback(const group_name_callback_type& group_name_callback)
+{
+    group_name_callback_ = group_name_callback;
+}
+
+inline void Obj_mtl::obj_batch_parser::smoothing_group_callback(const smoothing_group_callback_type& smoothing_group_callback)
+{
+    smoothing_group_callback_ = smoothing_group_callback;
+}
+
+inline void Obj_mtl::obj_batch_parser::object_name_callback(const object_name_callback_type& object_name_callback)
+{
+    object_name_callback_ = object_name_callback;
+}
+
+inline void Obj_mtl::obj_batch_parser::material_library_callback(const material_library_callback_type& material_library_callback)
+{
+    material_library_callback_ = material_library_callback;
+}
+
+inline void Obj_mtl::obj_batch_parser::material_name_callback(const material_name_callback_type& material_name_callback)
+{
+    material_name_callback_ = material_name_callback;
+}
+
+inline void Obj_mtl::obj_batch_parser::comment_callback(const comment_callback_type& comment_callback)
+{
+    comment_callback_ = comment_callback;
+}
+
+} // END namespace loaders =====================================================
+
+#endif // OBJBATCHPARSER_H
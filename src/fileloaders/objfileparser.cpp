@@ -18,6 +18,10 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 #include "objfileparser.h"
+#include "objbasicparser.h"
+#include "mappedfile.h"
+#include "compressedfile.h"
+#include "objtokenizer.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -57,7 +61,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
             // geometric vertex (v)
             if (keyword == "v") {
                 float_type x, y, z;
-                char whitespace_v_x, whitespace_x_y, whitespace_y_z;
+                char whitespace_v_x = '\0', whitespace_x_y = '\0', whitespace_y_z = '\0';
                 stringstream >> whitespace_v_x >> std::ws >> x >> whitespace_x_y >> std::ws >> y >> whitespace_y_z >> std::ws >> z >> std::ws;
                 if (/*!stringstream ||*/ !stringstream.eof() || !std::isspace(whitespace_v_x) || !std::isspace(whitespace_x_y) || !std::isspace(whitespace_y_z)) {
                     if (error_callback_) {
@@ -74,7 +78,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
             // texture vertex (vt)
             else if (keyword == "vt") {
                 float_type u, v;
-                char whitespace_vt_u, whitespace_u_v;
+                char whitespace_vt_u = '\0', whitespace_u_v = '\0';
                 stringstream >> whitespace_vt_u >> std::ws >> u >> whitespace_u_v >> std::ws >> v;
                 char whitespace_v_w = ' ';
                 if (!stringstream.eof()) {
@@ -121,7 +125,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
             // vertex normal (vn)
             else if (keyword == "vn") {
                 float_type x, y, z;
-                char whitespace_vn_x, whitespace_x_y, whitespace_y_z;
+                char whitespace_vn_x = '\0', whitespace_x_y = '\0', whitespace_y_z = '\0';
                 stringstream >> whitespace_vn_x >> std::ws >> x >> whitespace_x_y >> std::ws >> y >> whitespace_y_z >> std::ws >> z >> std::ws;
                 if (/*!stringstream ||*/ !stringstream.eof() || !std::isspace(whitespace_vn_x) || !std::isspace(whitespace_x_y) || !std::isspace(whitespace_y_z)) {
                     if (error_callback_) {
@@ -138,12 +142,12 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
             // face (f)
             else if ((keyword == "f") || (keyword == "fo")) {
                 index_type v1;
-                char whitespace_f_v1;
+                char whitespace_f_v1 = '\0';
                 stringstream >> whitespace_f_v1 >> std::ws >> v1;
                 if (std::isspace(stringstream.peek())) {
                     // f v
                     index_type v2, v3;
-                    char whitespace_v1_v2, whitespace_v2_v3;
+                    char whitespace_v1_v2 = '\0', whitespace_v2_v3 = '\0';
                     stringstream >> whitespace_v1_v2 >> std::ws >> v2 >> whitespace_v2_v3 >> std::ws >> v3;
                     char whitespace_v3_v4 = ' ';
                     if (!stringstream.eof()) {
@@ -304,7 +308,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
                     }
                 }
                 else {
-                    char slash_v1_vt1;
+                    char slash_v1_vt1 = '\0';
                     stringstream >> slash_v1_vt1;
                     if (stringstream.peek() != '/') {
                         index_type vt1;
@@ -312,7 +316,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
                         if (std::isspace(stringstream.peek())) {
                             // f v/vt
                             index_type v2, vt2, v3, vt3;
-                            char whitespace_vt1_v2, slash_v2_vt2, whitespace_vt2_v3, slash_v3_vt3;
+                            char whitespace_vt1_v2 = '\0', slash_v2_vt2 = '\0', whitespace_vt2_v3 = '\0', slash_v3_vt3 = '\0';
                             stringstream >> whitespace_vt1_v2 >> std::ws >> v2 >> slash_v2_vt2 >> vt2 >> whitespace_vt2_v3 >> std::ws >> v3 >> slash_v3_vt3 >> vt3;
                             char whitespace_vt3_v4 = ' ';
                             if (!stringstream.eof()) {
@@ -363,7 +367,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
                             }
                             else {
                                 index_type v4, vt4;
-                                char slash_v4_vt4;
+                                char slash_v4_vt4 = '\0';
                                 stringstream >> v4 >> slash_v4_vt4 >> vt4;
                                 char whitespace_vt4_v5 = ' ';
                                 if (!stringstream.eof()) {
@@ -416,7 +420,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
                                         index_type v_previous = v4, vt_previous = vt4;
                                         do {
                                             index_type v, vt;
-                                            char slash_geometric_vertices_texture_vertices;
+                                            char slash_geometric_vertices_texture_vertices = '\0';
                                             stringstream >> v >> slash_geometric_vertices_texture_vertices >> vt;
                                             char whitespace_vt_v = ' ';
                                             if (!stringstream.eof()) {
@@ -464,7 +468,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
                                         }
                                         do {
                                             index_type v, vt;
-                                            char slash_geometric_vertices_texture_vertices;
+                                            char slash_geometric_vertices_texture_vertices = '\0';
                                             stringstream >> v >> slash_geometric_vertices_texture_vertices >> vt;
                                             char whitespace_vt_v = ' ';
                                             if (!stringstream.eof()) {
@@ -510,7 +514,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
                         else {
                             // f v/vt/vn
                             index_type vn1, v2, vt2, vn2, v3, vt3, vn3;
-                            char slash_vt1_vn1, whitespace_vn1_v2, slash_v2_vt2, slash_vt2_vn2, whitespace_vn2_v3, slash_v3_vt3, slash_vt3_vn3;
+                            char slash_vt1_vn1 = '\0', whitespace_vn1_v2 = '\0', slash_v2_vt2 = '\0', slash_vt2_vn2 = '\0', whitespace_vn2_v3 = '\0', slash_v3_vt3 = '\0', slash_vt3_vn3 = '\0';
                             stringstream >> slash_vt1_vn1 >> vn1 >> whitespace_vn1_v2 >> std::ws >> v2 >> slash_v2_vt2 >> vt2 >> slash_vt2_vn2 >> vn2 >> whitespace_vn2_v3 >> std::ws >> v3 >> slash_v3_vt3 >> vt3 >> slash_vt3_vn3 >> vn3;
                             char whitespace_vn3_v4 = ' ';
                             if (!stringstream.eof()) {
@@ -574,7 +578,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
                             }
                             else {
                                 index_type v4, vt4, vn4;
-                                char slash_v4_vt4, slash_vt4_vn4;
+                                char slash_v4_vt4 = '\0', slash_vt4_vn4 = '\0';
                                 stringstream >> v4 >> slash_v4_vt4 >> vt4 >> slash_vt4_vn4 >> vn4;
                                 char whitespace_vn4_v5 = ' ';
                                 if (!stringstream.eof()) {
@@ -628,7 +632,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
                                         index_type v_previous = v4, vt_previous = vt4, vn_previous = vn4;
                                         do {
                                             index_type v, vt, vn;
-                                            char slash_geometric_vertices_texture_vertices, slash_vt_vn;
+                                            char slash_geometric_vertices_texture_vertices = '\0', slash_vt_vn = '\0';
                                             stringstream >> v >> slash_geometric_vertices_texture_vertices >> vt >> slash_vt_vn >> vn;
                                             char whitespace_vn_v = ' ';
                                             if (!stringstream.eof()) {
@@ -677,7 +681,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
                                         }
                                         do {
                                             index_type v, vt, vn;
-                                            char slash_geometric_vertices_texture_vertices, slash_vt_vn;
+                                            char slash_geometric_vertices_texture_vertices = '\0', slash_vt_vn = '\0';
                                             stringstream >> v >> slash_geometric_vertices_texture_vertices >> vt >> slash_vt_vn >> vn;
                                             char whitespace_vn_v = ' ';
                                             if (!stringstream.eof()) {
@@ -729,7 +733,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
                     else {
                         // f v//vn
                         index_type vn1, v2, vn2, v3, vn3;
-                        char slash_vt1_vn1, whitespace_vn1_v2, slash_v2_vt2, slash_vt2_vn2, whitespace_vn2_v3, slash_v3_vt3, slash_vt3_vn3;
+                        char slash_vt1_vn1 = '\0', whitespace_vn1_v2 = '\0', slash_v2_vt2 = '\0', slash_vt2_vn2 = '\0', whitespace_vn2_v3 = '\0', slash_v3_vt3 = '\0', slash_vt3_vn3 = '\0';
                         stringstream >> slash_vt1_vn1 >> vn1 >> whitespace_vn1_v2 >> std::ws >> v2 >> slash_v2_vt2 >> slash_vt2_vn2 >> vn2 >> whitespace_vn2_v3 >> std::ws >> v3 >> slash_v3_vt3 >> slash_vt3_vn3 >> vn3;
                         char whitespace_vn3_v4 = ' ';
                         if (!stringstream.eof()) {
@@ -780,7 +784,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
                         }
                         else {
                             index_type v4, vn4;
-                            char slash_v4_vt4, slash_vt4_vn4;
+                            char slash_v4_vt4 = '\0', slash_vt4_vn4 = '\0';
                             stringstream >> v4 >> slash_v4_vt4 >> slash_vt4_vn4 >> vn4;
                             char whitespace_vn4_v5 = ' ';
                             if (!stringstream.eof()) {
@@ -830,7 +834,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
                                     index_type v_previous = v4, vn_previous = vn4;
                                     do {
                                         index_type v, vn;
-                                        char slash_geometric_vertices_texture_vertices, slash_vt_vn;
+                                        char slash_geometric_vertices_texture_vertices = '\0', slash_vt_vn = '\0';
                                         stringstream >> v >> slash_geometric_vertices_texture_vertices >> slash_vt_vn >> vn;
                                         char whitespace_vn_v = ' ';
                                         if (!stringstream.eof()) {
@@ -875,7 +879,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
                                     }
                                     do {
                                         index_type v, vn;
-                                        char slash_geometric_vertices_texture_vertices, slash_vt_vn;
+                                        char slash_geometric_vertices_texture_vertices = '\0', slash_vt_vn = '\0';
                                         stringstream >> v >> slash_geometric_vertices_texture_vertices >> slash_vt_vn >> vn;
                                         char whitespace_vn_v = ' ';
                                         if (!stringstream.eof()) {
@@ -956,7 +960,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
             // smoothing group (s)
             else if (keyword == "s") {
                 std::string group_number_string;
-                char whitespace_mtllib_group_number;
+                char whitespace_mtllib_group_number = '\0';
                 stringstream >> whitespace_mtllib_group_number >> std::ws >> group_number_string >> std::ws;
                 if (/*!stringstream ||*/ !stringstream.eof() || !std::isspace(whitespace_mtllib_group_number)) {
                     if (error_callback_) {
@@ -987,7 +991,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
             // object name (o)
             else if (keyword == "o") {
                 std::string object_name;
-                char whitespace_mtllib_object_name;
+                char whitespace_mtllib_object_name = '\0';
                 stringstream >> whitespace_mtllib_object_name >> std::ws >> object_name >> std::ws;
                 if (/*!stringstream ||*/ !stringstream.eof() || !std::isspace(whitespace_mtllib_object_name)) {
                     if (error_callback_) {
@@ -1004,7 +1008,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
             // material library (mtllib)
             else if (keyword == "mtllib") {
                 std::string filename;
-                char whitespace_mtllib_filename;
+                char whitespace_mtllib_filename = '\0';
 
                 //bool failbit = (stringstream.rdstate() & std::ifstream::failbit );
 
@@ -1027,7 +1031,7 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
             // material name (usemtl)
             else if (keyword == "usemtl") {
                 std::string material_name;
-                char whitespace_mtllib_material_name;
+                char whitespace_mtllib_material_name = '\0';
                 stringstream >> whitespace_mtllib_material_name >> std::ws >> material_name >> std::ws;
                 if (/*!stringstream ||*/ !stringstream.eof() || !std::isspace(whitespace_mtllib_material_name)) {
                     if (error_callback_) {
@@ -1068,467 +1072,581 @@ bool Obj_mtl::obj_parser::parse(std::istream& istream)
     return istream.fail() && istream.eof() && !istream.bad();
 }
 
+bool Obj_mtl::obj_parser::parse(const std::string& filename)
+{
+    if (CompressedFile::isCompressed(filename)) {
+        CompressedFile compressed;
+        if (!compressed.open(filename)) {
+            if (error_callback_) {
+                error_callback_(0, compressed.error());
+            }
+            return false;
+        }
+        const char* data;
+        std::size_t size;
+        bool result = true;
+        while (result && compressed.nextBlock(data, size)) {
+            result = feed(data, size);
+        }
+        if (result && !compressed.error().empty()) {
+            if (error_callback_) {
+                error_callback_(0, compressed.error());
+            }
+            // the last line is incomplete, not parsed
+            push_parser_.reset();
+            return false;
+        }
+        return finish() && result;
+    }
+    MappedFile file;
+    if (file.open(filename)) {
+        return parse(file.begin(), file.end());
+    }
+    std::ifstream ifstream(filename.c_str());
+    return parse(ifstream);
+}
+
+std::string Obj_mtl::obj_parser::info_message(const statistics& statistics)
+{
+    std::ostringstream info_message;
+    info_message << "Vertices : " << statistics.number_of_geometric_vertices << std::endl;
+    info_message << "Texture coordinates : " << statistics.number_of_texture_vertices << std::endl;
+    info_message << "Normals : " << statistics.number_of_vertex_normals << std::endl;
+    info_message << "Faces : " << statistics.number_of_faces << std::endl;
+    info_message << "Groups name : " << statistics.number_of_group_names << std::endl;
+    info_message << "Smoothing groups : " << statistics.number_of_smoothing_groups << std::endl;
+    info_message << "Object names : " << statistics.number_of_object_names << std::endl;
+    info_message << "Material Library : " << statistics.number_of_material_libraries << std::endl;
+    info_message << "Material names : " << statistics.number_of_material_names;
+    return info_message.str();
+}
+
+bool Obj_mtl::obj_parser::parse(const char* begin, const char* end)
+{
+    statistics totals;
+    return parse(begin, end, totals);
+}
+
+class Obj_mtl::obj_parser::callback_handler {
+public:
+    explicit callback_handler(const obj_parser& parser)
+        : parser_(parser)
+    {
+    }
+
+    void info(std::size_t line_number, const std::string& message)
+    {
+        if (parser_.info_callback_) {
+            parser_.info_callback_(line_number, message);
+        }
+    }
+    void warning(std::size_t line_number, const std::string& message)
+    {
+        if (parser_.warning_callback_) {
+            parser_.warning_callback_(line_number, message);
+        }
+    }
+    void error(std::size_t line_number, const std::string& message)
+    {
+        if (parser_.error_callback_) {
+            parser_.error_callback_(line_number, message);
+        }
+    }
+
+    void geometric_vertex(float_type x, float_type y, float_type z)
+    {
+        if (parser_.geometric_vertex_callback_) {
+            parser_.geometric_vertex_callback_(x, y, z);
+        }
+    }
+    void texture_vertex(float_type u, float_type v)
+    {
+        if (parser_.texture_vertex_callback_) {
+            parser_.texture_vertex_callback_(u, v);
+        }
+    }
+    void vertex_normal(float_type x, float_type y, float_type z)
+    {
+        if (parser_.vertex_normal_callback_) {
+            parser_.vertex_normal_callback_(x, y, z);
+        }
+    }
+
+    void triangular_face_geometric_vertices(index_type v1, index_type v2, index_type v3)
+    {
+        if (parser_.triangular_face_geometric_vertices_callback_) {
+            parser_.triangular_face_geometric_vertices_callback_(v1, v2, v3);
+        }
+    }
+    void triangular_face_geometric_vertices_texture_vertices(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        if (parser_.triangular_face_geometric_vertices_texture_vertices_callback_) {
+            parser_.triangular_face_geometric_vertices_texture_vertices_callback_(v_vt(v1), v_vt(v2), v_vt(v3));
+        }
+    }
+    void triangular_face_geometric_vertices_vertex_normals(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        if (parser_.triangular_face_geometric_vertices_vertex_normals_callback_) {
+            parser_.triangular_face_geometric_vertices_vertex_normals_callback_(v_vn(v1), v_vn(v2), v_vn(v3));
+        }
+    }
+    void triangular_face_geometric_vertices_texture_vertices_vertex_normals(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        if (parser_.triangular_face_geometric_vertices_texture_vertices_vertex_normals_callback_) {
+            parser_.triangular_face_geometric_vertices_texture_vertices_vertex_normals_callback_(v_vt_vn(v1), v_vt_vn(v2), v_vt_vn(v3));
+        }
+    }
+
+    void quadrilateral_face_geometric_vertices(index_type v1, index_type v2, index_type v3, index_type v4)
+    {
+        if (parser_.quadrilateral_face_geometric_vertices_callback_) {
+            parser_.quadrilateral_face_geometric_vertices_callback_(v1, v2, v3, v4);
+        }
+    }
+    void quadrilateral_face_geometric_vertices_texture_vertices(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3, const face_vertex_type& v4)
+    {
+        if (parser_.quadrilateral_face_geometric_vertices_texture_vertices_callback_) {
+            parser_.quadrilateral_face_geometric_vertices_texture_vertices_callback_(v_vt(v1), v_vt(v2), v_vt(v3), v_vt(v4));
+        }
+    }
+    void quadrilateral_face_geometric_vertices_vertex_normals(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3, const face_vertex_type& v4)
+    {
+        if (parser_.quadrilateral_face_geometric_vertices_vertex_normals_callback_) {
+            parser_.quadrilateral_face_geometric_vertices_vertex_normals_callback_(v_vn(v1), v_vn(v2), v_vn(v3), v_vn(v4));
+        }
+    }
+    void quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3, const face_vertex_type& v4)
+    {
+        if (parser_.quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals_callback_) {
+            parser_.quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals_callback_(v_vt_vn(v1), v_vt_vn(v2), v_vt_vn(v3), v_vt_vn(v4));
+        }
+    }
+
+    void polygonal_face_geometric_vertices_begin(index_type v1, index_type v2, index_type v3)
+    {
+        if (parser_.polygonal_face_geometric_vertices_begin_callback_) {
+            parser_.polygonal_face_geometric_vertices_begin_callback_(v1, v2, v3);
+        }
+    }
+    void polygonal_face_geometric_vertices_vertex(index_type v)
+    {
+        if (parser_.polygonal_face_geometric_vertices_vertex_callback_) {
+            parser_.polygonal_face_geometric_vertices_vertex_callback_(v);
+        }
+    }
+    void polygonal_face_geometric_vertices_end()
+    {
+        if (parser_.polygonal_face_geometric_vertices_end_callback_) {
+            parser_.polygonal_face_geometric_vertices_end_callback_();
+        }
+    }
+    void polygonal_face_geometric_vertices_texture_vertices_begin(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        if (parser_.polygonal_face_geometric_vertices_texture_vertices_begin_callback_) {
+            parser_.polygonal_face_geometric_vertices_texture_vertices_begin_callback_(v_vt(v1), v_vt(v2), v_vt(v3));
+        }
+    }
+    void polygonal_face_geometric_vertices_texture_vertices_vertex(const face_vertex_type& v)
+    {
+        if (parser_.polygonal_face_geometric_vertices_texture_vertices_vertex_callback_) {
+            parser_.polygonal_face_geometric_vertices_texture_vertices_vertex_callback_(v_vt(v));
+        }
+    }
+    void polygonal_face_geometric_vertices_texture_vertices_end()
+    {
+        if (parser_.polygonal_face_geometric_vertices_texture_vertices_end_callback_) {
+            parser_.polygonal_face_geometric_vertices_texture_vertices_end_callback_();
+        }
+    }
+    void polygonal_face_geometric_vertices_vertex_normals_begin(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        if (parser_.polygonal_face_geometric_vertices_vertex_normals_begin_callback_) {
+            parser_.polygonal_face_geometric_vertices_vertex_normals_begin_callback_(v_vn(v1), v_vn(v2), v_vn(v3));
+        }
+    }
+    void polygonal_face_geometric_vertices_vertex_normals_vertex(const face_vertex_type& v)
+    {
+        if (parser_.polygonal_face_geometric_vertices_vertex_normals_vertex_callback_) {
+            parser_.polygonal_face_geometric_vertices_vertex_normals_vertex_callback_(v_vn(v));
+        }
+    }
+    void polygonal_face_geometric_vertices_vertex_normals_end()
+    {
+        if (parser_.polygonal_face_geometric_vertices_vertex_normals_end_callback_) {
+            parser_.polygonal_face_geometric_vertices_vertex_normals_end_callback_();
+        }
+    }
+    void polygonal_face_geometric_vertices_texture_vertices_vertex_normals_begin(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        if (parser_.polygonal_face_geometric_vertices_texture_vertices_vertex_normals_begin_callback_) {
+            parser_.polygonal_face_geometric_vertices_texture_vertices_vertex_normals_begin_callback_(v_vt_vn(v1), v_vt_vn(v2), v_vt_vn(v3));
+        }
+    }
+    void polygonal_face_geometric_vertices_texture_vertices_vertex_normals_vertex(const face_vertex_type& v)
+    {
+        if (parser_.polygonal_face_geometric_vertices_texture_vertices_vertex_normals_vertex_callback_) {
+            parser_.polygonal_face_geometric_vertices_texture_vertices_vertex_normals_vertex_callback_(v_vt_vn(v));
+        }
+    }
+    void polygonal_face_geometric_vertices_texture_vertices_vertex_normals_end()
+    {
+        if (parser_.polygonal_face_geometric_vertices_texture_vertices_vertex_normals_end_callback_) {
+            parser_.polygonal_face_geometric_vertices_texture_vertices_vertex_normals_end_callback_();
+        }
+    }
+
+    void group_name(const std::string& name)
+    {
+        if (parser_.group_name_callback_) {
+            parser_.group_name_callback_(name);
+        }
+    }
+    void smoothing_group(size_type group_number)
+    {
+        if (parser_.smoothing_group_callback_) {
+            parser_.smoothing_group_callback_(group_number);
+        }
+    }
+    void object_name(const std::string& name)
+    {
+        if (parser_.object_name_callback_) {
+            parser_.object_name_callback_(name);
+        }
+    }
+    void material_library(const std::string& name)
+    {
+        if (parser_.material_library_callback_) {
+            parser_.material_library_callback_(name);
+        }
+    }
+    void material_name(const std::string& name)
+    {
+        if (parser_.material_name_callback_) {
+            parser_.material_name_callback_(name);
+        }
+    }
+    void comment(const std::string& comment)
+    {
+        if (parser_.comment_callback_) {
+            parser_.comment_callback_(comment);
+        }
+    }
+
+private:
+    static index_2_tuple_type v_vt(const face_vertex_type& vertex) { return index_2_tuple_type(vertex.v, vertex.vt); }
+    static index_2_tuple_type v_vn(const face_vertex_type& vertex) { return index_2_tuple_type(vertex.v, vertex.vn); }
+    static index_3_tuple_type v_vt_vn(const face_vertex_type& vertex) { return index_3_tuple_type(vertex.v, vertex.vt, vertex.vn); }
+
+    const obj_parser& parser_;
+};
+
+bool Obj_mtl::obj_parser::parse(const char* begin, const char* end, statistics& statistics)
+{
+    callback_handler handler(*this);
+    basic_obj_parser<callback_handler> parser(handler, flags_);
+    return parser.parse(begin, end, statistics);
+}
+
+class Obj_mtl::obj_parser::push_parser {
+public:
+    explicit push_parser(const obj_parser& parser)
+        : handler(parser)
+        , parser(handler, parser.flags_)
+    {
+    }
+
+    callback_handler handler;
+    basic_obj_parser<callback_handler> parser;
+};
+
+// out of line : push_parser is only defined here
+Obj_mtl::obj_parser::obj_parser(flags_type flags)
+    : flags_(flags)
+{
+}
+
+Obj_mtl::obj_parser::~obj_parser()
+{
+}
+
+bool Obj_mtl::obj_parser::feed(const char* data, std::size_t size)
+{
+    if (!push_parser_) {
+        push_parser_.reset(new push_parser(*this));
+    }
+    return push_parser_->parser.feed(data, size);
+}
+
+bool Obj_mtl::obj_parser::finish()
+{
+    if (!push_parser_) {
+        push_parser_.reset(new push_parser(*this));
+    }
+    bool result = push_parser_->parser.finish();
+    push_parser_.reset();
+    return result;
+}
+
+namespace {
+
+inline void set_color(Obj_mtl::float_type* color, Obj_mtl::float_type r, Obj_mtl::float_type g, Obj_mtl::float_type b)
+{
+    color[0] = r;
+    color[1] = g;
+    color[2] = b;
+}
+
+}
+
+bool Obj_mtl::mtl_parser::parse(const std::string& filename)
+{
+    // whole file in memory : parsed by pointers, like the OBJ files
+    std::string content;
+    if (CompressedFile::isCompressed(filename)) {
+        CompressedFile compressed;
+        if (!compressed.open(filename)) {
+            if (error_callback_) {
+                error_callback_(0, compressed.error());
+            }
+            return false;
+        }
+        const char* data;
+        std::size_t size;
+        while (compressed.nextBlock(data, size)) {
+            content.append(data, size);
+        }
+        if (!compressed.error().empty()) {
+            if (error_callback_) {
+                error_callback_(0, compressed.error());
+            }
+            return false;
+        }
+        return parse(content.data(), content.data() + content.size());
+    }
+    MappedFile file;
+    if (file.open(filename)) {
+        return parse(file.begin(), file.end());
+    }
+    std::ifstream ifstream(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!ifstream) {
+        if (error_callback_) {
+            error_callback_(0, "can't open " + filename);
+        }
+        return false;
+    }
+    content.assign((std::istreambuf_iterator<char>(ifstream)), std::istreambuf_iterator<char>());
+    return parse(content.data(), content.data() + content.size());
+}
 
 bool Obj_mtl::mtl_parser::parse(std::istream& istream)
 {
-    std::string line;
-    std::size_t line_number = 0;
+    std::string content((std::istreambuf_iterator<char>(istream)), std::istreambuf_iterator<char>());
+    return parse(content.data(), content.data() + content.size());
+}
 
+bool Obj_mtl::mtl_parser::parse(const char* begin, const char* end)
+{
+    material_block_ = mtl_material_block();
+    material_block_pending_ = false;
+    bool result = parse_lines(begin, end);
+    // last material, or the one being defined when an error occurred
+    flush_material_block();
+    return result;
+}
+
+void Obj_mtl::mtl_parser::flush_material_block()
+{
+    if (material_block_pending_ && material_block_callback_) {
+        material_block_callback_(material_block_);
+    }
+    material_block_pending_ = false;
+}
+
+bool Obj_mtl::mtl_parser::parse_lines(const char* begin, const char* end)
+{
+    using namespace tokenizer;
+
+    std::size_t line_number = 0;
     std::size_t number_of_material_names = 0;
 
-    while (!istream.eof() && std::getline(istream, line)) {
+    auto error = [&](const char* message) {
+        if (error_callback_) {
+            error_callback_(line_number, message);
+        }
+        return false;
+    };
+
+    const char* next_line = begin;
+    while (next_line != end) {
+        const char* line_begin = next_line;
+        const char* eol = line_end(line_begin, end);
+        next_line = (eol == end) ? end : eol + 1;
         ++line_number;
-        std::istringstream stringstream(line);
-        stringstream.unsetf(std::ios_base::skipws);
 
-        stringstream >> std::ws;
-        if (stringstream.eof()) {
-            if (flags_ & parse_blank_lines_as_comment) {
-                if (comment_callback_) {
-                    comment_callback_(line);
-                }
+        const char* p = line_begin;
+        skip_space(p, eol);
+        if (p == eol) {
+            if ((flags_ & parse_blank_lines_as_comment) && comment_callback_) {
+                comment_callback_(std::string(line_begin, eol));
             }
+            continue;
         }
-        else if (stringstream.peek() == '#') {
+        if (*p == '#') {
             if (comment_callback_) {
-                comment_callback_(line);
+                comment_callback_(std::string(line_begin, eol));
             }
+            continue;
         }
-        else {
-            std::string keyword;
-            stringstream >> keyword;
-            if (keyword == "newmtl") {
-                std::string material_name;
-                char whitespace_mtllib_material_name;
-                stringstream >> whitespace_mtllib_material_name >> std::ws >> material_name >> std::ws;
-                if (/*!stringstream ||*/ !stringstream.eof() || !std::isspace(whitespace_mtllib_material_name)) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                ++number_of_material_names;
-                if (material_name_callback_) {
-                    material_name_callback_(material_name);
-                }
-            }
-            // Ka
-            else if (keyword == "Ka") {
-                float_type r, g, b;
-                char whitespace_v_r, whitespace_r_g, whitespace_g_b;
-                stringstream >> whitespace_v_r >> std::ws >> r >> whitespace_r_g >> std::ws >> g >> whitespace_g_b >> std::ws >> b >> std::ws;
-                if (/*!stringstream ||*/ !stringstream.eof() || !std::isspace(whitespace_v_r) || !std::isspace(whitespace_r_g) || !std::isspace(whitespace_g_b)) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                if (material_Ka_callback_) {
-                    material_Ka_callback_(r, g, b);
-                }
-            }
-
-            // Kd
-            else if (keyword == "Kd") {
-                float_type r, g, b;
-                char whitespace_v_r, whitespace_r_g, whitespace_g_b;
-                stringstream >> whitespace_v_r >> std::ws >> r >> whitespace_r_g >> std::ws >> g >> whitespace_g_b >> std::ws >> b >> std::ws;
-                if (/*!stringstream ||*/ !stringstream.eof() || !std::isspace(whitespace_v_r) || !std::isspace(whitespace_r_g) || !std::isspace(whitespace_g_b)) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                if (material_Kd_callback_) {
-                    material_Kd_callback_(r, g, b);
-                }
-            }
 
-            // Ks
-            else if (keyword == "Ks") {
-                float_type r, g, b;
-                char whitespace_v_r, whitespace_r_g, whitespace_g_b;
-                stringstream >> whitespace_v_r >> std::ws >> r >> whitespace_r_g >> std::ws >> g >> whitespace_g_b >> std::ws >> b >> std::ws;
-                if (/*!stringstream ||*/ !stringstream.eof() || !std::isspace(whitespace_v_r) || !std::isspace(whitespace_r_g) || !std::isspace(whitespace_g_b)) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                if (material_Ks_callback_) {
-                    material_Ks_callback_(r, g, b);
-                }
-            }
+        const char* keyword = p;
+        p = token_end(p, eol);
+        const char* keyword_end = p;
 
-            // Tf
-            else if (keyword == "Tf") {
-                float_type r, g, b;
-                char whitespace_v_r, whitespace_r_g, whitespace_g_b;
-                stringstream >> whitespace_v_r >> std::ws >> r >> whitespace_r_g >> std::ws >> g >> whitespace_g_b >> std::ws >> b >> std::ws;
-                if (/*!stringstream ||*/ !stringstream.eof() || !std::isspace(whitespace_v_r) || !std::isspace(whitespace_r_g) || !std::isspace(whitespace_g_b)) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                if (material_Tf_callback_) {
-                    material_Tf_callback_(r, g, b);
-                }
+        // colour : three floats
+        float_type* color = 0;
+        int color_flag = 0;
+        const material_Ka_callback_type* color_callback = 0;
+        if (token_equals(keyword, keyword_end, "Ka")) {
+            color = material_block_.Ka, color_flag = mtl_material_block::has_Ka, color_callback = &material_Ka_callback_;
+        }
+        else if (token_equals(keyword, keyword_end, "Kd")) {
+            color = material_block_.Kd, color_flag = mtl_material_block::has_Kd, color_callback = &material_Kd_callback_;
+        }
+        else if (token_equals(keyword, keyword_end, "Ks")) {
+            color = material_block_.Ks, color_flag = mtl_material_block::has_Ks, color_callback = &material_Ks_callback_;
+        }
+        else if (token_equals(keyword, keyword_end, "Tf")) {
+            color = material_block_.Tf, color_flag = mtl_material_block::has_Tf, color_callback = &material_Tf_callback_;
+        }
+        if (color) {
+            float_type r, g, b;
+            if (!separator(p, eol) || !parse_float(p, eol, r, end) || !separator(p, eol) || !parse_float(p, eol, g, end) || !separator(p, eol) || !parse_float(p, eol, b, end) || !end_of_line(p, eol)) {
+                return error("parse error");
             }
-            // illum
-            else if (keyword == "illum") {
-                index_type i;
-                char whitespace_v_i;
-                stringstream >> whitespace_v_i >> std::ws >> i >> std::ws;
-                if (/*!stringstream ||*/ !stringstream.eof() || !std::isspace(whitespace_v_i)) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                if (material_Illum_callback_) {
-                    material_Illum_callback_(i);
-                }
+            if (*color_callback) {
+                (*color_callback)(r, g, b);
             }
+            set_color(color, r, g, b);
+            material_block_.colors |= color_flag;
+            material_block_pending_ = true;
+            continue;
+        }
 
-            // dissolve (d)
-            else if (keyword == "d") {
-                char whitespace_dissolve_attribute = ' ';
-                if (!stringstream.eof()) {
-                    stringstream >> whitespace_dissolve_attribute >> std::ws;
-                }
-                if (/*!stringstream ||*/ !std::isspace(whitespace_dissolve_attribute) || stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                std::string dissolve_attribute;
-                stringstream >> dissolve_attribute >> std::ws;
-                if (/*!stringstream ||*/ !stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                if (material_dissolve_callback_) {
-                    material_dissolve_callback_(dissolve_attribute);
-                }
-            }
-            // Shininess (Ns)
-            else if (keyword == "Ns") {
-                float_type n;
-                char whitespace_v_n;
-                stringstream >> whitespace_v_n >> std::ws >> n >> std::ws;
-                if (/*!stringstream ||*/ !stringstream.eof() || !std::isspace(whitespace_v_n)) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                if (material_shininess_callback_) {
-                    material_shininess_callback_(n);
-                }
+        // texture map : the rest of the line (options and file name)
+        std::string* map = 0;
+        const material_map_Ka_callback_type* map_callback = 0;
+        if (token_equals(keyword, keyword_end, "map_Ka")) {
+            map = &material_block_.map_Ka, map_callback = &material_map_Ka_callback_;
+        }
+        else if (token_equals(keyword, keyword_end, "map_Kd")) {
+            map = &material_block_.map_Kd, map_callback = &material_map_Kd_callback_;
+        }
+        else if (token_equals(keyword, keyword_end, "map_Ks")) {
+            map = &material_block_.map_Ks, map_callback = &material_map_Ks_callback_;
+        }
+        else if (token_equals(keyword, keyword_end, "map_Ns")) {
+            map = &material_block_.map_Ns, map_callback = &material_map_Ns_callback_;
+        }
+        else if (token_equals(keyword, keyword_end, "map_d")) {
+            map = &material_block_.map_d, map_callback = &material_map_d_callback_;
+        }
+        else if (token_equals(keyword, keyword_end, "disp")) {
+            map = &material_block_.dispmap, map_callback = &material_dispmap_callback_;
+        }
+        else if (token_equals(keyword, keyword_end, "decal")) {
+            map = &material_block_.decalmap, map_callback = &material_decalmap_callback_;
+        }
+        else if (token_equals(keyword, keyword_end, "bump")) {
+            map = &material_block_.bumpmap, map_callback = &material_bumpmap_callback_;
+        }
+        else if (token_equals(keyword, keyword_end, "refl")) {
+            map = &material_block_.reflmap, map_callback = &material_reflmap_callback_;
+        }
+        else if (token_equals(keyword, keyword_end, "map_normal")) {
+            map = &material_block_.normalmap, map_callback = &material_normalmap_callback_;
+        }
+        if (map) {
+            if (!separator(p, eol) || p == eol) {
+                return error("parse error");
             }
-            // Sharpness (sharpness)
-            else if (keyword == "sharpness") {
-                float_type n;
-                char whitespace_v_n;
-                stringstream >> whitespace_v_n >> std::ws >> n >> std::ws;
-                if (/*!stringstream ||*/ !stringstream.eof() || !std::isspace(whitespace_v_n)) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                if (material_sharpness_callback_) {
-                    material_sharpness_callback_(n);
-                }
-            }
-            // ior (Ni)
-            else if (keyword == "Ni") {
-                float_type n;
-                char whitespace_v_n;
-                stringstream >> whitespace_v_n >> std::ws >> n >> std::ws;
-                if (/*!stringstream ||*/ !stringstream.eof() || !std::isspace(whitespace_v_n)) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                if (material_ior_callback_) {
-                    material_ior_callback_(n);
-                }
+            map->assign(p, eol);
+            if (*map_callback) {
+                (*map_callback)(*map);
             }
+            material_block_pending_ = true;
+            continue;
+        }
 
-            // map_Ka
-            else if (keyword == "map_Ka") {
-                char whitespace_map_attribute = ' ';
-                if (!stringstream.eof()) {
-                    stringstream >> whitespace_map_attribute >> std::ws;
-                }
-                if (/*!stringstream ||*/ !std::isspace(whitespace_map_attribute) || stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                std::string map_attribute;
-                //stringstream >> map_attribute >> std::ws;
-                getline(stringstream, map_attribute);
-                if (/*!stringstream ||*/ !stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                if (material_map_Ka_callback_) {
-                    material_map_Ka_callback_(map_attribute);
-                }
+        if (token_equals(keyword, keyword_end, "newmtl")) {
+            if (!separator(p, eol)) {
+                return error("parse error");
             }
-            // map_Kd
-            else if (keyword == "map_Kd") {
-                char whitespace_map_attribute = ' ';
-                if (!stringstream.eof()) {
-                    stringstream >> whitespace_map_attribute >> std::ws;
-                }
-                if (/*!stringstream ||*/ !std::isspace(whitespace_map_attribute) || stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                std::string map_attribute;
-                //stringstream >> map_attribute >> std::ws;
-                getline(stringstream, map_attribute);
-                if (/*!stringstream ||*/ !stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "map_Kd parse error");
-                    }
-                    return false;
-                }
-                if (material_map_Kd_callback_) {
-                    material_map_Kd_callback_(map_attribute);
-                }
+            const char* name = p;
+            p = token_end(p, eol);
+            const char* name_end = p;
+            if (!end_of_line(p, eol)) {
+                return error("parse error");
             }
-            // map_Ks
-            else if (keyword == "map_Ks") {
-                char whitespace_map_attribute = ' ';
-                if (!stringstream.eof()) {
-                    stringstream >> whitespace_map_attribute >> std::ws;
-                }
-                if (/*!stringstream ||*/ !std::isspace(whitespace_map_attribute) || stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                std::string map_attribute;
-                //stringstream >> map_attribute >> std::ws;
-                getline(stringstream, map_attribute);
-                if (/*!stringstream ||*/ !stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                if (material_map_Ks_callback_) {
-                    material_map_Ks_callback_(map_attribute);
-                }
+            flush_material_block();
+            material_block_ = mtl_material_block();
+            material_block_.name.assign(name, name_end);
+            material_block_pending_ = true;
+            ++number_of_material_names;
+            if (material_name_callback_) {
+                material_name_callback_(material_block_.name);
             }
-            // map_Ns
-            else if (keyword == "map_Ns") {
-                char whitespace_map_attribute = ' ';
-                if (!stringstream.eof()) {
-                    stringstream >> whitespace_map_attribute >> std::ws;
-                }
-                if (/*!stringstream ||*/ !std::isspace(whitespace_map_attribute) || stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                std::string map_attribute;
-                //stringstream >> map_attribute >> std::ws;
-                getline(stringstream, map_attribute);
-                if (/*!stringstream ||*/ !stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                if (material_map_Ns_callback_) {
-                    material_map_Ns_callback_(map_attribute);
-                }
+        }
+        // illum
+        else if (token_equals(keyword, keyword_end, "illum")) {
+            index_type i;
+            if (!separator(p, eol) || !parse_index(p, eol, i) || !end_of_line(p, eol)) {
+                return error("parse error");
             }
-            // map_d
-            else if (keyword == "map_d") {
-                char whitespace_map_attribute = ' ';
-                if (!stringstream.eof()) {
-                    stringstream >> whitespace_map_attribute >> std::ws;
-                }
-                if (/*!stringstream ||*/ !std::isspace(whitespace_map_attribute) || stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                std::string map_attribute;
-                //stringstream >> map_attribute >> std::ws;
-                getline(stringstream, map_attribute);
-                if (/*!stringstream ||*/ !stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                if (material_map_d_callback_) {
-                    material_map_d_callback_(map_attribute);
-                }
+            if (material_Illum_callback_) {
+                material_Illum_callback_(i);
             }
-            // disp
-            else if (keyword == "disp") {
-                char whitespace_map_attribute = ' ';
-                if (!stringstream.eof()) {
-                    stringstream >> whitespace_map_attribute >> std::ws;
-                }
-                if (/*!stringstream ||*/ !std::isspace(whitespace_map_attribute) || stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                std::string map_attribute;
-                //stringstream >> map_attribute >> std::ws;
-                getline(stringstream, map_attribute);
-                if (/*!stringstream ||*/ !stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                if (material_dispmap_callback_) {
-                    material_dispmap_callback_(map_attribute);
-                }
+        }
+        // dissolve (d)
+        else if (token_equals(keyword, keyword_end, "d")) {
+            if (!separator(p, eol) || p == eol) {
+                return error("parse error");
             }
-            // decal
-            else if (keyword == "decal") {
-                char whitespace_map_attribute = ' ';
-                if (!stringstream.eof()) {
-                    stringstream >> whitespace_map_attribute >> std::ws;
-                }
-                if (/*!stringstream ||*/ !std::isspace(whitespace_map_attribute) || stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                std::string map_attribute;
-                //stringstream >> map_attribute >> std::ws;
-                getline(stringstream, map_attribute);
-                if (/*!stringstream ||*/ !stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                if (material_decalmap_callback_) {
-                    material_decalmap_callback_(map_attribute);
-                }
+            const char* attribute = p;
+            p = token_end(p, eol);
+            const char* attribute_end = p;
+            if (!end_of_line(p, eol)) {
+                return error("parse error");
             }
-            // bump
-            else if (keyword == "bump") {
-                char whitespace_map_attribute = ' ';
-                if (!stringstream.eof()) {
-                    stringstream >> whitespace_map_attribute >> std::ws;
-                }
-                if (/*!stringstream ||*/ !std::isspace(whitespace_map_attribute) || stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                std::string map_attribute;
-                //stringstream >> map_attribute >> std::ws;
-                getline(stringstream, map_attribute);
-                if (/*!stringstream ||*/ !stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                if (material_bumpmap_callback_) {
-                    material_bumpmap_callback_(map_attribute);
-                }
+            if (material_dissolve_callback_) {
+                material_dissolve_callback_(std::string(attribute, attribute_end));
             }
-            // refl
-            else if (keyword == "refl") {
-                char whitespace_map_attribute = ' ';
-                if (!stringstream.eof()) {
-                    stringstream >> whitespace_map_attribute >> std::ws;
-                }
-                if (/*!stringstream ||*/ !std::isspace(whitespace_map_attribute) || stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                std::string map_attribute;
-                //stringstream >> map_attribute >> std::ws;
-                getline(stringstream, map_attribute);
-                if (/*!stringstream ||*/ !stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                if (material_reflmap_callback_) {
-                    material_reflmap_callback_(map_attribute);
-                }
+        }
+        // Shininess (Ns), sharpness, ior (Ni)
+        else if (token_equals(keyword, keyword_end, "Ns") || token_equals(keyword, keyword_end, "sharpness") || token_equals(keyword, keyword_end, "Ni")) {
+            float_type n;
+            if (!separator(p, eol) || !parse_float(p, eol, n, end) || !end_of_line(p, eol)) {
+                return error("parse error");
             }
-            // refl
-            else if (keyword == "map_normal") {
-                char whitespace_map_attribute = ' ';
-                if (!stringstream.eof()) {
-                    stringstream >> whitespace_map_attribute >> std::ws;
-                }
-                if (/*!stringstream ||*/ !std::isspace(whitespace_map_attribute) || stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                std::string map_attribute;
-                //stringstream >> map_attribute >> std::ws;
-                getline(stringstream, map_attribute);
-                if (/*!stringstream ||*/ !stringstream.eof()) {
-                    if (error_callback_) {
-                        error_callback_(line_number, "parse error");
-                    }
-                    return false;
-                }
-                if (material_normalmap_callback_) {
-                    material_normalmap_callback_(map_attribute);
-                }
+            const material_shininess_callback_type& callback = (*keyword == 'N') ? ((keyword[1] == 's') ? material_shininess_callback_ : material_ior_callback_) : material_sharpness_callback_;
+            if (callback) {
+                callback(n);
             }
-
-            // unknown keyword
-            else {
-                std::string message = "Unknown keyword " + keyword + " : ignoring line " + line;
-                if (warning_callback_) {
-                    warning_callback_(line_number, message);
-                }
+        }
+        // unknown keyword
+        else {
+            std::string message = "Unknown keyword " + std::string(keyword, keyword_end) + " : ignoring line " + std::string(line_begin, eol);
+            if (warning_callback_) {
+                warning_callback_(line_number, message);
             }
         }
     }
-    //     std::string info_message= "Info on parsed file :\nVertices : " + number_of_geometric_vertices ;
     std::ostringstream info_message;
     info_message << "Numbers of materials : " << number_of_material_names << std::endl;
+    flush_material_block();
     if (info_callback_) {
         info_callback_(line_number, info_message.str());
     }
-
-    return istream.fail() && istream.eof() && !istream.bad();
+    return true;
 }
 
 }
@@ -20,12 +20,14 @@
 #ifndef OBJFILEPARSER_H
 #define OBJFILEPARSER_H
 #include <cstddef>
+#include <cstdint>
 #include <tuple>
 #include <fstream>
 #include <istream>
 #include <string>
 #include <cctype>
 #include <functional>
+#include <memory>
 
 // =============================================================================
 namespace Loaders {
@@ -40,13 +42,38 @@ namespace Obj_mtl {
   *  @{
   */
 typedef std::size_t size_type;
-typedef int index_type;
+typedef std::int64_t index_type; ///< 64 bits : indices of files with more than 2^31 vertices
 typedef float float_type;
 typedef std::tuple<index_type, index_type> index_2_tuple_type;
 typedef std::tuple<index_type, index_type, index_type> index_3_tuple_type;
 typedef std::tuple<float_type, float_type, float_type> float_3_tuple_type;
 /** @} */
 
+/** @ingroup OBJ-MTL
+  * Colours and texture maps of a material, sent in one call by
+  * #mtl_parser once the material is complete (at the next newmtl or at the
+  * end of the file). Maps are the raw map statements, empty if not given.
+  */
+struct mtl_material_block {
+    typedef enum {
+        has_Ka = 1 << 0,
+        has_Kd = 1 << 1,
+        has_Ks = 1 << 2,
+        has_Tf = 1 << 3
+    } Colors;
+
+    mtl_material_block();
+
+    std::string name;
+    int colors; ///< combination of Colors
+    float_type Ka[3];
+    float_type Kd[3];
+    float_type Ks[3];
+    float_type Tf[3];
+    std::string map_Ka, map_Kd, map_Ks, map_Ns, map_d;
+    std::string dispmap, decalmap, bumpmap, reflmap, normalmap;
+};
+
 /** @ingroup OBJ-MTL
           * Class to parse MTL file.
           */
@@ -79,6 +106,8 @@ public:
     typedef std::function<void(const std::string&)> material_reflmap_callback_type;
     typedef std::function<void(const std::string&)> material_normalmap_callback_type;
 
+    typedef std::function<void(const mtl_material_block&)> material_block_callback_type;
+
     typedef std::function<void(const std::string&)> comment_callback_type;
 
     typedef int flags_type;
@@ -114,12 +143,21 @@ public:
     void material_bumpmap_callback(const material_bumpmap_callback_type& bumpmap_callback);
     void material_reflmap_callback(const material_reflmap_callback_type& reflmap_callback);
     void material_normalmap_callback(const material_normalmap_callback_type& normalmap_callback);
+    /// Colours and maps of each material in one call, in addition to the
+    /// callbacks above.
+    void material_block_callback(const material_block_callback_type& block_callback);
     void comment_callback(const comment_callback_type& comment_callback);
 
     bool parse(std::istream& istream);
+    /// Parse a file, gzip and zstd compressed files are decompressed on the fly.
     bool parse(const std::string& filename);
+    /// Parse a file content in memory (with the pointer based tokenizer).
+    bool parse(const char* begin, const char* end);
 
 private:
+    bool parse_lines(const char* begin, const char* end);
+    void flush_material_block();
+
     flags_type flags_;
     info_callback_type info_callback_;
     warning_callback_type warning_callback_;
@@ -144,7 +182,10 @@ private:
     material_bumpmap_callback_type material_bumpmap_callback_;
     material_reflmap_callback_type material_reflmap_callback_;
     material_normalmap_callback_type material_normalmap_callback_;
+    material_block_callback_type material_block_callback_;
     comment_callback_type comment_callback_;
+    mtl_material_block material_block_;
+    bool material_block_pending_;
 };
 
 
@@ -198,14 +239,32 @@ public:
         triangulate_faces = 1 << 1,
         translate_negative_indices = 1 << 2
     } ParseOptions;
+
+    /** Running totals of a parse.
+      * A parse may start from the totals of the preceding part of a file,
+      * so that line numbers and relative indices are those of the whole file.
+      */
+    struct statistics {
+        statistics();
+        std::size_t line_number;
+        std::size_t number_of_geometric_vertices, number_of_texture_vertices, number_of_vertex_normals, number_of_faces;
+        std::size_t number_of_group_names, number_of_smoothing_groups, number_of_object_names, number_of_material_libraries, number_of_material_names;
+    };
+    /// Summary sent to the info callback at the end of a parse.
+    static std::string info_message(const statistics& statistics);
+
     obj_parser(flags_type flags = 0);
+    ~obj_parser();
     void info_callback(const info_callback_type& info_callback);
     void warning_callback(const warning_callback_type& warning_callback);
     void error_callback(const error_callback_type& error_callback);
     void geometric_vertex_callback(const geometric_vertex_callback_type& geometric_vertex_callback);
     void texture_vertex_callback(const texture_vertex_callback_type& texture_vertex_callback);
     void vertex_normal_callback(const vertex_normal_callback_type& vertex_normal_callback);
-    void face_callbacks(const triangular_face_geometric_vertices_callback_type& triangular_face_geometric_vertices_callback, const triangular_face_geometric_vertices_texture_vertices_callback_type& triangular_face_geometric_vertices_texture_vertices_callback, const triangular_face_geometric_vertices_vertex_normals_callback_type& triangular_face_geometric_vertices_vertex_normals_callback, const triangular_face_geometric_vertices_texture_vertices_vertex_normals_callback_type& triangular_face_geometric_vertices_texture_vertices_vertex_normals_callback, const quadrilateral_face_geometric_vertices_callback_type& quadrilateral_face_geometric_vertices_callback, const quadrilateral_face_geometric_vertices_texture_vertices_callback_type& quadrilateral_face_geometric_vertices_texture_vertices_callback, const quadrilateral_face_geometric_vertices_vertex_normals_callback_type& quadrilateral_face_geometric_vertices_vertex_normals_callback, const quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals_callback_type& quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals_callback); /*, const polygonal_face_geometric_vertices_begin_callback_type& polygonal_face_geometric_vertices_begin_callback, const polygonal_face_geometric_vertices_vertex_callback_type& polygonal_face_geometric_vertices_vertex_callback, const polygonal_face_geometric_vertices_end_callback_type& polygonal_face_geometric_vertices_end_callback, const polygonal_face_geometric_vertices_texture_vertices_begin_callback_type& polygonal_face_geometric_vertices_texture_vertices_begin_callback, const polygonal_face_geometric_vertices_texture_vertices_vertex_callback_type& polygonal_face_geometric_vertices_texture_vertices_vertex_callback, const polygonal_face_geometric_vertices_texture_vertices_end_callback_type& polygonal_face_geometric_vertices_texture_vertices_end_callback, const polygonal_face_geometric_vertices_vertex_normals_begin_callback_type& polygonal_face_geometric_vertices_vertex_normals_begin_callback, const polygonal_face_geometric_vertices_vertex_normals_vertex_callback_type& polygonal_face_geometric_vertices_vertex_normals_vertex_callback, const polygonal_face_geometric_vertices_vertex_normals_end_callback_type& polygonal_face_geometric_vertices_vertex_normals_end_callback, const polygonal_face_geometric_vertices_texture_vertices_vertex_normals_begin_callback_type& polygonal_face_geometric_vertices_texture_vertices_vertex_normals_begin_callback, const polygonal_face_geometric_vertices_texture_vertices_vertex_normals_vertex_callback_type& polygonal_face_geometric_vertices_texture_vertices_vertex_normals_vertex_callback, const polygonal_face_geometric_vertices_texture_vertices_vertex_normals_end_callback_type& polygonal_face_geometric_vertices_texture_vertices_vertex_normals_end_callback);*/
+    void face_callbacks(const triangular_face_geometric_vertices_callback_type& triangular_face_geometric_vertices_callback, const triangular_face_geometric_vertices_texture_vertices_callback_type& triangular_face_geometric_vertices_texture_vertices_callback, const triangular_face_geometric_vertices_vertex_normals_callback_type& triangular_face_geometric_vertices_vertex_normals_callback, const triangular_face_geometric_vertices_texture_vertices_vertex_normals_callback_type& triangular_face_geometric_vertices_texture_vertices_vertex_normals_callback, const quadrilateral_face_geometric_vertices_callback_type& quadrilateral_face_geometric_vertices_callback, const quadrilateral_face_geometric_vertices_texture_vertices_callback_type& quadrilateral_face_geometric_vertices_texture_vertices_callback, const quadrilateral_face_geometric_vertices_vertex_normals_callback_type& quadrilateral_face_geometric_vertices_vertex_normals_callback, const quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals_callback_type& quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals_callback);
+    /// Polygons (more than 4 vertices) are sent vertex by vertex, between begin
+    /// and end, unless triangulate_faces is set.
+    void polygonal_face_callbacks(const polygonal_face_geometric_vertices_begin_callback_type& polygonal_face_geometric_vertices_begin_callback, const polygonal_face_geometric_vertices_vertex_callback_type& polygonal_face_geometric_vertices_vertex_callback, const polygonal_face_geometric_vertices_end_callback_type& polygonal_face_geometric_vertices_end_callback, const polygonal_face_geometric_vertices_texture_vertices_begin_callback_type& polygonal_face_geometric_vertices_texture_vertices_begin_callback, const polygonal_face_geometric_vertices_texture_vertices_vertex_callback_type& polygonal_face_geometric_vertices_texture_vertices_vertex_callback, const polygonal_face_geometric_vertices_texture_vertices_end_callback_type& polygonal_face_geometric_vertices_texture_vertices_end_callback, const polygonal_face_geometric_vertices_vertex_normals_begin_callback_type& polygonal_face_geometric_vertices_vertex_normals_begin_callback, const polygonal_face_geometric_vertices_vertex_normals_vertex_callback_type& polygonal_face_geometric_vertices_vertex_normals_vertex_callback, const polygonal_face_geometric_vertices_vertex_normals_end_callback_type& polygonal_face_geometric_vertices_vertex_normals_end_callback, const polygonal_face_geometric_vertices_texture_vertices_vertex_normals_begin_callback_type& polygonal_face_geometric_vertices_texture_vertices_vertex_normals_begin_callback, const polygonal_face_geometric_vertices_texture_vertices_vertex_normals_vertex_callback_type& polygonal_face_geometric_vertices_texture_vertices_vertex_normals_vertex_callback, const polygonal_face_geometric_vertices_texture_vertices_vertex_normals_end_callback_type& polygonal_face_geometric_vertices_texture_vertices_vertex_normals_end_callback);
 
     void group_name_callback(const group_name_callback_type& group_name_callback);
     void smoothing_group_callback(const smoothing_group_callback_type& smoothing_group_callback);
@@ -214,9 +273,28 @@ public:
     void material_name_callback(const material_name_callback_type& material_name_callback);
     void comment_callback(const comment_callback_type& comment_callback);
     bool parse(std::istream& istream);
+    /// Parse a file, mapped in memory when possible, read as a stream otherwise (pipes, devices).
+    /// gzip and zstd compressed files are decompressed by a separate thread
+    /// and parsed in push mode.
     bool parse(const std::string& filename);
+    /// Parse an in-memory OBJ content [begin, end), without per-line allocation.
+    bool parse(const char* begin, const char* end);
+    /// Parse a part of an OBJ content, statistics holds the totals of the
+    /// preceding parts and is updated.
+    bool parse(const char* begin, const char* end, statistics& statistics);
+    /// Push mode : parse the next size characters of an OBJ content (from a
+    /// socket, a decompressor...). Lines may be split between calls.
+    /// Returns false once a parse error occurred.
+    bool feed(const char* data, std::size_t size);
+    /// End of a push mode parse : parse the last line and send the summary.
+    bool finish();
 
 private:
+    // forwards the events of basic_obj_parser to the callbacks
+    class callback_handler;
+    // handler and parser kept between the calls of a push mode parse
+    class push_parser;
+
     flags_type flags_;
     info_callback_type info_callback_;
     warning_callback_type warning_callback_;
@@ -250,21 +328,25 @@ private:
     material_library_callback_type material_library_callback_;
     material_name_callback_type material_name_callback_;
     comment_callback_type comment_callback_;
+    std::unique_ptr<push_parser> push_parser_;
 };
 
 } // END namespace obj =========================================================
 
-inline Obj_mtl::obj_parser::obj_parser(flags_type flags)
-    : flags_(flags)
+inline Obj_mtl::obj_parser::statistics::statistics()
+    : line_number(0)
+    , number_of_geometric_vertices(0)
+    , number_of_texture_vertices(0)
+    , number_of_vertex_normals(0)
+    , number_of_faces(0)
+    , number_of_group_names(0)
+    , number_of_smoothing_groups(0)
+    , number_of_object_names(0)
+    , number_of_material_libraries(0)
+    , number_of_material_names(0)
 {
 }
 
-inline bool Obj_mtl::obj_parser::parse(const std::string& filename)
-{
-    std::ifstream ifstream(filename.c_str());
-    return parse(ifstream);
-}
-
 inline void Obj_mtl::obj_parser::info_callback(const info_callback_type& info_callback)
 {
     info_callback_ = info_callback;
@@ -295,7 +377,7 @@ inline void Obj_mtl::obj_parser::vertex_normal_callback(const vertex_normal_call
     vertex_normal_callback_ = vertex_normal_callback;
 }
 
-inline void Obj_mtl::obj_parser::face_callbacks(const triangular_face_geometric_vertices_callback_type& triangular_face_geometric_vertices_callback, const triangular_face_geometric_vertices_texture_vertices_callback_type& triangular_face_geometric_vertices_texture_vertices_callback, const triangular_face_geometric_vertices_vertex_normals_callback_type& triangular_face_geometric_vertices_vertex_normals_callback, const triangular_face_geometric_vertices_texture_vertices_vertex_normals_callback_type& triangular_face_geometric_vertices_texture_vertices_vertex_normals_callback, const quadrilateral_face_geometric_vertices_callback_type& quadrilateral_face_geometric_vertices_callback, const quadrilateral_face_geometric_vertices_texture_vertices_callback_type& quadrilateral_face_geometric_vertices_texture_vertices_callback, const quadrilateral_face_geometric_vertices_vertex_normals_callback_type& quadrilateral_face_geometric_vertices_vertex_normals_callback, const quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals_callback_type& quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals_callback /*, const polygonal_face_geometric_vertices_begin_callback_type& polygonal_face_geometric_vertices_begin_callback, const polygonal_face_geometric_vertices_vertex_callback_type& polygonal_face_geometric_vertices_vertex_callback, const polygonal_face_geometric_vertices_end_callback_type& polygonal_face_geometric_vertices_end_callback, const polygonal_face_geometric_vertices_texture_vertices_begin_callback_type& polygonal_face_geometric_vertices_texture_vertices_begin_callback, const polygonal_face_geometric_vertices_texture_vertices_vertex_callback_type& polygonal_face_geometric_vertices_texture_vertices_vertex_callback, const polygonal_face_geometric_vertices_texture_vertices_end_callback_type& polygonal_face_geometric_vertices_texture_vertices_end_callback, const polygonal_face_geometric_vertices_vertex_normals_begin_callback_type& polygonal_face_geometric_vertices_vertex_normals_begin_callback, const polygonal_face_geometric_vertices_vertex_normals_vertex_callback_type& polygonal_face_geometric_vertices_vertex_normals_vertex_callback, const polygonal_face_geometric_vertices_vertex_normals_end_callback_type& polygonal_face_geometric_vertices_vertex_normals_end_callback, const polygonal_face_geometric_vertices_texture_vertices_vertex_normals_begin_callback_type& polygonal_face_geometric_vertices_texture_vertices_vertex_normals_begin_callback, const polygonal_face_geometric_vertices_texture_vertices_vertex_normals_vertex_callback_type& polygonal_face_geometric_vertices_texture_vertices_vertex_normals_vertex_callback, const polygonal_face_geometric_vertices_texture_vertices_vertex_normals_end_callback_type& polygonal_face_geometric_vertices_texture_vertices_vertex_normals_end_callback*/)
+inline void Obj_mtl::obj_parser::face_callbacks(const triangular_face_geometric_vertices_callback_type& triangular_face_geometric_vertices_callback, const triangular_face_geometric_vertices_texture_vertices_callback_type& triangular_face_geometric_vertices_texture_vertices_callback, const triangular_face_geometric_vertices_vertex_normals_callback_type& triangular_face_geometric_vertices_vertex_normals_callback, const triangular_face_geometric_vertices_texture_vertices_vertex_normals_callback_type& triangular_face_geometric_vertices_texture_vertices_vertex_normals_callback, const quadrilateral_face_geometric_vertices_callback_type& quadrilateral_face_geometric_vertices_callback, const quadrilateral_face_geometric_vertices_texture_vertices_callback_type& quadrilateral_face_geometric_vertices_texture_vertices_callback, const quadrilateral_face_geometric_vertices_vertex_normals_callback_type& quadrilateral_face_geometric_vertices_vertex_normals_callback, const quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals_callback_type& quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals_callback)
 {
     triangular_face_geometric_vertices_callback_ = triangular_face_geometric_vertices_callback;
     triangular_face_geometric_vertices_texture_vertices_callback_ = triangular_face_geometric_vertices_texture_vertices_callback;
@@ -305,18 +387,22 @@ inline void Obj_mtl::obj_parser::face_callbacks(const triangular_face_geometric_
     quadrilateral_face_geometric_vertices_texture_vertices_callback_ = quadrilateral_face_geometric_vertices_texture_vertices_callback;
     quadrilateral_face_geometric_vertices_vertex_normals_callback_ = quadrilateral_face_geometric_vertices_vertex_normals_callback;
     quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals_callback_ = quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals_callback;
-    /*    polygonal_face_geometric_vertices_begin_callback_ = polygonal_face_geometric_vertices_begin_callback;
-          polygonal_face_geometric_vertices_vertex_callback_ = polygonal_face_geometric_vertices_vertex_callback;
-          polygonal_face_geometric_vertices_end_callback_ = polygonal_face_geometric_vertices_end_callback;
-          polygonal_face_geometric_vertices_texture_vertices_begin_callback_ = polygonal_face_geometric_vertices_texture_vertices_begin_callback;
-          polygonal_face_geometric_vertices_texture_vertices_vertex_callback_ = polygonal_face_geometric_vertices_texture_vertices_vertex_callback;
-          polygonal_face_geometric_vertices_texture_vertices_end_callback_ = polygonal_face_geometric_vertices_texture_vertices_end_callback;
-          polygonal_face_geometric_vertices_vertex_normals_begin_callback_ = polygonal_face_geometric_vertices_vertex_normals_begin_callback;
-          polygonal_face_geometric_vertices_vertex_normals_vertex_callback_ = polygonal_face_geometric_vertices_vertex_normals_vertex_callback;
-          polygonal_face_geometric_vertices_vertex_normals_end_callback_ = polygonal_face_geometric_vertices_vertex_normals_end_callback;
-          polygonal_face_geometric_vertices_texture_vertices_vertex_normals_begin_callback_ = polygonal_face_geometric_vertices_texture_vertices_vertex_normals_begin_callback;
-          polygonal_face_geometric_vertices_texture_vertices_vertex_normals_vertex_callback_ = polygonal_face_geometric_vertices_texture_vertices_vertex_normals_vertex_callback;
-          polygonal_face_geometric_vertices_texture_vertices_vertex_normals_end_callback_ = polygonal_face_geometric_vertices_texture_vertices_vertex_normals_end_callback;*/
+}
+
+inline void Obj_mtl::obj_parser::polygonal_face_callbacks(const polygonal_face_geometric_vertices_begin_callback_type& polygonal_face_geometric_vertices_begin_callback, const polygonal_face_geometric_vertices_vertex_callback_type& polygonal_face_geometric_vertices_vertex_callback, const polygonal_face_geometric_vertices_end_callback_type& polygonal_face_geometric_vertices_end_callback, const polygonal_face_geometric_vertices_texture_vertices_begin_callback_type& polygonal_face_geometric_vertices_texture_vertices_begin_callback, const polygonal_face_geometric_vertices_texture_vertices_vertex_callback_type& polygonal_face_geometric_vertices_texture_vertices_vertex_callback, const polygonal_face_geometric_vertices_texture_vertices_end_callback_type& polygonal_face_geometric_vertices_texture_vertices_end_callback, const polygonal_face_geometric_vertices_vertex_normals_begin_callback_type& polygonal_face_geometric_vertices_vertex_normals_begin_callback, const polygonal_face_geometric_vertices_vertex_normals_vertex_callback_type& polygonal_face_geometric_vertices_vertex_normals_vertex_callback, const polygonal_face_geometric_vertices_vertex_normals_end_callback_type& polygonal_face_geometric_vertices_vertex_normals_end_callback, const polygonal_face_geometric_vertices_texture_vertices_vertex_normals_begin_callback_type& polygonal_face_geometric_vertices_texture_vertices_vertex_normals_begin_callback, const polygonal_face_geometric_vertices_texture_vertices_vertex_normals_vertex_callback_type& polygonal_face_geometric_vertices_texture_vertices_vertex_normals_vertex_callback, const polygonal_face_geometric_vertices_texture_vertices_vertex_normals_end_callback_type& polygonal_face_geometric_vertices_texture_vertices_vertex_normals_end_callback)
+{
+    polygonal_face_geometric_vertices_begin_callback_ = polygonal_face_geometric_vertices_begin_callback;
+    polygonal_face_geometric_vertices_vertex_callback_ = polygonal_face_geometric_vertices_vertex_callback;
+    polygonal_face_geometric_vertices_end_callback_ = polygonal_face_geometric_vertices_end_callback;
+    polygonal_face_geometric_vertices_texture_vertices_begin_callback_ = polygonal_face_geometric_vertices_texture_vertices_begin_callback;
+    polygonal_face_geometric_vertices_texture_vertices_vertex_callback_ = polygonal_face_geometric_vertices_texture_vertices_vertex_callback;
+    polygonal_face_geometric_vertices_texture_vertices_end_callback_ = polygonal_face_geometric_vertices_texture_vertices_end_callback;
+    polygonal_face_geometric_vertices_vertex_normals_begin_callback_ = polygonal_face_geometric_vertices_vertex_normals_begin_callback;
+    polygonal_face_geometric_vertices_vertex_normals_vertex_callback_ = polygonal_face_geometric_vertices_vertex_normals_vertex_callback;
+    polygonal_face_geometric_vertices_vertex_normals_end_callback_ = polygonal_face_geometric_vertices_vertex_normals_end_callback;
+    polygonal_face_geometric_vertices_texture_vertices_vertex_normals_begin_callback_ = polygonal_face_geometric_vertices_texture_vertices_vertex_normals_begin_callback;
+    polygonal_face_geometric_vertices_texture_vertices_vertex_normals_vertex_callback_ = polygonal_face_geometric_vertices_texture_vertices_vertex_normals_vertex_callback;
+    polygonal_face_geometric_vertices_texture_vertices_vertex_normals_end_callback_ = polygonal_face_geometric_vertices_texture_vertices_vertex_normals_end_callback;
 }
 
 inline void Obj_mtl::obj_parser::group_name_callback(const group_name_callback_type& group_name_callback)
@@ -465,15 +551,23 @@ inline void Obj_mtl::mtl_parser::material_normalmap_callback(const material_norm
     material_normalmap_callback_ = normalmap_callback;
 }
 
-inline bool Obj_mtl::mtl_parser::parse(const std::string& filename)
+inline void Obj_mtl::mtl_parser::material_block_callback(const material_block_callback_type& block_callback)
 {
-    std::ifstream ifstream(filename.c_str());
-    return parse(ifstream);
+    material_block_callback_ = block_callback;
 }
 
 inline Obj_mtl::mtl_parser::mtl_parser(flags_type flags)
     : flags_(flags)
+    , material_block_pending_(false)
+{
+}
+
+inline Obj_mtl::mtl_material_block::mtl_material_block()
+    : colors(0)
 {
+    for (int i = 0; i < 3; ++i) {
+        Ka[i] = Kd[i] = Ks[i] = Tf[i] = 0;
+    }
 }
 
 
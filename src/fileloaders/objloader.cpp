@@ -18,8 +18,13 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 #include "objloader.h"
+#include "compressedfile.h"
+#include "meshstreams.h"
+#include "objtokenizer.h"
+#include "objtriangulator.h"
+#include "parallel.h"
 
-
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
@@ -32,13 +37,33 @@
 namespace Loaders {
 namespace Obj_mtl {
 
+namespace {
+
+// en-tete des fichiers cache : a incrementer quand le format ou les maillages
+// construits changent
+const char CacheMagic[8] = { 'O', 'B', 'J', 'C', 'A', 'C', 'H', 'E' };
+const unsigned int CacheVersion = 4;
+const unsigned int CacheByteOrder = 0x01020304;
+
+}
 
 ObjLoader::ObjLoader()
 {
     vertices = 0;
     normals = 0;
     textures = 0;
-    materialNumber = 0;
+    mThreadCount = 0;
+    mCancel = 0;
+    mWeldTolerance = glm::vec3(-1.f, 0.f, 0.f);
+    mVertexCacheSize = 0;
+    mMaxMeshVertices = std::size_t(1) << 24;
+    mMaxMeshTriangles = std::size_t(1) << 25;
+    mStreamParser = 0;
+    mCacheEnabled = true;
+    mCache = 0;
+    mMaterialLibraries = 0;
+    mParsedLibrary = 0;
+    currentMaterial = 0;
     currentGroup = new Group("default");
     allgroups["default"] = currentGroup;
     groupsNumber = 1;
@@ -50,7 +75,8 @@ ObjLoader::ObjLoader()
 
 ObjLoader::~ObjLoader()
 {
-    mtllib.erase(mtllib.begin(), mtllib.end());
+    delete mStreamParser;
+    delete mCache;
     //     delete allgroups["default"];
     allgroups.erase(allgroups.begin(), allgroups.end());
 }
@@ -77,71 +103,273 @@ void ObjLoader::error_callback(const std::string& /*filename*/, std::size_t line
     lastParseMessage = info_message.str();
 }
 
+void ObjLoader::add_vertices(const float* xyz, std::size_t count)
+{
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "glm::vec3 must be packed");
+    if (count == 0)
+        return;
+    std::size_t size = verticesTable.size();
+    verticesTable.resize(size + count);
+    std::memcpy(static_cast<void*>(&verticesTable[size]), xyz, count * sizeof(glm::vec3));
+    vertices += count;
+}
+
+void ObjLoader::add_normals(const float* xyz, std::size_t count)
+{
+    if (count == 0)
+        return;
+    std::size_t size = normalsTable.size();
+    normalsTable.resize(size + count);
+    std::memcpy(static_cast<void*>(&normalsTable[size]), xyz, count * sizeof(glm::vec3));
+    normals += count;
+}
+
+void ObjLoader::add_textures(const float* uv, std::size_t count)
+{
+    static_assert(sizeof(glm::vec2) == 2 * sizeof(float), "glm::vec2 must be packed");
+    if (count == 0)
+        return;
+    std::size_t size = texturesTable.size();
+    texturesTable.resize(size + count);
+    std::memcpy(static_cast<void*>(&texturesTable[size]), uv, count * sizeof(glm::vec2));
+    textures += count;
+}
+
+void ObjLoader::add_faces(const Obj_mtl::face_block& block)
+{
+    std::size_t corner = 0;
+    for (std::size_t i = 0; i < block.size; ++i) {
+        add_face(block.corners[i], block.attributes[i], block.v + corner, block.vt + corner, block.vn + corner);
+        corner += block.corners[i];
+    }
+}
+
+void ObjLoader::add_face(int cornersNumber, unsigned char attributes, const Obj_mtl::index_type* v, const Obj_mtl::index_type* vt, const Obj_mtl::index_type* vn)
+{
+    bool hasTextures = (attributes & Obj_mtl::obj_face::has_texture_vertices) != 0;
+    bool hasNormals = (attributes & Obj_mtl::obj_face::has_vertex_normals) != 0;
+    currentGroup->addFace(cornersNumber, v, hasTextures ? vt : 0, hasNormals ? vn : 0);
+}
+
+void ObjLoader::add_geometry(const Obj_mtl::obj_geometry& geometry, const std::string& dirname)
+{
+    // tableaux de sommets, normales et coordonnees de texture
+    if (!geometry.geometric_vertices.empty())
+        add_vertices(&geometry.geometric_vertices[0], geometry.geometric_vertices.size() / 3);
+    if (!geometry.vertex_normals.empty())
+        add_normals(&geometry.vertex_normals[0], geometry.vertex_normals.size() / 3);
+    if (!geometry.texture_vertices.empty())
+        add_textures(&geometry.texture_vertices[0], geometry.texture_vertices.size() / 2);
+
+    // faces, dans l'ordre du fichier vis a vis des groupes et materiaux
+    std::size_t s = 0;
+    std::size_t corner = 0;
+    for (std::size_t f = 0; f <= geometry.faces.size(); ++f) {
+        for (; s < geometry.statements.size() && geometry.statements[s].face == f; ++s) {
+            const Obj_mtl::obj_statement& statement = geometry.statements[s];
+            switch (statement.kind) {
+            case Obj_mtl::obj_statement::group_name:
+            case Obj_mtl::obj_statement::object_name:
+                set_group(statement.name);
+                break;
+            case Obj_mtl::obj_statement::smoothing_group:
+                smooth_group(statement.smoothing_group_number);
+                break;
+            case Obj_mtl::obj_statement::material_library:
+                parse_material_library(dirname, statement.name);
+                break;
+            case Obj_mtl::obj_statement::material_name:
+                set_material(statement.name);
+                break;
+            }
+        }
+        if (f < geometry.faces.size()) {
+            const Obj_mtl::obj_face& face = geometry.faces[f];
+            add_face(face.size, face.attributes, &geometry.face_v[corner], &geometry.face_vt[corner], &geometry.face_vn[corner]);
+            corner += face.size;
+        }
+    }
+}
+
 bool ObjLoader::load(const QString& filename, QString& reason)
 {
-    Obj_mtl::obj_parser* parser = new Obj_mtl::obj_parser(Obj_mtl::obj_parser::translate_negative_indices /*obj_mtl::obj_parser::triangulate_faces*/);
+    /* Cache valide : pas d'analyse du fichier */
+    mCacheFile.clear();
+    mCacheSources.clear();
+    if (mCacheEnabled) {
+        if (loadCache(filename, reason))
+            return true;
+        mCacheFile = cachePath(filename);
+        mCacheSources.push_back(Loaders::CacheSource::of(QFileInfo(filename).absoluteFilePath().toStdString()));
+    }
 
-    std::ifstream file(filename.toStdString().c_str());
+    if (mThreadCount != 1) {
+        Obj_mtl::obj_parallel_parser parser(Obj_mtl::obj_parser::translate_negative_indices, mThreadCount);
+        parser.info_callback(std::bind(&ObjLoader::info_callback, this, filename.toStdString(), std::placeholders::_1, std::placeholders::_2));
+        parser.warning_callback(std::bind(&ObjLoader::warning_callback, this, filename.toStdString(), std::placeholders::_1, std::placeholders::_2));
+        parser.error_callback(std::bind(&ObjLoader::error_callback, this, filename.toStdString(), std::placeholders::_1, std::placeholders::_2));
+
+        QString dirname = QFileInfo(filename).absolutePath() + "/";
+        mObjDir = dirname;
+
+        /* Parse, puis ajout des tableaux fusionnes */
+        Obj_mtl::obj_geometry geometry;
+        bool result = parser.parse(filename.toStdString(), geometry);
+        std::string parseMessage = lastParseMessage;
+        add_geometry(geometry, dirname.toStdString());
+        if (!result)
+            mCacheFile.clear();
+        lastParseMessage = parseMessage + memoryMessage();
+        std::cerr << lastParseMessage;
+        reason = QString(lastParseMessage.c_str());
+        return result;
+    }
+
+    Obj_mtl::obj_batch_parser* parser = new Obj_mtl::obj_batch_parser(Obj_mtl::obj_parser::translate_negative_indices /*obj_mtl::obj_parser::triangulate_faces*/);
+
+    QString dirname = QFileInfo(filename).absolutePath() + "/";
 
+    mObjDir = dirname;
+    connectParser(parser, filename.toStdString(), dirname.toStdString());
+
+    /* Parse (fichier projete en memoire, lu en memoire sinon) */
+    bool result = parser->parse(filename.toStdString());
+    if (!result)
+        mCacheFile.clear();
+    lastParseMessage += memoryMessage();
+    std::cerr << lastParseMessage;
+    reason = QString(lastParseMessage.c_str());
+
+    delete parser;
+    return result;
+}
+
+
+bool ObjLoader::loadCache(const QString& filename, QString& reason)
+{
+    std::string cacheFile = cachePath(filename);
+    if (!readCache(cacheFile, QFileInfo(filename).absoluteFilePath().toStdString()))
+        return false;
+    lastParseMessage = filename.toStdString() + "\nLoaded from cache " + cacheFile + "\n";
+    std::cerr << lastParseMessage;
+    reason = QString(lastParseMessage.c_str());
+    return true;
+}
+
+
+void ObjLoader::connectParser(Obj_mtl::obj_batch_parser* parser, const std::string& filename, const std::string& dirname)
+{
     /* Association des callbacks */
-    parser->info_callback(std::bind(&ObjLoader::info_callback, this, filename.toStdString(), std::placeholders::_1, std::placeholders::_2));
-    parser->warning_callback(std::bind(&ObjLoader::warning_callback, this, filename.toStdString(), std::placeholders::_1, std::placeholders::_2));
-    parser->error_callback(std::bind(&ObjLoader::error_callback, this, filename.toStdString(), std::placeholders::_1, std::placeholders::_2));
-
-
-    parser->geometric_vertex_callback(std::bind(&ObjLoader::vertex_callback, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
-    parser->vertex_normal_callback(std::bind(&ObjLoader::normal_callback, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
-    parser->texture_vertex_callback(std::bind(&ObjLoader::texture_callback, this, std::placeholders::_1, std::placeholders::_2));
-
-    parser->face_callbacks(
-        //triangular_face_geometric_vertices_callback
-        std::bind(&ObjLoader::add_face_T_vertices, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3),
-        //triangular_face_geometric_vertices_texture_vertices_callback
-        std::bind(&ObjLoader::add_face_T_vertices_textures, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3),
-        //triangular_face_geometric_vertices_vertex_normals_callback
-        std::bind(&ObjLoader::add_face_T_vertices_normals, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3),
-        //triangular_face_geometric_vertices_texture_vertices_vertex_normals_callback
-        std::bind(&ObjLoader::add_face_T_vertices_textures_normals, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3),
-        //quadrilateral_face_geometric_vertices_callback
-        std::bind(&ObjLoader::add_face_Q_vertices, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4),
-        //quadrilateral_face_geometric_vertices_texture_vertices_callback
-        std::bind(&ObjLoader::add_face_Q_vertices_textures, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4),
-        //quadrilateral_face_geometric_vertices_vertex_normals_callback
-        std::bind(&ObjLoader::add_face_Q_vertices_normals, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4),
-        //quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals_callback
-        std::bind(&ObjLoader::add_face_Q_vertices_textures_normals, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4));
+    parser->info_callback(std::bind(&ObjLoader::info_callback, this, filename, std::placeholders::_1, std::placeholders::_2));
+    parser->warning_callback(std::bind(&ObjLoader::warning_callback, this, filename, std::placeholders::_1, std::placeholders::_2));
+    parser->error_callback(std::bind(&ObjLoader::error_callback, this, filename, std::placeholders::_1, std::placeholders::_2));
+
+    /* Sommets et faces par blocs */
+    parser->geometric_vertices_callback(std::bind(&ObjLoader::add_vertices, this, std::placeholders::_1, std::placeholders::_2));
+    parser->vertex_normals_callback(std::bind(&ObjLoader::add_normals, this, std::placeholders::_1, std::placeholders::_2));
+    parser->texture_vertices_callback(std::bind(&ObjLoader::add_textures, this, std::placeholders::_1, std::placeholders::_2));
+    parser->faces_callback(std::bind(&ObjLoader::add_faces, this, std::placeholders::_1));
 
     parser->group_name_callback(std::bind(&ObjLoader::set_group, this, std::placeholders::_1));
     parser->smoothing_group_callback(std::bind(&ObjLoader::smooth_group, this, std::placeholders::_1));
     parser->object_name_callback(std::bind(&ObjLoader::set_group, this, std::placeholders::_1));
     parser->material_name_callback(std::bind(&ObjLoader::set_material, this, std::placeholders::_1));
 
-    QString dirname = QFileInfo(filename).absolutePath() + "/";
+    parser->material_library_callback(std::bind(&ObjLoader::parse_material_library, this, dirname, std::placeholders::_1));
+}
 
+void ObjLoader::beginStream(const QString& objDir, const MeshCallback& meshCallback)
+{
+    QString dirname = objDir;
+    if (!dirname.endsWith('/'))
+        dirname += '/';
     mObjDir = dirname;
-    parser->material_library_callback(std::bind(&ObjLoader::parse_material_library, this, dirname.toStdString(), std::placeholders::_1));
+    mMeshCallback = meshCallback;
+    mCacheFile.clear();
 
-    /* Parse */
-    bool result = parser->parse(file);
+    delete mStreamParser;
+    mStreamParser = new Obj_mtl::obj_batch_parser(Obj_mtl::obj_parser::translate_negative_indices);
+    connectParser(mStreamParser, "stream", dirname.toStdString());
+
+    /* Un maillage par groupe, des que le groupe suivant commence */
+    mStreamParser->group_name_callback(std::bind(&ObjLoader::stream_group, this, std::placeholders::_1));
+    mStreamParser->object_name_callback(std::bind(&ObjLoader::stream_group, this, std::placeholders::_1));
+}
+
+bool ObjLoader::feed(const char* data, std::size_t size, QString& reason)
+{
+    if (!mStreamParser) {
+        reason = "feed() called before beginStream()";
+        return false;
+    }
+    bool result = mStreamParser->feed(data, size);
+    if (!result)
+        reason = QString(lastParseMessage.c_str());
+    return result;
+}
+
+bool ObjLoader::finish(QString& reason)
+{
+    if (!mStreamParser) {
+        reason = "finish() called before beginStream()";
+        return false;
+    }
+    bool result = mStreamParser->finish();
+    delete mStreamParser;
+    mStreamParser = 0;
     std::cerr << lastParseMessage;
     reason = QString(lastParseMessage.c_str());
 
-    delete parser;
+    // dernier groupe (et ce qui precede une erreur)
+    for (std::map<std::string, Group*>::iterator group = allgroups.begin(); group != allgroups.end(); ++group) {
+        if (!group->second->empty)
+            compileGroup(group->second);
+        delete group->second;
+    }
+    allgroups.clear();
+    currentGroup = new Group("default");
+    allgroups["default"] = currentGroup;
     return result;
 }
 
+void ObjLoader::stream_group(const std::string& name)
+{
+    // le groupe courant est complet : envoi du maillage (ses faces sont liberees)
+    if (!currentGroup->empty)
+        compileGroup(currentGroup);
+    allgroups.erase(currentGroup->name);
+    delete currentGroup;
+    set_group(name);
+}
 
 void ObjLoader::parse_material_library(const std::string& dirname, const std::string& name)
 {
 
 
+    /* La bibliotheque peut etre compressee (name.gz, name.zst) */
     std::string filename;
-    filename = dirname + name;
-    std::ifstream file(filename.c_str());
+    filename = Loaders::CompressedFile::resolve(dirname + name);
+    if (!mCacheFile.empty())
+        mCacheSources.push_back(Loaders::CacheSource::of(filename));
 
     //     std::cerr << "parse_material_library " << filename << std::endl;
 
+    if (mMaterialLibraries) {
+        useSharedLibrary(filename);
+        return;
+    }
+    /* Chemins des textures relatifs au dossier de la bibliotheque */
+    MaterialLibrary* library = new MaterialLibrary(filename.substr(0, filename.find_last_of('/') + 1));
+    mOwnedLibraries.push_back(std::unique_ptr<MaterialLibrary>(library));
+    parseMaterialFile(filename, *library);
+    mLibraries.push_back(library);
+}
+
+void ObjLoader::parseMaterialFile(const std::string& filename, MaterialLibrary& library)
+{
     Obj_mtl::mtl_parser* mtlparser = new Obj_mtl::mtl_parser();
+    mParsedLibrary = &library;
+    currentMaterial = 0;
 
     /* Association des callbacks */
     mtlparser->info_callback(std::bind(&ObjLoader::info_callback, this, filename, std::placeholders::_1, std::placeholders::_2));
@@ -150,655 +378,519 @@ void ObjLoader::parse_material_library(const std::string& dirname, const std::st
 
     mtlparser->material_name_callback(std::bind(&ObjLoader::new_material, this, std::placeholders::_1));
 
-    mtlparser->material_Ka_callback(std::bind(&ObjLoader::material_Ka, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
-    mtlparser->material_Kd_callback(std::bind(&ObjLoader::material_Kd, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
-    mtlparser->material_Ks_callback(std::bind(&ObjLoader::material_Ks, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
-    mtlparser->material_Tf_callback(std::bind(&ObjLoader::material_Tf, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+    /* Couleurs et textures : un bloc par materiau */
+    mtlparser->material_block_callback(std::bind(&ObjLoader::material_block, this, std::placeholders::_1));
     mtlparser->material_shininess_callback(std::bind(&ObjLoader::material_shininess, this, std::placeholders::_1));
-    mtlparser->material_map_Kd_callback(std::bind(&ObjLoader::material_map_Kd, this, std::placeholders::_1));
-    mtlparser->material_map_Ks_callback(std::bind(&ObjLoader::material_map_Ks, this, std::placeholders::_1));
-    mtlparser->material_map_Ns_callback(std::bind(&ObjLoader::material_map_Ns, this, std::placeholders::_1));
-    mtlparser->material_map_d_callback(std::bind(&ObjLoader::material_map_d, this, std::placeholders::_1));
-    mtlparser->material_bumpmap_callback(std::bind(&ObjLoader::material_bump, this, std::placeholders::_1));
-    mtlparser->material_normalmap_callback(std::bind(&ObjLoader::material_normal, this, std::placeholders::_1));
+    mtlparser->material_sharpness_callback(std::bind(&ObjLoader::material_sharpness, this, std::placeholders::_1));
+    mtlparser->material_ior_callback(std::bind(&ObjLoader::material_ior, this, std::placeholders::_1));
+    mtlparser->material_Illum_callback(std::bind(&ObjLoader::material_illum, this, std::placeholders::_1));
 
     mtlparser->material_dissolve_callback(std::bind(&ObjLoader::material_dissolve, this, std::placeholders::_1));
 
     /* Parse */
-    mtlparser->parse(file);
+    mtlparser->parse(filename);
     std::cerr << lastParseMessage;
     delete mtlparser;
+    mParsedLibrary = 0;
+    currentMaterial = 0;
+}
+
+void ObjLoader::useSharedLibrary(const std::string& filename)
+{
+    /* Premier utilisateur : analyse dans la bibliotheque vide, les autres
+       chargeurs utilisent la meme, sans copie de ses materiaux */
+    const MaterialLibrary& library = mMaterialLibraries->library(filename, [&](MaterialLibrary& materials) {
+        parseMaterialFile(filename, materials);
+    });
+    mLibraries.push_back(&library);
+}
+
+void ObjLoader::new_material(const std::string& name)
+{
+    std::size_t materialsNumber = mParsedLibrary->size();
+    currentMaterial = &mParsedLibrary->material(mParsedLibrary->addMaterial(name));
+    if (mParsedLibrary->size() == materialsNumber)
+        std::cerr << "WARNING : duplicate material " << name << std::endl;
+}
+
+void ObjLoader::material_block(const Obj_mtl::mtl_material_block& block)
+{
+    int id = mParsedLibrary->find(block.name);
+    if (id < 0)
+        return;
+    currentMaterial = &mParsedLibrary->material(id);
+    if (block.colors & Obj_mtl::mtl_material_block::has_Ka)
+        material_Ka(block.Ka[0], block.Ka[1], block.Ka[2]);
+    if (block.colors & Obj_mtl::mtl_material_block::has_Kd)
+        material_Kd(block.Kd[0], block.Kd[1], block.Kd[2]);
+    if (block.colors & Obj_mtl::mtl_material_block::has_Ks)
+        material_Ks(block.Ks[0], block.Ks[1], block.Ks[2]);
+    if (block.colors & Obj_mtl::mtl_material_block::has_Tf)
+        material_Tf(block.Tf[0], block.Tf[1], block.Tf[2]);
+    if (!block.map_Ka.empty())
+        material_map(block.map_Ka, currentMaterial->map_ka, &currentMaterial->map_ka_scale);
+    if (!block.map_Kd.empty())
+        material_map(block.map_Kd, currentMaterial->map_kd, &currentMaterial->map_kd_scale);
+    if (!block.map_Ks.empty())
+        material_map(block.map_Ks, currentMaterial->map_ks, &currentMaterial->map_ks_scale);
+    if (!block.map_Ns.empty())
+        material_map(block.map_Ns, currentMaterial->map_Ns, &currentMaterial->map_Ns_scale);
+    if (!block.map_d.empty())
+        material_map(block.map_d, currentMaterial->map_d, &currentMaterial->map_d_scale);
+    if (!block.bumpmap.empty())
+        material_map(block.bumpmap, currentMaterial->bumpmap, &currentMaterial->bumpmap_scale);
+    if (!block.dispmap.empty())
+        material_map(block.dispmap, currentMaterial->dispmap, 0);
+    if (!block.decalmap.empty())
+        material_map(block.decalmap, currentMaterial->decalmap, 0);
+    if (!block.normalmap.empty())
+        material_map(block.normalmap, currentMaterial->normalmap, 0);
+    if (!block.reflmap.empty())
+        material_map(block.reflmap, currentMaterial->reflmap, 0);
+}
+
+void ObjLoader::material_map(const std::string& statement, int& texture, glm::vec3* scale)
+{
+    using namespace Obj_mtl::tokenizer;
+    const char* p = statement.data();
+    const char* end = p + statement.size();
+    skip_space(p, end);
+    // options : -s, -o, -t (1 a 3 nombres), -mm (2 valeurs), les autres
+    // (-blendu, -clamp, -bm, -imfchan...) une valeur
+    while (p != end && *p == '-') {
+        const char* option = p + 1;
+        const char* option_end = token_end(p, end);
+        p = option_end;
+        skip_space(p, end);
+        bool vector = token_equals(option, option_end, "s") || token_equals(option, option_end, "o") || token_equals(option, option_end, "t");
+        if (vector) {
+            float values[3] = { 1., 1., 1. };
+            for (int i = 0; i < 3 && p != end; ++i) {
+                const char* q = p;
+                const char* value_end = token_end(p, end);
+                if (!parse_float(q, value_end, values[i]) || q != value_end)
+                    break;
+                p = value_end;
+                skip_space(p, end);
+            }
+            if (scale && token_equals(option, option_end, "s"))
+                *scale = glm::vec3(values[0], values[1], values[2]);
+            continue;
+        }
+        int values = token_equals(option, option_end, "mm") ? 2 : 1;
+        for (int i = 0; i < values && p != end; ++i) {
+            p = token_end(p, end);
+            skip_space(p, end);
+        }
+    }
+    // nom du fichier : la fin de la ligne, sans les blancs de fin
+    while (end != p && is_space(end[-1]))
+        --end;
+    texture = (p != end) ? mParsedLibrary->addTexture(std::string(p, end)) : -1;
+}
+
+bool ObjLoader::hasCurrentMaterial(const char* statement) const
+{
+    if (!currentMaterial)
+        std::cerr << "WARNING : " << statement << " before newmtl ignored" << std::endl;
+    return currentMaterial != 0;
 }
 
-int ObjLoader::faceType(Face* f)
+void ObjLoader::material_dissolve(const std::string& d)
+{
+    if (!hasCurrentMaterial("d"))
+        return;
+    const char* p = d.data();
+    const char* end = p + d.size();
+    float value;
+    if (d[0] != '-') {
+        if (Obj_mtl::tokenizer::parse_float(p, end, value))
+            currentMaterial->dissolve = value;
+    }
+    else {
+        std::cerr << "TODO : manage parameterized dissolve" << std::endl;
+    }
+}
+
+int ObjLoader::faceType(const FaceList& faces)
 {
     int type = 4; // 0 -> full, 1 -> normales, 2 -> textures, 3 ->vertex uniquement
-    if (f->have[NORMALS] && f->have[TEXTURES])
+    if (faces.have[NORMALS] && faces.have[TEXTURES])
         type = 0;
-    else if (f->have[NORMALS])
+    else if (faces.have[NORMALS])
         type = 1;
-    else if (f->have[TEXTURES])
+    else if (faces.have[TEXTURES])
         type = 2;
     else
         type = 3;
     return type;
 }
 
-void ObjLoader::addVerticeNormalTexturePart(ObjMesh* mesh, FaceList& faces, int num)
-{
-    std::vector<Face*>::iterator it = faces.begin();
-    std::map<VertexObj, int> vertexBuffer;
-    // Etape 1 : construire la liste des sommets (vert.norm.tex) uniques
-    int addedVerticesNumber = 0;
-    do {
-        VertexObj v1(*this, (*it)->vertices[0], (*it)->textures[0], (*it)->normals[0]);
-        vertexBuffer[v1] = ++addedVerticesNumber;
-        VertexObj v2(*this, (*it)->vertices[1], (*it)->textures[1], (*it)->normals[1]);
-        vertexBuffer[v2] = ++addedVerticesNumber;
-        VertexObj v3(*this, (*it)->vertices[2], (*it)->textures[2], (*it)->normals[2]);
-        vertexBuffer[v3] = ++addedVerticesNumber;
-        if ((*it)->type == QUAD) {
-            VertexObj v4(*this, (*it)->vertices[3], (*it)->textures[3], (*it)->normals[3]);
-            vertexBuffer[v4] = ++addedVerticesNumber;
-        }
-    } while (++it != faces.end());
-
-    // Etape 2 : numeroter les sommets
-    int newnumber = 0;
-    for (std::map<VertexObj, int>::iterator vm = vertexBuffer.begin(); vm != vertexBuffer.end(); ++vm)
-        vm->second = newnumber++;
-
-    // Etape 3 : construire la liste des faces
-    std::vector<int> triangleBuffer;
-    std::vector<int> quadBuffer;
-
-    int reservedSize = faces.size();
-    triangleBuffer.reserve(reservedSize);
-    quadBuffer.reserve(reservedSize);
-
-    it = faces.begin();
-    do {
-        VertexObj v1(*this, (*it)->vertices[0], (*it)->textures[0], (*it)->normals[0]);
-        VertexObj v2(*this, (*it)->vertices[1], (*it)->textures[1], (*it)->normals[1]);
-        VertexObj v3(*this, (*it)->vertices[2], (*it)->textures[2], (*it)->normals[2]);
-        int index1 = vertexBuffer.find(v1)->second;
-        int index2 = vertexBuffer.find(v2)->second;
-        int index3 = vertexBuffer.find(v3)->second;
-
-        if ((*it)->type == TRIANGLE) {
-            triangleBuffer.push_back(index1);
-            triangleBuffer.push_back(index2);
-            triangleBuffer.push_back(index3);
-        }
-        else {
-            VertexObj v4(*this, (*it)->vertices[3], (*it)->textures[3], (*it)->normals[3]);
-            int index4 = vertexBuffer.find(v4)->second;
-            quadBuffer.push_back(index1);
-            quadBuffer.push_back(index2);
-            quadBuffer.push_back(index3);
-            quadBuffer.push_back(index4);
-        }
-        delete (*it);
-    } while (++it != faces.end());
-
-    // etape4 : construire le tableau de sommet final
-    std::vector<float> glVertexBuffer;
-    for (std::map<VertexObj, int>::iterator vm = vertexBuffer.begin(); vm != vertexBuffer.end(); ++vm) {
-        glVertexBuffer.push_back(vm->first.vertex.x);
-        glVertexBuffer.push_back(vm->first.vertex.y);
-        glVertexBuffer.push_back(vm->first.vertex.z);
-        glVertexBuffer.push_back(vm->first.normal.x);
-        glVertexBuffer.push_back(vm->first.normal.y);
-        glVertexBuffer.push_back(vm->first.normal.z);
-        glVertexBuffer.push_back(vm->first.texcoord[0]);
-        glVertexBuffer.push_back(vm->first.texcoord[1]);
-    }
-    // etape 5 : construire le Mesh pour le renderer
-    SmoothGroup* theSmoothGroup = new SmoothGroup(glVertexBuffer, triangleBuffer, quadBuffer, true, true);
-    mesh->addSmoothGroup(theSmoothGroup);
-
-    // On nettoie tout !
-    glVertexBuffer.erase(glVertexBuffer.begin(), glVertexBuffer.end());
-    triangleBuffer.erase(triangleBuffer.begin(), triangleBuffer.end());
-    quadBuffer.erase(quadBuffer.begin(), quadBuffer.end());
-    vertexBuffer.erase(vertexBuffer.begin(), vertexBuffer.end());
-}
-
-void ObjLoader::addVerticeNormalPart(ObjMesh* mesh, FaceList& faces, int num)
-{
-    std::vector<Face*>::iterator it = faces.begin();
-    std::map<VertexObj, int> vertexBuffer;
-    // Etape 1 : construire la liste des sommets (vert.norm.tex) uniques
-    int addedVerticesNumber = 0;
-    do {
-        VertexObj v1(*this, (*it)->vertices[0], (*it)->normals[0]);
-        vertexBuffer[v1] = ++addedVerticesNumber;
-        VertexObj v2(*this, (*it)->vertices[1], (*it)->normals[1]);
-        vertexBuffer[v2] = ++addedVerticesNumber;
-        VertexObj v3(*this, (*it)->vertices[2], (*it)->normals[2]);
-        vertexBuffer[v3] = ++addedVerticesNumber;
-        if ((*it)->type == QUAD) {
-            VertexObj v4(*this, (*it)->vertices[3], (*it)->normals[3]);
-            vertexBuffer[v4] = ++addedVerticesNumber;
-        }
-    } while (++it != faces.end());
-
-    // Etape 2 : numeroter les sommets
-    int newnumber = 0;
-    for (std::map<VertexObj, int>::iterator vm = vertexBuffer.begin(); vm != vertexBuffer.end(); ++vm)
-        vm->second = newnumber++;
-
-    // Etape 3 : construire la liste des faces
-    std::vector<int> triangleBuffer;
-    std::vector<int> quadBuffer;
-
-    int reservedSize = faces.size();
-    triangleBuffer.reserve(reservedSize);
-    quadBuffer.reserve(reservedSize);
-
-    it = faces.begin();
-    do {
-        VertexObj v1(*this, (*it)->vertices[0], (*it)->normals[0]);
-        VertexObj v2(*this, (*it)->vertices[1], (*it)->normals[1]);
-        VertexObj v3(*this, (*it)->vertices[2], (*it)->normals[2]);
-        int index1 = vertexBuffer.find(v1)->second;
-        int index2 = vertexBuffer.find(v2)->second;
-        int index3 = vertexBuffer.find(v3)->second;
-
-        if ((*it)->type == TRIANGLE) {
-            triangleBuffer.push_back(index1);
-            triangleBuffer.push_back(index2);
-            triangleBuffer.push_back(index3);
-        }
-        else {
-            VertexObj v4(*this, (*it)->vertices[3], (*it)->normals[3]);
-            int index4 = vertexBuffer.find(v4)->second;
-            quadBuffer.push_back(index1);
-            quadBuffer.push_back(index2);
-            quadBuffer.push_back(index3);
-            quadBuffer.push_back(index4);
-        }
-        delete (*it);
-    } while (++it != faces.end());
-
-    // etape4 : construire le tableau de sommet final
-    std::vector<float> glVertexBuffer;
-    for (std::map<VertexObj, int>::iterator vm = vertexBuffer.begin(); vm != vertexBuffer.end(); ++vm) {
-        glVertexBuffer.push_back(vm->first.vertex.x);
-        glVertexBuffer.push_back(vm->first.vertex.y);
-        glVertexBuffer.push_back(vm->first.vertex.z);
-        glVertexBuffer.push_back(vm->first.normal.x);
-        glVertexBuffer.push_back(vm->first.normal.y);
-        glVertexBuffer.push_back(vm->first.normal.z);
-    }
-    // etape 5 : construire le Mesh pour le renderer
-    SmoothGroup* theSmoothGroup = new SmoothGroup(glVertexBuffer, triangleBuffer, quadBuffer, true, false);
-    mesh->addSmoothGroup(theSmoothGroup);
-
-    // On nettoie tout !
-    glVertexBuffer.erase(glVertexBuffer.begin(), glVertexBuffer.end());
-    triangleBuffer.erase(triangleBuffer.begin(), triangleBuffer.end());
-    quadBuffer.erase(quadBuffer.begin(), quadBuffer.end());
-    vertexBuffer.erase(vertexBuffer.begin(), vertexBuffer.end());
-}
-
-void ObjLoader::addVerticeTexturePart(ObjMesh* mesh, FaceList& faces, int num)
-{
-    std::vector<Face*>::iterator it = faces.begin();
-    std::map<VertexObj, int> vertexBuffer;
-    // Etape 1 : construire la liste des sommets (vert.tex) uniques
-    int addedVerticesNumber = 0;
-    do {
-        VertexObj v1(*this, (*it)->vertices[0], (*it)->textures[0], true);
-        vertexBuffer[v1] = ++addedVerticesNumber;
-        VertexObj v2(*this, (*it)->vertices[1], (*it)->textures[1], true);
-        vertexBuffer[v2] = ++addedVerticesNumber;
-        VertexObj v3(*this, (*it)->vertices[2], (*it)->textures[2], true);
-        vertexBuffer[v3] = ++addedVerticesNumber;
-        if ((*it)->type == QUAD) {
-            VertexObj v4(*this, (*it)->vertices[3], (*it)->textures[3], true);
-            vertexBuffer[v4] = ++addedVerticesNumber;
-        }
-    } while (++it != faces.end());
-
-    // Etape 2 : numeroter les sommets
-    int newnumber = 0;
-    for (std::map<VertexObj, int>::iterator vm = vertexBuffer.begin(); vm != vertexBuffer.end(); ++vm)
-        vm->second = newnumber++;
-
-    // Etape 3 : construire la liste des faces
-    std::vector<int> triangleBuffer;
-    std::vector<int> quadBuffer;
-
-    int reservedSize = faces.size();
-    triangleBuffer.reserve(reservedSize);
-    quadBuffer.reserve(reservedSize);
-
-    it = faces.begin();
-    do {
-        VertexObj v1(*this, (*it)->vertices[0], (*it)->textures[0], true);
-        VertexObj v2(*this, (*it)->vertices[1], (*it)->textures[1], true);
-        VertexObj v3(*this, (*it)->vertices[2], (*it)->textures[2], true);
-        int index1 = vertexBuffer.find(v1)->second;
-        int index2 = vertexBuffer.find(v2)->second;
-        int index3 = vertexBuffer.find(v3)->second;
-
-        if ((*it)->type == TRIANGLE) {
-            triangleBuffer.push_back(index1);
-            triangleBuffer.push_back(index2);
-            triangleBuffer.push_back(index3);
+template <bool Normals, bool Textures, bool Welded>
+void ObjLoader::indexPart(Part& part)
+{
+    const FaceList& faces = *part.faces;
+
+    // tailles exactes : une face de n coins donne n - 2 triangles, ecrits
+    // dans l'ordre des faces
+    std::size_t cornersNumber = faces.vertices.size();
+    part.triangles.resize(3 * (cornersNumber - 2 * faces.size()));
+    unsigned int* triangle = part.triangles.data();
+
+    const IndexArray::View vertices = faces.vertices.view();
+    const IndexArray::View textures = faces.textures.view();
+    const IndexArray::View normals = faces.normals.view();
+    const unsigned short* corners = faces.corners.data();
+
+    // Sommets soudes sur les triplets d'indices (coin source de chaque
+    // sommet, dans l'ordre de premiere apparition), ou un sommet par coin
+    // sans reorganisation ; numerotes a partir de 0 dans chaque morceau
+    VertexWelder<unsigned int> welder(Welded ? std::min(faces.size(), mMaxMeshVertices) : 0);
+    Chunk chunk = Chunk();
+    // sommets d'une face et triangulation des polygones : memoire reutilisee
+    // d'une face a l'autre
+    std::vector<unsigned int> index(4);
+    Obj_mtl::polygon_triangulator triangulator;
+    std::size_t corner = 0;
+    for (std::size_t f = 0; f < faces.size(); ++f) {
+        std::size_t cornersOfFace = corners[f];
+        std::size_t chunkVertices = Welded ? welder.size() : corner - chunk.firstSource;
+        if (chunkVertices + cornersOfFace > mMaxMeshVertices || chunk.trianglesNumber + cornersOfFace - 2 > mMaxMeshTriangles) {
+            // morceau complet : les sommets de la suite sont renumerotes, ceux
+            // deja soudes sont dupliques
+            chunk.verticesNumber = chunkVertices;
+            part.chunks.push_back(chunk);
+            chunk.firstTriangle += chunk.trianglesNumber;
+            chunk.trianglesNumber = 0;
+            chunk.firstSource = Welded ? part.sources.size() : corner;
+            if (Welded)
+                welder = VertexWelder<unsigned int>(std::min(faces.size() - f, mMaxMeshVertices));
         }
-        else {
-            VertexObj v4(*this, (*it)->vertices[3], (*it)->textures[3], true);
-            int index4 = vertexBuffer.find(v4)->second;
-            quadBuffer.push_back(index1);
-            quadBuffer.push_back(index2);
-            quadBuffer.push_back(index3);
-            quadBuffer.push_back(index4);
+        if (index.size() < cornersOfFace)
+            index.resize(cornersOfFace);
+        for (std::size_t c = 0; c < cornersOfFace; ++c) {
+            std::size_t current = corner + c;
+            index[c] = (unsigned int)(current - chunk.firstSource);
+            if (Welded) {
+                // sommet i du morceau de memes indices que le coin courant
+                auto same = [&](std::size_t i) {
+                    std::size_t source = part.sources[chunk.firstSource + i];
+                    return vertices[source] == vertices[current] && (!Textures || textures[source] == textures[current])
+                           && (!Normals || normals[source] == normals[current]);
+                };
+                bool added;
+                std::size_t h = welder.hash(vertices[current], Textures ? textures[current] : 0, Normals ? normals[current] : 0);
+                index[c] = (unsigned int)welder.weld(h, same, added);
+                if (added)
+                    part.sources.push_back(current);
+            }
         }
-        delete (*it);
-    } while (++it != faces.end());
-
-    // etape4 : construire le tableau de sommet final
-    std::vector<float> glVertexBuffer;
-    for (std::map<VertexObj, int>::iterator vm = vertexBuffer.begin(); vm != vertexBuffer.end(); ++vm) {
-        glVertexBuffer.push_back(vm->first.vertex.x);
-        glVertexBuffer.push_back(vm->first.vertex.y);
-        glVertexBuffer.push_back(vm->first.vertex.z);
-        glVertexBuffer.push_back(vm->first.texcoord[0]);
-        glVertexBuffer.push_back(vm->first.texcoord[1]);
-    }
-    // etape 5 : construire le Mesh pour le renderer
-    SmoothGroup* theSmoothGroup = new SmoothGroup(glVertexBuffer, triangleBuffer, quadBuffer, false, true);
-    mesh->addSmoothGroup(theSmoothGroup);
-
-    // On nettoie tout !
-    glVertexBuffer.erase(glVertexBuffer.begin(), glVertexBuffer.end());
-    triangleBuffer.erase(triangleBuffer.begin(), triangleBuffer.end());
-    quadBuffer.erase(quadBuffer.begin(), quadBuffer.end());
-    vertexBuffer.erase(vertexBuffer.begin(), vertexBuffer.end());
-}
-
-void ObjLoader::addVerticePart(ObjMesh* mesh, FaceList& faces, int num)
-{
-    std::vector<Face*>::iterator it = faces.begin();
-    std::map<VertexObj, int> vertexBuffer;
-    // Etape 1 : construire la liste des sommets (vert) uniques
-    int addedVerticesNumber = 0;
-    do {
-        VertexObj v1(*this, (*it)->vertices[0]);
-        vertexBuffer[v1] = ++addedVerticesNumber;
-        VertexObj v2(*this, (*it)->vertices[1]);
-        vertexBuffer[v2] = ++addedVerticesNumber;
-        VertexObj v3(*this, (*it)->vertices[2]);
-        vertexBuffer[v3] = ++addedVerticesNumber;
-
-        if ((*it)->type == QUAD) {
-            VertexObj v4(*this, (*it)->vertices[3]);
-            vertexBuffer[v4] = ++addedVerticesNumber;
+        if (cornersOfFace == 3) {
+            *triangle++ = index[0];
+            *triangle++ = index[1];
+            *triangle++ = index[2];
         }
-    } while (++it != faces.end());
-
-    // Etape 2 : numeroter les sommets
-    int newnumber = 0;
-    for (std::map<VertexObj, int>::iterator vm = vertexBuffer.begin(); vm != vertexBuffer.end(); ++vm)
-        vm->second = newnumber++;
-
-    // Etape 3 : construire la liste des faces
-    std::vector<int> triangleBuffer;
-    std::vector<int> quadBuffer;
-
-    int reservedSize = faces.size();
-    triangleBuffer.reserve(reservedSize);
-    quadBuffer.reserve(reservedSize);
-
-    it = faces.begin();
-    do {
-        VertexObj v1(*this, (*it)->vertices[0]);
-        VertexObj v2(*this, (*it)->vertices[1]);
-        VertexObj v3(*this, (*it)->vertices[2]);
-        int index1 = vertexBuffer.find(v1)->second;
-        int index2 = vertexBuffer.find(v2)->second;
-        int index3 = vertexBuffer.find(v3)->second;
-
-        if ((*it)->type == TRIANGLE) {
-            triangleBuffer.push_back(index1);
-            triangleBuffer.push_back(index2);
-            triangleBuffer.push_back(index3);
+        else if (cornersOfFace == 4) {
+            // quadrilatere coupe selon sa diagonale interieure
+            unsigned int split[6];
+            Obj_mtl::polygon_triangulator::triangulate_quadrilateral(&verticesTable[vertices[corner]].x, &verticesTable[vertices[corner + 1]].x,
+                                                                      &verticesTable[vertices[corner + 2]].x, &verticesTable[vertices[corner + 3]].x, split);
+            for (int t = 0; t < 6; ++t)
+                *triangle++ = index[split[t]];
         }
         else {
-            VertexObj v4(*this, (*it)->vertices[3]);
-            int index4 = vertexBuffer.find(v4)->second;
-            quadBuffer.push_back(index1);
-            quadBuffer.push_back(index2);
-            quadBuffer.push_back(index3);
-            quadBuffer.push_back(index4);
-        }
-        delete (*it);
-    } while (++it != faces.end());
-
-    // etape4 : construire le tableau de sommet final
-    std::vector<float> glVertexBuffer;
-    for (std::map<VertexObj, int>::iterator vm = vertexBuffer.begin(); vm != vertexBuffer.end(); ++vm) {
-        glVertexBuffer.push_back(vm->first.vertex.x);
-        glVertexBuffer.push_back(vm->first.vertex.y);
-        glVertexBuffer.push_back(vm->first.vertex.z);
-    }
-    // etape 5 : construire le Mesh pour le renderer
-    SmoothGroup* theSmoothGroup = new SmoothGroup(glVertexBuffer, triangleBuffer, quadBuffer, false, false);
-    mesh->addSmoothGroup(theSmoothGroup);
-
-    // On nettoie tout !
-    glVertexBuffer.erase(glVertexBuffer.begin(), glVertexBuffer.end());
-    triangleBuffer.erase(triangleBuffer.begin(), triangleBuffer.end());
-    quadBuffer.erase(quadBuffer.begin(), quadBuffer.end());
-    vertexBuffer.erase(vertexBuffer.begin(), vertexBuffer.end());
-}
-
-void ObjLoader::addRawVerticeNormalTexturePart(ObjMesh* mesh, FaceList& faces, int num)
-{
-    std::vector<Face*>::iterator it = faces.begin();
-    // Etape 1 : construire la liste des faces
-    std::vector<int> triangleBuffer;
-    std::vector<int> quadBuffer;
-    std::vector<float> glVertexBuffer;
-
-    int reservedSize = faces.size();
-    triangleBuffer.reserve(reservedSize);
-    quadBuffer.reserve(reservedSize);
-    glVertexBuffer.reserve(3. * reservedSize);
-
-    int indexVertex = 0;
-    it = faces.begin();
-    do {
-        VertexObj v1(*this, (*it)->vertices[0], (*it)->textures[0], (*it)->normals[0]);
-        VertexObj v2(*this, (*it)->vertices[1], (*it)->textures[1], (*it)->normals[1]);
-        VertexObj v3(*this, (*it)->vertices[2], (*it)->textures[2], (*it)->normals[2]);
-
-        glVertexBuffer.push_back(v1.vertex.x);
-        glVertexBuffer.push_back(v1.vertex.y);
-        glVertexBuffer.push_back(v1.vertex.z);
-        glVertexBuffer.push_back(v1.normal.x);
-        glVertexBuffer.push_back(v1.normal.y);
-        glVertexBuffer.push_back(v1.normal.z);
-        glVertexBuffer.push_back(v1.texcoord[0]);
-        glVertexBuffer.push_back(v1.texcoord[1]);
-
-        glVertexBuffer.push_back(v2.vertex.x);
-        glVertexBuffer.push_back(v2.vertex.y);
-        glVertexBuffer.push_back(v2.vertex.z);
-        glVertexBuffer.push_back(v2.normal.x);
-        glVertexBuffer.push_back(v2.normal.y);
-        glVertexBuffer.push_back(v2.normal.z);
-        glVertexBuffer.push_back(v2.texcoord[0]);
-        glVertexBuffer.push_back(v2.texcoord[1]);
-
-        glVertexBuffer.push_back(v3.vertex.x);
-        glVertexBuffer.push_back(v3.vertex.y);
-        glVertexBuffer.push_back(v3.vertex.z);
-        glVertexBuffer.push_back(v3.normal.x);
-        glVertexBuffer.push_back(v3.normal.y);
-        glVertexBuffer.push_back(v3.normal.z);
-        glVertexBuffer.push_back(v3.texcoord[0]);
-        glVertexBuffer.push_back(v3.texcoord[1]);
-
-        int index1 = indexVertex++;
-        int index2 = indexVertex++;
-        int index3 = indexVertex++;
-
-        if ((*it)->type == TRIANGLE) {
-            triangleBuffer.push_back(index1);
-            triangleBuffer.push_back(index2);
-            triangleBuffer.push_back(index3);
+            // polygone : triangles ecrits en numeros de coins de la face,
+            // remplaces ensuite par les numeros de sommets
+            triangulator.clear();
+            for (std::size_t c = 0; c < cornersOfFace; ++c) {
+                const glm::vec3& position = verticesTable[vertices[corner + c]];
+                triangulator.add_vertex(position.x, position.y, position.z);
+            }
+            std::size_t count = 3 * triangulator.triangulate(triangle);
+            for (std::size_t t = 0; t < count; ++t)
+                triangle[t] = index[triangle[t]];
+            triangle += count;
         }
-        else {
-            VertexObj v4(*this, (*it)->vertices[3], (*it)->textures[3], (*it)->normals[3]);
-            glVertexBuffer.push_back(v4.vertex.x);
-            glVertexBuffer.push_back(v4.vertex.y);
-            glVertexBuffer.push_back(v4.vertex.z);
-            glVertexBuffer.push_back(v4.normal.x);
-            glVertexBuffer.push_back(v4.normal.y);
-            glVertexBuffer.push_back(v4.normal.z);
-            glVertexBuffer.push_back(v4.texcoord[0]);
-            glVertexBuffer.push_back(v4.texcoord[1]);
-
-            int index4 = indexVertex++;
-
-            quadBuffer.push_back(index1);
-            quadBuffer.push_back(index2);
-            quadBuffer.push_back(index3);
-            quadBuffer.push_back(index4);
+        chunk.trianglesNumber += cornersOfFace - 2;
+        corner += cornersOfFace;
+    }
+    chunk.verticesNumber = Welded ? welder.size() : corner - chunk.firstSource;
+    part.chunks.push_back(chunk);
+}
+
+template <bool Normals, bool Textures, bool Welded>
+void ObjLoader::writePart(Part& part)
+{
+    FaceList& faces = *part.faces;
+    const IndexArray::View vertices = faces.vertices.view();
+    const IndexArray::View textures = faces.textures.view();
+    const IndexArray::View normals = faces.normals.view();
+    const std::vector<Chunk>& chunks = part.chunks;
+
+    // coin source du sommet i d'un morceau
+    auto source = [&](const Chunk& chunk, std::size_t i) {
+        return Welded ? part.sources[chunk.firstSource + i] : chunk.firstSource + i;
+    };
+
+    // sans normales : somme des normales des triangles de chaque sommet
+    // (ponderees par leur aire), normalisee, calculee par vertexNormals hors
+    // de la destination (memoire GPU projetee en ecriture seule). Les sommets des morceaux sont numerotes a la
+    // suite ; un sommet soude duplique dans plusieurs morceaux a une seule
+    // normale, celle de tous ses triangles (normalIndex).
+    std::vector<glm::vec3> computedNormals;
+    std::vector<std::size_t> normalIndex;
+    auto normalOf = [&](std::size_t i) {
+        return normalIndex.empty() ? i : normalIndex[i];
+    };
+    if (!Normals) {
+        std::size_t verticesNumber = 0;
+        for (std::size_t k = 0; k < chunks.size(); ++k)
+            verticesNumber += chunks[k].verticesNumber;
+        std::size_t normalsNumber = verticesNumber;
+        if (Welded && chunks.size() > 1) {
+            // premier sommet de chaque normale : meme position et coordonnees de texture
+            VertexWelder<std::size_t> welder(verticesNumber);
+            std::vector<std::size_t> firstVertex;
+            normalIndex.resize(verticesNumber);
+            for (std::size_t i = 0; i < verticesNumber; ++i) {
+                std::size_t s = part.sources[i];
+                auto same = [&](std::size_t n) {
+                    std::size_t source = part.sources[firstVertex[n]];
+                    return vertices[source] == vertices[s] && (!Textures || textures[source] == textures[s]);
+                };
+                bool added;
+                normalIndex[i] = welder.weld(welder.hash(vertices[s], Textures ? textures[s] : 0, 0), same, added);
+                if (added)
+                    firstVertex.push_back(i);
+            }
+            normalsNumber = welder.size();
         }
-        delete (*it);
-    } while (++it != faces.end());
-    // etape 2 : construire le Mesh pour le renderer
-    SmoothGroup* theSmoothGroup = new SmoothGroup(glVertexBuffer, triangleBuffer, quadBuffer, true, true);
-    mesh->addSmoothGroup(theSmoothGroup);
-    // On nettoie tout !
-    glVertexBuffer.erase(glVertexBuffer.begin(), glVertexBuffer.end());
-    triangleBuffer.erase(triangleBuffer.begin(), triangleBuffer.end());
-    quadBuffer.erase(quadBuffer.begin(), quadBuffer.end());
-}
-
-void ObjLoader::addRawVerticeNormalPart(ObjMesh* mesh, FaceList& faces, int num)
-{
-    std::vector<Face*>::iterator it = faces.begin();
-    // Etape 1 : construire la liste des faces
-    std::vector<int> triangleBuffer;
-    std::vector<int> quadBuffer;
-    std::vector<float> glVertexBuffer;
-
-    int reservedSize = faces.size();
-    triangleBuffer.reserve(reservedSize);
-    quadBuffer.reserve(reservedSize);
-    glVertexBuffer.reserve(3. * reservedSize);
-
-    int indexVertex = 0;
-    it = faces.begin();
-    do {
-        VertexObj v1(*this, (*it)->vertices[0], (*it)->normals[0]);
-        VertexObj v2(*this, (*it)->vertices[1], (*it)->normals[1]);
-        VertexObj v3(*this, (*it)->vertices[2], (*it)->normals[2]);
-
-        glVertexBuffer.push_back(v1.vertex.x);
-        glVertexBuffer.push_back(v1.vertex.y);
-        glVertexBuffer.push_back(v1.vertex.z);
-        glVertexBuffer.push_back(v1.normal.x);
-        glVertexBuffer.push_back(v1.normal.y);
-        glVertexBuffer.push_back(v1.normal.z);
-
-        glVertexBuffer.push_back(v2.vertex.x);
-        glVertexBuffer.push_back(v2.vertex.y);
-        glVertexBuffer.push_back(v2.vertex.z);
-        glVertexBuffer.push_back(v2.normal.x);
-        glVertexBuffer.push_back(v2.normal.y);
-        glVertexBuffer.push_back(v2.normal.z);
-
-        glVertexBuffer.push_back(v3.vertex.x);
-        glVertexBuffer.push_back(v3.vertex.y);
-        glVertexBuffer.push_back(v3.vertex.z);
-        glVertexBuffer.push_back(v3.normal.x);
-        glVertexBuffer.push_back(v3.normal.y);
-        glVertexBuffer.push_back(v3.normal.z);
-
-        int index1 = indexVertex++;
-        int index2 = indexVertex++;
-        int index3 = indexVertex++;
-
-        if ((*it)->type == TRIANGLE) {
-            triangleBuffer.push_back(index1);
-            triangleBuffer.push_back(index2);
-            triangleBuffer.push_back(index3);
+        // position de chaque normale et triangles en numeros de normales
+        std::vector<glm::vec3> positions(normalsNumber);
+        std::vector<unsigned int> normalTriangles(part.triangles.size());
+        std::size_t first = 0;
+        unsigned int* triangle = normalTriangles.data();
+        for (std::size_t k = 0; k < chunks.size(); ++k) {
+            const Chunk& chunk = chunks[k];
+            for (std::size_t i = 0; i < chunk.verticesNumber; ++i)
+                positions[normalOf(first + i)] = verticesTable[vertices[source(chunk, i)]];
+            const unsigned int* index = part.triangles.data() + 3 * chunk.firstTriangle;
+            for (std::size_t t = 0; t < 3 * chunk.trianglesNumber; ++t)
+                *triangle++ = (unsigned int)normalOf(first + index[t]);
+            first += chunk.verticesNumber;
         }
-        else {
-            VertexObj v4(*this, (*it)->vertices[3], (*it)->normals[3]);
-            glVertexBuffer.push_back(v4.vertex.x);
-            glVertexBuffer.push_back(v4.vertex.y);
-            glVertexBuffer.push_back(v4.vertex.z);
-            glVertexBuffer.push_back(v4.normal.x);
-            glVertexBuffer.push_back(v4.normal.y);
-            glVertexBuffer.push_back(v4.normal.z);
-
-            int index4 = indexVertex++;
-
-            quadBuffer.push_back(index1);
-            quadBuffer.push_back(index2);
-            quadBuffer.push_back(index3);
-            quadBuffer.push_back(index4);
+        // normales unitaires quelle que soit l'echelle du modele (la soudure
+        // compare des distances absolues), nulles pour les triangles degeneres
+        computedNormals.resize(normalsNumber);
+        Loaders::vertexNormals(&positions.data()->x, &positions.data()->y, &positions.data()->z, 3,
+                               normalTriangles.data(), normalTriangles.size() / 3, normalsNumber,
+                               &computedNormals.data()->x, &computedNormals.data()->y, &computedNormals.data()->z, 3,
+                               Loaders::MeshStreams::AreaWeighting, mThreadCount);
+    }
+
+    // sommets entrelaces, ecrits une seule fois
+    std::size_t first = 0;
+    for (std::size_t k = 0; k < chunks.size(); ++k) {
+        const Chunk& chunk = chunks[k];
+        float* vertex = chunk.vertices;
+        for (std::size_t i = 0; i < chunk.verticesNumber; ++i, vertex += 8) {
+            std::size_t s = source(chunk, i);
+            const glm::vec3& position = verticesTable[vertices[s]];
+            const glm::vec3& normal = Normals ? normalsTable[normals[s]] : computedNormals[normalOf(first + i)];
+            vertex[0] = position.x;
+            vertex[1] = position.y;
+            vertex[2] = position.z;
+            vertex[3] = normal.x;
+            vertex[4] = normal.y;
+            vertex[5] = normal.z;
+            if (Textures) {
+                const glm::vec2& texcoord = texturesTable[textures[s]];
+                vertex[6] = texcoord.x;
+                vertex[7] = texcoord.y;
+            }
+            else {
+                vertex[6] = 0.f;
+                vertex[7] = 0.f;
+            }
         }
-        delete (*it);
-    } while (++it != faces.end());
-    // etape 2 : construire le Mesh pour le renderer
-    SmoothGroup* theSmoothGroup = new SmoothGroup(glVertexBuffer, triangleBuffer, quadBuffer, true, false);
-    mesh->addSmoothGroup(theSmoothGroup);
-    // On nettoie tout !
-    glVertexBuffer.erase(glVertexBuffer.begin(), glVertexBuffer.end());
-    triangleBuffer.erase(triangleBuffer.begin(), triangleBuffer.end());
-    quadBuffer.erase(quadBuffer.begin(), quadBuffer.end());
-}
-
-void ObjLoader::addRawVerticeTexturePart(ObjMesh* mesh, FaceList& faces, int num)
-{
-    std::vector<Face*>::iterator it = faces.begin();
-    // Etape 1 : construire la liste des faces
-    std::vector<int> triangleBuffer;
-    std::vector<int> quadBuffer;
-    std::vector<float> glVertexBuffer;
-
-    int reservedSize = faces.size();
-    triangleBuffer.reserve(reservedSize);
-    quadBuffer.reserve(reservedSize);
-    glVertexBuffer.reserve(3. * reservedSize);
-
-    int indexVertex = 0;
-    it = faces.begin();
-    do {
-        VertexObj v1(*this, (*it)->vertices[0], (*it)->textures[0], true);
-        VertexObj v2(*this, (*it)->vertices[1], (*it)->textures[1], true);
-        VertexObj v3(*this, (*it)->vertices[2], (*it)->textures[2], true);
-
-        glVertexBuffer.push_back(v1.vertex.x);
-        glVertexBuffer.push_back(v1.vertex.y);
-        glVertexBuffer.push_back(v1.vertex.z);
-        glVertexBuffer.push_back(v1.texcoord[0]);
-        glVertexBuffer.push_back(v1.texcoord[1]);
-
-        glVertexBuffer.push_back(v2.vertex.x);
-        glVertexBuffer.push_back(v2.vertex.y);
-        glVertexBuffer.push_back(v2.vertex.z);
-        glVertexBuffer.push_back(v2.texcoord[0]);
-        glVertexBuffer.push_back(v2.texcoord[1]);
-
-        glVertexBuffer.push_back(v3.vertex.x);
-        glVertexBuffer.push_back(v3.vertex.y);
-        glVertexBuffer.push_back(v3.vertex.z);
-        glVertexBuffer.push_back(v3.texcoord[0]);
-        glVertexBuffer.push_back(v3.texcoord[1]);
-
-        int index1 = indexVertex++;
-        int index2 = indexVertex++;
-        int index3 = indexVertex++;
-
-        if ((*it)->type == TRIANGLE) {
-            triangleBuffer.push_back(index1);
-            triangleBuffer.push_back(index2);
-            triangleBuffer.push_back(index3);
+        const unsigned int* index = part.triangles.data() + 3 * chunk.firstTriangle;
+        for (std::size_t t = 0; t < 3 * chunk.trianglesNumber; ++t)
+            chunk.triangles[t] = index[t] + chunk.firstVertex;
+        first += chunk.verticesNumber;
+    }
+
+    faces.clear();
+    std::vector<unsigned int>().swap(part.triangles);
+    std::vector<std::size_t>().swap(part.sources);
+}
+
+void ObjLoader::indexPart(Part& part)
+{
+    // smooth group 0 : pas de lissage, ajout des sommets sans reorganisation
+    switch (faceType(*part.faces)) {
+    case 0: // group with complete faces
+        return part.welded ? indexPart<true, true, true>(part) : indexPart<true, true, false>(part);
+    case 1: // groupe avec faces vertex+normales
+        return part.welded ? indexPart<true, false, true>(part) : indexPart<true, false, false>(part);
+    case 2: // groupe avec faces vertex+textures
+        return part.welded ? indexPart<false, true, true>(part) : indexPart<false, true, false>(part);
+    case 3: // groupe avec faces vertex uniquement
+        return part.welded ? indexPart<false, false, true>(part) : indexPart<false, false, false>(part);
+    default:
+        std::cerr << "Cas normalement impossible !" << std::endl;
+    }
+}
+
+void ObjLoader::writePart(Part& part)
+{
+    switch (faceType(*part.faces)) {
+    case 0:
+        return part.welded ? writePart<true, true, true>(part) : writePart<true, true, false>(part);
+    case 1:
+        return part.welded ? writePart<true, false, true>(part) : writePart<true, false, false>(part);
+    case 2:
+        return part.welded ? writePart<false, true, true>(part) : writePart<false, true, false>(part);
+    case 3:
+        return part.welded ? writePart<false, false, true>(part) : writePart<false, false, false>(part);
+    default:
+        std::cerr << "Cas normalement impossible !" << std::endl;
+    }
+}
+
+void ObjLoader::setMaxMeshSize(std::size_t vertices, std::size_t triangles)
+{
+    // une face (au plus Obj_mtl::max_face_vertices coins) tient dans un
+    // maillage, et les indices des triangles sur 32 bits
+    mMaxMeshVertices = std::min(std::max(vertices, std::size_t(65536)), std::size_t(0xffffffff));
+    mMaxMeshTriangles = std::max(triangles, std::size_t(65536));
+}
+
+void ObjLoader::buildGroups(const std::vector<Group*>& groups, Loaders::MeshSink& sink, std::vector<std::size_t>& meshGroups)
+{
+    // groupes et smooth groups independants : traites en parallele
+    std::vector<std::size_t> firstPart;
+    std::vector<Part> parts;
+    for (std::size_t g = 0; g < groups.size(); ++g) {
+        firstPart.push_back(parts.size());
+        for (std::map<int, FaceList>::iterator sg = groups[g]->faces.begin(); sg != groups[g]->faces.end(); ++sg) {
+            if (!sg->second.empty()) {
+                Part part;
+                part.faces = &sg->second;
+                part.welded = (sg->first != 0);
+                parts.push_back(part);
+            }
         }
-        else {
-            VertexObj v4(*this, (*it)->vertices[3], (*it)->textures[3], true);
-            glVertexBuffer.push_back(v4.vertex.x);
-            glVertexBuffer.push_back(v4.vertex.y);
-            glVertexBuffer.push_back(v4.vertex.z);
-            glVertexBuffer.push_back(v4.texcoord[0]);
-            glVertexBuffer.push_back(v4.texcoord[1]);
-
-            int index4 = indexVertex++;
-
-            quadBuffer.push_back(index1);
-            quadBuffer.push_back(index2);
-            quadBuffer.push_back(index3);
-            quadBuffer.push_back(index4);
+    }
+    firstPart.push_back(parts.size());
+
+    // Etape 1 : indices, d'ou la taille exacte de chaque morceau
+    // (chargement annule : morceaux restants abandonnes, vides)
+    parallelFor(parts.size(), mThreadCount, [&](std::size_t i) {
+        if (cancelled())
+            return;
+        indexPart(parts[i]);
+    });
+
+    // maillages d'un groupe : ses morceaux dans l'ordre, un nouveau maillage
+    // quand mMaxMeshVertices ou mMaxMeshTriangles serait depasse
+    struct MeshLayout {
+        std::size_t group;
+        std::vector<Chunk*> chunks;
+        std::size_t verticesNumber;
+        std::size_t trianglesNumber;
+    };
+    std::vector<MeshLayout> meshes;
+    for (std::size_t g = 0; g < groups.size(); ++g) {
+        std::size_t firstMesh = meshes.size();
+        for (std::size_t i = firstPart[g]; i < firstPart[g + 1]; ++i) {
+            for (std::size_t k = 0; k < parts[i].chunks.size(); ++k) {
+                Chunk& chunk = parts[i].chunks[k];
+                if (meshes.size() == firstMesh
+                    || meshes.back().verticesNumber + chunk.verticesNumber > mMaxMeshVertices
+                    || meshes.back().trianglesNumber + chunk.trianglesNumber > mMaxMeshTriangles) {
+                    MeshLayout mesh;
+                    mesh.group = g;
+                    mesh.verticesNumber = mesh.trianglesNumber = 0;
+                    meshes.push_back(mesh);
+                }
+                MeshLayout& mesh = meshes.back();
+                mesh.chunks.push_back(&chunk);
+                mesh.verticesNumber += chunk.verticesNumber;
+                mesh.trianglesNumber += chunk.trianglesNumber;
+            }
         }
-        delete (*it);
-    } while (++it != faces.end());
-    // etape 2 : construire le Mesh pour le renderer
-    SmoothGroup* theSmoothGroup = new SmoothGroup(glVertexBuffer, triangleBuffer, quadBuffer, false, true);
-    mesh->addSmoothGroup(theSmoothGroup);
-    // On nettoie tout !
-    glVertexBuffer.erase(glVertexBuffer.begin(), glVertexBuffer.end());
-    triangleBuffer.erase(triangleBuffer.begin(), triangleBuffer.end());
-    quadBuffer.erase(quadBuffer.begin(), quadBuffer.end());
-}
-
-void ObjLoader::addRawVerticePart(ObjMesh* mesh, FaceList& faces, int num)
-{
-    std::vector<Face*>::iterator it = faces.begin();
-    // Etape 1 : construire la liste des faces
-    std::vector<int> triangleBuffer;
-    std::vector<int> quadBuffer;
-    std::vector<float> glVertexBuffer;
-
-    int reservedSize = faces.size();
-    triangleBuffer.reserve(reservedSize);
-    quadBuffer.reserve(reservedSize);
-    glVertexBuffer.reserve(3. * reservedSize);
-
-    int indexVertex = 0;
-    it = faces.begin();
-    do {
-        VertexObj v1(*this, (*it)->vertices[0]);
-        VertexObj v2(*this, (*it)->vertices[1]);
-        VertexObj v3(*this, (*it)->vertices[2]);
-
-        glVertexBuffer.push_back(v1.vertex.x);
-        glVertexBuffer.push_back(v1.vertex.y);
-        glVertexBuffer.push_back(v1.vertex.z);
-        glVertexBuffer.push_back(v2.vertex.x);
-        glVertexBuffer.push_back(v2.vertex.y);
-        glVertexBuffer.push_back(v2.vertex.z);
-        glVertexBuffer.push_back(v3.vertex.x);
-        glVertexBuffer.push_back(v3.vertex.y);
-        glVertexBuffer.push_back(v3.vertex.z);
-
-        int index1 = indexVertex++;
-        int index2 = indexVertex++;
-        int index3 = indexVertex++;
-        if ((*it)->type == TRIANGLE) {
-            triangleBuffer.push_back(index1);
-            triangleBuffer.push_back(index2);
-            triangleBuffer.push_back(index3);
+    }
+
+    // stockage final des maillages, position de chaque morceau
+    for (std::size_t m = 0; m < meshes.size(); ++m) {
+        const MeshLayout& mesh = meshes[m];
+        float* vertices;
+        unsigned int* triangles;
+        sink.beginMesh(groups[mesh.group]->name, mesh.verticesNumber, mesh.trianglesNumber, vertices, triangles);
+        meshGroups.push_back(mesh.group);
+        std::size_t verticesNumber = 0, trianglesNumber = 0;
+        for (std::size_t k = 0; k < mesh.chunks.size(); ++k) {
+            Chunk& chunk = *mesh.chunks[k];
+            chunk.vertices = vertices + 8 * verticesNumber;
+            chunk.triangles = triangles + 3 * trianglesNumber;
+            chunk.firstVertex = (unsigned int)verticesNumber;
+            verticesNumber += chunk.verticesNumber;
+            trianglesNumber += chunk.trianglesNumber;
         }
-        else {
-            VertexObj v4(*this, (*it)->vertices[3]);
+    }
 
-            glVertexBuffer.push_back(v4.vertex.x);
-            glVertexBuffer.push_back(v4.vertex.y);
-            glVertexBuffer.push_back(v4.vertex.z);
+    // Etape 2 : sommets et triangles ecrits a leur place
+    parallelFor(parts.size(), mThreadCount, [&](std::size_t i) {
+        if (cancelled())
+            return;
+        writePart(parts[i]);
+    });
+    for (std::size_t m = 0; m < meshes.size(); ++m)
+        sink.endMesh(m);
+}
 
-            int index4 = indexVertex++;
+void ObjLoader::getObjects(std::vector<Loaders::Mesh*>& meshes)
+{
+    std::vector<int> materialIds;
+    getObjects(meshes, materialIds);
+}
 
-            quadBuffer.push_back(index1);
-            quadBuffer.push_back(index2);
-            quadBuffer.push_back(index3);
-            quadBuffer.push_back(index4);
-        }
-        delete (*it);
-    } while (++it != faces.end());
-    // etape 2 : construire le Mesh pour le renderer
-    SmoothGroup* theSmoothGroup = new SmoothGroup(glVertexBuffer, triangleBuffer, quadBuffer, false, false);
-    mesh->addSmoothGroup(theSmoothGroup);
-    // On nettoie tout !
-    glVertexBuffer.erase(glVertexBuffer.begin(), glVertexBuffer.end());
-    triangleBuffer.erase(triangleBuffer.begin(), triangleBuffer.end());
-    quadBuffer.erase(quadBuffer.begin(), quadBuffer.end());
+void ObjLoader::getObjects(std::vector<Loaders::Mesh*>& meshes, std::vector<const mtlMaterial*>& materials)
+{
+    std::vector<int> materialIds;
+    getObjects(meshes, materialIds);
+    for (std::size_t m = 0; m < materialIds.size(); ++m)
+        materials.push_back(mMaterials[materialIds[m]]);
 }
 
+void ObjLoader::getObjects(std::vector<Loaders::Mesh*>& meshes, std::vector<int>& materialIds)
+{
+    std::size_t meshesNumber = meshes.size();
+    std::size_t idsNumber = materialIds.size();
+    Loaders::MeshArraySink sink(meshes);
+    std::vector<std::string> names;
+    bool parsed = !mCacheFile.empty();
+    buildObjects(sink, materialIds, parsed ? &names : 0);
+    // maillages incomplets d'un chargement annule : ni cache ni traitements
+    if (cancelled())
+        return;
+    if (parsed)
+        writeCache(names, std::vector<int>(materialIds.begin() + idsNumber, materialIds.end()), meshes.data() + meshesNumber);
+    weldMeshes(meshes, meshesNumber);
+    optimizeMeshes(meshes, meshesNumber);
+}
 
-// TODO : Ecrire la transformation des objets en table de sommets/table de triangle
-/*
-  Pour chaque objet, construire une liste unique de sommets et de triangles, récupérer le matériau et appeler un callback pour mettre l'objet dans la scène.
- */
-void ObjLoader::getObjects(std::vector<Loaders::Mesh*>& meshes)
+void ObjLoader::getObjects(Loaders::MeshSink& sink, std::vector<const mtlMaterial*>& materials)
+{
+    std::vector<int> materialIds;
+    buildObjects(sink, materialIds, 0);
+    for (std::size_t m = 0; m < materialIds.size(); ++m)
+        materials.push_back(mMaterials[materialIds[m]]);
+    mCacheFile.clear();
+    mCacheSources.clear();
+}
+
+void ObjLoader::buildObjects(Loaders::MeshSink& sink, std::vector<int>& materialIds, std::vector<std::string>* names)
 {
     /*
 void ObjLoader::addEntities (Scene * theScene, const Transform& transform) {
@@ -808,74 +900,436 @@ void ObjLoader::addEntities (Scene * theScene, const Transform& transform) {
 			materialAddFunction (*it, theScene);
 	}
 */
-    //add geometries to the scene
-    {
-        // add geometries
-        for (std::map<std::string, Group*>::iterator group = allgroups.begin(); group != allgroups.end(); ++group) {
-            Group* theGroup = group->second;
-            if (!theGroup->empty) {
-                ObjMesh* theMesh;
-                // 				std::cerr << "Material name : " << theGroup->getMaterial() << std::endl;
-                theMesh = new ObjMesh(theGroup->name /*, theScene->getMaterialByName (theGroup->getMaterial())*/);
-                for (std::map<int, FaceList>::iterator sg = theGroup->faces.begin(); sg != theGroup->faces.end(); ++sg) {
-                    //                 std::cerr << "Traitement de " << theGroup->name << " smooth group " << sg->first << std::endl;
-                    std::vector<Face*>::iterator it = sg->second.begin();
-                    if (it != sg->second.end()) {
-                        // le groupe n'est pas vide !
-                        int type = faceType(*it);
-                        switch (type) {
-                        case 0: // group with complete faces
-                            if (sg->first == 0) {
-                                // pas de lissage sur ce smoothgroup
-                                // ajout des sommets sans reorganisation
-                                addRawVerticeNormalTexturePart(theMesh, sg->second, sg->first);
-                            }
-                            else {
-                                addVerticeNormalTexturePart(theMesh, sg->second, sg->first);
-                            }
-                            break;
-                        case 1: // groupe avec faces vertex+normales
-                            if (sg->first == 0) {
-                                // pas de lissage sur ce smoothgroup
-                                // ajout des sommets sans reorganisation
-                                addRawVerticeNormalPart(theMesh, sg->second, sg->first);
-                            }
-                            else {
-                                addVerticeNormalPart(theMesh, sg->second, sg->first);
-                            }
-                            break;
-                        case 2: // groupe avec faces vertex+textures
-                            if (sg->first == 0) {
-                                // pas de lissage sur ce smoothgroup
-                                // ajout des sommets sans reorganisation
-                                addRawVerticeTexturePart(theMesh, sg->second, sg->first);
-                            }
-                            else {
-                                addVerticeTexturePart(theMesh, sg->second, sg->first);
-                            }
-                            break;
-                        case 3: // groupe avec faces vertex uniquement
-                            if (sg->first == 0) {
-                                // pas de lissage sur ce smoothgroup
-                                // ajout des sommets sans reorganisation
-                                addRawVerticePart(theMesh, sg->second, sg->first);
-                            }
-                            else {
-                                addVerticePart(theMesh, sg->second, sg->first);
-                            }
-                            break;
-                        default:
-                            std::cerr << "Cas normalement impossible !" << std::endl;
-                        }
-                    }
-                }
+    // maillages du cache : copie des tableaux du fichier projete en memoire
+    if (mCache) {
+        std::vector<float*> vertices(mCachedMeshes.size());
+        std::vector<unsigned int*> triangles(mCachedMeshes.size());
+        for (std::size_t m = 0; m < mCachedMeshes.size(); ++m) {
+            const CachedMesh& cached = mCachedMeshes[m];
+            sink.beginMesh(cached.name, cached.nbVertices, cached.nbTriangles, vertices[m], triangles[m]);
+            materialIds.push_back(materialId(cached.material));
+        }
+        parallelFor(mCachedMeshes.size(), mThreadCount, [&](std::size_t m) {
+            if (cancelled())
+                return;
+            const CachedMesh& cached = mCachedMeshes[m];
+            std::memcpy(vertices[m], cached.vertices, cached.nbVertices * 8 * sizeof(float));
+            std::memcpy(triangles[m], cached.triangles, cached.nbTriangles * 3 * sizeof(unsigned int));
+        });
+        for (std::size_t m = 0; m < mCachedMeshes.size(); ++m)
+            sink.endMesh(m);
+        mCachedMeshes.clear();
+        delete mCache;
+        mCache = 0;
+        resolveMaterials();
+        return;
+    }
 
-                meshes.push_back(theMesh->compile());
-                delete theMesh;
-            }
-            delete theGroup;
+    //add geometries to the scene : dans l'ordre de allgroups
+    std::vector<Group*> groups;
+    for (std::map<std::string, Group*>::iterator group = allgroups.begin(); group != allgroups.end(); ++group) {
+        if (!group->second->empty)
+            groups.push_back(group->second);
+    }
+    std::vector<std::size_t> meshGroups;
+    buildGroups(groups, sink, meshGroups);
+    for (std::size_t m = 0; m < meshGroups.size(); ++m) {
+        const Group* group = groups[meshGroups[m]];
+        materialIds.push_back(group->material >= 0 ? group->material : materialId("default"));
+        if (names)
+            names->push_back(group->name);
+    }
+    resolveMaterials();
+
+    for (std::map<std::string, Group*>::iterator group = allgroups.begin(); group != allgroups.end(); ++group)
+        delete group->second;
+}
+
+void ObjLoader::weldMeshes(std::vector<Loaders::Mesh*>& meshes, std::size_t first)
+{
+    if (mWeldTolerance.x < 0.f)
+        return;
+    // le cache contient les maillages non soudes : soudure a chaque chargement
+    std::size_t vertices = 0, triangles = 0;
+    for (std::size_t m = first; m < meshes.size() && !cancelled(); ++m) {
+        std::size_t nbTriangles = meshes[m]->nbTriangles();
+        vertices += meshes[m]->weld(mWeldTolerance.x, mWeldTolerance.y, mWeldTolerance.z, mThreadCount);
+        triangles += nbTriangles - meshes[m]->nbTriangles();
+    }
+    std::cerr << "Welding : " << vertices << " vertices and " << triangles << " degenerated triangles removed" << std::endl;
+}
+
+void ObjLoader::optimizeMeshes(std::vector<Loaders::Mesh*>& meshes, std::size_t first)
+{
+    if (mVertexCacheSize == 0 || first == meshes.size())
+        return;
+    // comme la soudure, a chaque chargement (cache non optimise)
+    std::vector<Loaders::VertexCacheStatistics> before(meshes.size() - first), after(meshes.size() - first);
+    parallelFor(meshes.size() - first, mThreadCount, [&](std::size_t m) {
+        if (cancelled())
+            return;
+        Loaders::Mesh* mesh = meshes[first + m];
+        before[m] = mesh->vertexCacheStatistics(mVertexCacheSize);
+        mesh->optimizeVertexCache(mVertexCacheSize);
+        after[m] = mesh->vertexCacheStatistics(mVertexCacheSize);
+    });
+    // moyennes ponderees par les nombres de triangles et de sommets
+    double triangles = 0, vertices = 0, acmr[2] = { 0, 0 }, atvr[2] = { 0, 0 };
+    for (std::size_t m = 0; m < before.size(); ++m) {
+        double t = double(meshes[first + m]->nbTriangles()), v = double(meshes[first + m]->nbVertices());
+        triangles += t;
+        vertices += v;
+        acmr[0] += before[m].acmr * t;
+        acmr[1] += after[m].acmr * t;
+        atvr[0] += before[m].atvr * v;
+        atvr[1] += after[m].atvr * v;
+    }
+    if (triangles > 0 && vertices > 0)
+        std::cerr << "Vertex cache (" << mVertexCacheSize << ") : ACMR " << acmr[0] / triangles << " -> " << acmr[1] / triangles
+                  << ", ATVR " << atvr[0] / vertices << " -> " << atvr[1] / vertices << std::endl;
+}
+
+void ObjLoader::compileGroup(Group* group)
+{
+    std::vector<Loaders::Mesh*> meshes;
+    Loaders::MeshArraySink sink(meshes);
+    std::vector<std::size_t> meshGroups;
+    buildGroups(std::vector<Group*>(1, group), sink, meshGroups);
+    for (std::size_t m = 0; m < meshes.size(); ++m) {
+        if (cancelled())
+            delete meshes[m];
+        else
+            mMeshCallback(meshes[m]);
+    }
+}
+
+std::string ObjLoader::cachePath(const QString& filename) const
+{
+    QFileInfo file(filename);
+    std::string path = file.absoluteFilePath().toStdString();
+    if (mCacheDir.isEmpty())
+        return path + ".meshcache";
+
+    // dossier commun : nom du fichier et hachage du chemin (fichiers homonymes)
+    std::ostringstream cacheFile;
+    cacheFile << mCacheDir.toStdString() << "/" << file.fileName().toStdString() << "-"
+              << std::hex << Loaders::CacheSource::hash(path.data(), path.size()) << ".meshcache";
+    return cacheFile.str();
+}
+
+/*
+ * Fichier cache :
+ *   en-tete : CacheMagic, CacheVersion, CacheByteOrder
+ *   sources : nombre, puis chemin, taille, date et hachage de chaque fichier
+ *   materiaux : nombre, puis chaque mtlMaterial utilise par les maillages
+ *               (chemins des textures complets)
+ *   maillages : nombre, puis pour chaque maillage le nom de son groupe,
+ *               son materiau, normales et coordonnees de texture (un octet
+ *               chacun), les nombres de sommets et de triangles (64 bits),
+ *               et les tableaux
+ *               de sommets (8 floats) et de triangles (3 indices)
+ */
+void ObjLoader::writeCache(const std::vector<std::string>& names, const std::vector<int>& materialIds, Loaders::Mesh* const* meshes)
+{
+    Loaders::CacheWriter cache(mCacheFile);
+    cache.write(CacheMagic);
+    cache.write(CacheVersion);
+    cache.write(CacheByteOrder);
+
+    cache.write((unsigned int)mCacheSources.size());
+    for (std::size_t s = 0; s < mCacheSources.size(); ++s) {
+        cache.write(mCacheSources[s].mPath);
+        cache.write(mCacheSources[s].mSize);
+        cache.write(mCacheSources[s].mTime);
+        cache.write(mCacheSources[s].mHash);
+    }
+
+    std::vector<const mtlMaterial*> used;
+    for (std::size_t m = 0; m < mMaterials.size(); ++m) {
+        if (mMaterials[m])
+            used.push_back(mMaterials[m]);
+    }
+    cache.write((unsigned int)used.size());
+    for (std::size_t m = 0; m < used.size(); ++m)
+        writeMaterial(cache, *used[m]);
+
+    cache.write((unsigned int)names.size());
+    for (std::size_t g = 0; g < names.size(); ++g) {
+        const Loaders::Mesh* mesh = meshes[g];
+        cache.write(names[g]);
+        cache.write(mMaterialNames[materialIds[g]]);
+        cache.write((unsigned char)mesh->hasNormals());
+        cache.write((unsigned char)mesh->hasTextureCoords());
+        cache.write((unsigned long long)mesh->nbVertices());
+        cache.write((unsigned long long)mesh->nbTriangles());
+        cache.writeArray(mesh->vertexData(), mesh->nbVertices() * 8 * sizeof(float));
+        cache.writeArray(mesh->triangleData(), mesh->nbTriangles() * 3 * sizeof(unsigned int));
+    }
+
+    if (!cache.commit())
+        std::cerr << "WARNING : can't write cache " << mCacheFile << std::endl;
+    mCacheFile.clear();
+    mCacheSources.clear();
+}
+
+bool ObjLoader::readCache(const std::string& cacheFile, const std::string& filename)
+{
+    Loaders::CacheReader* cache = new Loaders::CacheReader(cacheFile);
+    char magic[8];
+    unsigned int version, byteOrder;
+    bool valid = cache->read(magic) && std::memcmp(magic, CacheMagic, sizeof(magic)) == 0
+                 && cache->read(version) && version == CacheVersion
+                 && cache->read(byteOrder) && byteOrder == CacheByteOrder;
+
+    // fichier OBJ et bibliotheques de materiaux inchanges
+    std::vector<std::string> libraries;
+    unsigned int sourcesNumber = 0;
+    valid = valid && cache->read(sourcesNumber) && sourcesNumber > 0;
+    for (unsigned int s = 0; valid && s < sourcesNumber; ++s) {
+        Loaders::CacheSource source;
+        valid = cache->read(source.mPath) && cache->read(source.mSize) && cache->read(source.mTime) && cache->read(source.mHash)
+                && (s != 0 || source.mPath == filename) && source.isCurrent();
+        if (s != 0)
+            libraries.push_back(source.mPath);
+    }
+
+    std::unique_ptr<MaterialLibrary> materials(new MaterialLibrary(""));
+    unsigned int materialsNumber = 0;
+    valid = valid && cache->read(materialsNumber);
+    for (unsigned int m = 0; valid && m < materialsNumber; ++m)
+        valid = readMaterial(*cache, *materials);
+
+    // tableaux dans le fichier projete, indices verifies (cache corrompu)
+    std::vector<CachedMesh> cachedMeshes;
+    unsigned int meshesNumber = 0;
+    valid = valid && cache->read(meshesNumber);
+    for (unsigned int m = 0; valid && m < meshesNumber; ++m) {
+        CachedMesh mesh;
+        std::string name, material;
+        unsigned char hasNormals, hasTextureCoords;
+        unsigned long long nbVertices, nbTriangles;
+        // tailles des tableaux representables (indices sur 32 bits)
+        valid = cache->read(name) && cache->read(material) && cache->read(hasNormals) && cache->read(hasTextureCoords)
+                && cache->read(nbVertices) && cache->read(nbTriangles)
+                && nbVertices <= 0xffffffffull + 1 && nbVertices <= std::size_t(-1) / (8 * sizeof(float))
+                && nbTriangles <= std::size_t(-1) / (3 * sizeof(unsigned int));
+        if (!valid)
+            break;
+        mesh.nbVertices = std::size_t(nbVertices);
+        mesh.nbTriangles = std::size_t(nbTriangles);
+        mesh.hasNormals = (hasNormals != 0);
+        mesh.hasTextureCoords = (hasTextureCoords != 0);
+        mesh.name = name;
+        mesh.material = material;
+        mesh.vertices = reinterpret_cast<const float*>(cache->readArray(mesh.nbVertices * 8 * sizeof(float)));
+        mesh.triangles = reinterpret_cast<const unsigned int*>(cache->readArray(mesh.nbTriangles * 3 * sizeof(unsigned int)));
+        valid = cache->ok();
+        for (std::size_t i = 0; valid && i < 3 * mesh.nbTriangles; ++i)
+            valid = mesh.triangles[i] < mesh.nbVertices;
+        cachedMeshes.push_back(mesh);
+    }
+
+    if (!valid) {
+        delete cache;
+        return false;
+    }
+    if (mMaterialLibraries) {
+        // materiaux partages avec les autres chargeurs plutot que les copies du cache
+        for (std::size_t l = 0; l < libraries.size(); ++l)
+            useSharedLibrary(libraries[l]);
+    }
+    else {
+        mLibraries.push_back(materials.get());
+        mOwnedLibraries.push_back(std::move(materials));
+    }
+    delete mCache;
+    mCache = cache;
+    mCachedMeshes.swap(cachedMeshes);
+    return true;
+}
+
+void ObjLoader::writeMaterial(Loaders::CacheWriter& cache, const mtlMaterial& material)
+{
+    cache.write(material.name);
+    cache.write(material.Ka);
+    cache.write(material.Kd);
+    cache.write(material.Ks);
+    cache.write(material.Tf);
+    cache.write(material.illum);
+    cache.write(material.shininess);
+    cache.write(material.sharpness);
+    cache.write(material.dissolve);
+    cache.write(material.ior);
+    cache.write(material.texturePath(material.map_ka));
+    cache.write(material.map_ka_scale);
+    cache.write(material.texturePath(material.map_kd));
+    cache.write(material.map_kd_scale);
+    cache.write(material.texturePath(material.map_ks));
+    cache.write(material.map_ks_scale);
+    cache.write(material.texturePath(material.map_Ns));
+    cache.write(material.map_Ns_scale);
+    cache.write(material.texturePath(material.map_d));
+    cache.write(material.map_d_scale);
+    cache.write(material.texturePath(material.dispmap));
+    cache.write(material.texturePath(material.decalmap));
+    cache.write(material.texturePath(material.normalmap));
+    cache.write(material.texturePath(material.bumpmap));
+    cache.write(material.bumpmap_scale);
+    cache.write(material.texturePath(material.reflmap));
+}
+
+bool ObjLoader::readMaterial(Loaders::CacheReader& cache, MaterialLibrary& library)
+{
+    std::string name;
+    if (!cache.read(name))
+        return false;
+    mtlMaterial& material = library.material(library.addMaterial(name));
+    // texture : chemin complet, identifiant dans library
+    std::string texture;
+    auto readTexture = [&](int& id) {
+        cache.read(texture);
+        id = texture.empty() ? -1 : library.addTexture(texture);
+    };
+    cache.read(material.Ka);
+    cache.read(material.Kd);
+    cache.read(material.Ks);
+    cache.read(material.Tf);
+    cache.read(material.illum);
+    cache.read(material.shininess);
+    cache.read(material.sharpness);
+    cache.read(material.dissolve);
+    cache.read(material.ior);
+    readTexture(material.map_ka);
+    cache.read(material.map_ka_scale);
+    readTexture(material.map_kd);
+    cache.read(material.map_kd_scale);
+    readTexture(material.map_ks);
+    cache.read(material.map_ks_scale);
+    readTexture(material.map_Ns);
+    cache.read(material.map_Ns_scale);
+    readTexture(material.map_d);
+    cache.read(material.map_d_scale);
+    readTexture(material.dispmap);
+    readTexture(material.decalmap);
+    readTexture(material.normalmap);
+    readTexture(material.bumpmap);
+    cache.read(material.bumpmap_scale);
+    readTexture(material.reflmap);
+    return cache.ok();
+}
+
+int ObjLoader::materialId(const std::string& name)
+{
+    std::pair<std::unordered_map<std::string, int>::iterator, bool> id = mMaterialIds.insert(std::make_pair(name, int(mMaterialNames.size())));
+    if (id.second)
+        mMaterialNames.push_back(name);
+    return id.first->second;
+}
+
+const ObjLoader::mtlMaterial* ObjLoader::findMaterial(const std::string& name) const
+{
+    for (std::size_t l = 0; l < mLibraries.size(); ++l) {
+        int id = mLibraries[l]->find(name);
+        if (id >= 0)
+            return &mLibraries[l]->material(id);
+    }
+    return 0;
+}
+
+void ObjLoader::resolveMaterials()
+{
+    // seuls les materiaux utilises sont cherches dans les bibliotheques
+    for (std::size_t m = mMaterials.size(); m < mMaterialNames.size(); ++m)
+        mMaterials.push_back(findMaterial(mMaterialNames[m]));
+}
+
+std::string ObjLoader::mtlMaterial::texturePath(int texture) const
+{
+    return (library && texture >= 0) ? library->texturePath(texture) : std::string();
+}
+
+std::string ObjLoader::memoryMessage() const
+{
+    // une allocation par face : 3 x int[4], 2 booleens et le type (56 octets),
+    // le pointeur et l'en-tete d'allocation (16 octets)
+    const std::size_t heapFaceSize = 56 + sizeof(void*) + 16;
+    std::size_t facesNumber = 0;
+    std::size_t facesMemory = 0;
+    for (std::map<std::string, Group*>::const_iterator group = allgroups.begin(); group != allgroups.end(); ++group) {
+        for (std::map<int, FaceList>::const_iterator sg = group->second->faces.begin(); sg != group->second->faces.end(); ++sg) {
+            facesNumber += sg->second.size();
+            facesMemory += sg->second.memory();
         }
     }
+    std::size_t heapMemory = facesNumber * heapFaceSize;
+    // coordonnees de texture (u, v) au lieu de (u, v, 0)
+    std::size_t savedMemory = texturesTable.size() * sizeof(float);
+    if (heapMemory > facesMemory)
+        savedMemory += heapMemory - facesMemory;
+
+    std::ostringstream message;
+    message << "Faces memory : " << facesMemory / (1024. * 1024.) << " MB (" << savedMemory / (1024. * 1024.) << " MB saved)" << std::endl;
+    return message.str();
+}
+
+// =============================================================================
+
+int MaterialLibrary::find(const std::string& name) const
+{
+    std::unordered_map<std::string, int>::const_iterator id = mMaterialIds.find(name);
+    return id != mMaterialIds.end() ? id->second : -1;
+}
+
+std::string MaterialLibrary::texturePath(int id) const
+{
+    const std::string& path = mTextures[id];
+    // chemin absolu (/..., \\..., C:...) ou relatif au dossier de la bibliotheque
+    bool absolute = path[0] == '/' || path[0] == '\\' || (path.size() > 1 && path[1] == ':');
+    return absolute ? path : mDirectory + path;
+}
+
+int MaterialLibrary::addMaterial(const std::string& name)
+{
+    std::pair<std::unordered_map<std::string, int>::iterator, bool> id = mMaterialIds.insert(std::make_pair(name, int(mMaterials.size())));
+    if (id.second) {
+        mMaterials.push_back(ObjLoader::mtlMaterial(name));
+        mMaterials.back().library = this;
+    }
+    return id.first->second;
+}
+
+int MaterialLibrary::addTexture(const std::string& path)
+{
+    std::pair<std::unordered_map<std::string, int>::iterator, bool> id = mTextureIds.insert(std::make_pair(path, int(mTextures.size())));
+    if (id.second)
+        mTextures.push_back(path);
+    return id.first->second;
+}
+
+// =============================================================================
+
+const MaterialLibrary& MaterialLibraries::library(const std::string& filename, const Parser& parse)
+{
+    // entree creee sous le verrou, analyse hors du verrou : les autres
+    // bibliotheques restent accessibles pendant l'analyse
+    Entry* entry;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::unique_ptr<Entry>& slot = mLibraries[filename];
+        if (!slot) {
+            slot.reset(new Entry);
+            slot->materials.reset(new MaterialLibrary(filename.substr(0, filename.find_last_of('/') + 1)));
+        }
+        entry = slot.get();
+    }
+    std::call_once(entry->parsed, [&]() { parse(*entry->materials); });
+    return *entry->materials;
+}
+
+std::size_t MaterialLibraries::size() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mLibraries.size();
 }
 
 } // end namespace obj
@@ -21,15 +21,23 @@
 #define OBJLOADER_H
 
 #include <QString>
+#include <algorithm>
+#include <atomic>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <iostream>
 #include <sstream>
+#include <memory>
+#include <mutex>
 
 #include "glm/glm.hpp"
 #include "glm/gtx/string_cast.hpp"
 #include "objfileparser.h"
-#include "objmesh.h"
+#include "objparallelparser.h"
+#include "objbatchparser.h"
+#include "meshcache.h"
+#include "meshsink.h"
 
 #include "utils.h"
 using namespace Utils;
@@ -65,6 +73,9 @@ namespace Obj_mtl {
  */
 
 
+class MaterialLibrary;
+class MaterialLibraries;
+
 /** @ingroup OBJ-MTL
     Class to load geometry in OBJ/MTL format.
     @author Mathias Paulin <Mathias.Paulin@irit.fr>
@@ -81,251 +92,446 @@ public:
     /// @return if loaded correctly or not
     bool load(const QString& filename, QString& reason);
 
+    /// Load the file at "filename" from its binary cache only (see
+    /// #setCacheEnabled()), use #getObjects() to retreive the meshes.
+    /// @return false if there is no valid cache for the file
+    bool loadCache(const QString& filename, QString& reason);
+
     /// Get the loaded meshes after calling #load().
     ///  An OBJ defines one or several meshes therefore we return a vector
     ///  "meshes"
     void getObjects(std::vector<Loaders::Mesh*>& meshes);
 
+    /// Number of threads used by #load() to parse the file (0 : all cores,
+    /// 1 : serial parse, vertices and faces received by blocks), and by
+    /// #getObjects() to build the groups and smooth groups in parallel.
+    void setThreadCount(unsigned threadCount) { mThreadCount = threadCount; }
+
+    /// Binary cache of the loaded files (enabled by default) : #getObjects()
+    /// writes the meshes and materials of a parsed file in a cache file.
+    /// While the OBJ file and its material libraries are unchanged (same
+    /// size, and same modification time or content), #load() maps the cache
+    /// instead of parsing the file.
+    void setCacheEnabled(bool enabled) { mCacheEnabled = enabled; }
+    /// Existing folder of the cache files, empty (default) for a cache next
+    /// to each OBJ file ("file.obj.meshcache").
+    void setCacheDir(const QString& cacheDir) { mCacheDir = cacheDir; }
+
+    /// Optional welding of the meshes built by #getObjects() (see
+    /// Mesh::weld()) : vertices closer than the tolerances are merged, across
+    /// the smooth groups of a group. A negative position tolerance (default)
+    /// disables welding.
+    void setWeldTolerance(float position, float normal, float texcoord)
+    {
+        mWeldTolerance = glm::vec3(position, normal, texcoord);
+    }
+
+    /// Optional post-transform vertex cache optimization of the meshes
+    /// built by #getObjects(), after welding (see
+    /// Mesh::optimizeVertexCache()) : triangles reordered for a cache of
+    /// cacheSize vertices, then vertices in their order of first use.
+    /// Disabled by default. ACMR and ATVR before and after are printed.
+    void setVertexCacheOptimization(bool enabled, unsigned cacheSize = 16)
+    {
+        mVertexCacheSize = enabled ? std::max(cacheSize, 3u) : 0;
+    }
+
+    /// Largest meshes built by #getObjects() and by a streaming load
+    /// (default : 2^24 vertices and 2^25 triangles, at least 65536 of each,
+    /// at most 2^32 - 1 vertices). A larger group is split into several meshes
+    /// with the name and the material of the group : their triangles index
+    /// their own vertices (32 bits indices, 16 bits are enough up to 65536
+    /// vertices), the vertices shared by two of them are duplicated.
+    void setMaxMeshSize(std::size_t vertices, std::size_t triangles);
+
+    /// Receives the meshes of a streaming load.
+    typedef std::function<void(Loaders::Mesh*)> MeshCallback;
+
+    /// Start a streaming load : the OBJ content is then given by chunks to
+    /// #feed(). Each group (g or o) is compiled and sent to meshCallback as
+    /// soon as the next one starts and its faces are released, so that
+    /// faces memory is bounded by the largest group. Vertices, normals and
+    /// texture coordinates are kept for the whole file (OBJ indices are
+    /// global). A group continued later in the file gives another mesh.
+    /// @param objDir : folder of the material libraries and textures
+    void beginStream(const QString& objDir, const MeshCallback& meshCallback);
+    /// Parse the next chunk of a streaming load, lines may be split
+    /// between chunks.
+    /// @param reason : error message if any
+    /// @return false once the content could not be parsed
+    bool feed(const char* data, std::size_t size, QString& reason);
+    /// End of a streaming load : the last group is sent to the callback.
+    bool finish(QString& reason);
+
+    /// Optional cancel flag, set by another thread (0 : no cancel). Once it
+    /// is set, the groups being built are abandoned between two parts,
+    /// #getObjects() returns incomplete meshes (not cached, welded nor
+    /// optimized) that the caller deletes, and a streaming load sends no
+    /// more meshes to its callback.
+    void setCancelFlag(const std::atomic<bool>* cancel) { mCancel = cancel; }
+
+    /** @ingroup OBJ-MTL
+                   OBJ material.
+                */
+    class mtlMaterial {
+    public:
+        std::string name;
+        /// Library of the material, which holds the paths of its textures
+        /// (see #texturePath()).
+        const MaterialLibrary* library;
+
+        float Ka[3];
+        float Kd[3];
+        float Ks[3];
+        float Tf[3];
+
+        int illum;
+        float shininess;
+        float sharpness;
+        float dissolve;
+        float ior;
+
+        // textures : identifiants dans la bibliotheque, -1 sans texture
+        int map_ka;
+        glm::vec3 map_ka_scale;
+
+        int map_kd;
+        glm::vec3 map_kd_scale;
+
+        int map_ks;
+        glm::vec3 map_ks_scale;
+
+        int map_Ns;
+        glm::vec3 map_Ns_scale;
+
+        int map_d;
+        glm::vec3 map_d_scale;
+
+        int dispmap;
+
+        int decalmap;
+
+        int normalmap;
+
+        int bumpmap;
+        glm::vec3 bumpmap_scale;
+
+        int reflmap;
+
+        mtlMaterial(std::string n)
+            : name(n)
+            , library(0)
+            , illum(0)
+            , shininess(0.)
+            , sharpness(0.)
+            , dissolve(1.)
+            , ior(1.)
+            , map_ka(-1)
+            , map_kd(-1)
+            , map_ks(-1)
+            , map_Ns(-1)
+            , map_d(-1)
+            , dispmap(-1)
+            , decalmap(-1)
+            , normalmap(-1)
+            , bumpmap(-1)
+            , reflmap(-1)
+        {
+            for (int i = 0; i < 3; ++i)
+                Ka[i] = Kd[i] = Ks[i] = Tf[i] = 0.;
+            map_ka_scale = map_kd_scale = map_ks_scale = glm::vec3(1.0, 1.0, 1.0);
+            map_Ns_scale = map_d_scale = bumpmap_scale = glm::vec3(1.0, 1.0, 1.0);
+        }
+
+        /// Path of a texture of the material (e.g. texturePath(map_kd)),
+        /// relative paths are completed with the folder of the library.
+        /// Resolved on demand : only for the materials a renderer uses.
+        /// @return an empty string for -1 (no texture)
+        std::string texturePath(int texture) const;
+    };
+
+    /// Same as #getObjects(), with the material of each mesh : materials[i]
+    /// is the material of meshes[i], 0 if the libraries don't define it.
+    /// The materials belong to the #ObjLoader, or to its #MaterialLibraries.
+    void getObjects(std::vector<Loaders::Mesh*>& meshes, std::vector<const mtlMaterial*>& materials);
+
+    /// Same as #getObjects(), with the material ID of each mesh :
+    /// #materials()[materialIds[i]] is the material of meshes[i].
+    void getObjects(std::vector<Loaders::Mesh*>& meshes, std::vector<int>& materialIds);
+
+    /// Materials used by the groups of the loaded file (usemtl), indexed by
+    /// material ID : a flat table that a renderer can index directly. An
+    /// entry is 0 when no library defines the material. Complete after
+    /// #getObjects().
+    const std::vector<const mtlMaterial*>& materials() const { return mMaterials; }
+
+    /// Build the loaded meshes directly in their final storage (see
+    /// #MeshSink), e.g. mapped OpenGL buffers : the exact size of each mesh
+    /// is known after the indices of its faces are computed, then its
+    /// vertices and triangles are written once. materials[i] is the material
+    /// of the mesh i of the sink. The cache is not written and the meshes are
+    /// not welded (see #setCacheEnabled() and #setWeldTolerance()).
+    void getObjects(Loaders::MeshSink& sink, std::vector<const mtlMaterial*>& materials);
+
+    /// Material libraries shared with other loaders (0 : libraries parsed
+    /// by this loader), see #MaterialLibraries.
+    void setMaterialLibraries(MaterialLibraries* libraries) { mMaterialLibraries = libraries; }
+
     // sous classes et methodes
 private:
-    class mtlMaterial;
-    typedef std::pair<std::string, mtlMaterial*> NamedMaterial;
-
     std::string lastParseMessage;
 
     // table des sommets, normales et coordtextures
     std::vector<glm::vec3> verticesTable;
-    int vertices;
+    std::size_t vertices;
     std::vector<glm::vec3> normalsTable;
-    int normals;
-    std::vector<glm::vec3> texturesTable;
-    int textures;
+    std::size_t normals;
+    std::vector<glm::vec2> texturesTable;
+    std::size_t textures;
 
     //folder in which the model is stored (for paths to textures)
     QString mObjDir;
 
+    unsigned mThreadCount;
+    // drapeau d'annulation (0 : pas d'annulation)
+    const std::atomic<bool>* mCancel;
+    bool cancelled() const { return mCancel && mCancel->load(std::memory_order_relaxed); }
+    // tolerances de soudure (position, normale, coordonnees de texture)
+    glm::vec3 mWeldTolerance;
+    unsigned mVertexCacheSize; // 0 : pas d'optimisation
+    // taille maximale des maillages (decoupage des groupes)
+    std::size_t mMaxMeshVertices;
+    std::size_t mMaxMeshTriangles;
+
+    // chargement en flux
+    Obj_mtl::obj_batch_parser* mStreamParser;
+    MeshCallback mMeshCallback;
+
+    // cache binaire : fichier a ecrire par getObjects et ses sources (OBJ et
+    // bibliotheques de materiaux), ou cache valide lu par getObjects
+    struct CachedMesh {
+        const float* vertices;
+        std::size_t nbVertices;
+        const unsigned int* triangles;
+        std::size_t nbTriangles;
+        bool hasNormals;
+        bool hasTextureCoords;
+        std::string name;
+        std::string material;
+    };
+    bool mCacheEnabled;
+    QString mCacheDir;
+    std::string mCacheFile;
+    std::vector<Loaders::CacheSource> mCacheSources;
+    Loaders::CacheReader* mCache;
+    std::vector<CachedMesh> mCachedMeshes;
+
+    // bibliotheques de materiaux partagees (0 : bibliotheques propres)
+    MaterialLibraries* mMaterialLibraries;
+    // bibliotheques utilisees (mtllib) dans l'ordre : un materiau est pris
+    // dans la premiere qui le definit
+    std::vector<const MaterialLibrary*> mLibraries;
+    // bibliotheques propres, analysees par ce chargeur ou lues du cache
+    std::vector<std::unique_ptr<MaterialLibrary> > mOwnedLibraries;
+    // bibliotheque en cours d'analyse
+    MaterialLibrary* mParsedLibrary;
+    // noms des materiaux utilises (usemtl) internes : identifiant de
+    // materiau -> nom, et materiau une fois resolu dans mLibraries
+    std::unordered_map<std::string, int> mMaterialIds;
+    std::vector<std::string> mMaterialNames;
+    std::vector<const mtlMaterial*> mMaterials;
+
     // triangular faces definition
     enum FaceVertexElement { NORMALS = 0,
                              TEXTURES };
     /** @ingroup OBJ-MTL
-                   OBJ vertex.
+                   Vertex welding : table de hachage (adressage ouvert, sondage
+                   lineaire) des triplets d'indices (v, vt, vn). Les sommets sont
+                   numerotes dans l'ordre de premiere apparition ; la table ne
+                   garde que le hachage et le numero de chaque sommet (Index :
+                   unsigned int pour au plus 2^32 - 1 sommets), l'appelant
+                   compare les triplets a partir du numero.
                 */
-    class VertexObj {
-        friend class ObjLoader;
-        glm::vec3 vertex;
-        glm::vec3 normal;
-        float texcoord[2];
-        bool have[2];
+    template <typename Index>
+    class VertexWelder {
+        struct Entry {
+            Index hash;
+            Index index; // numero + 1, 0 : vide
+        };
+        std::vector<Entry> table;
+        std::size_t mask;
+        std::size_t weldedNumber;
+
+        void grow()
+        {
+            std::vector<Entry> old;
+            old.swap(table);
+            Entry empty = { 0, 0 };
+            table.assign(2 * old.size(), empty);
+            mask = table.size() - 1;
+            for (std::size_t e = 0; e < old.size(); ++e) {
+                if (old[e].index == 0)
+                    continue;
+                std::size_t i = std::size_t(old[e].hash) & mask;
+                while (table[i].index != 0)
+                    i = (i + 1) & mask;
+                table[i] = old[e];
+            }
+        }
 
     public:
-        VertexObj(const ObjLoader& loader, int v)
+        // un maillage ferme a environ deux fois moins de sommets que de faces :
+        // table dimensionnee sur le nombre de faces, agrandie au dela d'un remplissage de moitie
+        explicit VertexWelder(std::size_t facesNumber)
+            : weldedNumber(0)
         {
-            vertex = loader.verticesTable[v];
-            texcoord[0] = texcoord[1] = 0.0f;
-            have[NORMALS] = have[TEXTURES] = false;
-        }
-        VertexObj(const ObjLoader& loader, int v, int t, bool)
+            std::size_t size = 16;
+            while (size < facesNumber)
+                size *= 2;
+            Entry empty = { 0, 0 };
+            table.assign(size, empty);
+            mask = size - 1;
+        }
+        static std::size_t hash(std::size_t v, std::size_t t, std::size_t n)
         {
-            vertex = loader.verticesTable[v];
-            texcoord[0] = loader.texturesTable[t].x;
-            texcoord[1] = loader.texturesTable[t].y;
-            have[NORMALS] = false;
-            have[TEXTURES] = true;
-        }
-        VertexObj(const ObjLoader& loader, int v, int n)
+            unsigned long long h = (unsigned long long)v * 0x9e3779b97f4a7c15ULL;
+            h ^= (unsigned long long)t * 0xc2b2ae3d27d4eb4fULL;
+            h ^= (unsigned long long)n * 0x165667b19e3779f9ULL;
+            h ^= h >> 29;
+            return std::size_t(h);
+        }
+        /* Numero du sommet de hachage h, same(numero) indiquant un sommet
+           deja soude identique ; added indique un nouveau sommet */
+        template <typename Same>
+        std::size_t weld(std::size_t h, const Same& same, bool& added)
+        {
+            std::size_t i = h & mask;
+            while (table[i].index != 0) {
+                if (table[i].hash == Index(h) && same(std::size_t(table[i].index - 1))) {
+                    added = false;
+                    return std::size_t(table[i].index - 1);
+                }
+                i = (i + 1) & mask;
+            }
+            table[i].hash = Index(h);
+            table[i].index = Index(++weldedNumber);
+            added = true;
+            if (2 * weldedNumber > table.size())
+                grow();
+            return weldedNumber - 1;
+        }
+        std::size_t size() const
         {
-            vertex = loader.verticesTable[v];
-            normal = loader.normalsTable[n];
-            texcoord[0] = texcoord[1] = 0.0f;
-            have[NORMALS] = true;
-            have[TEXTURES] = false;
+            return weldedNumber;
         }
-        VertexObj(const ObjLoader& loader, int v, int t, int n)
+    };
+
+    /** @ingroup OBJ-MTL
+                   Indices OBJ (a partir de 0) stockes sur 32 bits, et sur 48
+                   bits apres le premier indice superieur a 2^32 - 1 (tableau
+                   de poids forts) : la memoire des fichiers usuels n'augmente
+                   pas avec les index_type de 64 bits.
+                */
+    class IndexArray {
+        std::vector<unsigned int> low;
+        std::vector<unsigned short> high;
+
+    public:
+        // lecture des indices sans acces au vector (boucles internes)
+        struct View {
+            const unsigned int* low;
+            const unsigned short* high;
+            std::size_t operator[](std::size_t i) const
+            {
+                return high ? (std::size_t(high[i]) << 32 | low[i]) : std::size_t(low[i]);
+            }
+        };
+        void push_back(Obj_mtl::index_type index)
+        {
+            unsigned long long value = (unsigned long long)index;
+            if ((value >> 32) != 0 && high.empty())
+                high.assign(low.size(), 0);
+            low.push_back((unsigned int)value);
+            if (!high.empty())
+                high.push_back((unsigned short)(value >> 32));
+        }
+        View view() const
         {
-            vertex = loader.verticesTable[v];
-            normal = loader.normalsTable[n];
-            texcoord[0] = loader.texturesTable[t].x;
-            texcoord[1] = loader.texturesTable[t].y;
-            have[NORMALS] = true;
-            have[TEXTURES] = true;
+            View view = { low.data(), high.empty() ? 0 : high.data() };
+            return view;
         }
-        friend bool operator<(const VertexObj& a, const VertexObj& b)
+        std::size_t size() const
         {
-            if (a == b)
-                return false;
-            else if (a.vertex == b.vertex) {
-                // comparer la normale
-                if (a.normal == b.normal) {
-                    // comparer les text coord
-                    if (a.texcoord[0] < b.texcoord[0])
-                        return true;
-                    else if (a.texcoord[0] > b.texcoord[0])
-                        return false;
-                    else
-                        return (a.texcoord[1] < b.texcoord[1]);
-                }
-                else {
-                    // comparer les normales
-                    if (a.normal.x < b.normal.x)
-                        return true;
-                    else if (a.normal.x > b.normal.x)
-                        return false;
-                    else if (a.normal.y < b.normal.y)
-                        return true;
-                    else if (a.normal.y > b.normal.y)
-                        return false;
-                    else
-                        return (a.normal.z < b.normal.z);
-                }
-            }
-            else {
-                if (a.vertex.x < b.vertex.x)
-                    return true;
-                else if (a.vertex.x > b.vertex.x)
-                    return false;
-                else if (a.vertex.y < b.vertex.y)
-                    return true;
-                else if (a.vertex.y > b.vertex.y)
-                    return false;
-                else
-                    return (a.vertex.z < b.vertex.z);
-            }
+            return low.size();
         }
-
-        friend bool operator==(const VertexObj& a, const VertexObj& b)
+        // octets alloues
+        std::size_t memory() const
         {
-            return ((a.vertex == b.vertex) && (a.normal == b.normal) && (a.texcoord[0] == b.texcoord[0]) && (a.texcoord[1] == b.texcoord[1]));
+            return low.capacity() * sizeof(unsigned int) + high.capacity() * sizeof(unsigned short);
         }
-
-        friend std::ostream& operator<<(std::ostream& os, const VertexObj& a)
+        void clear()
         {
-            os << "Pos : " << glm::to_string(a.vertex) << " -- Norm : " << glm::to_string(a.normal) << " -- Tex : " << a.texcoord[0] << " " << a.texcoord[1] << " ";
-            return os;
+            std::vector<unsigned int>().swap(low);
+            std::vector<unsigned short>().swap(high);
         }
     };
 
-    enum FaceType { TRIANGLE = 0,
-                    QUAD };
     /** @ingroup OBJ-MTL
-                   OBJ face.
+                   OBJ faces of a smooth group, stored in contiguous arrays :
+                   vertex, texture and normal indices of each corner, and the
+                   number of corners (3 or more) of each face.
+                   Texture and normal indices are stored when the first face has them.
                 */
-    class Face {
+    class FaceList {
         friend class ObjLoader;
-        int vertices[4];
-        int normals[4];
-        int textures[4];
+        IndexArray vertices;
+        IndexArray textures;
+        IndexArray normals;
+        std::vector<unsigned short> corners;
         bool have[2];
-        FaceType type;
 
     public:
-        Face(int s0, int s1, int s2)
+        FaceList()
         {
-            vertices[0] = s0;
-            vertices[1] = s1;
-            vertices[2] = s2;
             have[NORMALS] = have[TEXTURES] = false;
-            type = TRIANGLE;
         }
-        Face(int s0, int s1, int s2, int s3)
-        {
-            vertices[0] = s0;
-            vertices[1] = s1;
-            vertices[2] = s2;
-            vertices[3] = s3;
-            have[NORMALS] = have[TEXTURES] = false;
-            type = QUAD;
-        }
-
-        Face(int s0, int s1, int s2, int n0, int n1, int n2)
+        /* Indices OBJ (a partir de 1), t et n nuls si absents */
+        void add(int cornersNumber, const Obj_mtl::index_type* v, const Obj_mtl::index_type* t, const Obj_mtl::index_type* n)
         {
-            vertices[0] = s0;
-            vertices[1] = s1;
-            vertices[2] = s2;
-            normals[0] = n0;
-            normals[1] = n1;
-            normals[2] = n2;
-            have[NORMALS] = true;
-            have[TEXTURES] = false;
-            type = TRIANGLE;
+            if (corners.empty()) {
+                have[TEXTURES] = (t != 0);
+                have[NORMALS] = (n != 0);
+            }
+            corners.push_back((unsigned short)cornersNumber);
+            for (int c = 0; c < cornersNumber; ++c) {
+                vertices.push_back(v[c] - 1);
+                if (have[TEXTURES])
+                    textures.push_back(t ? t[c] - 1 : 0);
+                if (have[NORMALS])
+                    normals.push_back(n ? n[c] - 1 : 0);
+            }
         }
-
-        Face(int s0, int s1, int s2, int s3, int n0, int n1, int n2, int n3)
+        std::size_t size() const
         {
-            vertices[0] = s0;
-            vertices[1] = s1;
-            vertices[2] = s2;
-            vertices[3] = s3;
-            normals[0] = n0;
-            normals[1] = n1;
-            normals[2] = n2;
-            normals[3] = n3;
-            have[NORMALS] = true;
-            have[TEXTURES] = false;
-            type = QUAD;
+            return corners.size();
         }
-
-        Face(int s0, int s1, int s2, int t0, int t1, int t2, bool)
+        bool empty() const
         {
-            vertices[0] = s0;
-            vertices[1] = s1;
-            vertices[2] = s2;
-            textures[0] = t0;
-            textures[1] = t1;
-            textures[2] = t2;
-            have[NORMALS] = false;
-            have[TEXTURES] = true;
-            type = TRIANGLE;
+            return corners.empty();
         }
-
-        Face(int s0, int s1, int s2, int s3, int t0, int t1, int t2, int t3, bool)
+        // octets alloues
+        std::size_t memory() const
         {
-            vertices[0] = s0;
-            vertices[1] = s1;
-            vertices[2] = s2;
-            vertices[3] = s3;
-            textures[0] = t0;
-            textures[1] = t1;
-            textures[2] = t2;
-            textures[3] = t3;
-            have[NORMALS] = false;
-            have[TEXTURES] = true;
-            type = QUAD;
+            return vertices.memory() + textures.memory() + normals.memory() + corners.capacity() * sizeof(unsigned short);
         }
-
-        Face(int s0, int s1, int s2, int n0, int n1, int n2, int t0, int t1, int t2)
+        void clear()
         {
-            vertices[0] = s0;
-            vertices[1] = s1;
-            vertices[2] = s2;
-            normals[0] = n0;
-            normals[1] = n1;
-            normals[2] = n2;
-            textures[0] = t0;
-            textures[1] = t1;
-            textures[2] = t2;
-            have[NORMALS] = have[TEXTURES] = true;
-            type = TRIANGLE;
-        }
-
-        Face(int s0, int s1, int s2, int s3, int n0, int n1, int n2, int n3, int t0, int t1, int t2, int t3)
-        {
-            vertices[0] = s0;
-            vertices[1] = s1;
-            vertices[2] = s2;
-            vertices[3] = s3;
-            normals[0] = n0;
-            normals[1] = n1;
-            normals[2] = n2;
-            normals[3] = n3;
-            textures[0] = t0;
-            textures[1] = t1;
-            textures[2] = t2;
-            textures[3] = t3;
-            have[NORMALS] = have[TEXTURES] = true;
-            type = QUAD;
+            vertices.clear();
+            textures.clear();
+            normals.clear();
+            std::vector<unsigned short>().swap(corners);
         }
     };
-    typedef std::vector<Face*> FaceList;
 
     /** @ingroup OBJ-MTL
                    OBJ group.
@@ -333,7 +539,7 @@ private:
     class Group {
         friend class ObjLoader;
         std::string name;
-        std::string material;
+        int material; // identifiant de materiau, -1 : "default"
         int smoothGroup;
         std::map<int, FaceList> faces;
         bool empty;
@@ -341,7 +547,7 @@ private:
     public:
         Group(std::string n)
             : name(n)
-            , material("default")
+            , material(-1)
             , smoothGroup(0)
         {
             empty = true;
@@ -350,18 +556,18 @@ private:
         {
             smoothGroup = s;
         }
-        void setMaterial(std::string m)
+        void setMaterial(int m)
         {
             material = m;
         }
-        std::string getMaterial()
+        int getMaterial()
         {
             return material;
         }
-        void addFace(Face* f)
+        void addFace(int cornersNumber, const Obj_mtl::index_type* v, const Obj_mtl::index_type* t, const Obj_mtl::index_type* n)
         {
             empty = false;
-            faces[smoothGroup].push_back(f);
+            faces[smoothGroup].add(cornersNumber, v, t, n);
         }
         FaceList& getFaces(int s = 0)
         {
@@ -374,79 +580,80 @@ private:
     std::map<std::string, Group*> allgroups;
     int groupsNumber;
 
-    /** @ingroup OBJ-MTL
-                   OBJ material.
-                */
-    class mtlMaterial {
-    public:
-        std::string name;
-
-        float Ka[3];
-        float Kd[3];
-        float Ks[3];
-        float Tf[3];
-
-        int illum;
-        float shininess;
-        float sharpness;
-        float dissolve;
-        float ior;
-
-        //std::string dissolve;
-        std::string map_ka;
-        glm::vec3 map_ka_scale;
-
-        std::string map_kd;
-        glm::vec3 map_kd_scale;
-
-        std::string map_ks;
-        glm::vec3 map_ks_scale;
-
-        std::string map_Ns;
-        glm::vec3 map_Ns_scale;
-
-        std::string map_d;
-        glm::vec3 map_d_scale;
-
-        std::string dispmap;
-
-        std::string decalmap;
-
-        std::string normalmap;
-
-        std::string bumpmap;
-        glm::vec3 bumpmap_scale;
-
-        std::string reflmap;
-
-        mtlMaterial(std::string n)
-            : name(n)
-        {
-            map_kd_scale = glm::vec3(1.0, 1.0, 1.0);
-            map_ks_scale = glm::vec3(1.0, 1.0, 1.0);
-            map_Ns_scale = glm::vec3(1.0, 1.0, 1.0);
-            bumpmap_scale = glm::vec3(1.0, 1.0, 1.0);
-            dissolve = 1.;
-        }
-    };
     mtlMaterial* currentMaterial;
-    std::map<std::string, mtlMaterial*> mtllib;
-    int materialNumber;
 
-    int faceType(Face* f);
+    int faceType(const FaceList& faces);
+    // identifiant du materiau "name", ajoute au premier usage
+    int materialId(const std::string& name);
+    // materiau defini par la premiere bibliotheque de mLibraries, 0 sinon
+    const mtlMaterial* findMaterial(const std::string& name) const;
+    // materiaux des identifiants pas encore resolus
+    void resolveMaterials();
 
     // -------------------------
 
 private:
-    void addVerticeNormalTexturePart(ObjMesh* mesh, FaceList& faces, int num);
-    void addVerticeNormalPart(ObjMesh* mesh, FaceList& faces, int num);
-    void addVerticeTexturePart(ObjMesh* mesh, FaceList& faces, int num);
-    void addVerticePart(ObjMesh* mesh, FaceList& faces, int num);
-
-    void addRawVerticeNormalTexturePart(ObjMesh* mesh, FaceList& faces, int num);
-    void addRawVerticeNormalPart(ObjMesh* mesh, FaceList& faces, int num);
-    void addRawVerticeTexturePart(ObjMesh* mesh, FaceList& faces, int num);
-    void addRawVerticePart(ObjMesh* mesh, FaceList& faces, int num);
+    // morceau d'une partie : faces consecutives dont les sommets (au plus
+    // mMaxMeshVertices) sont numerotes a partir de 0, et sa destination
+    struct Chunk {
+        std::size_t firstTriangle; // dans Part::triangles
+        std::size_t trianglesNumber;
+        std::size_t firstSource; // dans Part::sources, ou premier coin sans soudure
+        std::size_t verticesNumber;
+        float* vertices;
+        unsigned int* triangles;
+        unsigned int firstVertex; // dans le maillage de destination
+    };
+    // partie de maillage (smooth group) : triangles et coin source de chaque
+    // sommet, calcules avant l'ecriture des sommets (tailles exactes)
+    struct Part {
+        FaceList* faces;
+        bool welded;
+        std::vector<unsigned int> triangles; // indices locaux a chaque morceau
+        std::vector<std::size_t> sources; // vide sans soudure : un sommet par coin
+        std::vector<Chunk> chunks;
+    };
+    // Etape 1 : indices des triangles (quadrilateres et polygones triangules,
+    // voir Obj_mtl::polygon_triangulator), sommets soudes sur les triplets
+    // d'indices (smooth group non nul) ; attributs des sommets (normales,
+    // coordonnees de texture) et soudure choisis a la compilation. Un
+    // nouveau morceau commence avant la face qui pourrait depasser
+    // mMaxMeshVertices ou mMaxMeshTriangles.
+    template <bool Normals, bool Textures, bool Welded>
+    void indexPart(Part& part);
+    void indexPart(Part& part);
+    // Etape 2 : sommets entrelaces (x, y, z, nx, ny, nz, u, v) et triangles
+    // de chaque morceau ecrits a sa destination, les faces sont liberees
+    template <bool Normals, bool Textures, bool Welded>
+    void writePart(Part& part);
+    void writePart(Part& part);
+    // maillages des groupes ecrits dans sink (un ou plusieurs par groupe,
+    // groupe de chaque maillage dans meshGroups), les faces sont liberees
+    void buildGroups(const std::vector<Group*>& groups, Loaders::MeshSink& sink, std::vector<std::size_t>& meshGroups);
+    // maillages des groupes ou du cache ecrits dans sink, les groupes sont detruits
+    void buildObjects(Loaders::MeshSink& sink, std::vector<int>& materialIds, std::vector<std::string>* names);
+    // maillages d'un groupe envoyes a mMeshCallback, les faces du groupe
+    // sont liberees
+    void compileGroup(Group* group);
+    // soudure des maillages [first, meshes.size()) selon mWeldTolerance
+    void weldMeshes(std::vector<Loaders::Mesh*>& meshes, std::size_t first);
+    // ordre des triangles et des sommets des maillages [first, meshes.size())
+    // pour le cache de sommets (mVertexCacheSize)
+    void optimizeMeshes(std::vector<Loaders::Mesh*>& meshes, std::size_t first);
+    // memoire des faces (et economie par rapport a une allocation par face)
+    std::string memoryMessage() const;
+    void connectParser(Obj_mtl::obj_batch_parser* parser, const std::string& filename, const std::string& dirname);
+    // analyse d'une bibliotheque de materiaux dans library
+    void parseMaterialFile(const std::string& filename, MaterialLibrary& library);
+    // bibliotheque partagee ajoutee a mLibraries
+    void useSharedLibrary(const std::string& filename);
+
+    // cache binaire
+    std::string cachePath(const QString& filename) const;
+    bool readCache(const std::string& cacheFile, const std::string& filename);
+    void writeCache(const std::vector<std::string>& names, const std::vector<int>& materialIds, Loaders::Mesh* const* meshes);
+    static void writeMaterial(Loaders::CacheWriter& cache, const mtlMaterial& material);
+    static bool readMaterial(Loaders::CacheReader& cache, MaterialLibrary& library);
 
 protected:
     // Callbacks de log
@@ -454,112 +661,17 @@ protected:
     void warning_callback(const std::string& filename, std::size_t line_number, const std::string& message);
     void error_callback(const std::string& filename, std::size_t line_number, const std::string& message);
 
-    // Callback de sommets
-    void vertex_callback(float x, float y, float z)
-    {
-        verticesTable.push_back(glm::vec3(x, y, z));
-        vertices++;
-    }
-    void normal_callback(float nx, float ny, float nz)
-    {
-        normalsTable.push_back(glm::vec3(nx, ny, nz));
-        normals++;
-    }
-    void texture_callback(float u, float v)
-    {
-        texturesTable.push_back(glm::vec3(u, v, 0.0));
-        textures++;
-    }
-
-    // Callbacks de faces
-    void add_face_T_vertices(int i0, int i1, int i2)
-    {
-        currentGroup->addFace(new Face(i0 - 1, i1 - 1, i2 - 1));
-    }
-    void add_face_Q_vertices(int i0, int i1, int i2, int i3)
-    {
-        currentGroup->addFace(new Face(i0 - 1, i1 - 1, i2 - 1, i3 - 1));
-    }
-
-    void add_face_T_vertices_textures(const Obj_mtl::index_2_tuple_type& v1_vt1, const Obj_mtl::index_2_tuple_type& v2_vt2, const Obj_mtl::index_2_tuple_type& v3_vt3)
-    {
-        currentGroup->addFace(new Face(
-            std::get<0>(v1_vt1) - 1,
-            std::get<0>(v2_vt2) - 1,
-            std::get<0>(v3_vt3) - 1,
-            std::get<1>(v1_vt1) - 1,
-            std::get<1>(v2_vt2) - 1,
-            std::get<1>(v3_vt3) - 1,
-            true));
-    }
-
-    void add_face_Q_vertices_textures(const Obj_mtl::index_2_tuple_type& v1_vt1, const Obj_mtl::index_2_tuple_type& v2_vt2, const Obj_mtl::index_2_tuple_type& v3_vt3, const Obj_mtl::index_2_tuple_type& v4_vt4)
-    {
-        currentGroup->addFace(new Face(
-            std::get<0>(v1_vt1) - 1,
-            std::get<0>(v2_vt2) - 1,
-            std::get<0>(v3_vt3) - 1,
-            std::get<0>(v4_vt4) - 1,
-            std::get<1>(v1_vt1) - 1,
-            std::get<1>(v2_vt2) - 1,
-            std::get<1>(v3_vt3) - 1,
-            std::get<1>(v4_vt4) - 1, true));
-    }
-
-    void add_face_T_vertices_normals(const Obj_mtl::index_2_tuple_type& v1_vn1, const Obj_mtl::index_2_tuple_type& v2_vn2, const Obj_mtl::index_2_tuple_type& v3_vn3)
-    {
-        currentGroup->addFace(new Face(
-            std::get<0>(v1_vn1) - 1,
-            std::get<0>(v2_vn2) - 1,
-            std::get<0>(v3_vn3) - 1,
-            std::get<1>(v1_vn1) - 1,
-            std::get<1>(v2_vn2) - 1,
-            std::get<1>(v3_vn3) - 1));
-    }
-
-    void add_face_Q_vertices_normals(const Obj_mtl::index_2_tuple_type& v1_vn1, const Obj_mtl::index_2_tuple_type& v2_vn2, const Obj_mtl::index_2_tuple_type& v3_vn3, const Obj_mtl::index_2_tuple_type& v4_vn4)
-    {
-        currentGroup->addFace(new Face(
-            std::get<0>(v1_vn1) - 1,
-            std::get<0>(v2_vn2) - 1,
-            std::get<0>(v3_vn3) - 1,
-            std::get<0>(v4_vn4) - 1,
-            std::get<1>(v1_vn1) - 1,
-            std::get<1>(v2_vn2) - 1,
-            std::get<1>(v3_vn3) - 1,
-            std::get<1>(v4_vn4) - 1));
-    }
-
-    void add_face_T_vertices_textures_normals(const Obj_mtl::index_3_tuple_type& v1_vtn1, const Obj_mtl::index_3_tuple_type& v2_vtn2, const Obj_mtl::index_3_tuple_type& v3_vtn3)
-    {
-        currentGroup->addFace(new Face(
-            std::get<0>(v1_vtn1) - 1,
-            std::get<0>(v2_vtn2) - 1,
-            std::get<0>(v3_vtn3) - 1,
-            std::get<2>(v1_vtn1) - 1,
-            std::get<2>(v2_vtn2) - 1,
-            std::get<2>(v3_vtn3) - 1,
-            std::get<1>(v1_vtn1) - 1,
-            std::get<1>(v2_vtn2) - 1,
-            std::get<1>(v3_vtn3) - 1));
-    }
+    // Callbacks de blocs de sommets et de faces
+    void add_vertices(const float* xyz, std::size_t count);
+    void add_normals(const float* xyz, std::size_t count);
+    void add_textures(const float* uv, std::size_t count);
+    void add_faces(const Obj_mtl::face_block& block);
 
-    void add_face_Q_vertices_textures_normals(const Obj_mtl::index_3_tuple_type& v1_vtn1, const Obj_mtl::index_3_tuple_type& v2_vtn2, const Obj_mtl::index_3_tuple_type& v3_vtn3, const Obj_mtl::index_3_tuple_type& v4_vtn4)
-    {
-        currentGroup->addFace(new Face(
-            std::get<0>(v1_vtn1) - 1,
-            std::get<0>(v2_vtn2) - 1,
-            std::get<0>(v3_vtn3) - 1,
-            std::get<0>(v4_vtn4) - 1,
-            std::get<2>(v1_vtn1) - 1,
-            std::get<2>(v2_vtn2) - 1,
-            std::get<2>(v3_vtn3) - 1,
-            std::get<2>(v4_vtn4) - 1,
-            std::get<1>(v1_vtn1) - 1,
-            std::get<1>(v2_vtn2) - 1,
-            std::get<1>(v3_vtn3) - 1,
-            std::get<1>(v4_vtn4) - 1));
-    }
+    // Face de cornersNumber coins (indices consecutifs), attributes
+    // combinaison de Obj_mtl::obj_face::Attributes
+    void add_face(int cornersNumber, unsigned char attributes, const Obj_mtl::index_type* v, const Obj_mtl::index_type* vt, const Obj_mtl::index_type* vn);
+    // Faces et etats d'un fichier analyse en parallele
+    void add_geometry(const Obj_mtl::obj_geometry& geometry, const std::string& dirname);
 
     // Callback de groupes
     void set_group(const std::string& name)
@@ -579,6 +691,9 @@ protected:
         }
     }
 
+    // Callback de groupes d'un chargement en flux : le groupe courant est termine
+    void stream_group(const std::string& name);
+
     // Callback de smoothing-group
     void smooth_group(int num)
     {
@@ -587,189 +702,17 @@ protected:
     // Callback de materiau
     void set_material(const std::string& name)
     {
-        currentGroup->setMaterial(name);
+        currentGroup->setMaterial(materialId(name));
     }
 
     void parse_material_library(const std::string& dirname, const std::string& filename);
 
     // Callback de materiau
-    void new_material(const std::string& name)
-    {
-        std::map<std::string, mtlMaterial*>::iterator mat = mtllib.find(name);
-        if (mat == mtllib.end()) {
-            currentMaterial = new mtlMaterial(name);
-            mtllib[name] = currentMaterial;
-            materialNumber++;
-        }
-        else {
-            std::cerr << "WARNING : duplicate material " << name << std::endl;
-            currentMaterial = mat->second;
-        }
-    }
-
-    void material_map_Kd(std::string texture)
-    {
-        // analyse de la chaine
-        if (texture[0] == '-') {
-            char minus, arg;
-            std::istringstream stringstream(texture);
-            stringstream.unsetf(std::ios_base::skipws);
-            stringstream >> minus >> arg >> std::ws;
-            switch (arg) {
-            case 's':
-                float sx, sy, sz;
-                stringstream >> sx >> std::ws >> sy >> std::ws >> sz >> std::ws;
-                currentMaterial->map_kd_scale = glm::vec3(sx, sy, sz);
-                break;
-            default:
-                std::cerr << "material_map_Kd : argument inconnu " << arg << std::endl;
-            }
-            std::string filename;
-            stringstream >> filename;
-            currentMaterial->map_kd = filename;
-        }
-        else {
-            std::istringstream stringstream(texture);
-            stringstream.unsetf(std::ios_base::skipws);
-            std::string filename;
-            stringstream >> filename;
-            currentMaterial->map_kd = filename;
-        }
-    }
-
-
-    void material_map_Ks(std::string texture)
-    {
-        // analyse de la chaine
-        if (texture[0] == '-') {
-            char minus, arg;
-            std::istringstream stringstream(texture);
-            stringstream.unsetf(std::ios_base::skipws);
-            stringstream >> minus >> arg >> std::ws;
-            switch (arg) {
-            case 's':
-                float sx, sy, sz;
-                stringstream >> sx >> std::ws >> sy >> std::ws >> sz >> std::ws;
-                currentMaterial->map_ks_scale = glm::vec3(sx, sy, sz);
-                break;
-            default:
-                std::cerr << "material_map_Ks : argument inconnu " << arg << std::endl;
-            }
-            std::string filename;
-            stringstream >> filename;
-            currentMaterial->map_ks = filename;
-        }
-        else {
-            std::istringstream stringstream(texture);
-            stringstream.unsetf(std::ios_base::skipws);
-            std::string filename;
-            stringstream >> filename;
-            currentMaterial->map_ks = filename;
-        }
-    }
-
-    void material_map_Ns(std::string texture)
-    {
-        // analyse de la chaine
-        if (texture[0] == '-') {
-            char minus, arg;
-            std::istringstream stringstream(texture);
-            stringstream.unsetf(std::ios_base::skipws);
-            stringstream >> minus >> arg >> std::ws;
-            switch (arg) {
-            case 's':
-                float sx, sy, sz;
-                stringstream >> sx >> std::ws >> sy >> std::ws >> sz >> std::ws;
-                currentMaterial->map_Ns_scale = glm::vec3(sx, sy, sz);
-                break;
-            default:
-                std::cerr << "material_map_Ns : argument inconnu " << arg << std::endl;
-            }
-            std::string filename;
-            stringstream >> filename;
-            currentMaterial->map_Ns = filename;
-        }
-        else {
-            std::istringstream stringstream(texture);
-            stringstream.unsetf(std::ios_base::skipws);
-            std::string filename;
-            stringstream >> filename;
-            currentMaterial->map_Ns = filename;
-        }
-    }
-
-
-    void material_map_d(std::string texture)
-    {
-        // analyse de la chaine
-        if (texture[0] == '-') {
-            char minus, arg;
-            std::istringstream stringstream(texture);
-            stringstream.unsetf(std::ios_base::skipws);
-            stringstream >> minus >> arg >> std::ws;
-            switch (arg) {
-            case 's':
-                float sx, sy, sz;
-                stringstream >> sx >> std::ws >> sy >> std::ws >> sz >> std::ws;
-                currentMaterial->map_d_scale = glm::vec3(sx, sy, sz);
-                break;
-            default:
-                std::cerr << "material_map_d : argument inconnu " << arg << std::endl;
-            }
-            std::string filename;
-            stringstream >> filename;
-            currentMaterial->map_d = filename;
-        }
-        else {
-            std::istringstream stringstream(texture);
-            stringstream.unsetf(std::ios_base::skipws);
-            std::string filename;
-            stringstream >> filename;
-            currentMaterial->map_d = filename;
-        }
-    }
-
-
-    void material_bump(std::string texture)
-    {
-        // analyse de la chaine
-        if (texture[0] == '-') {
-            char minus, arg;
-            std::istringstream stringstream(texture);
-            stringstream.unsetf(std::ios_base::skipws);
-            stringstream >> minus >> arg >> std::ws;
-            switch (arg) {
-            case 's':
-                float sx, sy, sz;
-                stringstream >> sx >> std::ws >> sy >> std::ws >> sz >> std::ws;
-                currentMaterial->bumpmap_scale = glm::vec3(sx, sy, sz);
-                break;
-            default:
-                std::cerr << "material_bump : argument inconnu " << arg << std::endl;
-            }
-            std::string filename;
-            stringstream >> filename;
-            currentMaterial->bumpmap = filename;
-        }
-        else {
-            std::istringstream stringstream(texture);
-            stringstream.unsetf(std::ios_base::skipws);
-            std::string filename;
-            stringstream >> filename;
-            currentMaterial->bumpmap = filename;
-        }
-    }
-
-    void material_normal(std::string texture)
-    {
-        std::cerr << "material_normal : " << texture << std::endl;
-        std::istringstream stringstream(texture);
-        stringstream.unsetf(std::ios_base::skipws);
-        std::string filename;
-        stringstream >> filename;
-        currentMaterial->normalmap = filename;
-    }
+    void new_material(const std::string& name);
 
+    // texture (map_Kd, bump...) : options puis chemin du fichier, interne
+    // dans la bibliotheque ; seule l'option -s (echelle) est conservee
+    void material_map(const std::string& statement, int& texture, glm::vec3* scale);
 
     void material_Ka(float r, float g, float b)
     {
@@ -795,23 +738,109 @@ protected:
         currentMaterial->Tf[1] = g;
         currentMaterial->Tf[2] = b;
     }
+    // Callback de bloc de materiau (couleurs et textures)
+    void material_block(const Obj_mtl::mtl_material_block& block);
+
+    // instruction avant le premier newmtl : ignoree avec un avertissement
+    bool hasCurrentMaterial(const char* statement) const;
+
     void material_shininess(float n)
     {
-        currentMaterial->shininess = n;
+        if (hasCurrentMaterial("Ns"))
+            currentMaterial->shininess = n;
     }
+    void material_sharpness(float n)
+    {
+        if (hasCurrentMaterial("sharpness"))
+            currentMaterial->sharpness = n;
+    }
+    void material_ior(float n)
+    {
+        if (hasCurrentMaterial("Ni"))
+            currentMaterial->ior = n;
+    }
+    void material_illum(int i)
+    {
+        if (hasCurrentMaterial("illum"))
+            currentMaterial->illum = i;
+    }
+
+    void material_dissolve(const std::string& d);
+};
 
-    void material_dissolve(std::string d)
+/** @ingroup OBJ-MTL
+    Materials of a MTL file in a flat array. Material names and texture
+    paths are interned into integer IDs : the index of the material in the
+    library, and the index of the path in its table of textures (a texture
+    used by several materials is stored once). Read only once parsed.
+*/
+class MaterialLibrary {
+public:
+    /// Empty library, relative texture paths are completed with "directory"
+    explicit MaterialLibrary(const std::string& directory)
+        : mDirectory(directory)
     {
-        if (d[0] != '-') {
-            float value;
-            std::istringstream stringstream(d);
-            stringstream >> value;
-            currentMaterial->dissolve = value;
-        }
-        else {
-            std::cerr << "TODO : manage parameterized dissolve" << std::endl;
-        }
     }
+
+    /// ID of the material "name", -1 if the library doesn't define it
+    int find(const std::string& name) const;
+    /// Number of materials
+    std::size_t size() const { return mMaterials.size(); }
+    const ObjLoader::mtlMaterial& material(int id) const { return mMaterials[id]; }
+    ObjLoader::mtlMaterial& material(int id) { return mMaterials[id]; }
+
+    /// Number of distinct texture paths
+    std::size_t texturesNumber() const { return mTextures.size(); }
+    /// Path of the texture "id", see ObjLoader::mtlMaterial::texturePath()
+    std::string texturePath(int id) const;
+
+    /// ID of a new material "name", or of the material already named so
+    /// (duplicated newmtl)
+    int addMaterial(const std::string& name);
+    /// ID of the texture path "path", added at the first call
+    int addTexture(const std::string& path);
+
+private:
+    std::string mDirectory;
+    std::vector<ObjLoader::mtlMaterial> mMaterials;
+    std::unordered_map<std::string, int> mMaterialIds;
+    std::vector<std::string> mTextures;
+    std::unordered_map<std::string, int> mTextureIds;
+
+    MaterialLibrary(const MaterialLibrary&);
+    MaterialLibrary& operator=(const MaterialLibrary&);
+};
+
+/** @ingroup OBJ-MTL
+    Material libraries shared by several #ObjLoader (see
+    ObjLoader::setMaterialLibraries()), for instance the loaders of a scene
+    running concurrently : each library is parsed once, by the first loader
+    which uses it, then its materials are read only. Thread safe.
+*/
+class MaterialLibraries {
+public:
+    /// Parse of a library into an empty #MaterialLibrary
+    typedef std::function<void(MaterialLibrary&)> Parser;
+
+    MaterialLibraries() {}
+
+    /// Materials of the library "filename" : parsed by "parse" at the first
+    /// call, the other callers wait for the end of this parse.
+    const MaterialLibrary& library(const std::string& filename, const Parser& parse);
+
+    /// Number of libraries
+    std::size_t size() const;
+
+private:
+    struct Entry {
+        std::once_flag parsed;
+        std::unique_ptr<MaterialLibrary> materials;
+    };
+    mutable std::mutex mMutex;
+    std::map<std::string, std::unique_ptr<Entry> > mLibraries;
+
+    MaterialLibraries(const MaterialLibraries&);
+    MaterialLibraries& operator=(const MaterialLibraries&);
 };
 
 } // END namespace obj =========================================================
@@ -54,12 +54,10 @@ void ObjMesh::printfInfo() const {
 
 }
 
-Mesh *ObjMesh::compile(){
-    int nbParts = parts.size();
-    Mesh * result = new Mesh();
-    for (int i = 0; i < nbParts; i++)
-        *result += *parts[i];
-    return result;
+Mesh *ObjMesh::compile(unsigned threadCount){
+    // une seule allocation et copie parallele des parties
+    std::vector<const Mesh *> meshes(parts.begin(), parts.end());
+    return new Mesh(meshes, threadCount);
 }
 
 // -------------------------------------------------------
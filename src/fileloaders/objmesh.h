@@ -65,7 +65,9 @@ public:
         nbTriangles = mNbTri;
     }
 
-    Mesh * compile();
+    /// Concatenation of the smooth groups, copied by threadCount threads
+    /// (0 : all cores).
+    Mesh * compile(unsigned threadCount = 0);
 
     std::string getName(){ return mName; }
 
@@ -0,0 +1,410 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#include "objparallelparser.h"
+#include "objbasicparser.h"
+#include "mappedfile.h"
+#include "compressedfile.h"
+#include "parallel.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+namespace Loaders {
+
+namespace {
+
+using namespace Obj_mtl;
+
+// chunks smaller than that are not worth a thread
+const std::size_t minimal_chunk_size = 1 << 20;
+
+struct chunk_type {
+    const char* begin;
+    const char* end;
+    // totals of the preceding chunks, then totals at the end of this chunk
+    obj_parser::statistics statistics;
+    obj_geometry geometry;
+    std::vector<std::pair<std::size_t, std::string> > warnings;
+    bool failed;
+    std::size_t error_line;
+    std::string error_message;
+};
+
+// Count the lines and the vertices of a chunk (first pass).
+void count(const char* begin, const char* end, obj_parser::statistics& statistics)
+{
+    using namespace tokenizer;
+    const char* line = begin;
+    while (line != end) {
+        const char* eol = line_end(line, end);
+        ++statistics.line_number;
+        const char* p = line;
+        skip_space(p, eol);
+        if (p != eol && *p == 'v') {
+            ++p;
+            if (p == eol || is_space(*p)) {
+                ++statistics.number_of_geometric_vertices;
+            }
+            else if ((*p == 't' || *p == 'n') && (p + 1 == eol || is_space(p[1]))) {
+                if (*p == 't') {
+                    ++statistics.number_of_texture_vertices;
+                }
+                else {
+                    ++statistics.number_of_vertex_normals;
+                }
+            }
+        }
+        line = (eol == end) ? end : eol + 1;
+    }
+}
+
+void add_statement(obj_geometry& geometry, obj_statement::Kind kind, const std::string& name, size_type smoothing_group_number = 0)
+{
+    obj_statement statement;
+    statement.kind = kind;
+    statement.face = geometry.faces.size();
+    statement.smoothing_group_number = smoothing_group_number;
+    statement.name = name;
+    geometry.statements.push_back(statement);
+}
+
+// Fill the geometry, the warnings and the error of a chunk.
+class chunk_handler : public obj_handler {
+public:
+    explicit chunk_handler(chunk_type& chunk)
+        : chunk_(chunk)
+        , geometry_(chunk.geometry)
+        , polygon_(false)
+    {
+    }
+
+    void warning(std::size_t line_number, const std::string& message)
+    {
+        chunk_.warnings.push_back(std::make_pair(line_number, message));
+    }
+    void error(std::size_t line_number, const std::string& message)
+    {
+        // the chunk is kept up to the error, without an unfinished polygon
+        if (polygon_) {
+            std::size_t size = geometry_.face_v.size() - geometry_.faces.back().size;
+            geometry_.face_v.resize(size);
+            geometry_.face_vt.resize(size);
+            geometry_.face_vn.resize(size);
+            geometry_.faces.pop_back();
+            polygon_ = false;
+        }
+        chunk_.error_line = line_number;
+        chunk_.error_message = message;
+    }
+
+    void geometric_vertex(float_type x, float_type y, float_type z)
+    {
+        geometry_.geometric_vertices.push_back(x);
+        geometry_.geometric_vertices.push_back(y);
+        geometry_.geometric_vertices.push_back(z);
+    }
+    void texture_vertex(float_type u, float_type v)
+    {
+        geometry_.texture_vertices.push_back(u);
+        geometry_.texture_vertices.push_back(v);
+    }
+    void vertex_normal(float_type x, float_type y, float_type z)
+    {
+        geometry_.vertex_normals.push_back(x);
+        geometry_.vertex_normals.push_back(y);
+        geometry_.vertex_normals.push_back(z);
+    }
+
+    void triangular_face_geometric_vertices(index_type v1, index_type v2, index_type v3)
+    {
+        face_vertex_type c1 = { v1, 0, 0 }, c2 = { v2, 0, 0 }, c3 = { v3, 0, 0 };
+        triangle(0, c1, c2, c3);
+    }
+    void triangular_face_geometric_vertices_texture_vertices(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        triangle(obj_face::has_texture_vertices, v1, v2, v3);
+    }
+    void triangular_face_geometric_vertices_vertex_normals(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        triangle(obj_face::has_vertex_normals, v1, v2, v3);
+    }
+    void triangular_face_geometric_vertices_texture_vertices_vertex_normals(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        triangle(obj_face::has_texture_vertices | obj_face::has_vertex_normals, v1, v2, v3);
+    }
+
+    void quadrilateral_face_geometric_vertices(index_type v1, index_type v2, index_type v3, index_type v4)
+    {
+        face_vertex_type c1 = { v1, 0, 0 }, c2 = { v2, 0, 0 }, c3 = { v3, 0, 0 }, c4 = { v4, 0, 0 };
+        quadrilateral(0, c1, c2, c3, c4);
+    }
+    void quadrilateral_face_geometric_vertices_texture_vertices(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3, const face_vertex_type& v4)
+    {
+        quadrilateral(obj_face::has_texture_vertices, v1, v2, v3, v4);
+    }
+    void quadrilateral_face_geometric_vertices_vertex_normals(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3, const face_vertex_type& v4)
+    {
+        quadrilateral(obj_face::has_vertex_normals, v1, v2, v3, v4);
+    }
+    void quadrilateral_face_geometric_vertices_texture_vertices_vertex_normals(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3, const face_vertex_type& v4)
+    {
+        quadrilateral(obj_face::has_texture_vertices | obj_face::has_vertex_normals, v1, v2, v3, v4);
+    }
+
+    void polygonal_face_geometric_vertices_begin(index_type v1, index_type v2, index_type v3)
+    {
+        face_vertex_type c1 = { v1, 0, 0 }, c2 = { v2, 0, 0 }, c3 = { v3, 0, 0 };
+        polygon_begin(0, c1, c2, c3);
+    }
+    void polygonal_face_geometric_vertices_vertex(index_type v)
+    {
+        face_vertex_type c = { v, 0, 0 };
+        polygon_vertex(c);
+    }
+    void polygonal_face_geometric_vertices_end() { polygon_ = false; }
+    void polygonal_face_geometric_vertices_texture_vertices_begin(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        polygon_begin(obj_face::has_texture_vertices, v1, v2, v3);
+    }
+    void polygonal_face_geometric_vertices_texture_vertices_vertex(const face_vertex_type& v) { polygon_vertex(v); }
+    void polygonal_face_geometric_vertices_texture_vertices_end() { polygon_ = false; }
+    void polygonal_face_geometric_vertices_vertex_normals_begin(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        polygon_begin(obj_face::has_vertex_normals, v1, v2, v3);
+    }
+    void polygonal_face_geometric_vertices_vertex_normals_vertex(const face_vertex_type& v) { polygon_vertex(v); }
+    void polygonal_face_geometric_vertices_vertex_normals_end() { polygon_ = false; }
+    void polygonal_face_geometric_vertices_texture_vertices_vertex_normals_begin(const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        polygon_begin(obj_face::has_texture_vertices | obj_face::has_vertex_normals, v1, v2, v3);
+    }
+    void polygonal_face_geometric_vertices_texture_vertices_vertex_normals_vertex(const face_vertex_type& v) { polygon_vertex(v); }
+    void polygonal_face_geometric_vertices_texture_vertices_vertex_normals_end() { polygon_ = false; }
+
+    void group_name(const std::string& name) { add_statement(geometry_, obj_statement::group_name, name); }
+    void smoothing_group(size_type number) { add_statement(geometry_, obj_statement::smoothing_group, std::string(), number); }
+    void object_name(const std::string& name) { add_statement(geometry_, obj_statement::object_name, name); }
+    void material_library(const std::string& name) { add_statement(geometry_, obj_statement::material_library, name); }
+    void material_name(const std::string& name) { add_statement(geometry_, obj_statement::material_name, name); }
+
+private:
+    void add_face(unsigned short size, unsigned char attributes)
+    {
+        obj_face face;
+        face.size = size;
+        face.attributes = attributes;
+        geometry_.faces.push_back(face);
+    }
+    void corner(const face_vertex_type& vertex)
+    {
+        geometry_.face_v.push_back(vertex.v);
+        geometry_.face_vt.push_back(vertex.vt);
+        geometry_.face_vn.push_back(vertex.vn);
+    }
+    void triangle(unsigned char attributes, const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        add_face(3, attributes);
+        corner(v1), corner(v2), corner(v3);
+    }
+    void quadrilateral(unsigned char attributes, const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3, const face_vertex_type& v4)
+    {
+        add_face(4, attributes);
+        corner(v1), corner(v2), corner(v3), corner(v4);
+    }
+    void polygon_begin(unsigned char attributes, const face_vertex_type& v1, const face_vertex_type& v2, const face_vertex_type& v3)
+    {
+        polygon_ = true;
+        triangle(attributes, v1, v2, v3);
+    }
+    void polygon_vertex(const face_vertex_type& vertex)
+    {
+        ++geometry_.faces.back().size;
+        corner(vertex);
+    }
+
+    chunk_type& chunk_;
+    obj_geometry& geometry_;
+    bool polygon_;
+};
+
+template <typename T>
+void append(std::vector<T>& to, std::size_t offset, const std::vector<T>& from)
+{
+    std::copy(from.begin(), from.end(), to.begin() + offset);
+}
+
+}
+
+bool Obj_mtl::obj_parallel_parser::parse(const std::string& filename, obj_geometry& geometry)
+{
+    if (CompressedFile::isCompressed(filename)) {
+        // the chunks need the whole content : decompressed in memory
+        geometry = obj_geometry();
+        CompressedFile compressed;
+        std::string content;
+        const char* data;
+        std::size_t size;
+        if (compressed.open(filename)) {
+            while (compressed.nextBlock(data, size)) {
+                content.append(data, size);
+            }
+        }
+        if (!compressed.error().empty()) {
+            if (error_callback_) {
+                error_callback_(0, compressed.error());
+            }
+            return false;
+        }
+        return parse(content.data(), content.data() + content.size(), geometry);
+    }
+    MappedFile file;
+    if (file.open(filename)) {
+        return parse(file.begin(), file.end(), geometry);
+    }
+    // pipes, devices : read in memory
+    std::ifstream ifstream(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!ifstream) {
+        geometry = obj_geometry();
+        return false;
+    }
+    std::string content((std::istreambuf_iterator<char>(ifstream)), std::istreambuf_iterator<char>());
+    return parse(content.data(), content.data() + content.size(), geometry);
+}
+
+bool Obj_mtl::obj_parallel_parser::parse(const char* begin, const char* end, obj_geometry& geometry)
+{
+    geometry = obj_geometry();
+
+    // split at line boundaries
+    std::size_t size = end - begin;
+    std::size_t nbThreads = threadCount(threads_);
+    std::size_t nbChunks = std::max<std::size_t>(1, std::min(4 * nbThreads, size / minimal_chunk_size));
+    std::vector<chunk_type> chunks(nbChunks);
+    const char* chunk_begin = begin;
+    for (std::size_t i = 0; i < nbChunks; ++i) {
+        const char* chunk_end = (i + 1 == nbChunks) ? end : begin + (size * (i + 1)) / nbChunks;
+        if (chunk_end < chunk_begin) {
+            chunk_end = chunk_begin;
+        }
+        if (chunk_end != end) {
+            chunk_end = tokenizer::line_end(chunk_end, end);
+            chunk_end = (chunk_end == end) ? end : chunk_end + 1;
+        }
+        chunks[i].begin = chunk_begin;
+        chunks[i].end = chunk_end;
+        chunks[i].failed = false;
+        chunk_begin = chunk_end;
+    }
+
+    // pass 1 : lines and vertices of each chunk
+    parallelFor(nbChunks, threads_, [&](std::size_t i) {
+        count(chunks[i].begin, chunks[i].end, chunks[i].statistics);
+    });
+
+    // prefix sum : totals before each chunk
+    obj_parser::statistics before;
+    for (std::size_t i = 0; i < nbChunks; ++i) {
+        obj_parser::statistics counted = chunks[i].statistics;
+        chunks[i].statistics = before;
+        before.line_number += counted.line_number;
+        before.number_of_geometric_vertices += counted.number_of_geometric_vertices;
+        before.number_of_texture_vertices += counted.number_of_texture_vertices;
+        before.number_of_vertex_normals += counted.number_of_vertex_normals;
+    }
+
+    // pass 2 : parse the chunks
+    parallelFor(nbChunks, threads_, [&](std::size_t i) {
+        chunk_type& chunk = chunks[i];
+        chunk_handler handler(chunk);
+        basic_obj_parser<chunk_handler> parser(handler, flags_);
+        chunk.failed = !parser.parse(chunk.begin, chunk.end, chunk.statistics);
+    });
+
+    // keep the chunks up to the first error, as a serial parse would
+    std::size_t nbValidChunks = 0;
+    while (nbValidChunks < nbChunks) {
+        if (chunks[nbValidChunks++].failed) {
+            break;
+        }
+    }
+
+    // pass 3 : concatenation
+    std::vector<std::size_t> v_offset(nbValidChunks + 1, 0), vt_offset(nbValidChunks + 1, 0), vn_offset(nbValidChunks + 1, 0), f_offset(nbValidChunks + 1, 0), c_offset(nbValidChunks + 1, 0);
+    for (std::size_t i = 0; i < nbValidChunks; ++i) {
+        v_offset[i + 1] = v_offset[i] + chunks[i].geometry.geometric_vertices.size();
+        vt_offset[i + 1] = vt_offset[i] + chunks[i].geometry.texture_vertices.size();
+        vn_offset[i + 1] = vn_offset[i] + chunks[i].geometry.vertex_normals.size();
+        f_offset[i + 1] = f_offset[i] + chunks[i].geometry.faces.size();
+        c_offset[i + 1] = c_offset[i] + chunks[i].geometry.face_v.size();
+    }
+    geometry.geometric_vertices.resize(v_offset[nbValidChunks]);
+    geometry.texture_vertices.resize(vt_offset[nbValidChunks]);
+    geometry.vertex_normals.resize(vn_offset[nbValidChunks]);
+    geometry.faces.resize(f_offset[nbValidChunks]);
+    geometry.face_v.resize(c_offset[nbValidChunks]);
+    geometry.face_vt.resize(c_offset[nbValidChunks]);
+    geometry.face_vn.resize(c_offset[nbValidChunks]);
+    parallelFor(nbValidChunks, threads_, [&](std::size_t i) {
+        append(geometry.geometric_vertices, v_offset[i], chunks[i].geometry.geometric_vertices);
+        append(geometry.texture_vertices, vt_offset[i], chunks[i].geometry.texture_vertices);
+        append(geometry.vertex_normals, vn_offset[i], chunks[i].geometry.vertex_normals);
+        append(geometry.faces, f_offset[i], chunks[i].geometry.faces);
+        append(geometry.face_v, c_offset[i], chunks[i].geometry.face_v);
+        append(geometry.face_vt, c_offset[i], chunks[i].geometry.face_vt);
+        append(geometry.face_vn, c_offset[i], chunks[i].geometry.face_vn);
+    });
+
+    obj_parser::statistics totals;
+    for (std::size_t i = 0; i < nbValidChunks; ++i) {
+        chunk_type& chunk = chunks[i];
+        for (std::size_t s = 0; s < chunk.geometry.statements.size(); ++s) {
+            geometry.statements.push_back(chunk.geometry.statements[s]);
+            geometry.statements.back().face += f_offset[i];
+        }
+        if (warning_callback_) {
+            for (std::size_t w = 0; w < chunk.warnings.size(); ++w) {
+                warning_callback_(chunk.warnings[w].first, chunk.warnings[w].second);
+            }
+        }
+        if (chunk.failed) {
+            if (error_callback_) {
+                error_callback_(chunk.error_line, chunk.error_message);
+            }
+            return false;
+        }
+        totals.line_number = chunk.statistics.line_number;
+        totals.number_of_geometric_vertices = chunk.statistics.number_of_geometric_vertices;
+        totals.number_of_texture_vertices = chunk.statistics.number_of_texture_vertices;
+        totals.number_of_vertex_normals = chunk.statistics.number_of_vertex_normals;
+        totals.number_of_faces += chunk.statistics.number_of_faces;
+        totals.number_of_group_names += chunk.statistics.number_of_group_names;
+        totals.number_of_smoothing_groups += chunk.statistics.number_of_smoothing_groups;
+        totals.number_of_object_names += chunk.statistics.number_of_object_names;
+        totals.number_of_material_libraries += chunk.statistics.number_of_material_libraries;
+        totals.number_of_material_names += chunk.statistics.number_of_material_names;
+    }
+    if (info_callback_) {
+        info_callback_(totals.line_number, obj_parser::info_message(totals));
+    }
+    return true;
+}
+
+} // namespace loaders
@@ -0,0 +1,148 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef OBJPARALLELPARSER_H
+#define OBJPARALLELPARSER_H
+
+#include <string>
+#include <vector>
+#include "objfileparser.h"
+
+// =============================================================================
+namespace Loaders {
+// =============================================================================
+
+// =============================================================================
+namespace Obj_mtl {
+// =============================================================================
+
+/** @ingroup OBJ-MTL
+  * Face of an #obj_geometry. The indices of its corners follow those of the
+  * preceding face in obj_geometry::face_v, face_vt and face_vn, they are
+  * those given to the face callbacks of #obj_parser (1-based, translated if
+  * translate_negative_indices is set).
+  */
+struct obj_face {
+    typedef enum {
+        has_texture_vertices = 1 << 0,
+        has_vertex_normals = 1 << 1
+    } Attributes;
+
+    unsigned short size;      ///< number of corners, 3 or more
+    unsigned char attributes; ///< combination of Attributes
+};
+
+/** @ingroup OBJ-MTL
+  * State statement (g, s, o, mtllib, usemtl) of an #obj_geometry.
+  * The statement applies to the faces that follow, face is the number of
+  * faces defined before it.
+  */
+struct obj_statement {
+    typedef enum {
+        group_name,
+        smoothing_group,
+        object_name,
+        material_library,
+        material_name
+    } Kind;
+
+    Kind kind;
+    size_type face;
+    size_type smoothing_group_number;
+    std::string name;
+};
+
+/** @ingroup OBJ-MTL
+  * Content of an OBJ file as arrays, as produced by #obj_parallel_parser.
+  */
+struct obj_geometry {
+    std::vector<float_type> geometric_vertices; ///< x y z
+    std::vector<float_type> texture_vertices;   ///< u v
+    std::vector<float_type> vertex_normals;     ///< x y z
+    std::vector<obj_face> faces;
+    std::vector<index_type> face_v;             ///< corners of the faces
+    std::vector<index_type> face_vt;            ///< 0 when the face has no texture vertices
+    std::vector<index_type> face_vn;            ///< 0 when the face has no vertex normals
+    std::vector<obj_statement> statements;
+};
+
+/** @ingroup OBJ-MTL
+  * Multi-threaded OBJ parser.
+  * The file is split at line boundaries in chunks. A first parallel pass
+  * counts lines and vertices of each chunk, a prefix sum of these counts
+  * gives each chunk its starting line number and vertex counts so that the
+  * chunks are then parsed concurrently, with relative (negative) indices
+  * resolved and bounds checked exactly as in a serial parse. Chunk results
+  * are finally concatenated into an #obj_geometry.
+  * The geometry, the warnings and the error (first one in file order) are
+  * identical to a serial parse with #obj_parser using the same flags.
+  */
+class obj_parallel_parser {
+public:
+    typedef obj_parser::info_callback_type info_callback_type;
+    typedef obj_parser::warning_callback_type warning_callback_type;
+    typedef obj_parser::error_callback_type error_callback_type;
+    typedef obj_parser::flags_type flags_type;
+
+    /// @param threads number of threads, 0 for all cores.
+    obj_parallel_parser(flags_type flags = 0, unsigned threads = 0);
+
+    void info_callback(const info_callback_type& info_callback);
+    void warning_callback(const warning_callback_type& warning_callback);
+    void error_callback(const error_callback_type& error_callback);
+
+    /// Parse a file. Files that can't be mapped in memory are read in memory first.
+    bool parse(const std::string& filename, obj_geometry& geometry);
+    /// Parse an in-memory OBJ content [begin, end).
+    bool parse(const char* begin, const char* end, obj_geometry& geometry);
+
+private:
+    flags_type flags_;
+    unsigned threads_;
+    info_callback_type info_callback_;
+    warning_callback_type warning_callback_;
+    error_callback_type error_callback_;
+};
+
+} // END namespace obj =========================================================
+
+inline Obj_mtl::obj_parallel_parser::obj_parallel_parser(flags_type flags, unsigned threads)
+    : flags_(flags)
+    , threads_(threads)
+{
+}
+
+inline void Obj_mtl::obj_parallel_parser::info_callback(const info_callback_type& info_callback)
+{
+    info_callback_ = info_callback;
+}
+
+inline void Obj_mtl::obj_parallel_parser::warning_callback(const warning_callback_type& warning_callback)
+{
+    warning_callback_ = warning_callback;
+}
+
+inline void Obj_mtl::obj_parallel_parser::error_callback(const error_callback_type& error_callback)
+{
+    error_callback_ = error_callback;
+}
+
+} // END namespace loaders =====================================================
+
+#endif // OBJPARALLELPARSER_H
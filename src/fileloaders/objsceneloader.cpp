@@ -0,0 +1,51 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#include "objsceneloader.h"
+#include "parallel.h"
+
+namespace Loaders {
+namespace Obj_mtl {
+
+std::size_t SceneLoader::load(const std::vector<QString>& filenames, std::vector<Model>& models)
+{
+    // parallelisme sur les fichiers : chaque chargeur est sequentiel
+    models.resize(filenames.size());
+    parallelFor(filenames.size(), mThreadCount, [&](std::size_t f) {
+        Model& model = models[f];
+        model.filename = filenames[f];
+        ObjLoader loader;
+        loader.setThreadCount(1);
+        loader.setCacheEnabled(mCacheEnabled);
+        loader.setCacheDir(mCacheDir);
+        loader.setMaterialLibraries(&mLibraries);
+        model.loaded = loader.load(filenames[f], model.reason);
+        loader.getObjects(model.meshes, model.materials);
+    });
+
+    std::size_t loaded = 0;
+    for (std::size_t f = 0; f < models.size(); ++f) {
+        if (models[f].loaded)
+            loaded++;
+    }
+    return loaded;
+}
+
+} // namespace obj
+} // namespace loaders
@@ -0,0 +1,82 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef OBJSCENELOADER_H
+#define OBJSCENELOADER_H
+
+#include "objloader.h"
+
+#include <QString>
+#include <vector>
+
+// =============================================================================
+namespace Loaders {
+// =============================================================================
+
+// =============================================================================
+namespace Obj_mtl {
+// =============================================================================
+
+/** @ingroup OBJ-MTL
+    Concurrent loading of the OBJ files of a scene : the files are loaded by
+    a pool of threads, one #ObjLoader per file, and their material libraries
+    are parsed once and shared (see #MaterialLibraries).
+*/
+class SceneLoader {
+public:
+    /// Meshes of a loaded file (owned by the caller), and the material of
+    /// each mesh (owned by the #SceneLoader, 0 if undefined)
+    struct Model {
+        QString filename;
+        bool loaded;
+        QString reason;
+        std::vector<Loaders::Mesh*> meshes;
+        std::vector<const ObjLoader::mtlMaterial*> materials;
+    };
+
+    SceneLoader() : mThreadCount(0), mCacheEnabled(true) {}
+
+    /// Number of files loaded at the same time (0 : all cores). Each file
+    /// is parsed and built by a single thread.
+    void setThreadCount(unsigned threadCount) { mThreadCount = threadCount; }
+    /// Binary cache of the files, see ObjLoader::setCacheEnabled()
+    void setCacheEnabled(bool enabled) { mCacheEnabled = enabled; }
+    void setCacheDir(const QString& cacheDir) { mCacheDir = cacheDir; }
+
+    /// Load the files : models[i] is the model of filenames[i]. The
+    /// materials stay valid as long as the #SceneLoader exists, and are
+    /// shared with the next loads.
+    /// @return the number of files loaded correctly
+    std::size_t load(const std::vector<QString>& filenames, std::vector<Model>& models);
+
+    /// Material libraries parsed by the loads
+    const MaterialLibraries& materialLibraries() const { return mLibraries; }
+
+private:
+    unsigned mThreadCount;
+    bool mCacheEnabled;
+    QString mCacheDir;
+    MaterialLibraries mLibraries;
+};
+
+} // END namespace obj =========================================================
+
+} // END namespace loaders =====================================================
+
+#endif // OBJSCENELOADER_H
@@ -0,0 +1,40 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#include "objtokenizer.h"
+#include <locale>
+#include <sstream>
+
+namespace Loaders {
+
+bool Obj_mtl::tokenizer::parse_float_slow(const char* begin, const char* end, float_type& value)
+{
+    // strtof depends on the C locale (set by Qt), the classic C++ locale does not.
+    std::istringstream stringstream(std::string(begin, end));
+    stringstream.imbue(std::locale::classic());
+    float_type f;
+    stringstream >> f;
+    if (stringstream.fail() || !stringstream.eof()) {
+        return false;
+    }
+    value = f;
+    return true;
+}
+
+} // namespace loaders
@@ -0,0 +1,422 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef OBJTOKENIZER_H
+#define OBJTOKENIZER_H
+
+#include <cstddef>
+#include <cstring>
+#include <climits>
+#include "objfileparser.h"
+
+// SIMD number parsing on x86 : SSE2 (16 characters windows) is always
+// available on x86-64, AVX2 (32 characters windows) when the compiler
+// targets it (-mavx2, /arch:AVX2, see OBJ_PARSER_AVX2 in CMakeLists.txt).
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OBJ_TOKENIZER_SIMD
+#include <emmintrin.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// =============================================================================
+namespace Loaders {
+// =============================================================================
+
+// =============================================================================
+namespace Obj_mtl {
+// =============================================================================
+
+/** @ingroup OBJ-MTL
+  * Pointer based lexical primitives used by the OBJ/MTL parsers.
+  * All functions work on a range [p, end) that is not null terminated, and
+  * advance p past the consumed characters. They accept exactly what the
+  * classic locale stream extractors accept, so that the pointer and stream
+  * based parsers behave the same.
+  */
+namespace tokenizer {
+
+/// Same character class as std::isspace in the "C" locale.
+inline bool is_space(char c)
+{
+    return (c == ' ') || (c >= '\t' && c <= '\r');
+}
+
+inline bool is_digit(char c)
+{
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+/// Skip white spaces (std::ws).
+inline void skip_space(const char*& p, const char* end)
+{
+    while (p != end && is_space(*p)) {
+        ++p;
+    }
+}
+
+/// Consume one mandatory white space and all the following ones.
+inline bool separator(const char*& p, const char* end)
+{
+    if (p == end || !is_space(*p)) {
+        return false;
+    }
+    skip_space(++p, end);
+    return true;
+}
+
+/// Skip the white spaces following a token, fails if the token is
+/// followed by anything else than white spaces or the end of the range.
+inline bool next_token(const char*& p, const char* end)
+{
+    return (p == end) || separator(p, end);
+}
+
+/// Skip trailing white spaces, true if nothing else remains.
+inline bool end_of_line(const char*& p, const char* end)
+{
+    skip_space(p, end);
+    return p == end;
+}
+
+/// Advance p to the end of the current non-blank token.
+inline const char* token_end(const char* p, const char* end)
+{
+    while (p != end && !is_space(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+/// Compare the range [begin, end) with the null terminated string keyword.
+inline bool token_equals(const char* begin, const char* end, const char* keyword)
+{
+    std::size_t size = std::strlen(keyword);
+    return std::size_t(end - begin) == size && std::memcmp(begin, keyword, size) == 0;
+}
+
+/// Find the end of the line starting at p (either a '\n' or end).
+inline const char* line_end(const char* p, const char* end)
+{
+    const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    return eol ? eol : end;
+}
+
+#ifdef OBJ_TOKENIZER_SIMD
+
+/** Character classes of a window of characters, bit i is set when p[i]
+  * belongs to the class. Bits past the window are 0.
+  */
+struct window_type {
+    unsigned long long digits;
+    unsigned long long dots;
+    unsigned long long slashes;
+};
+
+#ifdef __AVX2__
+enum { window_size = 32 };
+#else
+enum { window_size = 16 };
+#endif
+
+/// Number of readable characters that must remain after p to use the SIMD
+/// path : a sign, a window, and the 8 bytes read by parse_digits past its end.
+/// Windows may extend past the end of the token range (usually the end of
+/// the line) up to the end of the readable buffer.
+enum { simd_margin = window_size + 16 };
+
+inline unsigned count_trailing_zeros(unsigned long long mask)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return unsigned(index);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanForward(&index, static_cast<unsigned long>(mask))) {
+        return unsigned(index);
+    }
+    _BitScanForward(&index, static_cast<unsigned long>(mask >> 32));
+    return unsigned(index) + 32;
+#else
+    return unsigned(__builtin_ctzll(mask));
+#endif
+}
+
+/// Number of consecutive digits at position i of the window.
+inline unsigned digits_at(const window_type& window, unsigned i)
+{
+    return count_trailing_zeros(~(window.digits >> i));
+}
+
+/// Classify the window_size characters at p.
+inline window_type classify(const char* p)
+{
+    window_type window;
+#ifdef __AVX2__
+    __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i t = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+    // unsigned t <= 9
+    __m256i digit = _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8(9)), t);
+    window.digits = unsigned(_mm256_movemask_epi8(digit));
+    window.dots = unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('.'))));
+    window.slashes = unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('/'))));
+#else
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i t = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    // unsigned t <= 9
+    __m128i digit = _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(9)), t);
+    window.digits = unsigned(_mm_movemask_epi8(digit));
+    window.dots = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8('.'))));
+    window.slashes = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8('/'))));
+#endif
+    return window;
+}
+
+/// Value of the n (at most 8) digits at p, 8 characters must be readable.
+inline unsigned long long parse_eight_digits(const char* p, unsigned n)
+{
+    if (n == 0) {
+        return 0;
+    }
+    unsigned long long chunk;
+    std::memcpy(&chunk, p, sizeof(chunk));
+    // little endian : the first digit is the low byte, digits past n are
+    // shifted out and replaced by leading zeros ('\0' & 0x0f == 0)
+    chunk <<= 8 * (8 - n);
+    chunk = ((chunk & 0x0f0f0f0f0f0f0f0full) * 2561) >> 8;
+    chunk = ((chunk & 0x00ff00ff00ff00ffull) * 6553601) >> 16;
+    return ((chunk & 0x0000ffff0000ffffull) * 42949672960001ull) >> 32;
+}
+
+/// Value of the n (at most 16) digits at p.
+inline unsigned long long parse_digits(const char* p, unsigned n)
+{
+    if (n <= 8) {
+        return parse_eight_digits(p, n);
+    }
+    return parse_eight_digits(p, n - 8) * 100000000ull + parse_eight_digits(p + n - 8, 8);
+}
+
+#endif // OBJ_TOKENIZER_SIMD
+
+/// Parse a signed decimal integer, fails on overflow. Characters up to
+/// readable_end (>= end) may be read.
+inline bool parse_index(const char*& p, const char* end, index_type& value, const char* readable_end)
+{
+#ifdef OBJ_TOKENIZER_SIMD
+    if (readable_end - p >= simd_margin) {
+        const char* s = p + (*p == '-' || *p == '+');
+        unsigned n = digits_at(classify(s), 0);
+        // up to 16 digits can't overflow, a number that fills the window may
+        // have more digits : scalar path
+        if (n - 1 < 16 && n < unsigned(window_size) && std::ptrdiff_t(n) <= end - s) {
+            index_type v = index_type(parse_digits(s, n));
+            value = (*p == '-') ? -v : v;
+            p = s + n;
+            return true;
+        }
+    }
+#endif
+    const char* s = p;
+    bool negative = false;
+    if (s != end && (*s == '-' || *s == '+')) {
+        negative = (*s == '-');
+        ++s;
+    }
+    if (s == end || !is_digit(*s)) {
+        return false;
+    }
+    // magnitude up to 2^63 - 1, or 2^63 for a negative index
+    const unsigned long long limit = (unsigned long long)(LLONG_MAX) + (negative ? 1 : 0);
+    unsigned long long v = 0;
+    do {
+        unsigned digit = unsigned(*s - '0');
+        if (v > (limit - digit) / 10) {
+            return false;
+        }
+        v = v * 10 + digit;
+        ++s;
+    } while (s != end && is_digit(*s));
+    value = negative ? index_type(0 - v) : index_type(v);
+    p = s;
+    return true;
+}
+
+inline bool parse_index(const char*& p, const char* end, index_type& value)
+{
+    return parse_index(p, end, value, end);
+}
+
+/// Parse an unsigned decimal integer, fails on overflow.
+inline bool parse_size(const char*& p, const char* end, size_type& value)
+{
+    const char* s = p;
+    if (s != end && *s == '+') {
+        ++s;
+    }
+    if (s == end || !is_digit(*s)) {
+        return false;
+    }
+    size_type v = 0;
+    do {
+        size_type digit = size_type(*s - '0');
+        if (v > (size_type(-1) - digit) / 10) {
+            return false;
+        }
+        v = v * 10 + digit;
+        ++s;
+    } while (s != end && is_digit(*s));
+    value = v;
+    p = s;
+    return true;
+}
+
+/// Correctly rounded conversion of [begin, end), used when the fast path of
+/// parse_float can't guarantee an exact result.
+bool parse_float_slow(const char* begin, const char* end, float_type& value);
+
+/**
+  * Parse a decimal floating point number : [+-]digits[.digits][(e|E)[+-]digits].
+  * Numbers with at most 19 significant digits and a small decimal exponent
+  * are converted exactly with one double operation, the others (and the rare
+  * values that fall on a float rounding midpoint) go through parse_float_slow.
+  * Characters up to readable_end (>= end) may be read.
+  */
+inline bool parse_float(const char*& p, const char* end, float_type& value, const char* readable_end)
+{
+    static const double powers_of_ten[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+#ifdef OBJ_TOKENIZER_SIMD
+    // [+-]digits[.digits] of at most 16 digits, without exponent : the
+    // number is delimited from the window masks and its digits converted
+    // by 8, then rounded exactly as below.
+    if (readable_end - p >= simd_margin) {
+        const char* s = p + (*p == '-' || *p == '+');
+        window_type window = classify(s);
+        unsigned integer_digits = digits_at(window, 0);
+        unsigned dot = unsigned(window.dots >> integer_digits) & 1;
+        unsigned fraction_digits = dot ? digits_at(window, integer_digits + 1) : 0;
+        unsigned length = integer_digits + dot + fraction_digits;
+        unsigned digits = integer_digits + fraction_digits;
+        if (digits - 1 < 16 && length < unsigned(window_size) && std::ptrdiff_t(length) <= end - s && (s[length] | 0x20) != 'e') {
+            unsigned long long mantissa = parse_digits(s, integer_digits);
+            mantissa = mantissa * (unsigned long long)(powers_of_ten[fraction_digits]) + parse_digits(s + integer_digits + 1, fraction_digits);
+            if (mantissa < (1ull << 53)) {
+                double d = double(mantissa) / powers_of_ten[fraction_digits];
+                unsigned long long bits;
+                std::memcpy(&bits, &d, sizeof(bits));
+                if ((bits & 0x1fffffffull) != 0x10000000ull) {
+                    value = float_type((*p == '-') ? -d : d);
+                    p = s + length;
+                    return true;
+                }
+            }
+        }
+    }
+#endif
+    const char* s = p;
+    bool negative = false;
+    if (s != end && (*s == '-' || *s == '+')) {
+        negative = (*s == '-');
+        ++s;
+    }
+    unsigned long long mantissa = 0;
+    int digits = 0, significant_digits = 0, exponent = 0;
+    bool exact = true;
+    for (; s != end && is_digit(*s); ++s, ++digits) {
+        if (significant_digits < 19) {
+            mantissa = mantissa * 10 + (*s - '0');
+            significant_digits += (mantissa != 0);
+        }
+        else {
+            ++exponent;
+            exact &= (*s == '0');
+        }
+    }
+    if (s != end && *s == '.') {
+        for (++s; s != end && is_digit(*s); ++s, ++digits) {
+            if (significant_digits < 19) {
+                mantissa = mantissa * 10 + (*s - '0');
+                significant_digits += (mantissa != 0);
+                --exponent;
+            }
+            else {
+                exact &= (*s == '0');
+            }
+        }
+    }
+    if (digits == 0) {
+        return false;
+    }
+    if (s != end && (*s == 'e' || *s == 'E')) {
+        ++s;
+        bool negative_exponent = false;
+        if (s != end && (*s == '-' || *s == '+')) {
+            negative_exponent = (*s == '-');
+            ++s;
+        }
+        if (s == end || !is_digit(*s)) {
+            return false;
+        }
+        int e = 0;
+        for (; s != end && is_digit(*s); ++s) {
+            if (e < 100000) {
+                e = e * 10 + (*s - '0');
+            }
+        }
+        exponent += negative_exponent ? -e : e;
+    }
+    if (exact && mantissa < (1ull << 53) && exponent >= -22 && exponent <= 22) {
+        double d = double(mantissa);
+        d = (exponent < 0) ? d / powers_of_ten[-exponent] : d * powers_of_ten[exponent];
+        // A double exactly halfway between two floats would be rounded twice.
+        unsigned long long bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        if ((bits & 0x1fffffffull) != 0x10000000ull) {
+            value = float_type(negative ? -d : d);
+            p = s;
+            return true;
+        }
+    }
+    if (!parse_float_slow(p, s, value)) {
+        return false;
+    }
+    p = s;
+    return true;
+}
+
+inline bool parse_float(const char*& p, const char* end, float_type& value)
+{
+    return parse_float(p, end, value, end);
+}
+
+} // END namespace tokenizer
+
+} // END namespace obj =========================================================
+
+} // END namespace loaders =====================================================
+
+#endif // OBJTOKENIZER_H
@@ -0,0 +1,207 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#include "objtriangulator.h"
+#include <cmath>
+#include <utility>
+
+namespace Loaders {
+
+namespace {
+
+using Obj_mtl::float_type;
+
+// Twice the signed area of the triangle (a, b, c) of the projection plane,
+// positive when counterclockwise.
+inline float_type orientation(const float_type* a, const float_type* b, const float_type* c)
+{
+    return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+}
+
+inline bool same_point(const float_type* a, const float_type* b)
+{
+    return a[0] == b[0] && a[1] == b[1];
+}
+
+// Turn of the corner b of (a, b, c) around normal, negative when reflex.
+inline float_type turn(const float_type* a, const float_type* b, const float_type* c, const float_type* normal)
+{
+    float_type e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    float_type e2[3] = { c[0] - b[0], c[1] - b[1], c[2] - b[2] };
+    return (e1[1] * e2[2] - e1[2] * e2[1]) * normal[0] + (e1[2] * e2[0] - e1[0] * e2[2]) * normal[1] + (e1[0] * e2[1] - e1[1] * e2[0]) * normal[2];
+}
+
+}
+
+std::size_t Obj_mtl::polygon_triangulator::triangulate(unsigned int* triangles)
+{
+    std::size_t n = size();
+    if (n < 3) {
+        return 0;
+    }
+    if (n > 3) {
+        // Newell normal : robust for non-planar polygons, null for
+        // degenerate ones (that are then split as a fan)
+        float_type normal[3] = { 0, 0, 0 };
+        const float_type* p = &points_[0];
+        for (std::size_t i = 0, j = n - 1; i < n; j = i++) {
+            const float_type* a = p + 3 * j;
+            const float_type* b = p + 3 * i;
+            normal[0] += (a[1] - b[1]) * (a[2] + b[2]);
+            normal[1] += (a[2] - b[2]) * (a[0] + b[0]);
+            normal[2] += (a[0] - b[0]) * (a[1] + b[1]);
+        }
+        if (!convex(normal)) {
+            project(normal);
+            return clip_ears(triangles);
+        }
+    }
+    for (std::size_t i = 1; i + 1 < n; ++i) {
+        *triangles++ = 0;
+        *triangles++ = (unsigned int)i;
+        *triangles++ = (unsigned int)(i + 1);
+    }
+    return n - 2;
+}
+
+// A simple quadrilateral has at most one reflex corner, the inner diagonal
+// goes through it : p1 p3 when p1 or p3 is reflex, p0 p2 otherwise. The Newell normal of a
+// quadrilateral is the cross product of its diagonals.
+void Obj_mtl::polygon_triangulator::triangulate_quadrilateral(const float_type* p0, const float_type* p1, const float_type* p2, const float_type* p3, unsigned int* triangles)
+{
+    float_type d1[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+    float_type d2[3] = { p3[0] - p1[0], p3[1] - p1[1], p3[2] - p1[2] };
+    float_type normal[3] = { d1[1] * d2[2] - d1[2] * d2[1], d1[2] * d2[0] - d1[0] * d2[2], d1[0] * d2[1] - d1[1] * d2[0] };
+    unsigned int first = (turn(p0, p1, p2, normal) < 0 || turn(p2, p3, p0, normal) < 0) ? 1 : 0;
+    triangles[0] = first;
+    triangles[1] = first + 1;
+    triangles[2] = first + 2;
+    triangles[3] = first;
+    triangles[4] = first + 2;
+    triangles[5] = (first + 3) & 3;
+}
+
+// Fast test : every corner turns the same way around the normal.
+bool Obj_mtl::polygon_triangulator::convex(const float_type normal[3]) const
+{
+    if (normal[0] == 0 && normal[1] == 0 && normal[2] == 0) {
+        return true;
+    }
+    std::size_t n = size();
+    const float_type* p = &points_[0];
+    for (std::size_t i = 0; i < n; ++i) {
+        const float_type* a = p + 3 * (i == 0 ? n - 1 : i - 1);
+        const float_type* b = p + 3 * i;
+        const float_type* c = p + 3 * (i + 1 == n ? 0 : i + 1);
+        if (turn(a, b, c, normal) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Projection on the coordinate plane closest to the polygon plane, oriented
+// so that the polygon is counterclockwise.
+void Obj_mtl::polygon_triangulator::project(const float_type normal[3])
+{
+    float_type ax = std::fabs(normal[0]), ay = std::fabs(normal[1]), az = std::fabs(normal[2]);
+    int dropped = (ax > ay && ax > az) ? 0 : (ay > az ? 1 : 2);
+    int u = (dropped + 1) % 3, v = (dropped + 2) % 3;
+    if (normal[dropped] < 0) {
+        std::swap(u, v);
+    }
+    std::size_t n = size();
+    planar_.resize(2 * n);
+    for (std::size_t i = 0; i < n; ++i) {
+        planar_[2 * i] = points_[3 * i + u];
+        planar_[2 * i + 1] = points_[3 * i + v];
+    }
+}
+
+bool Obj_mtl::polygon_triangulator::is_convex_corner(std::size_t i) const
+{
+    const float_type* q = &planar_[0];
+    return orientation(q + 2 * previous_[i], q + 2 * i, q + 2 * next_[i]) > 0;
+}
+
+// Convex corner whose triangle contains no other (reflex) vertex.
+bool Obj_mtl::polygon_triangulator::is_ear(std::size_t i) const
+{
+    if (!convex_[i]) {
+        return false;
+    }
+    const float_type* q = &planar_[0];
+    const float_type* a = q + 2 * previous_[i];
+    const float_type* b = q + 2 * i;
+    const float_type* c = q + 2 * next_[i];
+    for (std::size_t j = next_[next_[i]]; j != previous_[i]; j = next_[j]) {
+        const float_type* p = q + 2 * j;
+        if (convex_[j] || same_point(p, a) || same_point(p, b) || same_point(p, c)) {
+            continue;
+        }
+        if (orientation(a, b, p) >= 0 && orientation(b, c, p) >= 0 && orientation(c, a, p) >= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::size_t Obj_mtl::polygon_triangulator::clip_ears(unsigned int* triangles)
+{
+    std::size_t n = size();
+    previous_.resize(n);
+    next_.resize(n);
+    convex_.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        previous_[i] = (unsigned int)(i == 0 ? n - 1 : i - 1);
+        next_[i] = (unsigned int)(i + 1 == n ? 0 : i + 1);
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+        convex_[i] = is_convex_corner(i);
+    }
+
+    std::size_t remaining = n;
+    std::size_t i = 0;
+    std::size_t tried = 0;
+    while (remaining > 3) {
+        // no ear left (self-intersecting polygon, rounding) : clipped anyway
+        if (!is_ear(i) && tried < remaining) {
+            i = next_[i];
+            ++tried;
+            continue;
+        }
+        unsigned int previous = previous_[i], next = next_[i];
+        *triangles++ = previous;
+        *triangles++ = (unsigned int)i;
+        *triangles++ = next;
+        next_[previous] = next;
+        previous_[next] = previous;
+        convex_[previous] = is_convex_corner(previous);
+        convex_[next] = is_convex_corner(next);
+        --remaining;
+        tried = 0;
+        i = next;
+    }
+    *triangles++ = previous_[i];
+    *triangles++ = (unsigned int)i;
+    *triangles++ = next_[i];
+    return n - 2;
+}
+
+} // namespace loaders
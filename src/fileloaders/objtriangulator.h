@@ -0,0 +1,107 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef OBJTRIANGULATOR_H
+#define OBJTRIANGULATOR_H
+
+#include <cstddef>
+#include <vector>
+#include "objfileparser.h"
+
+// =============================================================================
+namespace Loaders {
+// =============================================================================
+
+// =============================================================================
+namespace Obj_mtl {
+// =============================================================================
+
+/** @ingroup OBJ-MTL
+  * Triangulation of the polygonal faces of an OBJ file.
+  * Convex polygons are split as a fan from their first vertex. The other
+  * ones (concave, or far from planar) are split by ear clipping in the plane
+  * of their Newell normal, so that no triangle covers a notch of the
+  * polygon. A polygon of n vertices always gives n - 2 triangles, also when
+  * it is degenerate or self-intersecting (the fan or the clipping order is
+  * then kept as is).
+  * Buffers are kept from one polygon to the next : a triangulator only
+  * allocates memory for a polygon larger than all the previous ones.
+  */
+class polygon_triangulator {
+public:
+    polygon_triangulator();
+
+    /// Start a new polygon.
+    void clear();
+    /// Next vertex of the polygon.
+    void add_vertex(float_type x, float_type y, float_type z);
+    std::size_t size() const;
+
+    /// Write the triangles of the polygon in triangles, 3 * (size() - 2)
+    /// indices of its vertices (0 for the first added one), keeping the
+    /// orientation of the polygon. Returns the number of triangles.
+    std::size_t triangulate(unsigned int* triangles);
+
+    /// Fast path for quadrilaterals (x y z points) : split along the
+    /// diagonal that stays inside, 6 indices written in triangles.
+    static void triangulate_quadrilateral(const float_type* p0, const float_type* p1, const float_type* p2, const float_type* p3, unsigned int* triangles);
+
+private:
+    polygon_triangulator(const polygon_triangulator&);
+    polygon_triangulator& operator=(const polygon_triangulator&);
+
+    bool convex(const float_type normal[3]) const;
+    void project(const float_type normal[3]);
+    bool is_convex_corner(std::size_t i) const;
+    bool is_ear(std::size_t i) const;
+    std::size_t clip_ears(unsigned int* triangles);
+
+    std::vector<float_type> points_; // x y z
+    std::vector<float_type> planar_; // u v, counterclockwise
+    std::vector<unsigned int> previous_;
+    std::vector<unsigned int> next_;
+    std::vector<unsigned char> convex_;
+};
+
+} // END namespace obj =========================================================
+
+inline Obj_mtl::polygon_triangulator::polygon_triangulator()
+{
+}
+
+inline void Obj_mtl::polygon_triangulator::clear()
+{
+    points_.clear();
+}
+
+inline void Obj_mtl::polygon_triangulator::add_vertex(float_type x, float_type y, float_type z)
+{
+    points_.push_back(x);
+    points_.push_back(y);
+    points_.push_back(z);
+}
+
+inline std::size_t Obj_mtl::polygon_triangulator::size() const
+{
+    return points_.size() / 3;
+}
+
+} // END namespace loaders =====================================================
+
+#endif // OBJTRIANGULATOR_H
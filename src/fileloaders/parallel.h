@@ -0,0 +1,221 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// =============================================================================
+namespace Loaders {
+// =============================================================================
+
+/**
+  * @ingroup Loaders
+  * Number of threads to use for a requested count, 0 meaning "all cores".
+  */
+inline unsigned threadCount(unsigned requested)
+{
+    if (requested != 0) {
+        return requested;
+    }
+    unsigned cores = std::thread::hardware_concurrency();
+    return cores ? cores : 1;
+}
+
+/**
+  * @ingroup Loaders
+  * Threads of #parallelFor, created at the first use and kept until the end
+  * of the program ; the pool grows to the largest number of threads
+  * requested. Loops may be started by several threads, and by the tasks of
+  * another loop : the caller of a loop takes part in it, so that the loop
+  * completes even when all the threads of the pool are busy.
+  */
+class ThreadPool {
+public:
+    /// Loop of parallelFor, on the stack of its caller.
+    struct Loop {
+        std::size_t count;
+        void (*run)(const void* task, std::size_t i);
+        const void* task;
+        std::atomic<std::size_t> next;
+        // threads of the pool wanted, that took the loop, and still working
+        // on it
+        unsigned helpers, joined, active;
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+
+        /// Run the tasks not taken yet. The first exception stops the
+        /// distribution of the tasks and is kept for the caller.
+        void work()
+        {
+            for (std::size_t i = next++; i < count; i = next++) {
+                try {
+                    run(task, i);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                    next = count;
+                }
+            }
+        }
+    };
+
+    static ThreadPool& instance()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStop = true;
+        }
+        mWake.notify_all();
+        for (std::size_t t = 0; t < mThreads.size(); ++t) {
+            mThreads[t].join();
+        }
+    }
+
+    /// Run loop with loop.helpers threads of the pool, return when all its
+    /// tasks are done and rethrow the first exception of a task.
+    void run(Loop& loop)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            while (mThreads.size() < loop.helpers) {
+                mThreads.push_back(std::thread(&ThreadPool::helper, this));
+            }
+            mLoops.push_back(&loop);
+        }
+        mWake.notify_all();
+        loop.work();
+        // no new helper, then wait for the helpers still working
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (std::size_t l = 0; l < mLoops.size(); ++l) {
+                if (mLoops[l] == &loop) {
+                    mLoops.erase(mLoops.begin() + l);
+                    break;
+                }
+            }
+        }
+        std::unique_lock<std::mutex> lock(loop.mutex);
+        loop.finished.wait(lock, [&]() { return loop.active == 0; });
+        if (loop.error) {
+            std::rethrow_exception(loop.error);
+        }
+    }
+
+private:
+    ThreadPool()
+        : mStop(false)
+    {
+    }
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    void helper()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        for (;;) {
+            mWake.wait(lock, [&]() { return mStop || !mLoops.empty(); });
+            if (mStop) {
+                return;
+            }
+            Loop& loop = *mLoops.front();
+            if (++loop.joined == loop.helpers) {
+                mLoops.pop_front();
+            }
+            {
+                std::lock_guard<std::mutex> loopLock(loop.mutex);
+                ++loop.active;
+            }
+            lock.unlock();
+            loop.work();
+            {
+                std::lock_guard<std::mutex> loopLock(loop.mutex);
+                if (--loop.active == 0) {
+                    loop.finished.notify_all();
+                }
+            }
+            lock.lock();
+        }
+    }
+
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::deque<Loop*> mLoops;
+    std::vector<std::thread> mThreads;
+    bool mStop;
+};
+
+/**
+  * @ingroup Loaders
+  * Call task(i) for each i in [0, count), on at most threads threads
+  * (0 : all cores). Tasks are distributed dynamically, the calling thread
+  * takes part in the work and the function returns when all tasks are done.
+  * The other threads are those of #ThreadPool : a call wakes them up, it
+  * doesn't create them. An exception thrown by a task stops the
+  * distribution of the remaining tasks, and is rethrown to the caller once
+  * the running tasks are done.
+  */
+template <typename Task>
+void parallelFor(std::size_t count, unsigned threads, const Task& task)
+{
+    std::size_t nbThreads = threadCount(threads);
+    if (nbThreads > count) {
+        nbThreads = count;
+    }
+    if (nbThreads <= 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+    struct Invoke {
+        static void run(const void* task, std::size_t i) { (*static_cast<const Task*>(task))(i); }
+    };
+    ThreadPool::Loop loop;
+    loop.count = count;
+    loop.run = &Invoke::run;
+    loop.task = &task;
+    loop.next = 0;
+    loop.helpers = unsigned(nbThreads - 1);
+    loop.joined = 0;
+    loop.active = 0;
+    ThreadPool::instance().run(loop);
+}
+
+} // END namespace loaders =====================================================
+
+#endif // PARALLEL_H
@@ -0,0 +1,294 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#include "vertexcache.h"
+
+#include "glm/glm.hpp"
+#include <algorithm>
+
+namespace Loaders {
+
+namespace {
+
+// FIFO cache simulation of vertexCacheStatistics, triangle by triangle,
+// that can be emptied (time += cacheSize + 1)
+class FifoCache {
+public:
+    FifoCache(std::size_t nbVertices, unsigned cacheSize)
+        : mTransformed(nbVertices, 0)
+        , mTime(cacheSize + 1)
+        , mCacheSize(cacheSize)
+    {
+    }
+    unsigned misses(const unsigned int* triangle)
+    {
+        unsigned misses = 0;
+        for (int c = 0; c < 3; ++c) {
+            std::size_t& transformed = mTransformed[triangle[c]];
+            if (mTime - transformed > mCacheSize) {
+                transformed = mTime++;
+                ++misses;
+            }
+        }
+        return misses;
+    }
+    void clear() { mTime += mCacheSize + 1; }
+
+private:
+    std::vector<std::size_t> mTransformed;
+    std::size_t mTime;
+    unsigned mCacheSize;
+};
+
+}
+
+VertexCacheStatistics vertexCacheStatistics(const unsigned int* triangles, std::size_t nbTriangles, std::size_t nbVertices, unsigned cacheSize)
+{
+    // FIFO : a vertex is in the cache while less than cacheSize vertices
+    // were transformed after it
+    std::vector<std::size_t> transformed(nbVertices, 0);
+    std::size_t misses = 0;
+    for (std::size_t i = 0; i < 3 * nbTriangles; ++i) {
+        unsigned int v = triangles[i];
+        if (transformed[v] == 0 || misses - transformed[v] >= cacheSize) {
+            transformed[v] = ++misses;
+        }
+    }
+    VertexCacheStatistics statistics;
+    statistics.acmr = nbTriangles ? double(misses) / nbTriangles : 0.;
+    statistics.atvr = nbVertices ? double(misses) / nbVertices : 0.;
+    return statistics;
+}
+
+void optimizeVertexCache(unsigned int* triangles, std::size_t nbTriangles, std::size_t nbVertices, unsigned cacheSize)
+{
+    if (nbTriangles == 0) {
+        return;
+    }
+    // triangles of each vertex (counting sort), and number of triangles of
+    // each vertex not emitted yet
+    std::vector<unsigned int> live(nbVertices, 0);
+    for (std::size_t i = 0; i < 3 * nbTriangles; ++i) {
+        ++live[triangles[i]];
+    }
+    std::vector<std::size_t> firstTriangle(nbVertices + 1, 0);
+    for (std::size_t v = 0; v < nbVertices; ++v) {
+        firstTriangle[v + 1] = firstTriangle[v] + live[v];
+    }
+    std::vector<unsigned int> vertexTriangles(3 * nbTriangles);
+    {
+        std::vector<std::size_t> cursor(firstTriangle.begin(), firstTriangle.end() - 1);
+        for (std::size_t i = 0; i < 3 * nbTriangles; ++i) {
+            vertexTriangles[cursor[triangles[i]]++] = (unsigned int)(i / 3);
+        }
+    }
+
+    std::vector<unsigned int> result(3 * nbTriangles);
+    std::size_t written = 0;
+    std::vector<bool> emitted(nbTriangles, false);
+    // time at which each vertex entered the cache (0 : never)
+    std::vector<std::size_t> cacheTime(nbVertices, 0);
+    std::size_t time = cacheSize + 1;
+    // vertices of the emitted triangles, candidates when no vertex of the
+    // last fan can be used (dead end)
+    std::vector<unsigned int> deadEnd;
+    std::vector<unsigned int> candidates;
+    std::size_t cursor = 0;
+    std::size_t fan = triangles[0];
+    for (;;) {
+        // fan : triangles of the fan vertex not emitted yet
+        candidates.clear();
+        for (std::size_t k = firstTriangle[fan]; k < firstTriangle[fan + 1]; ++k) {
+            unsigned int t = vertexTriangles[k];
+            if (emitted[t]) {
+                continue;
+            }
+            emitted[t] = true;
+            for (int c = 0; c < 3; ++c) {
+                unsigned int v = triangles[3 * t + c];
+                result[written++] = v;
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (time - cacheTime[v] > cacheSize) {
+                    cacheTime[v] = time++;
+                }
+            }
+        }
+        if (written == result.size()) {
+            break;
+        }
+
+        // next fan vertex : among the candidates with live triangles whose
+        // fan would stay in the cache, the one that entered it first, else
+        // the first candidate with live triangles
+        std::size_t next = nbVertices;
+        std::size_t best = 0;
+        for (std::size_t i = 0; i < candidates.size(); ++i) {
+            unsigned int v = candidates[i];
+            if (live[v] == 0) {
+                continue;
+            }
+            std::size_t priority = 0;
+            if (time - cacheTime[v] + 2 * live[v] <= cacheSize) {
+                priority = time - cacheTime[v];
+            }
+            if (next == nbVertices || priority > best) {
+                best = priority;
+                next = v;
+            }
+        }
+        if (next == nbVertices) {
+            // dead end : last emitted vertex with live triangles, else the
+            // next vertex in input order
+            while (!deadEnd.empty() && next == nbVertices) {
+                unsigned int v = deadEnd.back();
+                deadEnd.pop_back();
+                if (live[v] > 0) {
+                    next = v;
+                }
+            }
+            while (next == nbVertices && cursor < nbVertices) {
+                if (live[cursor] > 0) {
+                    next = cursor;
+                }
+                ++cursor;
+            }
+        }
+        if (next == nbVertices) {
+            break;
+        }
+        fan = next;
+    }
+    std::copy(result.begin(), result.end(), triangles);
+}
+
+void optimizeOverdraw(unsigned int* triangles, std::size_t nbTriangles, const float* positions, std::size_t stride, std::size_t nbVertices,
+                      float threshold, unsigned cacheSize)
+{
+    if (nbTriangles == 0) {
+        return;
+    }
+    // patches : a triangle whose 3 vertices miss the cache starts a new one
+    std::vector<std::size_t> patches;
+    FifoCache cache(nbVertices, cacheSize);
+    for (std::size_t t = 0; t < nbTriangles; ++t) {
+        if (cache.misses(triangles + 3 * t) == 3 || t == 0) {
+            patches.push_back(t);
+        }
+    }
+    patches.push_back(nbTriangles);
+
+    // clusters : a patch is cut after the triangle where the miss ratio
+    // from the start of the cluster reaches threshold times the ratio of
+    // the patch (cache emptied at each cut, as between two clusters drawn
+    // apart)
+    std::vector<std::size_t> clusters;
+    for (std::size_t p = 0; p + 1 < patches.size(); ++p) {
+        std::size_t begin = patches[p], end = patches[p + 1];
+        cache.clear();
+        std::size_t patchMisses = 0;
+        for (std::size_t t = begin; t < end; ++t) {
+            patchMisses += cache.misses(triangles + 3 * t);
+        }
+        const double target = threshold * double(patchMisses) / double(end - begin);
+        cache.clear();
+        clusters.push_back(begin);
+        std::size_t misses = 0, count = 0;
+        for (std::size_t t = begin; t + 1 < end; ++t) {
+            misses += cache.misses(triangles + 3 * t);
+            ++count;
+            if (double(misses) <= target * double(count)) {
+                clusters.push_back(t + 1);
+                cache.clear();
+                misses = count = 0;
+            }
+        }
+    }
+    clusters.push_back(nbTriangles);
+    const std::size_t nbClusters = clusters.size() - 1;
+
+    // centroid (weighted by the areas) and normal of each cluster and of
+    // the mesh
+    std::vector<glm::vec3> centroids(nbClusters), normals(nbClusters);
+    glm::vec3 meshCentroid(0.f, 0.f, 0.f);
+    float meshArea = 0.f;
+    for (std::size_t c = 0; c < nbClusters; ++c) {
+        glm::vec3 centroid(0.f, 0.f, 0.f), normal(0.f, 0.f, 0.f);
+        float area = 0.f;
+        for (std::size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+            glm::vec3 p[3];
+            for (int k = 0; k < 3; ++k) {
+                const float* position = positions + triangles[3 * t + k] * stride;
+                p[k] = glm::vec3(position[0], position[1], position[2]);
+            }
+            glm::vec3 cross = glm::cross(p[1] - p[0], p[2] - p[0]);
+            float a = glm::length(cross);
+            centroid += a * (p[0] + p[1] + p[2]) / 3.f;
+            normal += cross;
+            area += a;
+        }
+        meshCentroid += centroid;
+        meshArea += area;
+        centroids[c] = area > 0.f ? centroid / area : centroid;
+        float length = glm::length(normal);
+        normals[c] = length > 0.f ? normal / length : normal;
+    }
+    if (meshArea > 0.f) {
+        meshCentroid /= meshArea;
+    }
+    std::vector<float> potential(nbClusters);
+    std::vector<std::size_t> order(nbClusters);
+    for (std::size_t c = 0; c < nbClusters; ++c) {
+        potential[c] = glm::dot(centroids[c] - meshCentroid, normals[c]);
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return potential[a] > potential[b]; });
+
+    std::vector<unsigned int> result;
+    result.reserve(3 * nbTriangles);
+    for (std::size_t i = 0; i < nbClusters; ++i) {
+        std::size_t c = order[i];
+        result.insert(result.end(), triangles + 3 * clusters[c], triangles + 3 * clusters[c + 1]);
+    }
+    std::copy(result.begin(), result.end(), triangles);
+}
+
+void optimizeVertexFetch(unsigned int* triangles, std::size_t nbTriangles, std::size_t nbVertices, std::vector<unsigned int>& order)
+{
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> newIndex(nbVertices, unused);
+    order.clear();
+    order.reserve(nbVertices);
+    for (std::size_t i = 0; i < 3 * nbTriangles; ++i) {
+        unsigned int& index = newIndex[triangles[i]];
+        if (index == unused) {
+            index = (unsigned int)order.size();
+            order.push_back(triangles[i]);
+        }
+        triangles[i] = index;
+    }
+    for (std::size_t v = 0; v < nbVertices; ++v) {
+        if (newIndex[v] == unused) {
+            order.push_back((unsigned int)v);
+        }
+    }
+}
+
+} // namespace loaders
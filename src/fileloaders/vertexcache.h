@@ -0,0 +1,90 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef VERTEXCACHE_H
+#define VERTEXCACHE_H
+
+#include <cstddef>
+#include <vector>
+
+// =============================================================================
+namespace Loaders {
+// =============================================================================
+
+/**
+  * @ingroup Loaders
+  * Efficiency of a triangle order for a FIFO post-transform vertex cache.
+  */
+struct VertexCacheStatistics {
+    /// Average cache miss ratio : transformed vertices per triangle (0.5 at
+    /// best on large regular meshes, 3 at worst).
+    double acmr;
+    /// Average transformed vertex ratio : transformed vertices per vertex
+    /// (1 at best).
+    double atvr;
+};
+
+/**
+  * @ingroup Loaders
+  * ACMR and ATVR of nbTriangles triangles (triples of indices in
+  * [0, nbVertices)) drawn in their order, for a FIFO cache of cacheSize
+  * vertices.
+  */
+VertexCacheStatistics vertexCacheStatistics(const unsigned int* triangles, std::size_t nbTriangles, std::size_t nbVertices, unsigned cacheSize = 16);
+
+/**
+  * @ingroup Loaders
+  * Reorders triangles in place for a post-transform vertex cache of
+  * cacheSize vertices (Tipsify : Sander, Nehab and Barczak, "Fast
+  * Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007).
+  * Triangles are emitted in fans around vertices, the next fan vertex
+  * being a vertex of the last fans still in the cache. Linear time, the
+  * vertices of each triangle keep their order (same orientation).
+  */
+void optimizeVertexCache(unsigned int* triangles, std::size_t nbTriangles, std::size_t nbVertices, unsigned cacheSize = 16);
+
+/**
+  * @ingroup Loaders
+  * Reorders triangles in place to reduce overdraw, keeping most of the
+  * vertex cache efficiency of an order given by #optimizeVertexCache().
+  * The triangles are split in clusters : at each triangle whose 3
+  * vertices miss the cache (new patch of the mesh), then inside these
+  * patches as soon as the cache miss ratio from the start of the cluster
+  * falls below threshold times the ratio of the patch (threshold >= 1 :
+  * fewer and larger clusters, closer to the vertex cache order). The
+  * clusters are then sorted by decreasing occlusion potential, the
+  * distance of their centroid to the mesh centroid along their average
+  * normal : clusters on the outside facing outward, which hide the
+  * others, are drawn first. View independent, vertex i is at
+  * (positions[i * stride], positions[i * stride + 1], positions[i * stride + 2]).
+  */
+void optimizeOverdraw(unsigned int* triangles, std::size_t nbTriangles, const float* positions, std::size_t stride, std::size_t nbVertices,
+                      float threshold = 1.05f, unsigned cacheSize = 16);
+
+/**
+  * @ingroup Loaders
+  * Renumbers the vertices in their order of first use by the triangles
+  * (sequential vertex fetch), unused vertices last. The triangles are
+  * changed in place, order[i] receives the previous index of vertex i.
+  */
+void optimizeVertexFetch(unsigned int* triangles, std::size_t nbTriangles, std::size_t nbVertices, std::vector<unsigned int>& order);
+
+} // END namespace loaders =====================================================
+
+#endif // VERTEXCACHE_H
@@ -18,6 +18,7 @@
  ***************************************************************************/
 
 #include "gldirect_draw.h"
+#include "fileloaders/meshstreams.h"
 
 #include <iostream>
 #include <cmath>
@@ -1579,25 +1580,25 @@ static void update_normals_triangles(const std::vector<float>& verts,
                                      std::vector<float>& normals,
                                      bool /*is_vert_provok_mode_last*/)
 {
-    for (int i = 0; i < (int)verts.size() / 3 / 3; ++i) {
-        // retrieve face index
-        int f[] = { i * 3, i * 3 + 1, i * 3 + 2 };
-        // retrieve vertices of the face 'f'
-        Vec3 v[3];
-        for (int i = 0; i < 3; ++i) {
-            v[i] = Vec3(verts[f[i] * 3],
-                        verts[f[i] * 3 + 1],
-                        verts[f[i] * 3 + 2]);
-        }
-        Vec3 n = (v[0] - v[1]).cross(v[2] - v[1]);
-        n.normalize();
-
-        // Every vertices with same normals
-        // (compatible first/last provoking vert)
-        for (int i = 0; i < 3; ++i) {
-            normals[f[i] * 3] = n.x;
-            normals[f[i] * 3 + 1] = n.y;
-            normals[f[i] * 3 + 2] = n.z;
+    const std::size_t nb_tris = verts.size() / 3 / 3;
+    if (nb_tris == 0)
+        return;
+    // Face normals of consecutive triangles, written in the normal of their
+    // first vertex (batched and vectorized by the loaders).
+    Loaders::triangleNormals(&verts[0], &verts[1], &verts[2], 3, 0, nb_tris,
+                             &normals[0], &normals[1], &normals[2], 9,
+                             true);
+
+    // Every vertices with same normals
+    // (compatible first/last provoking vert)
+    // Our faces are oriented by (v0 - v1) x (v2 - v1): opposite normal.
+    for (std::size_t i = 0; i < nb_tris; ++i) {
+        float* n = &normals[i * 9];
+        for (int c = 0; c < 3; ++c)
+            n[c] = -n[c];
+        for (int c = 0; c < 3; ++c) {
+            n[3 + c] = n[c];
+            n[6 + c] = n[c];
         }
     }
 }
@@ -42,6 +42,7 @@ MainWindow::MainWindow()
     : curFile("")
     , fileMenu(0)
     , renderMenu(0)
+    , mLoadLabel(0)
 {
     std::cout << std::endl
               << " -------- IG3D Renderer -------- "
@@ -65,12 +66,22 @@ MainWindow::MainWindow()
     setCentralWidget(glWidget);
     connect(openGLWindow, SIGNAL(fpsChanged(const QString&)),
             this, SLOT(statusChanged(const QString&)));
+
+    // Models are loaded in background, the progress is shown in the status bar
+    connect(openGLWindow->modelLoader(), SIGNAL(progressChanged(qint64, qint64, qint64)),
+            this, SLOT(loadProgress(qint64, qint64, qint64)));
+    connect(openGLWindow->modelLoader(), SIGNAL(loadFinished(bool, const QString&)),
+            this, SLOT(loadFinished(bool, const QString&)));
+    mLoadingFile = "../data/Camel.obj";
+    openGLWindow->loadModel(mLoadingFile);
+    cancelLoadAct->setEnabled(true);
 }
 
 // -----------------------------------------------------------------------------
 
 void MainWindow::clear()
 {
+    // the loading thread is stopped with the OpenGL widget
     delete openGLWindow;
     delete fileMenu;
     delete renderMenu;
@@ -110,6 +121,11 @@ void MainWindow::createActions()
     openAct->setStatusTip(tr("Open an existing file"));
     connect(openAct, SIGNAL(triggered()), this, SLOT(open()));
 
+    cancelLoadAct = new QAction(tr("&Cancel loading"), this);
+    cancelLoadAct->setStatusTip(tr("Cancel the loading of the file"));
+    cancelLoadAct->setEnabled(false);
+    connect(cancelLoadAct, SIGNAL(triggered()), this, SLOT(cancelLoading()));
+
     exitAct = new QAction(tr("E&xit"), this);
     exitAct->setShortcut(tr("Ctrl+Q"));
     exitAct->setStatusTip(tr("Exit the application"));
@@ -132,6 +148,7 @@ void MainWindow::createMenus()
 {
     fileMenu = menuBar()->addMenu(tr("&File"));
     fileMenu->addAction(openAct);
+    fileMenu->addAction(cancelLoadAct);
     fileMenu->addSeparator();
     fileMenu->addAction(exitAct);
 
@@ -146,6 +163,8 @@ void MainWindow::createMenus()
 void MainWindow::createStatusBar()
 {
     statusBar()->showMessage(tr("Ready"));
+    mLoadLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(mLoadLabel);
 }
 
 // -----------------------------------------------------------------------------
@@ -173,7 +192,6 @@ void MainWindow::writeSettings()
 void MainWindow::loadFile(const QString& fileName)
 {
     QFile file(fileName);
-    QString reason;
     if (!file.open(QFile::ReadOnly | QFile::Text)) {
         QMessageBox::warning(this, tr("Application"),
                              tr("Cannot read file %1:\n%2.")
@@ -182,23 +200,51 @@ void MainWindow::loadFile(const QString& fileName)
         return;
     }
 
-    QApplication::setOverrideCursor(Qt::WaitCursor);
+    // Background loading : the current scene is rendered until the new
+    // model is ready, see loadFinished()
+    mLoadingFile = fileName;
+    openGLWindow->loadModel(fileName);
+    mLoadLabel->setText(tr("Loading %1").arg(strippedName(fileName)));
+    cancelLoadAct->setEnabled(true);
+}
 
+// -----------------------------------------------------------------------------
 
-    //bool succeed = loadScene(fileName, reason);
+void MainWindow::cancelLoading()
+{
+    openGLWindow->modelLoader()->cancel();
+    cancelLoadAct->setEnabled(false);
+    mLoadLabel->clear();
+    statusBar()->showMessage(tr("Loading cancelled"), 2000);
+}
 
-    bool succeed = true;
+// -----------------------------------------------------------------------------
 
-    QApplication::restoreOverrideCursor();
+void MainWindow::loadProgress(qint64 bytesParsed, qint64 bytesTotal, qint64 facesBuilt)
+{
+    // progress of a cancelled load may still be queued
+    if (!openGLWindow->modelLoader()->isLoading())
+        return;
+    QString parsed = tr("%1 MB").arg(bytesParsed / (1024. * 1024.), 0, 'f', 1);
+    if (bytesTotal > 0)
+        parsed = tr("%1 / %2 MB").arg(bytesParsed / (1024. * 1024.), 0, 'f', 1).arg(bytesTotal / (1024. * 1024.), 0, 'f', 1);
+    mLoadLabel->setText(tr("Loading %1 : %2, %3 faces").arg(strippedName(mLoadingFile)).arg(parsed).arg(facesBuilt));
+}
 
-    if (succeed) {
+// -----------------------------------------------------------------------------
+
+void MainWindow::loadFinished(bool succeeded, const QString& message)
+{
+    cancelLoadAct->setEnabled(false);
+    mLoadLabel->clear();
+    if (succeeded) {
         reset();
-        setCurrentFile(fileName);
+        setCurrentFile(mLoadingFile);
         statusBar()->showMessage(tr("File loaded"), 2000);
         openGLWindow->updateGL();
     }
     else {
-        QMessageBox::warning(this, tr("Application"), tr("Cannot read file %1\n%2").arg(fileName));
+        QMessageBox::warning(this, tr("Application"), tr("Cannot read file %1\n%2").arg(mLoadingFile).arg(message));
         statusBar()->showMessage(tr("Error loading file"), 2000);
     }
 }
@@ -68,6 +68,10 @@ private slots:
     void open();
     void statusChanged(const QString& message);
 
+    void cancelLoading();
+    void loadProgress(qint64 bytesParsed, qint64 bytesTotal, qint64 facesBuilt);
+    void loadFinished(bool succeeded, const QString& message);
+
     void resetCamera();
     void reloadShaders();
 
@@ -91,11 +95,16 @@ private:
     QMenu* fileMenu;
     QMenu* renderMenu;
     QAction* openAct;
+    QAction* cancelLoadAct;
     QAction* exitAct;
     QAction* checkResetCamera;
     QAction* checkReloadShaders;
     QSize getSize();
     QString mNameFile;
+
+    /// File being loaded in background and its progress in the status bar
+    QString mLoadingFile;
+    QLabel* mLoadLabel;
 };
 
 
@@ -0,0 +1,216 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#include "modelloader.h"
+
+#include "fileloaders/compressedfile.h"
+#include "fileloaders/objloader.h"
+
+#include <QFileInfo>
+
+#include <vector>
+
+// =============================================================================
+namespace Gui {
+// =============================================================================
+
+MeshQueue::MeshQueue()
+{
+    mHead = mTail = new Node();
+    mHead->next.store(0, std::memory_order_relaxed);
+}
+
+// -----------------------------------------------------------------------------
+
+MeshQueue::~MeshQueue()
+{
+    while (mHead) {
+        Node* next = mHead->next.load(std::memory_order_relaxed);
+        delete mHead;
+        mHead = next;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void MeshQueue::push(const Item& item)
+{
+    Node* node = new Node();
+    node->next.store(0, std::memory_order_relaxed);
+    node->item = item;
+    // publish the node once its item is written
+    mTail->next.store(node, std::memory_order_release);
+    mTail = node;
+}
+
+// -----------------------------------------------------------------------------
+
+bool MeshQueue::pop(Item& item)
+{
+    Node* next = mHead->next.load(std::memory_order_acquire);
+    if (!next)
+        return false;
+    item = next->item;
+    delete mHead;
+    mHead = next;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+ModelLoader::ModelLoader(QObject* parent)
+    : QObject(parent)
+    , mCancel(false)
+    , mLoading(false)
+    , mGeneration(0)
+    , mTakenGeneration(0)
+{
+}
+
+// -----------------------------------------------------------------------------
+
+ModelLoader::~ModelLoader()
+{
+    cancel();
+    if (mThread.joinable())
+        mThread.join();
+    MeshQueue::Item item;
+    while (mQueue.pop(item))
+        delete item.mesh;
+}
+
+// -----------------------------------------------------------------------------
+
+void ModelLoader::load(const QString& fileName)
+{
+    cancel();
+    if (mThread.joinable())
+        mThread.join();
+    mCancel = false;
+    mLoading = true;
+    mThread = std::thread(&ModelLoader::run, this, fileName, unsigned(mGeneration));
+}
+
+// -----------------------------------------------------------------------------
+
+void ModelLoader::cancel()
+{
+    mCancel = true;
+    mLoading = false;
+    // the meshes already queued belong to a previous load
+    ++mGeneration;
+}
+
+// -----------------------------------------------------------------------------
+
+Loaders::Mesh* ModelLoader::takeMesh(bool& first)
+{
+    MeshQueue::Item item;
+    while (mQueue.pop(item)) {
+        if (item.generation != mGeneration) {
+            delete item.mesh;
+            continue;
+        }
+        first = (item.generation != mTakenGeneration);
+        mTakenGeneration = item.generation;
+        return item.mesh;
+    }
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+
+void ModelLoader::run(const QString& fileName, unsigned generation)
+{
+    qint64 bytesParsed = 0;
+    qint64 bytesTotal = 0;
+    qint64 facesBuilt = 0;
+    bool succeeded = true;
+    QString message;
+
+    // meshes are queued as soon as they are built
+    Loaders::Obj_mtl::ObjLoader loader;
+    loader.setCancelFlag(&mCancel);
+    auto deliver = [&](Loaders::Mesh* mesh) {
+        facesBuilt += mesh->nbTriangles();
+        MeshQueue::Item item = { mesh, generation };
+        mQueue.push(item);
+        emit meshReady();
+    };
+
+    if (loader.loadCache(fileName, message)) {
+        // valid binary cache : no parsing
+        bytesParsed = bytesTotal = QFileInfo(fileName).size();
+        std::vector<Loaders::Mesh*> meshes;
+        loader.getObjects(meshes);
+        // the meshes of a cancelled load are incomplete
+        for (std::size_t i = 0; i < meshes.size(); ++i) {
+            if (mCancel)
+                delete meshes[i];
+            else
+                deliver(meshes[i]);
+        }
+    }
+    else {
+        // streaming : the file is read (and decompressed) by blocks and each
+        // group is built once the next one starts
+        std::string name = fileName.toStdString();
+        Loaders::CompressedFile file(name);
+        if (!file.isOpen()) {
+            mLoading = false;
+            if (!mCancel)
+                emit loadFinished(false, QString(file.error().c_str()));
+            return;
+        }
+        if (file.format() == Loaders::CompressedFile::Plain)
+            bytesTotal = QFileInfo(fileName).size();
+
+        loader.beginStream(QFileInfo(fileName).absolutePath(), deliver);
+        const char* data;
+        std::size_t size;
+        while (succeeded && !mCancel && file.nextBlock(data, size)) {
+            succeeded = loader.feed(data, size, message);
+            bytesParsed += size;
+            emit progressChanged(bytesParsed, bytesTotal, facesBuilt);
+        }
+        if (succeeded && !file.error().empty()) {
+            succeeded = false;
+            message = QString(file.error().c_str());
+        }
+        // a cancelled stream is not finished, its groups are not built
+        if (!mCancel) {
+            QString finishMessage;
+            bool finished = loader.finish(finishMessage);
+            if (succeeded) {
+                succeeded = finished;
+                message = finishMessage;
+            }
+        }
+    }
+
+    mLoading = false;
+    if (!mCancel) {
+        emit progressChanged(bytesParsed, bytesTotal, facesBuilt);
+        emit loadFinished(succeeded, message);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+} // END namespace gui =========================================================
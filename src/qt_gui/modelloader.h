@@ -0,0 +1,125 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Mathias Paulin                                  *
+ *   Mathias.Paulin@irit.fr                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef MODELLOADER_H
+#define MODELLOADER_H
+
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+#include <thread>
+
+#include "fileloaders/mesh.h"
+
+// =============================================================================
+namespace Gui {
+// =============================================================================
+
+/**
+  * @ingroup InterfaceSystem
+  * Lock-free queue of the meshes built by a loading thread for the GL thread.
+  * One producer and one consumer : push() is only called by the loading
+  * thread and pop() by the GL thread.
+  */
+class MeshQueue {
+public:
+    struct Item {
+        Loaders::Mesh* mesh;
+        unsigned generation; ///< load which built the mesh
+    };
+
+    MeshQueue();
+    ~MeshQueue();
+
+    void push(const Item& item);
+    /// @return false if the queue is empty
+    bool pop(Item& item);
+
+private:
+    // non copyable
+    MeshQueue(const MeshQueue&);
+    MeshQueue& operator=(const MeshQueue&);
+
+    struct Node {
+        std::atomic<Node*> next;
+        Item item;
+    };
+    Node* mHead; ///< consumer side, already popped node
+    Node* mTail; ///< producer side, last pushed node
+};
+
+/**
+  * @ingroup InterfaceSystem
+  * Background model loading.
+  * The file is parsed and its meshes are built on worker threads while the
+  * current scene keeps rendering. The meshes are handed to the GL thread
+  * one by one with #takeMesh() as soon as they are built, and the progress
+  * is reported with Qt signals.
+  * A valid binary cache of the file is used when there is one (see
+  * Loaders::Obj_mtl::ObjLoader::setCacheEnabled()), the file is streamed
+  * and parsed by blocks otherwise.
+  */
+class ModelLoader : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ModelLoader(QObject* parent = 0);
+    ~ModelLoader();
+
+    /// Start loading "fileName" in background, the current load is cancelled
+    /// and its thread joined (it stops at its next cancel check).
+    void load(const QString& fileName);
+
+    /// Cancel the current load : its meshes are dropped and #loadFinished()
+    /// is not emitted. Doesn't wait for the loading thread, which stops at
+    /// its next cancel check (between two blocks of the file, two parts of
+    /// a group or two meshes) and is joined by the next #load() or by the
+    /// destructor.
+    void cancel();
+
+    bool isLoading() const { return mLoading; }
+
+    /// Next mesh of the current load (GL thread), 0 when none is ready.
+    /// The caller owns the mesh, "first" tells if this is the first mesh
+    /// of the load (the previous model can then be released).
+    Loaders::Mesh* takeMesh(bool& first);
+
+signals:
+    /// Bytes parsed (out of bytesTotal, 0 if unknown) and faces built.
+    void progressChanged(qint64 bytesParsed, qint64 bytesTotal, qint64 facesBuilt);
+    /// A mesh can be taken with #takeMesh().
+    void meshReady();
+    /// End of a load which was not cancelled.
+    void loadFinished(bool succeeded, const QString& message);
+
+private:
+    void run(const QString& fileName, unsigned generation);
+
+    MeshQueue mQueue;
+    std::thread mThread;
+    std::atomic<bool> mCancel;
+    std::atomic<bool> mLoading;
+    std::atomic<unsigned> mGeneration; ///< current load
+    unsigned mTakenGeneration; ///< load of the last taken mesh
+};
+
+} // END namespace gui =========================================================
+
+#endif // MODELLOADER_H
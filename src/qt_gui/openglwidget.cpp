@@ -51,6 +51,7 @@ OpenGLWidget::OpenGLWidget(QScreen* screen)
     , mHeight(-1)
     , m_theRenderer(nullptr)
     , mContext(0)
+    , mModelLoader(0)
 {
     setSurfaceType(OpenGLSurface);
 
@@ -75,6 +76,10 @@ OpenGLWidget::OpenGLWidget(QScreen* screen)
 
     resize(QSize(800, 450));
 
+    // meshes of background loads are uploaded by the next frames
+    mModelLoader = new ModelLoader(this);
+    connect(mModelLoader, SIGNAL(meshReady()), this, SLOT(updateGL()));
+
     connect(this, SIGNAL(widthChanged(int)), this, SLOT(resizeGL()));
     connect(this, SIGNAL(heightChanged(int)), this, SLOT(resizeGL()));
     //    QTimer *timer = new QTimer(this);
@@ -86,6 +91,8 @@ OpenGLWidget::OpenGLWidget(QScreen* screen)
 
 OpenGLWidget::~OpenGLWidget()
 {
+    // stop the loading thread before the renderer is released
+    delete mModelLoader;
     delete m_theRenderer;
     // Must be last to release all OpenGL objects before (VBOs shaders ...):
     delete mContext;
@@ -145,6 +152,8 @@ void OpenGLWidget::paintGL()
     tbx::Timer t;
     t.start();
 
+    uploadMeshes();
+
     // Draw here
     m_theRenderer->render();
 #if 0
@@ -171,6 +180,28 @@ void OpenGLWidget::paintGL()
 
 // -----------------------------------------------------------------------------
 
+void OpenGLWidget::uploadMeshes()
+{
+    // large models arrive in several frames, so that the rendering goes on
+    static const std::size_t UploadBudget = 1 << 20;
+    std::size_t triangles = 0;
+    bool first;
+    while (triangles < UploadBudget) {
+        Loaders::Mesh* mesh = mModelLoader->takeMesh(first);
+        if (!mesh)
+            return;
+        if (first)
+            m_theRenderer->clearMeshes();
+        m_theRenderer->addMesh(*mesh);
+        triangles += mesh->nbTriangles();
+        delete mesh;
+    }
+    // budget reached : next meshes at the next frame
+    QMetaObject::invokeMethod(this, "updateGL", Qt::QueuedConnection);
+}
+
+// -----------------------------------------------------------------------------
+
 void OpenGLWidget::keyPressEvent(QKeyEvent* e)
 {
 
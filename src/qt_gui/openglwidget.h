@@ -22,6 +22,7 @@
 
 
 #include "rendersystem/renderer.h"
+#include "modelloader.h"
 #include <QWindow>
 #include <QOpenGLContext>
 #include <QImage>
@@ -49,6 +50,11 @@ public:
 
     void printContextInfos();
 
+    /// Load the model "fileName" in background : the current scene is
+    /// rendered until the first mesh of the model is ready.
+    void loadModel(const QString& fileName){ mModelLoader->load(fileName); }
+    ModelLoader* modelLoader() const { return mModelLoader; }
+
 signals:
     void fpsChanged ( const QString & );
 
@@ -68,6 +74,9 @@ protected:
     virtual void exposeEvent      (QExposeEvent* e );
 private:
     void initGlew();
+    /// Upload the meshes built by the background load, at most
+    /// UploadBudget triangles per frame.
+    void uploadMeshes();
 
     int mWidth;
     int mHeight;
@@ -75,6 +84,8 @@ private:
     RenderSystem::Renderer* m_theRenderer;
 
     QOpenGLContext* mContext;
+
+    ModelLoader* mModelLoader;
 };
 
 } // END namespace gui =========================================================
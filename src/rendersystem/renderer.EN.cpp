@@ -27,6 +27,7 @@
 
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_access.hpp>
+#include <utility>
 
  /** @defgroup RendererGlobalFunctions
    * @author Mathias Paulin <Mathias.Paulin@irit.fr>
@@ -77,7 +78,10 @@ namespace RenderSystem {
         // #########################################################################
 
 
-        initGeometry(); // LAB 1 / PART II: Loading or building geometric data.
+        // LAB 1 / PART II: Loading or building geometric data.
+        // The model is loaded in background (Gui::ModelLoader) and its meshes
+        // are given to addMesh(), initGeometry() is the synchronous version.
+        //initGeometry();
     }
 
     //------------------------------------------------------------------------------
@@ -486,7 +490,18 @@ namespace RenderSystem {
     public:
         MyGLMesh(const Loaders::Mesh& mesh)
             : Loaders::Mesh(mesh)
+            , mVertexArrayObject(0)
         {
+            mVertexBufferObjects[VBO_VERTICES] = mVertexBufferObjects[VBO_INDICES] = 0;
+        }
+
+        /// Takes the buffers of mesh (e.g. merged by Loaders::Mesh's
+        /// constructor from parts) without copying them.
+        MyGLMesh(Loaders::Mesh&& mesh)
+            : Loaders::Mesh(std::move(mesh))
+            , mVertexArrayObject(0)
+        {
+            mVertexBufferObjects[VBO_VERTICES] = mVertexBufferObjects[VBO_INDICES] = 0;
         }
 
         MyGLMesh(const std::vector<float>& vertexBuffer,
@@ -498,12 +513,31 @@ namespace RenderSystem {
                 std::vector<int>(),
                 hasNormals,
                 hasTextureCoords)
+            , mVertexArrayObject(0)
+        {
+            mVertexBufferObjects[VBO_VERTICES] = mVertexBufferObjects[VBO_INDICES] = 0;
+        }
+
+        /// Mesh of nbVertices vertices and nbTriangles triangles without CPU
+        /// storage: its buffers are written through mapGL().
+        MyGLMesh(std::size_t nbVertices, std::size_t nbTriangles)
+            : Loaders::Mesh(0, 0)
+            , mVertexArrayObject(0)
         {
+            mNbVertices = nbVertices;
+            mNbTriangles = nbTriangles;
+            mVertexBufferObjects[VBO_VERTICES] = mVertexBufferObjects[VBO_INDICES] = 0;
         }
 
         /// Upload du maillage sur GPU
         /// Build VertexArrayObjects for the mesh.
-        void compileGL()
+        void compileGL() { compileGL(vertexData(), triangleData()); }
+
+        /// Build VertexArrayObjects for the mesh from raw vertices and
+        /// triangles (see Loaders::Mesh::vertexData()), uninitialized
+        /// buffers when null. The buffers of a mesh already compiled are
+        /// filled again.
+        void compileGL(const float* vertices, const unsigned int* triangles)
         {
             // This function aims to prepare our mesh for rendering with OpenGl.
             // To this end, you must load into video memory (GPU)
@@ -557,15 +591,19 @@ namespace RenderSystem {
                   // and store it in this->mVertexArrayObject
                   // ( glGenVertexArrays() )
 
-            glAssert(glGenVertexArrays(1, &mVertexArrayObject));
+            if (!mVertexArrayObject) {
+                glAssert(glGenVertexArrays(1, &mVertexArrayObject));
+            }
 
                   // 2 - Create 2 VBOs. Generate two identifiers for VertexBufferObject
                   // (one for vertices VBO_VERTICES, another for faces (triangles) VBO_INDICES)
                   // save them in this->mVertexBufferObjects
                   // ( glGenBuffers() )
 
-            glAssert(glGenBuffers(1, &mVertexBufferObjects[VBO_VERTICES]));
-            glAssert(glGenBuffers(1, &mVertexBufferObjects[VBO_INDICES]));
+            if (!mVertexBufferObjects[VBO_VERTICES]) {
+                glAssert(glGenBuffers(1, &mVertexBufferObjects[VBO_VERTICES]));
+                glAssert(glGenBuffers(1, &mVertexBufferObjects[VBO_INDICES]));
+            }
 
                   // 3 - Tell OpenGL which VAO we are currently working.
                   // Enable the previously created VertexArrayObject (VAO)
@@ -586,7 +624,7 @@ namespace RenderSystem {
                   // 5 - Fill the VertexBufferObject of vertices with
                   // (glBufferData())
 
-            glAssert(glBufferData(GL_ARRAY_BUFFER, mNbVertices*sizeof(Vertex), &mVertices[0], GL_STATIC_DRAW));
+            glAssert(glBufferData(GL_ARRAY_BUFFER, mNbVertices*sizeof(Vertex), vertices, GL_STATIC_DRAW));
 
                   // 6 - Describe the buffer memory layout / organization
                   // (glVertexAttribPointer())
@@ -619,7 +657,7 @@ namespace RenderSystem {
                   // 9 - Fill VertexBufferObject *of faces*
                   // ...
 
-            glAssert(glBufferData(GL_ELEMENT_ARRAY_BUFFER, mNbTriangles*sizeof(TriangleIndex), &mTriangles[0], GL_STATIC_DRAW));
+            uploadTriangles(triangles);
 
                   // LAB 1 / PART II: END CODE TO COMPLETE
                   // #####################################################################
@@ -629,6 +667,59 @@ namespace RenderSystem {
             glAssert(glBindVertexArray(0));
         }
 
+        /// Allocates the buffers of the mesh and maps them for writing: the
+        /// loader writes the vertices and triangles directly in video memory.
+        /// Falls back to a CPU copy uploaded by unmapGL() if the driver
+        /// cannot map a buffer, or if the indices are stored on 16 bits (the
+        /// loader writes 32 bits indices).
+        void mapGL(float*& vertices, unsigned int*& triangles)
+        {
+            compileGL(0, 0);
+            vertices = 0;
+            triangles = 0;
+            const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+            if (mNbVertices > 0) {
+                glAssert(glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObjects[VBO_VERTICES]));
+                vertices = (float*)glMapBufferRange(GL_ARRAY_BUFFER, 0, mNbVertices*sizeof(Vertex), access);
+            }
+            if (mNbTriangles > 0 && indexType() == GL_UNSIGNED_INT) {
+                glAssert(glBindVertexArray(mVertexArrayObject));
+                glAssert(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mVertexBufferObjects[VBO_INDICES]));
+                triangles = (unsigned int*)glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, mNbTriangles*sizeof(TriangleIndex), access);
+                glAssert(glBindVertexArray(0));
+            }
+            glAssert(glBindBuffer(GL_ARRAY_BUFFER, 0));
+            if (mNbVertices > 0 && !vertices) {
+                mVertices.resize(mNbVertices);
+                vertices = vertexData();
+            }
+            if (mNbTriangles > 0 && !triangles) {
+                mTriangles.resize(mNbTriangles, TriangleIndex(0, 0, 0));
+                triangles = triangleData();
+            }
+        }
+
+        /// Ends the writing started by mapGL().
+        void unmapGL()
+        {
+            if (!unmapBuffers(mVertices.empty(), mTriangles.empty()))
+                std::cerr << "MyGLMesh: buffer content lost while writing, mesh left empty" << std::endl;
+            // CPU copies (buffer not mapped by the driver, 16 bits indices)
+            if (!mVertices.empty()) {
+                glAssert(glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObjects[VBO_VERTICES]));
+                glAssert(glBufferData(GL_ARRAY_BUFFER, mNbVertices*sizeof(Vertex), vertexData(), GL_STATIC_DRAW));
+                glAssert(glBindBuffer(GL_ARRAY_BUFFER, 0));
+                VertexArray().swap(mVertices);
+            }
+            if (!mTriangles.empty()) {
+                glAssert(glBindVertexArray(mVertexArrayObject));
+                glAssert(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mVertexBufferObjects[VBO_INDICES]));
+                uploadTriangles(triangleData());
+                glAssert(glBindVertexArray(0));
+                TriangleIndexArray().swap(mTriangles);
+            }
+        }
+
         /// Draw the VertexArrayObjects (VAO "mVertexArrayObject") of the mesh.
         void drawGL()
         {
@@ -646,7 +737,7 @@ namespace RenderSystem {
             // Les sommets des triangles étant indexés et non consécutifs (sauf cas très particulier)
             // on utilisera la fonction glDrawElements(...)
 
-            glAssert(glDrawElements(GL_TRIANGLES, mNbTriangles*sizeof(TriangleIndex), GL_UNSIGNED_INT, 0));
+            glAssert(glDrawElements(GL_TRIANGLES, GLsizei(3 * mNbTriangles), indexType(), 0));
 
             // Watch out! The "count" parameter of glDrawElements() does not define
             // the number of triangles but the actual size your index buffer.
@@ -666,13 +757,76 @@ namespace RenderSystem {
             // 1 - delete VBO and VBE
             // glDeleteBuffers()
 
+            glAssert(glDeleteBuffers(NB_VBOS, mVertexBufferObjects));
+
             // 2 - Delete VAO
             // glDeleteVertexArrays()
 
+            glAssert(glDeleteVertexArrays(1, &mVertexArrayObject));
+
 
             // LAB 1 / PART II: END CODE TO COMPLETE
             // #####################################################################
         }
+
+    private:
+        /// Type of the indices of the element buffer: 16 bits when they
+        /// are enough (at most 65536 vertices, e.g. the chunks of a large
+        /// model, see ObjLoader::setMaxMeshSize()).
+        GLenum indexType() const { return mNbVertices <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT; }
+
+        /// Fills the bound element buffer with the triangles (uninitialized
+        /// when null), converted to indexType().
+        void uploadTriangles(const unsigned int* triangles)
+        {
+            std::size_t count = 3 * mNbTriangles;
+            if (indexType() == GL_UNSIGNED_INT) {
+                glAssert(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count*sizeof(GLuint), triangles, GL_STATIC_DRAW));
+                return;
+            }
+            std::vector<GLushort> shortIndices(triangles ? count : 0);
+            for (std::size_t i = 0; i < shortIndices.size(); ++i)
+                shortIndices[i] = GLushort(triangles[i]);
+            glAssert(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count*sizeof(GLushort), triangles ? shortIndices.data() : 0, GL_STATIC_DRAW));
+        }
+
+        /// Unmaps the mapped buffers, false if the driver lost their content.
+        bool unmapBuffers(bool vertices, bool triangles)
+        {
+            GLboolean ok = GL_TRUE;
+            if (vertices && mNbVertices > 0) {
+                glAssert(glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObjects[VBO_VERTICES]));
+                ok = glUnmapBuffer(GL_ARRAY_BUFFER) && ok;
+            }
+            if (triangles && mNbTriangles > 0) {
+                glAssert(glBindVertexArray(mVertexArrayObject));
+                glAssert(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mVertexBufferObjects[VBO_INDICES]));
+                ok = glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER) && ok;
+                glAssert(glBindVertexArray(0));
+            }
+            glAssert(glBindBuffer(GL_ARRAY_BUFFER, 0));
+            return ok == GL_TRUE;
+        }
+    };
+
+    /// Writes the meshes of a loader directly in the mapped buffers of new
+    /// MyGLMesh objects (no CPU copy of the meshes).
+    class GLMeshSink : public Loaders::MeshSink {
+    public:
+        explicit GLMeshSink(std::vector<MyGLMesh*>& meshes) : mMeshes(meshes), mFirst(meshes.size()) {}
+
+        void beginMesh(const std::string& /*name*/, std::size_t nbVertices, std::size_t nbTriangles, float*& vertices, unsigned int*& triangles)
+        {
+            MyGLMesh* mesh = new MyGLMesh(nbVertices, nbTriangles);
+            mesh->mapGL(vertices, triangles);
+            mMeshes.push_back(mesh);
+        }
+
+        void endMesh(std::size_t mesh) { mMeshes[mFirst + mesh]->unmapGL(); }
+
+    private:
+        std::vector<MyGLMesh*>& mMeshes;
+        std::size_t mFirst;
     };
 
     // -----------------------------------------------------------------------------
@@ -705,38 +859,24 @@ namespace RenderSystem {
         // and use the method ".load()" to parse an "camel.obj".
         // If an error occurs print it.
         // Retreive the parsed meshes with ".getObjects()"
-        std::vector<Loaders::Mesh*> meshes;
+        // (the meshes are written directly in the VBOs of new "MyGLMesh")
         Loaders::Obj_mtl::ObjLoader obj;
         QString reason;
         QString fileName("../data/Camel.obj");
         bool result = obj.load(fileName, reason);
         if (!result)
             std::cout << reason.toStdString();
-        obj.getObjects(meshes);
+        GLMeshSink sink(mMeshes);
+        std::vector<const Loaders::Obj_mtl::ObjLoader::mtlMaterial*> materials;
+        obj.getObjects(sink, materials);
 
 
         // 2 - Convert the list of meshes to "MyGLMesh"
         // (use this->mMeshes to store the converted objects)
-        
-        for (auto i = meshes.begin(); i != meshes.end(); i++)
-        { 
-            //if (i == meshes.begin()++) { std::cout << "hello there";  }
-            /*std::vector<float> vertexBuffer1;
-            std::vector<int> triangleBuffer1;
-            bool parameter;
-            (*i)->getData(vertexBuffer1, triangleBuffer1, parameter);
-            */
-            //MyGLMesh* mesh1 = new MyGLMesh(vertexBuffer1, triangleBuffer1);
-            //mMeshes.push_back(new MyGLMesh(vertexBuffer1, triangleBuffer1));
-            mMeshes.push_back(new MyGLMesh(*(*i)));
-        }
 
         // 3 - Upload to GPU with ".compileGL()"
 
-        for (auto i = mMeshes.begin(); i != mMeshes.end(); ++i)
-        {
-            (*i)->compileGL();
-        }
+        // (both done by the sink above)
 
         // LAB 1 / PART II: END CODE TO COMPLETE
         // #########################################################################
@@ -744,6 +884,25 @@ namespace RenderSystem {
 
     // -----------------------------------------------------------------------------
 
+    /// Upload to GPU one mesh of the scene (e.g. built by a background load).
+    void Renderer::addMesh(const Loaders::Mesh& mesh)
+    {
+        MyGLMesh* glMesh = new MyGLMesh(mesh.nbVertices(), mesh.nbTriangles());
+        glMesh->compileGL(mesh.vertexData(), mesh.triangleData());
+        mMeshes.push_back(glMesh);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void Renderer::clearMeshes()
+    {
+        for (unsigned i = 0; i < mMeshes.size(); ++i)
+            delete mMeshes[i];
+        mMeshes.clear();
+    }
+
+    // -----------------------------------------------------------------------------
+
     void Renderer::draw_list_mesh()
     {
         // #########################################################################
@@ -70,7 +70,10 @@ void Renderer::initRessources()
     // #####################################
 
 
-    initGeometry(); // TP 1 / PARTIE II: Loading or building geometric data.
+    // TP 1 / PARTIE II: Loading or building geometric data.
+    // Le modèle est chargé en arrière-plan (Gui::ModelLoader) et ses maillages
+    // sont donnés à addMesh(), initGeometry() est la version synchrone.
+    //initGeometry();
 }
 
 //------------------------------------------------------------------------------
@@ -345,7 +348,9 @@ private:
 public:
     MyGLMesh(const Loaders::Mesh& mesh)
         : Loaders::Mesh(mesh)
+        , mVertexArrayObject(0)
     {
+        mVertexBufferObjects[VBO_VERTICES] = mVertexBufferObjects[VBO_INDICES] = 0;
     }
 
     MyGLMesh(const std::vector<float>& vertexBuffer,
@@ -357,7 +362,9 @@ public:
                         std::vector<int>(),
                         hasNormals,
                         hasTextureCoords)
+        , mVertexArrayObject(0)
     {
+        mVertexBufferObjects[VBO_VERTICES] = mVertexBufferObjects[VBO_INDICES] = 0;
     }
 
     /**
@@ -480,8 +487,12 @@ void drawGL()
     // ########################################
     // 1 - Supprimer VBO et VBE glDeleteBuffers()
 
+    glAssert(glDeleteBuffers(2, mVertexBufferObjects));
+
     // 2 - Supprimer VAO glDeleteVertexArrays()
 
+    glAssert(glDeleteVertexArrays(1, &mVertexArrayObject));
+
     // ######################################
     // TP 1 / PARTIE II: Fin du code à écrire
     // ######################################
@@ -540,6 +551,26 @@ void Renderer::initGeometry()
  
 // -----------------------------------------------------------------------------
 
+/// Upload vers GPU d'un maillage de la scène (construit par un chargement en
+/// arrière-plan par exemple).
+void Renderer::addMesh(const Loaders::Mesh& mesh)
+{
+    MyGLMesh* glMesh = new MyGLMesh(mesh);
+    glMesh->compileGL();
+    mMeshes.push_back(glMesh);
+}
+
+// -----------------------------------------------------------------------------
+
+void Renderer::clearMeshes()
+{
+    for (unsigned i = 0; i < mMeshes.size(); ++i)
+        delete mMeshes[i];
+    mMeshes.clear();
+}
+
+// -----------------------------------------------------------------------------
+
 void Renderer::draw_list_mesh()
 {
     // #########################################################################
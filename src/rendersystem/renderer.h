@@ -25,6 +25,10 @@
 #include <vector>
 class GlDirectDraw;
 
+namespace Loaders {
+class Mesh;
+}
+
 /** @defgroup RenderSystem Simple OpenGL Rendering system
  *  Simple OpenGL 3.2 core renderer.
  * @author Mathias Paulin <Mathias.Paulin@irit.fr>
@@ -152,6 +156,12 @@ public:
     /// Initialise the geometric content
     void initGeometry();
 
+    /// Upload a mesh to the GPU and add it to the scene
+    void addMesh(const Loaders::Mesh& mesh);
+
+    /// Remove all the meshes of the scene
+    void clearMeshes();
+
     /// Initialise the shader configuration
     void initShaders();
 